@@ -3,11 +3,11 @@
  *
  * A Windows system tray application that:
  * - Launches Chrome with remote debugging enabled
- * - Sets up port forwarding for all network interfaces
+ * - Forwards the debug port on all network interfaces (built-in relay or netsh)
  * - Monitors Chrome DevTools API status
  * - Provides configuration via registry-backed settings dialog
  *
- * Compile with MinGW: x86_64-w64-mingw32-gcc
+ * Compile with MinGW: x86_64-w64-mingw32-gcc (together with cdp.c)
  */
 
 #define _WIN32_WINNT 0x0600
@@ -20,18 +20,21 @@
 // Winsock must be included before windows.h
 #include <winsock2.h>
 #include <ws2tcpip.h>
+#include <mswsock.h>
 #include <windows.h>
 #include <shellapi.h>
 #include <shlobj.h>
 #include <shlwapi.h>
 #include <iphlpapi.h>
-#include <wininet.h>
+#include <psapi.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <wchar.h>
 #include <objbase.h>
 
+#include "cdp.h"
+
 // ============================================================================
 // Constants and Definitions
 // ============================================================================
@@ -45,8 +48,27 @@
 #define REG_KEY_PATH L"SOFTWARE\\JPIT\\ChromeDevLauncher"
 #define REG_VALUE_CHROME_PATH L"ChromePath"
 #define REG_VALUE_DEBUG_PORT L"DebugPort"
+#define REG_VALUE_INSTANCE_COUNT L"InstanceCount"
 #define REG_VALUE_CONNECT_ADDRESS L"ConnectAddress"
 #define REG_VALUE_STATUS_INTERVAL L"StatusCheckInterval"
+#define REG_VALUE_FORWARD_MODE L"ForwardMode"
+#define REG_VALUE_HOT_STANDBY L"HotStandby"
+#define REG_VALUE_GOLDEN_PROFILE L"GoldenProfile"
+#define REG_VALUE_MEMORY_PROFILE_PATH L"MemoryProfilePath"
+#define REG_VALUE_JOB_MEMORY L"JobMemoryMB"
+#define REG_VALUE_PROCESS_MEMORY L"ProcessMemoryMB"
+#define REG_VALUE_CPU_RATE L"CpuRatePercent"
+#define REG_VALUE_ACTIVE_PROCESS_LIMIT L"ActiveProcessLimit"
+#define REG_VALUE_RESTART_ON_LIMIT L"RestartOnLimit"
+#define REG_VALUE_CLOSE_TIMEOUT L"CloseTimeout"
+#define REG_VALUE_FLAG_PRESET L"FlagPreset"
+#define REG_VALUE_EXTRA_ARGS L"ExtraArgs"
+#define REG_VALUE_HEADLESS L"Headless"
+#define REG_VALUE_BROKER_PORT L"BrokerPort"
+#define REG_VALUE_CONTEXT_POOL_SIZE L"ContextPoolSize"
+#define REG_VALUE_TAB_POOL_SIZE L"TabPoolSize"
+#define REG_VALUE_TAB_POOL_URLS L"TabPoolUrls"
+// Cache caps: one DWORD (MB) per cache class, named in g_cacheClasses
 #define REG_VALUE_CONFIGURED L"Configured"
 
 // Tray icon
@@ -58,9 +80,19 @@
 #define ID_TRAY_MENU_STATUS 1
 #define ID_TRAY_MENU_CONFIGURE 2
 #define ID_TRAY_MENU_EXIT 4
+#define ID_TRAY_MENU_EXPORT_TELEMETRY 5
+#define ID_TRAY_MENU_PAGE_FIRST 100  // + instance * CDP_MAX_TARGETS + target index
+#define ID_TRAY_MENU_PAGE_LAST (ID_TRAY_MENU_PAGE_FIRST + MAX_INSTANCES * CDP_MAX_TARGETS - 1)
 
 // Custom messages
 #define WM_BRING_CHROME_TO_FRONT (WM_USER + 100)
+#define WM_INTERFACES_CHANGED (WM_USER + 101)  // Posted by the address change callback
+#define WM_TASK_COMPLETE (WM_USER + 102)       // LPARAM = finished Task*
+#define WM_CHROME_EXITED (WM_USER + 103)       // WPARAM = job generation
+#define WM_CHROME_CRASHED (WM_USER + 104)      // WPARAM = job generation, LPARAM = PID
+#define WM_CDP_LIVENESS (WM_USER + 105)        // LPARAM = heap LivenessSnapshot*
+#define WM_CHROME_READY (WM_USER + 106)        // WPARAM = job generation
+#define WM_CHROME_LIMIT (WM_USER + 107)        // LPARAM = heap JobLimitEvent*
 
 // Resource IDs
 #define IDR_HTML_UI      200
@@ -68,14 +100,177 @@
 
 // Timers
 #define ID_TIMER_STATUS_CHECK 1
-#define ID_TIMER_CHROME_EXIT 2
-#define CHROME_EXIT_CHECK_INTERVAL 1000
+#define ID_TIMER_RECONCILE 3
+#define ID_TIMER_TELEMETRY 4
+#define ID_TIMER_FORWARD_RETRY 5
+#define RECONCILE_DEBOUNCE_MS 1000  // Address changes arrive in bursts (DHCP, VPN)
 #define ID_TIMER_WEBVIEW_SHOW_FALLBACK 1006
 #define WEBVIEW_SHOW_FALLBACK_DELAY_MS 350
 
 // Limits
 #define MAX_INTERFACES 32
+#define MAX_INSTANCES 16                                 // Chrome pool size limit
+#define STANDBY_INDEX MAX_INSTANCES                      // g_instances slot of the hot standby
+#define GOLDEN_INDEX (MAX_INSTANCES + 1)                 // g_instances slot that prepares the golden profile
+#define MAX_FORWARDS (MAX_INTERFACES * MAX_INSTANCES)    // One per interface and instance port
 #define MAX_STATUS_TEXT 512
+#define MAX_CACHE_CLASS_PATHS 3
+
+// Port forwarding modes (Configuration.forwardMode)
+#define FORWARD_MODE_RELAY 0         // Built-in IOCP relay (default)
+#define FORWARD_MODE_NETSH 1         // netsh interface portproxy, one process per entry
+#define FORWARD_MODE_NETSH_BATCH 2   // netsh interface portproxy, one script for all entries
+
+// Chrome flag presets (Configuration.flagPreset), see g_flagPresets
+#define FLAG_PRESET_NONE 0
+#define FLAG_PRESET_MAX_THROUGHPUT 1  // Background tabs keep full speed
+#define FLAG_PRESET_LOW_MEMORY 2      // Fewer processes and smaller heaps
+#define FLAG_PRESET_COUNT 3
+#define CHROME_EXTRA_ARGS_MAX 1024
+#define CHROME_COMMAND_LINE_MAX 32767  // CreateProcessW limit, in characters
+
+// netsh
+#define NETSH_TIMEOUT_MS 5000
+#define NETSH_BATCH_TIMEOUT_MS 30000
+#define NETSH_SCRIPT_LINE_MAX 160
+#define FORWARD_BENCHMARK_PORT 49222
+#define FORWARD_RETRY_BASE_MS 2000    // First retry of a failed forward, doubling per failure
+#define FORWARD_RETRY_MAX_MS 60000
+
+// Backend that owns an active PortForwardEntry
+#define FORWARD_BACKEND_NONE 0
+#define FORWARD_BACKEND_RELAY 1
+#define FORWARD_BACKEND_NETSH 2
+
+// DevTools HTTP probe - a hung Chrome must not hold a worker for long
+#define DEVTOOLS_CONNECT_TIMEOUT_MS 1000
+#define DEVTOOLS_READ_TIMEOUT_MS 2000
+#define DEVTOOLS_RESPONSE_MAX 4096
+
+// Readiness - Chrome writes this file into the profile once DevTools listens
+#define DEVTOOLS_ACTIVE_PORT_FILE L"DevToolsActivePort"
+#define READY_WATCH_BUFFER_SIZE 4096
+
+// Status probe scheduler - the configured status interval is the ceiling
+#define PROBE_MODE_STARTUP 0     // After launch, until the first successful probe
+#define PROBE_MODE_HEALTHY 1     // Interval doubles after every success
+#define PROBE_MODE_BURST 2       // Right after a failure
+#define PROBE_MODE_BACKOFF 3     // Still failing after the burst; interval doubles
+#define PROBE_FAST_INTERVAL_MS 250
+#define PROBE_HEALTHY_MIN_MS 1000
+#define PROBE_BURST_COUNT 8
+#define PROBE_STARTUP_TIMEOUT_MS 60000
+
+// Golden profile - prepared once by a Chrome of its own, then cloned per session
+#define GOLDEN_MARKER_SUFFIX L".ready"   // Next to the golden directory; holds the cold first-run ms
+#define GOLDEN_READY_TIMEOUT_MS 60000
+#define GOLDEN_SETTLE_MS 10000           // First-run tasks and component installs after DevTools listens
+#define GOLDEN_CLOSE_TIMEOUT_MS 10000
+#define BLOCK_CLONE_CHUNK (1024LL * 1024 * 1024)
+
+// Job limits - what a Chrome job ran into (JobLimitEvent.limit)
+#define JOB_LIMIT_JOB_MEMORY 0
+#define JOB_LIMIT_PROCESS_MEMORY 1
+#define JOB_LIMIT_ACTIVE_PROCESSES 2
+#define JOB_LIMIT_LOG_INTERVAL_MS 1000   // Allocations keep failing - log a burst once
+#define JOB_LIMIT_LOOKUP_TIMEOUT_MS 3000 // Tracing the instance for the page of a PID
+
+// Graceful close - Browser.close first, so Chrome flushes its profile and the
+// next launch skips crash recovery; the job is terminated after the deadline
+#define CLOSE_TIMEOUT_MAX 60             // seconds
+#define CLOSE_CDP_TIMEOUT_MS 2000        // Connect and Browser.close response
+#define CLOSE_POLL_INTERVAL_MS 50        // Child processes still in the job after the browser exited
+
+// Process telemetry - job members sampled into fixed-size rings
+#define TELEMETRY_INTERVAL_MS 5000
+#define TELEMETRY_PROCESS_RING 4096      // Process samples kept, the oldest are overwritten
+#define TELEMETRY_JOB_RING 1024          // Job samples kept
+#define TELEMETRY_MAX_PROCESSES 512      // Job members sampled per sweep, whole pool
+#define TELEMETRY_TOP_PROCESSES 5        // Per instance in the tray
+#define TELEMETRY_COMMAND_LINE_MAX (32 * 1024)
+#define PROCESS_COMMAND_LINE_INFORMATION 60  // PROCESSINFOCLASS value, Windows 8.1 and later
+
+// Chrome process roles, from the --type switch of the command line
+#define CHROME_PROCESS_UNKNOWN 0
+#define CHROME_PROCESS_BROWSER 1
+#define CHROME_PROCESS_RENDERER 2
+#define CHROME_PROCESS_EXTENSION 3
+#define CHROME_PROCESS_GPU 4
+#define CHROME_PROCESS_UTILITY 5
+#define CHROME_PROCESS_CRASHPAD 6
+
+// Job member PIDs for the window hook - open addressing, power of two
+#define JOB_PROCESS_SET_SIZE 4096
+
+// Chrome top-level windows, tracked from show/destroy events
+#define CHROME_WINDOW_MAX 256
+#define CHROME_WINDOW_CLASS L"Chrome_WidgetWin_1"
+#define BRING_TARGET_TIMEOUT_MS 3000
+#define PAGE_MENU_URL_MAX 80
+
+// Window hook benchmark (--benchmark-hook)
+#define HOOK_BENCHMARK_EVENTS 20000      // Show events raised by the storm thread
+#define HOOK_BENCHMARK_MEMBERS 256       // Fake job members in the PID set
+
+// Log file, next to the extracted WebView2 loader
+#define LOG_FILE_NAME L"ChromeDevLauncher.log"
+#define LOG_MAX_BYTES (1024 * 1024)       // Then rotated to .old
+#define LOG_LINE_MAX 1024
+
+// Profile location benchmark (--benchmark-profile[=URL])
+#define PROFILE_BENCHMARK_PORT 49223
+#define PROFILE_BENCHMARK_ROUNDS 3
+#define PROFILE_BENCHMARK_TIMEOUT_MS 30000
+#define PROFILE_BENCHMARK_URL "https://example.com/"
+#define PROFILE_BENCHMARK_URL_MAX 512
+
+#ifndef FSCTL_DUPLICATE_EXTENTS_TO_FILE
+#define FSCTL_DUPLICATE_EXTENTS_TO_FILE 0x00098344
+#endif
+#ifndef FILE_SUPPORTS_BLOCK_REFCOUNTING
+#define FILE_SUPPORTS_BLOCK_REFCOUNTING 0x08000000
+#endif
+
+// Profile cache janitor (Configuration.cacheCapMB index)
+#define CACHE_CLASS_HTTP 0           // Default\Cache
+#define CACHE_CLASS_CODE 1           // Default\Code Cache
+#define CACHE_CLASS_GPU 2            // GPUCache and shader caches
+#define CACHE_CLASS_CACHE_STORAGE 3  // Service Worker CacheStorage
+#define CACHE_CLASS_COUNT 4
+
+// CDP liveness - browser-level WebSocket session with pings
+#define CDP_PING_INTERVAL_MS 2000
+#define CDP_PING_DEADLINE_MS 1000
+#define CDP_RECONNECT_DELAY_MS 500
+
+// CDP broker - agents share one browser-level connection per Chrome
+#define BROKER_LISTEN_ADDRESS "0.0.0.0"
+
+// Worker task queue
+#define TASK_WORKER_COUNT 3
+#define TASK_SHUTDOWN_TIMEOUT_MS 10000
+
+// Chrome lifecycle tasks (Task.param = CHROME_TASK_PARAM(kind, instance index))
+#define CHROME_TASK_START 0     // Set up forwards (unless already up) and launch
+#define CHROME_TASK_STOP 1      // Terminate only (pool restart, shrink, standby off)
+#define CHROME_TASK_RELAUNCH 2  // Chrome exited on its own - start again if the path is valid
+#define CHROME_TASK_FORWARDS 3  // Rebuild forwards only - Chrome keeps running (pool-wide)
+#define CHROME_TASK_FAILOVER 4  // Chrome exited - adopt the hot standby in its place
+#define CHROME_TASK_PARAM(kind, index) ((LONG_PTR)(kind) | ((LONG_PTR)(index) << 8))
+#define CHROME_TASK_KIND(param) ((int)((param) & 0xFF))
+#define CHROME_TASK_INSTANCE(param) ((int)((param) >> 8))
+#define CHROME_RELAUNCH_DELAY_MS 500
+
+// Built-in relay
+#define RELAY_BUFFER_SIZE 16384
+#define RELAY_MIN_WORKERS 2
+#define RELAY_MAX_WORKERS 8
+#define RELAY_KEY_IO 1
+#define RELAY_KEY_SHUTDOWN 0
+#define RELAY_DIR_UPSTREAM 0    // Agent -> Chrome
+#define RELAY_DIR_DOWNSTREAM 1  // Chrome -> agent
+#define RELAY_ADDR_LEN (sizeof(struct sockaddr_in) + 16)
+#define RELAY_DRAIN_TIMEOUT_MS 1000
 
 // ============================================================================
 // Data Structures
@@ -83,27 +278,344 @@
 
 typedef struct {
     wchar_t chromePath[MAX_PATH];
-    int debugPort;
+    int debugPort;            // Port of the first instance; instance i uses debugPort + i
+    int instanceCount;        // Chrome instances in the pool (1..MAX_INSTANCES)
     wchar_t connectAddress[64];
     int statusCheckInterval;  // seconds
+    int forwardMode;          // FORWARD_MODE_*
+    BOOL hotStandby;          // Keep a prewarmed Chrome ready to replace one that exits
+    BOOL goldenProfile;       // Launch every session on a fresh clone of a prepared profile
+    wchar_t memoryProfilePath[MAX_PATH];  // Memory-backed root for profiles (RAM disk), empty = %TEMP%
+    int jobMemoryMB;          // Committed memory of one Chrome's process tree, 0 = unlimited
+    int processMemoryMB;      // Committed memory of each Chrome process, 0 = unlimited
+    int cpuRatePercent;       // Hard cap on one Chrome's share of all CPUs, 0 = unlimited
+    int activeProcessLimit;   // Processes one Chrome may run at once, 0 = unlimited
+    BOOL restartOnLimit;      // Relaunch a Chrome whose job hit a limit
+    int closeTimeout;         // seconds Chrome gets to exit after Browser.close, 0 = terminate right away
+    int flagPreset;           // FLAG_PRESET_*
+    wchar_t extraArgs[CHROME_EXTRA_ARGS_MAX];  // Appended to the Chrome command line as typed
+    BOOL headless;            // --headless=new: no windows, so no hiding hook
+    int brokerPort;           // CDP broker agents share the pool through, 0 = off
+    int contextPoolSize;      // Browser contexts the broker keeps ready per Chrome, 0 = off
+    int tabPoolSize;          // Loaded tabs the broker keeps ready per Chrome, 0 = off
+    wchar_t tabPoolUrls[CDP_BROKER_TAB_URL_LIST_MAX];  // Start URLs of those tabs, whitespace-separated
+    int cacheCapMB[CACHE_CLASS_COUNT];  // Per cache class (CACHE_CLASS_*), 0 = unlimited
 } Configuration;
 
+struct RelayListener;
+
 typedef struct {
     char listenIP[16];
-    int listenPort;
+    int listenPort;                // Pool port agents connect to
+    int connectPort;               // Port of the Chrome serving it (differs after a failover)
     BOOL active;
+    int backend;                   // FORWARD_BACKEND_* that created the forward
+    int mode;                      // FORWARD_MODE_* it was created under, for teardown
+    int failures;                  // Attempts that failed in a row
+    ULONGLONG retryTick;           // When an inactive entry is due another attempt
+    struct RelayListener* relay;   // Set when backend == FORWARD_BACKEND_RELAY
 } PortForwardEntry;
 
+// Built-in relay: one outstanding operation per direction of a connection
+typedef enum {
+    RELAY_OP_ACCEPT,
+    RELAY_OP_CONNECT,
+    RELAY_OP_RECV,
+    RELAY_OP_SEND
+} RelayOp;
+
+typedef struct {
+    OVERLAPPED ov;                  // Must be first - completions are mapped back from it
+    RelayOp op;
+    struct RelayConnection* conn;   // NULL for accept operations
+    int direction;                  // RELAY_DIR_*
+    DWORD length;                   // Bytes received and waiting to be sent
+    DWORD sent;                     // Bytes of length already sent
+    char buffer[RELAY_BUFFER_SIZE];
+} RelayIo;
+
+typedef struct RelayConnection {
+    struct RelayListener* listener;
+    struct RelayConnection* prev;
+    struct RelayConnection* next;
+    SOCKET client;
+    SOCKET upstream;
+    struct sockaddr_in upstreamAddr;  // Copy of the listener's, for ConnectEx
+    volatile LONG refCount;         // One per pending operation
+    volatile LONG closed;
+    volatile LONG eofCount;         // Both directions half-closed = done
+    RelayIo io[2];                  // Indexed by RELAY_DIR_*
+} RelayConnection;
+
+typedef struct RelayListener {
+    SOCKET sock;
+    SOCKET acceptSock;
+    char listenIP[16];
+    int listenPort;
+    struct sockaddr_in upstream;    // Guarded by upstreamLock (failover repoints it)
+    SRWLOCK upstreamLock;
+    volatile LONG refCount;         // Owner + pending accept + live connections
+    volatile LONG closed;
+    CRITICAL_SECTION lock;          // Guards the connection list
+    RelayConnection* connections;
+    RelayIo acceptIo;               // buffer receives the AcceptEx addresses
+    volatile LONG64 bytesUp;
+    volatile LONG64 bytesDown;
+    volatile LONG connectionsActive;
+    volatile LONG connectionsTotal;
+} RelayListener;
+
 typedef struct {
-    BOOL chromeApiResponding;
     BOOL portForwardsActive;
     int activeForwardCount;
-    char chromeVersion[64];                // Chrome version string
     wchar_t statusLine1[MAX_STATUS_TEXT];  // Main status
     wchar_t statusLine2[MAX_STATUS_TEXT];  // API status
     wchar_t statusLine3[MAX_STATUS_TEXT];  // Ports status
+    wchar_t statusLine4[MAX_STATUS_TEXT];  // Abnormal exits (empty if none)
+    wchar_t statusLine5[MAX_STATUS_TEXT];  // Hot standby (empty if disabled)
+    wchar_t statusLine6[MAX_STATUS_TEXT];  // Job limits hit (empty if none)
+    double forwardSetupMs;                 // Duration of the last SetupPortForwards
+    int failoverCount;                     // Exits absorbed by the hot standby
+    double lastFailoverMs;                 // Exit noticed to forwards re-pointed
+    unsigned long long lastFailoverUs;     // CdpNowUs() when that exit was noticed
+    int lastFailoverInstance;              // Pool slot the standby took over
+    double goldenColdStartMs;              // Launch to DevTools listening on an empty profile
+    double lastCloneMs;                    // Last golden profile clone
+    int lastCloneLinked;                   // ... files hardlinked
+    int lastCloneBlockCloned;              // ... files block cloned (copy-on-write)
+    int lastCloneCopied;                   // ... files copied
+    wchar_t profileRoot[MAX_PATH];         // Directory the profiles live in (see ResetInstanceHomes)
+    BOOL profileInMemory;                  // profileRoot is the memory-backed location
+    BOOL profileFallback;                  // A memory-backed location is configured but unusable
 } StatusInfo;
 
+// One Chrome of the pool, or the hot standby. Process fields are written by
+// lifecycle tasks under lock; health fields are only touched on the UI thread.
+// Port and profile directory travel with the browser: a failover swaps them
+// between the instance and the standby.
+typedef struct {
+    int index;
+    int debugPort;                         // Port Chrome listens on (see ResetInstanceHomes)
+    wchar_t profileDir[MAX_PATH];
+    SRWLOCK lock;                          // Serializes this instance's lifecycle tasks
+    HANDLE hJob;
+    HANDLE hProcess;
+    DWORD pid;
+    volatile LONG generation;              // Completion key of the current job
+    BOOL running;
+    unsigned long long launchUs;
+    int tasksPending;                      // Lifecycle tasks queued for this instance
+    BOOL cacheTrimmed;                     // Janitor ran since Chrome last used the profile
+
+    // Readiness: "running" means the process exists, "ready" that DevTools listens
+    BOOL ready;
+    HANDLE hReadyWatchThread;
+    HANDLE hReadyWatchStop;
+    volatile unsigned long long readyAtUs;
+
+    // Health
+    BOOL apiResponding;
+    char version[64];                      // Chrome version string
+    unsigned long long probeLatencyUs;     // Duration of the last successful API probe
+    double timeToReadyMs;                  // Launch to DevTools listening (0 = not yet)
+    int cdpLinkState;                      // CDP_LINK_* from the liveness monitor
+    int targetCount;                       // Targets reported by target discovery
+    unsigned long long cdpPingRttUs;
+    int abnormalExitCount;                 // Chrome processes that crashed since launch
+    DWORD lastAbnormalExitPID;
+    SYSTEMTIME lastAbnormalExitTime;
+    int limitHitCount;                     // Job limit notifications since the launcher started
+    int lastLimit;                         // JOB_LIMIT_* of the last one
+    DWORD lastLimitPID;                    // 0 if the notification names no process
+    SYSTEMTIME lastLimitTime;
+    ULONGLONG lastLimitTick;
+    ULONGLONG lastLimitLogTick;
+    BOOL limitLookupPending;               // The page of the last logged hit is being looked up
+    CdpTargetInfo targets[CDP_MAX_TARGETS];  // Copy of the liveness monitor's target list
+
+    // Keep-alive connection to the DevTools HTTP endpoint. Only used by the
+    // status probe task, of which at most one is in flight.
+    CdpHttpClient http;
+
+    // CDP liveness monitor (own thread, see cdp.c)
+    CdpMonitor monitor;
+    HANDLE hMonitorThread;
+    char monitorHost[CDP_HOST_MAX];        // Endpoint the monitor was last pointed at (UI thread)
+    int monitorPort;
+} ChromeInstance;
+
+// Status a worker measured; it reaches g_status on the UI thread when its
+// task completes (negative = not measured by this task)
+typedef struct {
+    double forwardSetupMs;
+    double goldenColdStartMs;
+    double cloneMs;
+    int cloneLinked;
+    int cloneBlockCloned;
+    int cloneCopied;
+} TaskStatus;
+
+// Worker task: run() executes on a worker thread, complete() on the UI thread
+typedef struct Task Task;
+typedef void (*TaskRunProc)(Task* task);
+typedef void (*TaskCompleteProc)(Task* task);
+
+struct Task {
+    TaskRunProc run;
+    TaskCompleteProc complete;  // Optional
+    LONG_PTR param;
+    LONG_PTR result;
+    void* data;                 // Heap block owned by the task
+    Configuration config;       // g_config when queued - run() reads this, never g_config
+    TaskStatus status;          // Written by run(), applied before complete()
+};
+
+// Result of a Chrome API probe, filled on a worker thread
+typedef struct {
+    BOOL responding;
+    char version[64];
+    unsigned long long latencyUs;
+    unsigned long long completedUs;  // CdpNowUs() when the response arrived
+} StatusProbeResult;
+
+// Outcome of a CHROME_TASK_FAILOVER, filled on a worker thread
+typedef struct {
+    unsigned long long exitUs;       // CdpNowUs() when the exit was noticed
+    unsigned long long repointedUs;  // Forwards point at the former standby
+    BOOL adopted;                    // FALSE: no usable standby, relaunched instead
+    BOOL standbyReady;               // The standby's DevTools was already listening
+} FailoverResult;
+
+// A class of disposable profile caches with its own size cap
+typedef struct {
+    const wchar_t* name;                          // Shown in the tray
+    const wchar_t* regValue;
+    const char* jsonKey;
+    int defaultCapMB;
+    const wchar_t* paths[MAX_CACHE_CLASS_PATHS];  // Relative to the profile directory
+    BOOL evictDirectories;                        // Evict whole subdirectories (one per origin)
+} CacheClass;
+
+// Outcome of the last janitor run, written by lifecycle workers
+typedef struct {
+    volatile LONG64 reclaimedTotal;               // All runs since start
+    ULONGLONG lastReclaimed;
+    double lastWalkMs;
+    volatile LONG runs;
+    ULONGLONG classBytes[CACHE_CLASS_COUNT];      // Per class after the last run
+} CacheJanitorStats;
+
+// Liveness monitor state handed to the UI thread (WM_CDP_LIVENESS)
+typedef struct {
+    int instance;
+    int state;
+    int targetCount;
+    unsigned long long pingRttUs;
+    char browser[64];
+    CdpTargetInfo targets[CDP_MAX_TARGETS];
+} LivenessSnapshot;
+
+// One job member at one telemetry sweep
+typedef struct {
+    ULONGLONG time;                  // FILETIME (UTC) of the sweep
+    int instance;
+    DWORD pid;
+    int type;                        // CHROME_PROCESS_*
+    SIZE_T workingSet;
+    SIZE_T privateBytes;
+    ULONGLONG cpuTime;               // Kernel + user, 100 ns units
+    double cpuPercent;               // Share of all CPUs since the previous sweep
+    ULONGLONG readBytes;
+    ULONGLONG writeBytes;
+    char targetId[64];               // CDP target the process renders, if known
+} ProcessSample;
+
+// Job totals at one sweep; they include processes that already exited
+typedef struct {
+    ULONGLONG time;
+    int instance;
+    DWORD activeProcesses;
+    DWORD totalProcesses;
+    ULONGLONG cpuTime;
+    double cpuPercent;
+    ULONGLONG readBytes;
+    ULONGLONG writeBytes;
+    SIZE_T peakJobMemory;
+} JobSample;
+
+// Counters of the previous sweep, for rates (telemetry worker only)
+typedef struct {
+    DWORD pid;
+    ULONGLONG createTime;            // Tells a reused PID apart
+    int type;
+    ULONGLONG cpuTime;
+    ULONGLONG time;
+} TrackedProcess;
+
+// Sample rings: memory stays constant however long the launcher runs
+typedef struct {
+    SRWLOCK lock;                    // Guards the rings and pageTargets
+    ProcessSample processes[TELEMETRY_PROCESS_RING];
+    ULONG processCount;              // Samples written so far; slot = count % ring size
+    JobSample jobs[TELEMETRY_JOB_RING];
+    ULONG jobCount;
+    ULONGLONG lastSweep;             // time of the newest samples, 0 before the first sweep
+    char pageTargets[STANDBY_INDEX + 1][64];  // Sole page target of an instance, "" if none or several
+
+    // Telemetry worker only (one sweep in flight)
+    TrackedProcess tracked[TELEMETRY_MAX_PROCESSES];
+    int trackedCount;
+    ULONGLONG jobCpuTime[STANDBY_INDEX + 1];
+    ULONGLONG jobTime[STANDBY_INDEX + 1];
+    LONG jobGeneration[STANDBY_INDEX + 1];
+} TelemetryStore;
+
+// PIDs of every process in a Chrome job, so the window hook rejects other
+// processes with one lookup. Written by the job monitor, read by any thread.
+typedef struct {
+    DWORD pid;                       // 0 = free slot
+    LONG generation;                 // Job the process belongs to
+} JobProcessEntry;
+
+typedef struct {
+    SRWLOCK lock;
+    JobProcessEntry entries[JOB_PROCESS_SET_SIZE];
+    int count;
+    BOOL overflowLogged;
+} JobProcessSet;
+
+// A Chrome top-level window (UI thread)
+typedef struct {
+    HWND hwnd;
+    DWORD pid;                       // Browser process that owns it
+} ChromeWindow;
+
+// Tray "Pages": a target to bring to front, resolved to its window bounds on a worker
+typedef struct {
+    int instance;
+    int port;
+    char targetId[64];
+    BOOL found;                      // Bounds below are valid
+    long left, top, width, height;   // DIPs, from Browser.getWindowForTarget
+} BringTargetRequest;
+
+// A job limit notification handed to the UI thread (WM_CHROME_LIMIT)
+typedef struct {
+    LONG generation;
+    int limit;                       // JOB_LIMIT_*
+    DWORD pid;                       // Process that hit it, 0 if not reported
+} JobLimitEvent;
+
+// A limit hit to log once its process is matched to a page on a worker
+typedef struct {
+    int instance;
+    LONG generation;
+    int port;
+    int limit;                       // JOB_LIMIT_*
+    DWORD pid;
+    char targetId[64];               // Page the process renders, empty if unknown
+} JobLimitLookup;
+
 // ============================================================================
 // Global Variables
 // ============================================================================
@@ -116,23 +628,103 @@ static NOTIFYICONDATAW g_nid = {0};
 // Configuration
 static Configuration g_config = {0};
 
-// Chrome process
-static HANDLE g_hJob = NULL;
-static HANDLE g_hChromeProcess = NULL;
-static DWORD g_dwChromePID = 0;
+// Chrome pool - the first g_config.instanceCount entries are in use, followed
+// by the hot standby and the golden-profile preparation slot
+static ChromeInstance g_instances[MAX_INSTANCES + 2] = {0};
+static ChromeInstance* const g_standby = &g_instances[STANDBY_INDEX];
+static ChromeInstance* const g_golden = &g_instances[GOLDEN_INDEX];
+static HANDLE g_hJobPort = NULL;              // Receives job notifications for every instance
+static HANDLE g_hJobMonitorThread = NULL;
+static volatile LONG g_jobGeneration = 0;     // Last completion key handed out
 
 // Port forwards
-static PortForwardEntry g_portForwards[MAX_INTERFACES] = {0};
+// g_forwardLock guards the published array (held briefly, shared by readers);
+// g_forwardOpLock serializes setup/cleanup/reconcile, which may block on netsh
+static PortForwardEntry g_portForwards[MAX_FORWARDS] = {0};
 static int g_portForwardCount = 0;
-
-// Temp directory
-static wchar_t g_szTempDir[MAX_PATH] = {0};
+static SRWLOCK g_forwardLock = SRWLOCK_INIT;
+static SRWLOCK g_forwardOpLock = SRWLOCK_INIT;
+static BOOL g_forwardsEnabled = FALSE;      // Between SetupPortForwards and CleanupAllPortForwards
+static HANDLE g_hAddressNotify = NULL;
+static volatile LONG g_reconcileRequests = 0;
+
+// Built-in relay engine
+static HANDLE g_hRelayPort = NULL;
+static HANDLE g_relayWorkers[RELAY_MAX_WORKERS] = {0};
+static int g_relayWorkerCount = 0;
+static volatile LONG g_relayLiveObjects = 0;  // Listeners + connections not yet freed
+static LPFN_ACCEPTEX g_pfnAcceptEx = NULL;
+static LPFN_CONNECTEX g_pfnConnectEx = NULL;
+
+// Profile cache janitor. Simple-cache backends (HTTP, code, GPU) rebuild their
+// index from whatever entries remain; CacheStorage keeps an index per origin,
+// so it loses whole origins.
+static const CacheClass g_cacheClasses[CACHE_CLASS_COUNT] = {
+    { L"Cache", L"CacheCapMB", "cacheCapMB", 512, { L"Default\\Cache" }, FALSE },
+    { L"Code Cache", L"CodeCacheCapMB", "codeCacheCapMB", 256, { L"Default\\Code Cache" }, FALSE },
+    { L"GPU caches", L"GpuCacheCapMB", "gpuCacheCapMB", 128,
+      { L"Default\\GPUCache", L"GrShaderCache", L"ShaderCache" }, FALSE },
+    { L"CacheStorage", L"CacheStorageCapMB", "cacheStorageCapMB", 512,
+      { L"Default\\Service Worker\\CacheStorage" }, TRUE },
+};
+static CacheJanitorStats g_janitor = {0};
+
+// Chrome switches per FLAG_PRESET_*
+static const wchar_t* const g_flagPresets[FLAG_PRESET_COUNT] = {
+    L"",
+    // Timers, rendering and IPC of background and occluded tabs run unthrottled
+    L"--disable-background-timer-throttling --disable-renderer-backgrounding "
+    L"--disable-backgrounding-occluded-windows --disable-ipc-flooding-protection "
+    L"--disable-hang-monitor",
+    // Tabs share a few renderers; no extensions, background fetches or large V8 heaps
+    L"--renderer-process-limit=4 --disable-extensions --disable-background-networking "
+    L"--js-flags=--max-old-space-size=512",
+};
 
 // Status
 static StatusInfo g_status = {0};
-static BOOL g_chromeRunning = FALSE;
 static BOOL g_chromeHidden = TRUE;  // Start hidden, restore on tray double-click
-static HWINEVENTHOOK g_hWinEventHook = NULL;  // Hook for real-time window detection
+static HWINEVENTHOOK g_hWinEventHook = NULL;  // All processes - only while a golden profile is prepared
+static HWINEVENTHOOK g_processHooks[STANDBY_INDEX + 1] = {0};  // Per browser process (UI thread)
+static DWORD g_processHookPids[STANDBY_INDEX + 1] = {0};
+static JobProcessSet g_jobProcesses = {0};
+static ChromeWindow g_chromeWindows[CHROME_WINDOW_MAX];    // Grouped by pid (UI thread)
+static int g_chromeWindowCount = 0;
+
+// Worker task queue
+static HANDLE g_hTaskPort = NULL;
+static HANDLE g_taskWorkers[TASK_WORKER_COUNT] = {0};
+static int g_taskWorkerCount = 0;
+static volatile BOOL g_taskQueueStopping = FALSE;
+
+// Lifecycle tasks (launch/terminate) are serialized per instance by
+// ChromeInstance.lock; the counters below are only touched on the UI thread
+static int g_lifecycleTasksPending = 0;
+static BOOL g_statusProbePending = FALSE;
+static BOOL g_poolRestartPending = FALSE;   // Pool stopping; StartChrome once it is down
+static BOOL g_poolRestartRebuild = FALSE;   // ... and rebuild the forwards then
+
+// Status probe scheduler (UI thread only)
+static int g_probeMode = PROBE_MODE_STARTUP;
+static UINT g_probeIntervalMs = PROBE_FAST_INTERVAL_MS;
+static int g_probeBurstLeft = 0;
+
+// Winsock for the per-instance DevTools clients
+static BOOL g_winsockStarted = FALSE;
+
+// CDP broker; its thread owns all of it. Endpoints and start URLs are handed
+// over, the UI thread keeps what it last handed over.
+static CdpBroker g_broker;
+static HANDLE g_hBrokerThread = NULL;
+static CdpEndpoint g_brokerUpstreams[CDP_BROKER_MAX_UPSTREAMS];
+static char g_brokerTabUrls[CDP_BROKER_TAB_URL_LIST_MAX];
+
+// Log file (any thread)
+static SRWLOCK g_logLock = SRWLOCK_INIT;
+
+// Process telemetry
+static TelemetryStore g_telemetry = {0};
+static BOOL g_telemetryPending = FALSE;     // UI thread only
 
 // ============================================================================
 // WebView2 COM interface definitions (minimal vtable approach)
@@ -375,6 +967,7 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
 static BOOL EnforceSingleInstance(void);
 static BOOL IsRunningAsAdmin(void);
 static void SelfElevate(void);
+static void LogMessage(const wchar_t* format, ...);
 
 // Configuration
 static BOOL LoadConfigFromRegistry(Configuration* config);
@@ -394,21 +987,102 @@ static void ShowContextMenu(HWND hwnd);
 static int EnumerateNonLoopbackInterfaces(PortForwardEntry* entries, int maxCount);
 static BOOL AddPortForward(const char* listenIP, int listenPort, const char* connectIP, int connectPort);
 static BOOL RemovePortForward(const char* listenIP, int listenPort);
-static void SetupPortForwards(void);
+static void SetupPortForwards(const Configuration* config, TaskStatus* status);
+static void EnsurePortForwards(const Configuration* config, TaskStatus* status);
 static void CleanupAllPortForwards(void);
+static void RunForwardBenchmark(void);
+static void RunProfileBenchmark(const char* url);
+static void RequestForwardReconcile(void);
+static void RegisterAddressChangeNotification(void);
+static void UnregisterAddressChangeNotification(void);
+
+// Built-in relay
+static BOOL RelayStartup(void);
+static void RelayShutdown(void);
+static RelayListener* RelayStartListener(const char* listenIP, int listenPort,
+                                         const char* connectIP, int connectPort);
+static void RelayStopListener(RelayListener* listener);
+
+// Worker task queue
+static BOOL StartTaskQueue(void);
+static void StopTaskQueue(void);
+static BOOL QueueTask(TaskRunProc run, TaskCompleteProc complete, LONG_PTR param, void* data);
+static void CompleteTask(Task* task);
+
+// Job monitor
+static BOOL StartJobMonitor(void);
+static void StopJobMonitor(void);
+static void ConfigureJobLimits(HANDLE hJob, const Configuration* config);
+
+// Telemetry
+static void QueueTelemetrySweep(void);
+static void PublishPageTarget(const ChromeInstance* inst);
+static void ExportTelemetry(HWND hwnd);
+static void FormatLauncherCpu(wchar_t* buffer, size_t size);
+static const wchar_t* GetChromeProcessTypeName(int type);
+static const char* FindTargetUrl(const ChromeInstance* inst, const char* targetId);
+
+// Chrome pool
+static ChromeInstance* FindInstanceByGeneration(LONG generation);
+static int CountRunningInstances(void);
+static int CountReadyInstances(void);
+static BOOL IsProcessInPool(DWORD pid);
+static BOOL IsProcessInBackground(DWORD pid);
+static BOOL IsStandbyConfigured(void);
+static BOOL GetProfileRoot(const wchar_t* memoryPath, wchar_t* root, size_t rootLen);
+static BOOL ResetInstanceHomes(void);
+
+// Readiness watch
+static void StartReadyWatch(ChromeInstance* inst);
+static void StopReadyWatch(ChromeInstance* inst);
+
+// CDP liveness
+static BOOL StartLivenessMonitor(ChromeInstance* inst);
+static void StopLivenessMonitor(ChromeInstance* inst);
+static void SyncLivenessMonitors(void);
+static void SyncCdpBroker(void);
+static void FormatBrokerStatus(wchar_t* buffer, size_t size);
+static void FormatContextPoolStatus(wchar_t* buffer, size_t size);
+static void FormatTabPoolStatus(wchar_t* buffer, size_t size);
 
 // Chrome
-static BOOL CreateTempDirectory(void);
-static void RemoveTempDirectory(void);
-static BOOL LaunchChrome(void);
-static void TerminateChrome(void);
-static void RestartChrome(void);
+static void StartChrome(void);
+static void QueueChromeLifecycleTask(int kind, int index);
+static void QueueChromeLifecycleTaskWithData(int kind, int index, void* data);
+static BOOL CreateTempDirectory(ChromeInstance* inst);
+static void RemoveTempDirectory(ChromeInstance* inst);
+static BOOL PrepareGoldenProfile(const Configuration* config, TaskStatus* status);
+static BOOL CloneGoldenProfile(ChromeInstance* inst, TaskStatus* status);
+static void GetDevToolsEndpoint(const Configuration* config, char* host, size_t hostLen);
+static BOOL LaunchChrome(ChromeInstance* inst, const Configuration* config, TaskStatus* status);
+static void TerminateChrome(ChromeInstance* inst);
+static BOOL RequestBrowserClose(ChromeInstance* inst);
+static void TerminateAllChrome(void);
+static void RestartChrome(BOOL rebuildForwards);
+static void RebuildPortForwards(void);
 static void InstallWinEventHook(void);
 static void RemoveWinEventHook(void);
+static void RemoveProcessHook(int index);
+static void SyncWinEventHooks(void);
+static void RemoveAllWinEventHooks(void);
+static void RunHookBenchmark(void);
+static LONG LookupJobProcess(DWORD pid);
+static void AddJobProcess(DWORD pid, LONG generation);
+static void RemoveJobProcesses(LONG generation);
 
 // Status
-static BOOL CheckChromeApiStatus(void);
+static void ScheduleStatusProbe(UINT delayMs);
+static void SetProbeMode(int mode);
+static void OnStatusProbeResult(BOOL success);
+static BOOL CheckChromeApiStatus(ChromeInstance* inst, const Configuration* config, char* version,
+                                 size_t versionLen, unsigned long long* latencyUs);
+static void RefreshStatusText(void);
+static void FormatInstanceSummary(const ChromeInstance* inst, wchar_t* buffer, size_t size);
 static void BringChromeToFront(void);
+static void BringTargetToFront(int instance, int target);
+static void OpenDevToolsInspector(void);
+static void ShowChrome(void);
+static void ArmForwardRetry(void);
 static int CountActivePortForwards(void);
 static void UpdateStatus(void);
 
@@ -481,8 +1155,29 @@ static void SelfElevate(void) {
 static void SetDefaultConfig(Configuration* config) {
     config->chromePath[0] = L'\0';  // Empty - must be configured
     config->debugPort = 9222;
+    config->instanceCount = 1;
     wcscpy_s(config->connectAddress, 64, L"127.0.0.1");
     config->statusCheckInterval = 60;
+    config->forwardMode = FORWARD_MODE_RELAY;
+    config->hotStandby = FALSE;
+    config->goldenProfile = FALSE;
+    config->memoryProfilePath[0] = L'\0';
+    config->jobMemoryMB = 0;
+    config->processMemoryMB = 0;
+    config->cpuRatePercent = 0;
+    config->activeProcessLimit = 0;
+    config->restartOnLimit = FALSE;
+    config->closeTimeout = 5;
+    config->flagPreset = FLAG_PRESET_NONE;
+    config->extraArgs[0] = L'\0';
+    config->headless = FALSE;
+    config->brokerPort = 0;
+    config->contextPoolSize = 0;
+    config->tabPoolSize = 0;
+    config->tabPoolUrls[0] = L'\0';
+    for (int i = 0; i < CACHE_CLASS_COUNT; i++) {
+        config->cacheCapMB[i] = g_cacheClasses[i].defaultCapMB;
+    }
 }
 
 static BOOL LoadConfigFromRegistry(Configuration* config) {
@@ -507,6 +1202,14 @@ static BOOL LoadConfigFromRegistry(Configuration* config) {
     RegQueryValueExW(hKey, REG_VALUE_DEBUG_PORT, NULL, &dataType,
                      (LPBYTE)&config->debugPort, &dataSize);
 
+    // Instance Count
+    dataSize = sizeof(config->instanceCount);
+    RegQueryValueExW(hKey, REG_VALUE_INSTANCE_COUNT, NULL, &dataType,
+                     (LPBYTE)&config->instanceCount, &dataSize);
+    if (config->instanceCount < 1 || config->instanceCount > MAX_INSTANCES) {
+        config->instanceCount = 1;
+    }
+
     // Connect Address
     dataSize = sizeof(config->connectAddress);
     RegQueryValueExW(hKey, REG_VALUE_CONNECT_ADDRESS, NULL, &dataType,
@@ -517,6 +1220,96 @@ static BOOL LoadConfigFromRegistry(Configuration* config) {
     RegQueryValueExW(hKey, REG_VALUE_STATUS_INTERVAL, NULL, &dataType,
                      (LPBYTE)&config->statusCheckInterval, &dataSize);
 
+    // Port Forwarding Mode
+    dataSize = sizeof(config->forwardMode);
+    RegQueryValueExW(hKey, REG_VALUE_FORWARD_MODE, NULL, &dataType,
+                     (LPBYTE)&config->forwardMode, &dataSize);
+    if (config->forwardMode < FORWARD_MODE_RELAY || config->forwardMode > FORWARD_MODE_NETSH_BATCH) {
+        config->forwardMode = FORWARD_MODE_RELAY;
+    }
+
+    // Hot Standby
+    dataSize = sizeof(config->hotStandby);
+    RegQueryValueExW(hKey, REG_VALUE_HOT_STANDBY, NULL, &dataType,
+                     (LPBYTE)&config->hotStandby, &dataSize);
+
+    // Golden Profile
+    dataSize = sizeof(config->goldenProfile);
+    RegQueryValueExW(hKey, REG_VALUE_GOLDEN_PROFILE, NULL, &dataType,
+                     (LPBYTE)&config->goldenProfile, &dataSize);
+
+    // Memory-Backed Profile Location
+    dataSize = sizeof(config->memoryProfilePath);
+    RegQueryValueExW(hKey, REG_VALUE_MEMORY_PROFILE_PATH, NULL, &dataType,
+                     (LPBYTE)config->memoryProfilePath, &dataSize);
+    config->memoryProfilePath[MAX_PATH - 1] = L'\0';
+
+    // Job Limits
+    dataSize = sizeof(config->jobMemoryMB);
+    RegQueryValueExW(hKey, REG_VALUE_JOB_MEMORY, NULL, &dataType,
+                     (LPBYTE)&config->jobMemoryMB, &dataSize);
+    dataSize = sizeof(config->processMemoryMB);
+    RegQueryValueExW(hKey, REG_VALUE_PROCESS_MEMORY, NULL, &dataType,
+                     (LPBYTE)&config->processMemoryMB, &dataSize);
+    dataSize = sizeof(config->cpuRatePercent);
+    RegQueryValueExW(hKey, REG_VALUE_CPU_RATE, NULL, &dataType,
+                     (LPBYTE)&config->cpuRatePercent, &dataSize);
+    dataSize = sizeof(config->activeProcessLimit);
+    RegQueryValueExW(hKey, REG_VALUE_ACTIVE_PROCESS_LIMIT, NULL, &dataType,
+                     (LPBYTE)&config->activeProcessLimit, &dataSize);
+    dataSize = sizeof(config->restartOnLimit);
+    RegQueryValueExW(hKey, REG_VALUE_RESTART_ON_LIMIT, NULL, &dataType,
+                     (LPBYTE)&config->restartOnLimit, &dataSize);
+    if (config->jobMemoryMB < 0) config->jobMemoryMB = 0;
+    if (config->processMemoryMB < 0) config->processMemoryMB = 0;
+    if (config->cpuRatePercent < 0 || config->cpuRatePercent > 100) config->cpuRatePercent = 0;
+    if (config->activeProcessLimit < 0) config->activeProcessLimit = 0;
+
+    // Graceful Close
+    dataSize = sizeof(config->closeTimeout);
+    RegQueryValueExW(hKey, REG_VALUE_CLOSE_TIMEOUT, NULL, &dataType,
+                     (LPBYTE)&config->closeTimeout, &dataSize);
+    if (config->closeTimeout < 0 || config->closeTimeout > CLOSE_TIMEOUT_MAX) config->closeTimeout = 5;
+
+    // Launch Flags
+    dataSize = sizeof(config->flagPreset);
+    RegQueryValueExW(hKey, REG_VALUE_FLAG_PRESET, NULL, &dataType,
+                     (LPBYTE)&config->flagPreset, &dataSize);
+    if (config->flagPreset < 0 || config->flagPreset >= FLAG_PRESET_COUNT) config->flagPreset = FLAG_PRESET_NONE;
+    dataSize = sizeof(config->extraArgs);
+    RegQueryValueExW(hKey, REG_VALUE_EXTRA_ARGS, NULL, &dataType,
+                     (LPBYTE)config->extraArgs, &dataSize);
+    config->extraArgs[CHROME_EXTRA_ARGS_MAX - 1] = L'\0';
+    dataSize = sizeof(config->headless);
+    RegQueryValueExW(hKey, REG_VALUE_HEADLESS, NULL, &dataType,
+                     (LPBYTE)&config->headless, &dataSize);
+
+    // CDP Broker
+    dataSize = sizeof(config->brokerPort);
+    RegQueryValueExW(hKey, REG_VALUE_BROKER_PORT, NULL, &dataType,
+                     (LPBYTE)&config->brokerPort, &dataSize);
+    if (config->brokerPort < 0 || config->brokerPort > 65535) config->brokerPort = 0;
+    dataSize = sizeof(config->contextPoolSize);
+    RegQueryValueExW(hKey, REG_VALUE_CONTEXT_POOL_SIZE, NULL, &dataType,
+                     (LPBYTE)&config->contextPoolSize, &dataSize);
+    if (config->contextPoolSize < 0 || config->contextPoolSize > CDP_BROKER_POOL_MAX) config->contextPoolSize = 0;
+    dataSize = sizeof(config->tabPoolSize);
+    RegQueryValueExW(hKey, REG_VALUE_TAB_POOL_SIZE, NULL, &dataType,
+                     (LPBYTE)&config->tabPoolSize, &dataSize);
+    if (config->tabPoolSize < 0 || config->tabPoolSize > CDP_BROKER_TAB_POOL_MAX) config->tabPoolSize = 0;
+    dataSize = sizeof(config->tabPoolUrls);
+    RegQueryValueExW(hKey, REG_VALUE_TAB_POOL_URLS, NULL, &dataType,
+                     (LPBYTE)config->tabPoolUrls, &dataSize);
+    config->tabPoolUrls[CDP_BROKER_TAB_URL_LIST_MAX - 1] = L'\0';
+
+    // Cache Caps
+    for (int i = 0; i < CACHE_CLASS_COUNT; i++) {
+        dataSize = sizeof(config->cacheCapMB[i]);
+        RegQueryValueExW(hKey, g_cacheClasses[i].regValue, NULL, &dataType,
+                         (LPBYTE)&config->cacheCapMB[i], &dataSize);
+        if (config->cacheCapMB[i] < 0) config->cacheCapMB[i] = 0;
+    }
+
     RegCloseKey(hKey);
     return TRUE;
 }
@@ -540,6 +1333,10 @@ static BOOL SaveConfigToRegistry(const Configuration* config) {
     RegSetValueExW(hKey, REG_VALUE_DEBUG_PORT, 0, REG_DWORD,
                    (const BYTE*)&config->debugPort, sizeof(config->debugPort));
 
+    // Instance Count
+    RegSetValueExW(hKey, REG_VALUE_INSTANCE_COUNT, 0, REG_DWORD,
+                   (const BYTE*)&config->instanceCount, sizeof(config->instanceCount));
+
     // Connect Address
     RegSetValueExW(hKey, REG_VALUE_CONNECT_ADDRESS, 0, REG_SZ,
                    (const BYTE*)config->connectAddress,
@@ -550,6 +1347,65 @@ static BOOL SaveConfigToRegistry(const Configuration* config) {
                    (const BYTE*)&config->statusCheckInterval,
                    sizeof(config->statusCheckInterval));
 
+    // Port Forwarding Mode
+    RegSetValueExW(hKey, REG_VALUE_FORWARD_MODE, 0, REG_DWORD,
+                   (const BYTE*)&config->forwardMode, sizeof(config->forwardMode));
+
+    // Hot Standby
+    RegSetValueExW(hKey, REG_VALUE_HOT_STANDBY, 0, REG_DWORD,
+                   (const BYTE*)&config->hotStandby, sizeof(config->hotStandby));
+
+    // Golden Profile
+    RegSetValueExW(hKey, REG_VALUE_GOLDEN_PROFILE, 0, REG_DWORD,
+                   (const BYTE*)&config->goldenProfile, sizeof(config->goldenProfile));
+
+    // Memory-Backed Profile Location
+    RegSetValueExW(hKey, REG_VALUE_MEMORY_PROFILE_PATH, 0, REG_SZ,
+                   (const BYTE*)config->memoryProfilePath,
+                   (DWORD)((wcslen(config->memoryProfilePath) + 1) * sizeof(wchar_t)));
+
+    // Job Limits
+    RegSetValueExW(hKey, REG_VALUE_JOB_MEMORY, 0, REG_DWORD,
+                   (const BYTE*)&config->jobMemoryMB, sizeof(config->jobMemoryMB));
+    RegSetValueExW(hKey, REG_VALUE_PROCESS_MEMORY, 0, REG_DWORD,
+                   (const BYTE*)&config->processMemoryMB, sizeof(config->processMemoryMB));
+    RegSetValueExW(hKey, REG_VALUE_CPU_RATE, 0, REG_DWORD,
+                   (const BYTE*)&config->cpuRatePercent, sizeof(config->cpuRatePercent));
+    RegSetValueExW(hKey, REG_VALUE_ACTIVE_PROCESS_LIMIT, 0, REG_DWORD,
+                   (const BYTE*)&config->activeProcessLimit, sizeof(config->activeProcessLimit));
+    RegSetValueExW(hKey, REG_VALUE_RESTART_ON_LIMIT, 0, REG_DWORD,
+                   (const BYTE*)&config->restartOnLimit, sizeof(config->restartOnLimit));
+
+    // Graceful Close
+    RegSetValueExW(hKey, REG_VALUE_CLOSE_TIMEOUT, 0, REG_DWORD,
+                   (const BYTE*)&config->closeTimeout, sizeof(config->closeTimeout));
+
+    // Launch Flags
+    RegSetValueExW(hKey, REG_VALUE_FLAG_PRESET, 0, REG_DWORD,
+                   (const BYTE*)&config->flagPreset, sizeof(config->flagPreset));
+    RegSetValueExW(hKey, REG_VALUE_EXTRA_ARGS, 0, REG_SZ,
+                   (const BYTE*)config->extraArgs,
+                   (DWORD)((wcslen(config->extraArgs) + 1) * sizeof(wchar_t)));
+    RegSetValueExW(hKey, REG_VALUE_HEADLESS, 0, REG_DWORD,
+                   (const BYTE*)&config->headless, sizeof(config->headless));
+
+    // CDP Broker
+    RegSetValueExW(hKey, REG_VALUE_BROKER_PORT, 0, REG_DWORD,
+                   (const BYTE*)&config->brokerPort, sizeof(config->brokerPort));
+    RegSetValueExW(hKey, REG_VALUE_CONTEXT_POOL_SIZE, 0, REG_DWORD,
+                   (const BYTE*)&config->contextPoolSize, sizeof(config->contextPoolSize));
+    RegSetValueExW(hKey, REG_VALUE_TAB_POOL_SIZE, 0, REG_DWORD,
+                   (const BYTE*)&config->tabPoolSize, sizeof(config->tabPoolSize));
+    RegSetValueExW(hKey, REG_VALUE_TAB_POOL_URLS, 0, REG_SZ,
+                   (const BYTE*)config->tabPoolUrls,
+                   (DWORD)((wcslen(config->tabPoolUrls) + 1) * sizeof(wchar_t)));
+
+    // Cache Caps
+    for (int i = 0; i < CACHE_CLASS_COUNT; i++) {
+        RegSetValueExW(hKey, g_cacheClasses[i].regValue, 0, REG_DWORD,
+                       (const BYTE*)&config->cacheCapMB[i], sizeof(config->cacheCapMB[i]));
+    }
+
     RegCloseKey(hKey);
     return TRUE;
 }
@@ -669,6 +1525,21 @@ static void webview_sync_controller_bounds(void) {
 }
 
 // Minimal JSON parser helpers
+// Four hex digits of a \uXXXX escape
+static BOOL json_parse_hex4(const char *p, unsigned long *out) {
+    *out = 0;
+    for (int n = 0; n < 4; n++) {
+        char c = p[n];
+        int digit = (c >= '0' && c <= '9') ? c - '0' :
+                    (c >= 'a' && c <= 'f') ? c - 'a' + 10 :
+                    (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (digit < 0) return FALSE;
+        *out = (*out << 4) | (unsigned long)digit;
+    }
+    return TRUE;
+}
+
+// Unescapes the string value of key into out as UTF-8 (\uXXXX included)
 static BOOL json_get_string(const char *json, const char *key, char *out, size_t outLen) {
     char search[128];
     snprintf(search, sizeof(search), "\"%s\"", key);
@@ -680,7 +1551,54 @@ static BOOL json_get_string(const char *json, const char *key, char *out, size_t
     p++;
     size_t i = 0;
     while (*p && *p != '"' && i < outLen - 1) {
-        out[i++] = *p++;
+        if (*p != '\\') {
+            out[i++] = *p++;
+            continue;
+        }
+        if (!*++p) break;
+
+        char c = *p++;
+        if (c != 'u') {
+            switch (c) {
+                case 'n': out[i++] = '\n'; break;
+                case 'r': out[i++] = '\r'; break;
+                case 't': out[i++] = '\t'; break;
+                case 'b': out[i++] = '\b'; break;
+                case 'f': out[i++] = '\f'; break;
+                default: out[i++] = c; break;  // \" \\ \/
+            }
+            continue;
+        }
+
+        unsigned long code, low;
+        if (!json_parse_hex4(p, &code)) break;
+        p += 4;
+        if (code >= 0xD800 && code <= 0xDBFF && p[0] == '\\' && p[1] == 'u' &&
+            json_parse_hex4(p + 2, &low) && low >= 0xDC00 && low <= 0xDFFF) {
+            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+            p += 6;
+        }
+
+        char utf8[4];
+        size_t bytes = 0;
+        if (code < 0x80) {
+            utf8[bytes++] = (char)code;
+        } else if (code < 0x800) {
+            utf8[bytes++] = (char)(0xC0 | (code >> 6));
+            utf8[bytes++] = (char)(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            utf8[bytes++] = (char)(0xE0 | (code >> 12));
+            utf8[bytes++] = (char)(0x80 | ((code >> 6) & 0x3F));
+            utf8[bytes++] = (char)(0x80 | (code & 0x3F));
+        } else {
+            utf8[bytes++] = (char)(0xF0 | (code >> 18));
+            utf8[bytes++] = (char)(0x80 | ((code >> 12) & 0x3F));
+            utf8[bytes++] = (char)(0x80 | ((code >> 6) & 0x3F));
+            utf8[bytes++] = (char)(0x80 | (code & 0x3F));
+        }
+        if (i + bytes > outLen - 1) break;
+        memcpy(out + i, utf8, bytes);
+        i += bytes;
     }
     out[i] = '\0';
     return TRUE;
@@ -697,6 +1615,17 @@ static BOOL json_get_int(const char *json, const char *key, int *out) {
     return TRUE;
 }
 
+static BOOL json_get_bool(const char *json, const char *key, BOOL *out) {
+    char search[128];
+    snprintf(search, sizeof(search), "\"%s\"", key);
+    const char *p = strstr(json, search);
+    if (!p) return FALSE;
+    p += strlen(search);
+    while (*p == ' ' || *p == ':') p++;
+    *out = (strncmp(p, "true", 4) == 0);
+    return TRUE;
+}
+
 // Escape a wide-char string for safe JSON embedding
 static void json_escape_wstring(const wchar_t *in, wchar_t *out, size_t outLen) {
     size_t j = 0;
@@ -730,10 +1659,37 @@ static void webview_push_init_config(void) {
     json_escape_wstring(g_config.chromePath, wPath, MAX_PATH * 2);
     wchar_t wAddr[128];
     json_escape_wstring(g_config.connectAddress, wAddr, 128);
-    wchar_t script[4096];
-    swprintf(script, 4096,
-        L"window.onInit({\"view\":\"config\",\"config\":{\"chromePath\":\"%s\",\"debugPort\":%d,\"connectAddress\":\"%s\",\"statusCheckInterval\":%d}})",
-        wPath, g_config.debugPort, wAddr, g_config.statusCheckInterval);
+    wchar_t wMemoryPath[MAX_PATH * 2];
+    json_escape_wstring(g_config.memoryProfilePath, wMemoryPath, MAX_PATH * 2);
+    wchar_t wExtraArgs[CHROME_EXTRA_ARGS_MAX * 2];
+    json_escape_wstring(g_config.extraArgs, wExtraArgs, CHROME_EXTRA_ARGS_MAX * 2);
+    wchar_t wTabPoolUrls[CDP_BROKER_TAB_URL_LIST_MAX * 2];
+    json_escape_wstring(g_config.tabPoolUrls, wTabPoolUrls, CDP_BROKER_TAB_URL_LIST_MAX * 2);
+    wchar_t script[8192];
+    int len = swprintf(script, 8192,
+        L"window.onInit({\"view\":\"config\",\"config\":{\"chromePath\":\"%s\",\"debugPort\":%d,\"instanceCount\":%d,\"connectAddress\":\"%s\",\"statusCheckInterval\":%d,\"forwardMode\":%d,\"hotStandby\":%s,\"goldenProfile\":%s,\"memoryProfilePath\":\"%s\"",
+        wPath, g_config.debugPort, g_config.instanceCount, wAddr, g_config.statusCheckInterval, g_config.forwardMode,
+        g_config.hotStandby ? L"true" : L"false", g_config.goldenProfile ? L"true" : L"false", wMemoryPath);
+    if (len > 0) {
+        len += swprintf(script + len, 8192 - len,
+            L",\"jobMemoryMB\":%d,\"processMemoryMB\":%d,\"cpuRatePercent\":%d,\"activeProcessLimit\":%d,\"restartOnLimit\":%s,\"closeTimeout\":%d",
+            g_config.jobMemoryMB, g_config.processMemoryMB, g_config.cpuRatePercent,
+            g_config.activeProcessLimit, g_config.restartOnLimit ? L"true" : L"false", g_config.closeTimeout);
+    }
+    if (len > 0) {
+        len += swprintf(script + len, 8192 - len, L",\"flagPreset\":%d,\"extraArgs\":\"%s\",\"headless\":%s,\"brokerPort\":%d,\"contextPoolSize\":%d",
+                        g_config.flagPreset, wExtraArgs, g_config.headless ? L"true" : L"false", g_config.brokerPort,
+                        g_config.contextPoolSize);
+    }
+    if (len > 0) {
+        len += swprintf(script + len, 8192 - len, L",\"tabPoolSize\":%d,\"tabPoolUrls\":\"%s\"",
+                        g_config.tabPoolSize, wTabPoolUrls);
+    }
+    for (int i = 0; i < CACHE_CLASS_COUNT && len > 0; i++) {
+        len += swprintf(script + len, 8192 - len, L",\"%hs\":%d",
+                        g_cacheClasses[i].jsonKey, g_config.cacheCapMB[i]);
+    }
+    if (len > 0) swprintf(script + len, 8192 - len, L"}})");
     webview_execute_script(script);
 }
 
@@ -889,19 +1845,86 @@ static HRESULT STDMETHODCALLTYPE MsgReceived_Invoke(ICoreWebView2WebMessageRecei
     } else if (strcmp(action, "saveSettings") == 0) {
         char chromePath[MAX_PATH] = {0};
         char connectAddress[64] = {0};
+        char memoryProfilePath[MAX_PATH] = {0};
         int debugPort = 9222;
+        int instanceCount = 1;
         int statusCheckInterval = 60;
+        int forwardMode = FORWARD_MODE_RELAY;
+        BOOL hotStandby = FALSE;
+        BOOL goldenProfile = FALSE;
+        int jobMemoryMB = 0;
+        int processMemoryMB = 0;
+        int cpuRatePercent = 0;
+        int activeProcessLimit = 0;
+        BOOL restartOnLimit = FALSE;
+        int closeTimeout = g_config.closeTimeout;
+        int flagPreset = FLAG_PRESET_NONE;
+        char extraArgs[CHROME_EXTRA_ARGS_MAX * 3] = {0};  // UTF-8
+        BOOL headless = FALSE;
+        int brokerPort = 0;
+        int contextPoolSize = 0;
+        int tabPoolSize = 0;
+        char tabPoolUrls[CDP_BROKER_TAB_URL_LIST_MAX * 3] = {0};  // UTF-8
 
         json_get_string(msg, "chromePath", chromePath, sizeof(chromePath));
         json_get_string(msg, "connectAddress", connectAddress, sizeof(connectAddress));
         json_get_int(msg, "debugPort", &debugPort);
+        json_get_int(msg, "instanceCount", &instanceCount);
         json_get_int(msg, "statusCheckInterval", &statusCheckInterval);
+        json_get_int(msg, "forwardMode", &forwardMode);
+        json_get_bool(msg, "hotStandby", &hotStandby);
+        json_get_bool(msg, "goldenProfile", &goldenProfile);
+        json_get_string(msg, "memoryProfilePath", memoryProfilePath, sizeof(memoryProfilePath));
+        json_get_int(msg, "jobMemoryMB", &jobMemoryMB);
+        json_get_int(msg, "processMemoryMB", &processMemoryMB);
+        json_get_int(msg, "cpuRatePercent", &cpuRatePercent);
+        json_get_int(msg, "activeProcessLimit", &activeProcessLimit);
+        json_get_bool(msg, "restartOnLimit", &restartOnLimit);
+        json_get_int(msg, "closeTimeout", &closeTimeout);
+        json_get_int(msg, "flagPreset", &flagPreset);
+        json_get_string(msg, "extraArgs", extraArgs, sizeof(extraArgs));
+        json_get_bool(msg, "headless", &headless);
+        json_get_int(msg, "brokerPort", &brokerPort);
+        json_get_int(msg, "contextPoolSize", &contextPoolSize);
+        json_get_int(msg, "tabPoolSize", &tabPoolSize);
+        json_get_string(msg, "tabPoolUrls", tabPoolUrls, sizeof(tabPoolUrls));
+        for (int i = 0; i < CACHE_CLASS_COUNT; i++) {
+            int capMB = g_config.cacheCapMB[i];
+            json_get_int(msg, g_cacheClasses[i].jsonKey, &capMB);
+            g_config.cacheCapMB[i] = capMB >= 0 ? capMB : 0;
+        }
 
         // Write to global config
         MultiByteToWideChar(CP_UTF8, 0, chromePath, -1, g_config.chromePath, MAX_PATH);
         MultiByteToWideChar(CP_UTF8, 0, connectAddress, -1, g_config.connectAddress, 64);
+        MultiByteToWideChar(CP_UTF8, 0, memoryProfilePath, -1, g_config.memoryProfilePath, MAX_PATH);
+        if (!MultiByteToWideChar(CP_UTF8, 0, extraArgs, -1, g_config.extraArgs, CHROME_EXTRA_ARGS_MAX)) {
+            g_config.extraArgs[CHROME_EXTRA_ARGS_MAX - 1] = L'\0';  // Cut at the limit
+        }
+        if (!MultiByteToWideChar(CP_UTF8, 0, tabPoolUrls, -1, g_config.tabPoolUrls, CDP_BROKER_TAB_URL_LIST_MAX)) {
+            g_config.tabPoolUrls[CDP_BROKER_TAB_URL_LIST_MAX - 1] = L'\0';
+        }
         g_config.debugPort = debugPort;
-        g_config.statusCheckInterval = statusCheckInterval;
+        g_config.instanceCount = (instanceCount >= 1 && instanceCount <= MAX_INSTANCES) ? instanceCount : 1;
+        if (g_config.debugPort + g_config.instanceCount - 1 > 65535 && g_config.debugPort < 65535) {
+            g_config.instanceCount = 65535 - g_config.debugPort + 1;
+        }
+        g_config.statusCheckInterval = statusCheckInterval >= 1 ? statusCheckInterval : 1;
+        g_config.forwardMode = (forwardMode >= FORWARD_MODE_RELAY && forwardMode <= FORWARD_MODE_NETSH_BATCH)
+                               ? forwardMode : FORWARD_MODE_RELAY;
+        g_config.hotStandby = hotStandby;
+        g_config.goldenProfile = goldenProfile;
+        g_config.jobMemoryMB = jobMemoryMB >= 0 ? jobMemoryMB : 0;
+        g_config.processMemoryMB = processMemoryMB >= 0 ? processMemoryMB : 0;
+        g_config.cpuRatePercent = (cpuRatePercent >= 0 && cpuRatePercent <= 100) ? cpuRatePercent : 0;
+        g_config.activeProcessLimit = activeProcessLimit >= 0 ? activeProcessLimit : 0;
+        g_config.restartOnLimit = restartOnLimit;
+        g_config.closeTimeout = (closeTimeout >= 0 && closeTimeout <= CLOSE_TIMEOUT_MAX) ? closeTimeout : 5;
+        g_config.flagPreset = (flagPreset >= 0 && flagPreset < FLAG_PRESET_COUNT) ? flagPreset : FLAG_PRESET_NONE;
+        g_config.headless = headless;
+        g_config.brokerPort = (brokerPort >= 0 && brokerPort <= 65535) ? brokerPort : 0;
+        g_config.contextPoolSize = (contextPoolSize >= 0 && contextPoolSize <= CDP_BROKER_POOL_MAX) ? contextPoolSize : 0;
+        g_config.tabPoolSize = (tabPoolSize >= 0 && tabPoolSize <= CDP_BROKER_TAB_POOL_MAX) ? tabPoolSize : 0;
         g_configChanged = TRUE;
 
         PostMessage(g_webviewHwnd, WM_CLOSE, 0, 0);
@@ -1098,34 +2121,57 @@ static BOOL ShowConfigDialog(HWND hwndParent) {
     }
 
     if (g_configChanged) {
-        // Check if Chrome-impacting settings changed
-        BOOL needsRestart = FALSE;
-        if (wcscmp(savedConfig.chromePath, g_config.chromePath) != 0 ||
-            savedConfig.debugPort != g_config.debugPort ||
-            wcscmp(savedConfig.connectAddress, g_config.connectAddress) != 0) {
-            needsRestart = TRUE;
-        }
+        // Chrome only needs a restart for its own settings; forwards are
+        // rebuilt only when what they listen on or point at changed
+        BOOL needsRestart = wcscmp(savedConfig.chromePath, g_config.chromePath) != 0 ||
+                            savedConfig.debugPort != g_config.debugPort ||
+                            savedConfig.instanceCount != g_config.instanceCount ||
+                            savedConfig.goldenProfile != g_config.goldenProfile ||
+                            _wcsicmp(savedConfig.memoryProfilePath, g_config.memoryProfilePath) != 0 ||
+                            savedConfig.jobMemoryMB != g_config.jobMemoryMB ||
+                            savedConfig.processMemoryMB != g_config.processMemoryMB ||
+                            savedConfig.cpuRatePercent != g_config.cpuRatePercent ||
+                            savedConfig.activeProcessLimit != g_config.activeProcessLimit ||
+                            savedConfig.flagPreset != g_config.flagPreset ||
+                            wcscmp(savedConfig.extraArgs, g_config.extraArgs) != 0 ||
+                            savedConfig.headless != g_config.headless;
+        BOOL forwardsChanged = savedConfig.debugPort != g_config.debugPort ||
+                               savedConfig.instanceCount != g_config.instanceCount ||
+                               wcscmp(savedConfig.connectAddress, g_config.connectAddress) != 0 ||
+                               savedConfig.forwardMode != g_config.forwardMode;
 
         // Save to registry
         SaveConfigToRegistry(&g_config);
         MarkAsConfigured();
 
-        // Restart Chrome if needed
-        if (needsRestart && g_chromeRunning) {
-            RestartChrome();
-        } else if (!g_chromeRunning && g_config.chromePath[0] != L'\0') {
-            SetupPortForwards();
-            LaunchChrome();
+        // Restart Chrome if needed (runs on a worker); a restart rebuilds the
+        // forwards once the pool is down
+        BOOL running = CountRunningInstances() > 0;
+        if (needsRestart && running) {
+            RestartChrome(forwardsChanged);
+        } else {
+            if (forwardsChanged && g_forwardsEnabled) {
+                RebuildPortForwards();
+            }
+            if (!running && g_lifecycleTasksPending == 0 && g_config.chromePath[0] != L'\0') {
+                StartChrome();
+            } else if (running && savedConfig.hotStandby != g_config.hotStandby &&
+                       g_standby->tasksPending == 0) {
+                // Bring the standby up or down next to the running pool
+                if (IsStandbyConfigured() && !g_standby->running) {
+                    QueueChromeLifecycleTask(CHROME_TASK_START, STANDBY_INDEX);
+                } else if (!g_config.hotStandby && g_standby->running) {
+                    QueueChromeLifecycleTask(CHROME_TASK_STOP, STANDBY_INDEX);
+                }
+            }
         }
 
-        // Update status check timer
-        if (g_hwnd) {
-            KillTimer(g_hwnd, ID_TIMER_STATUS_CHECK);
-            SetTimer(g_hwnd, ID_TIMER_STATUS_CHECK, g_config.statusCheckInterval * 1000, NULL);
-        }
+        SyncLivenessMonitors();
+
+        // Re-arm the status probe under the (possibly lower) interval ceiling
+        ScheduleStatusProbe(g_probeIntervalMs);
 
         UpdateStatus();
-        UpdateTrayTooltip();
 
         return TRUE;
     }
@@ -1172,11 +2218,223 @@ static void RemoveTrayIcon(void) {
 
 static void UpdateTrayTooltip(void) {
     // Tooltip can have newlines, so combine all lines
-    swprintf_s(g_nid.szTip, sizeof(g_nid.szTip)/sizeof(wchar_t),
-               L"%ls\n%ls\n%ls", g_status.statusLine1, g_status.statusLine2, g_status.statusLine3);
+    // szTip holds 128 characters - truncate rather than fail
+    _snwprintf_s(g_nid.szTip, sizeof(g_nid.szTip)/sizeof(wchar_t), _TRUNCATE,
+                 L"%ls\n%ls\n%ls", g_status.statusLine1, g_status.statusLine2, g_status.statusLine3);
     Shell_NotifyIconW(NIM_MODIFY, &g_nid);
 }
 
+static void FormatByteCount(LONG64 bytes, wchar_t* out, size_t outLen) {
+    if (bytes >= 1024LL * 1024 * 1024) {
+        swprintf_s(out, outLen, L"%.1f GB", (double)bytes / (1024.0 * 1024.0 * 1024.0));
+    } else if (bytes >= 1024 * 1024) {
+        swprintf_s(out, outLen, L"%.1f MB", (double)bytes / (1024.0 * 1024.0));
+    } else if (bytes >= 1024) {
+        swprintf_s(out, outLen, L"%.1f KB", (double)bytes / 1024.0);
+    } else {
+        swprintf_s(out, outLen, L"%lld B", bytes);
+    }
+}
+
+// Per-listener forwarding details (submenu of the tray menu)
+static void AppendForwardingMenu(HMENU hMenu) {
+    HMENU hSubMenu = CreatePopupMenu();
+    wchar_t line[MAX_STATUS_TEXT];
+
+    static const wchar_t* modeNames[] = {
+        L"Built-in relay", L"netsh portproxy", L"netsh portproxy (batched)"
+    };
+    swprintf_s(line, MAX_STATUS_TEXT, L"Mode: %ls (setup %.1f ms)",
+               modeNames[g_config.forwardMode], g_status.forwardSetupMs);
+    AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+
+    AcquireSRWLockShared(&g_forwardLock);
+    for (int i = 0; i < g_portForwardCount; i++) {
+        const PortForwardEntry* entry = &g_portForwards[i];
+        if (!entry->active) continue;
+
+        if (entry->backend == FORWARD_BACKEND_RELAY && entry->relay) {
+            wchar_t bytesIn[32], bytesOut[32];
+            FormatByteCount(entry->relay->bytesUp, bytesIn, 32);
+            FormatByteCount(entry->relay->bytesDown, bytesOut, 32);
+            swprintf_s(line, MAX_STATUS_TEXT, L"%hs:%d - %ld open, %ld total, %ls in, %ls out",
+                       entry->listenIP, entry->listenPort,
+                       entry->relay->connectionsActive, entry->relay->connectionsTotal,
+                       bytesIn, bytesOut);
+        } else {
+            swprintf_s(line, MAX_STATUS_TEXT, L"%hs:%d - netsh portproxy",
+                       entry->listenIP, entry->listenPort);
+        }
+        AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+    }
+    ReleaseSRWLockShared(&g_forwardLock);
+
+    AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hSubMenu, L"Forwarding");
+}
+
+// Per-instance health of a Chrome pool (submenu of the tray menu)
+static void AppendInstancesMenu(HMENU hMenu) {
+    HMENU hSubMenu = CreatePopupMenu();
+    wchar_t line[MAX_STATUS_TEXT];
+
+    for (int i = 0; i < g_config.instanceCount; i++) {
+        FormatInstanceSummary(&g_instances[i], line, MAX_STATUS_TEXT);
+        AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+    }
+
+    AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hSubMenu, L"Instances");
+}
+
+// Profile location, golden profile (cold first run vs. the clone each launch
+// starts from) and cache janitor results
+static void AppendProfileMenu(HMENU hMenu) {
+    HMENU hSubMenu = CreatePopupMenu();
+    wchar_t line[MAX_STATUS_TEXT];
+
+    if (g_status.profileInMemory) {
+        wchar_t drive[4] = { g_status.profileRoot[0], L':', L'\\', L'\0' };
+        BOOL ramDisk = g_status.profileRoot[1] == L':' && GetDriveTypeW(drive) == DRIVE_RAMDISK;
+        swprintf_s(line, MAX_STATUS_TEXT, L"Location: %ls (%ls)", g_status.profileRoot,
+                   ramDisk ? L"RAM disk" : L"memory-backed");
+        AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+    } else if (g_status.profileFallback) {
+        swprintf_s(line, MAX_STATUS_TEXT, L"Location: %ls (memory-backed location unavailable)",
+                   g_status.profileRoot);
+        AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+    }
+
+    if (g_janitor.runs > 0) {
+        wchar_t total[32], last[32];
+        FormatByteCount((LONG64)g_janitor.reclaimedTotal, total, 32);
+        FormatByteCount((LONG64)g_janitor.lastReclaimed, last, 32);
+        swprintf_s(line, MAX_STATUS_TEXT, L"Cache janitor: %ls reclaimed (last run %ls in %.0f ms)",
+                   total, last, g_janitor.lastWalkMs);
+        AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+
+        for (int c = 0; c < CACHE_CLASS_COUNT; c++) {
+            if (g_config.cacheCapMB[c] <= 0) continue;
+            wchar_t size[32];
+            FormatByteCount((LONG64)g_janitor.classBytes[c], size, 32);
+            swprintf_s(line, MAX_STATUS_TEXT, L"%ls: %ls of %d MB", g_cacheClasses[c].name,
+                       size, g_config.cacheCapMB[c]);
+            AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+        }
+    }
+    if (!g_config.goldenProfile) {
+        AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hSubMenu, L"Profile");
+        return;
+    }
+
+    if (g_status.goldenColdStartMs > 0) {
+        swprintf_s(line, MAX_STATUS_TEXT, L"Golden profile: cold first run %.0f ms",
+                   g_status.goldenColdStartMs);
+    } else {
+        wcscpy_s(line, MAX_STATUS_TEXT, L"Golden profile: not prepared yet");
+    }
+    AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+
+    if (g_status.lastCloneMs > 0) {
+        swprintf_s(line, MAX_STATUS_TEXT, L"Last clone: %.1f ms (%d linked, %d block cloned, %d copied)",
+                   g_status.lastCloneMs, g_status.lastCloneLinked, g_status.lastCloneBlockCloned,
+                   g_status.lastCloneCopied);
+        AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+    }
+
+    AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hSubMenu, L"Profile");
+}
+
+// Latest telemetry sweep: job totals per instance and its heaviest processes
+static void AppendProcessesMenu(HMENU hMenu) {
+    HMENU hSubMenu = CreatePopupMenu();
+    wchar_t line[MAX_STATUS_TEXT];
+
+    FormatLauncherCpu(line, MAX_STATUS_TEXT);
+    AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+
+    AcquireSRWLockShared(&g_telemetry.lock);
+    ULONG jobFirst = g_telemetry.jobCount > TELEMETRY_JOB_RING ? g_telemetry.jobCount - TELEMETRY_JOB_RING : 0;
+    for (ULONG j = jobFirst; j < g_telemetry.jobCount; j++) {
+        const JobSample* job = &g_telemetry.jobs[j % TELEMETRY_JOB_RING];
+        if (job->time != g_telemetry.lastSweep) continue;
+        const ChromeInstance* inst = &g_instances[job->instance];
+
+        wchar_t peak[32], read[32], written[32];
+        FormatByteCount((LONG64)job->peakJobMemory, peak, 32);
+        FormatByteCount((LONG64)job->readBytes, read, 32);
+        FormatByteCount((LONG64)job->writeBytes, written, 32);
+        swprintf_s(line, MAX_STATUS_TEXT, L"%ls :%d - %lu processes, %.0f%% CPU, %ls peak, %ls read, %ls written",
+                   inst == g_standby ? L"Standby" : L"Instance", inst->debugPort, job->activeProcesses,
+                   job->cpuPercent, peak, read, written);
+        AppendMenuW(hSubMenu, MF_SEPARATOR, 0, NULL);
+        AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+
+        // Heaviest first, by private bytes
+        const ProcessSample* top[TELEMETRY_TOP_PROCESSES];
+        int topCount = 0;
+        ULONG first = g_telemetry.processCount > TELEMETRY_PROCESS_RING
+                      ? g_telemetry.processCount - TELEMETRY_PROCESS_RING : 0;
+        for (ULONG n = g_telemetry.processCount; n > first; n--) {
+            const ProcessSample* sample = &g_telemetry.processes[(n - 1) % TELEMETRY_PROCESS_RING];
+            if (sample->time != g_telemetry.lastSweep) break;
+            if (sample->instance != job->instance) continue;
+
+            int pos = topCount < TELEMETRY_TOP_PROCESSES ? topCount++ : TELEMETRY_TOP_PROCESSES;
+            while (pos > 0 && top[pos - 1]->privateBytes < sample->privateBytes) {
+                if (pos < TELEMETRY_TOP_PROCESSES) top[pos] = top[pos - 1];
+                pos--;
+            }
+            if (pos < TELEMETRY_TOP_PROCESSES) top[pos] = sample;
+        }
+
+        for (int t = 0; t < topCount; t++) {
+            const ProcessSample* sample = top[t];
+            wchar_t privateBytes[32], workingSet[32];
+            FormatByteCount((LONG64)sample->privateBytes, privateBytes, 32);
+            FormatByteCount((LONG64)sample->workingSet, workingSet, 32);
+            int len = swprintf_s(line, MAX_STATUS_TEXT, L"    PID %lu %ls - %ls private, %ls working set, %.0f%% CPU",
+                                 sample->pid, GetChromeProcessTypeName(sample->type), privateBytes,
+                                 workingSet, sample->cpuPercent);
+            const char* url = FindTargetUrl(inst, sample->targetId);
+            if (len > 0 && url) {
+                swprintf_s(line + len, MAX_STATUS_TEXT - len, L" (%hs)", url);
+            }
+            AppendMenuW(hSubMenu, MF_STRING | MF_GRAYED, 0, line);
+        }
+    }
+    ReleaseSRWLockShared(&g_telemetry.lock);
+
+    AppendMenuW(hSubMenu, MF_SEPARATOR, 0, NULL);
+    AppendMenuW(hSubMenu, MF_STRING, ID_TRAY_MENU_EXPORT_TELEMETRY, L"Export...");
+    AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hSubMenu, L"Processes");
+}
+
+// Open pages of the pool; choosing one brings its tab to front
+static void AppendPagesMenu(HMENU hMenu) {
+    HMENU hSubMenu = CreatePopupMenu();
+    wchar_t line[MAX_STATUS_TEXT];
+
+    for (int i = 0; i < g_config.instanceCount; i++) {
+        const ChromeInstance* inst = &g_instances[i];
+        if (!inst->running) continue;
+        for (int t = 0; t < inst->targetCount && t < CDP_MAX_TARGETS; t++) {
+            if (strcmp(inst->targets[t].type, "page") != 0) continue;
+            if (g_config.instanceCount > 1) {
+                swprintf_s(line, MAX_STATUS_TEXT, L":%d - %.*hs", inst->debugPort, PAGE_MENU_URL_MAX,
+                           inst->targets[t].url);
+            } else {
+                swprintf_s(line, MAX_STATUS_TEXT, L"%.*hs", PAGE_MENU_URL_MAX, inst->targets[t].url);
+            }
+            AppendMenuW(hSubMenu, MF_STRING, ID_TRAY_MENU_PAGE_FIRST + i * CDP_MAX_TARGETS + t, line);
+        }
+    }
+
+    if (GetMenuItemCount(hSubMenu) > 0) {
+        AppendMenuW(hMenu, MF_POPUP, (UINT_PTR)hSubMenu, L"Pages");
+    } else {
+        DestroyMenu(hSubMenu);
+    }
+}
+
 static void ShowContextMenu(HWND hwnd) {
     POINT pt;
     GetCursorPos(&pt);
@@ -1191,6 +2449,43 @@ static void ShowContextMenu(HWND hwnd) {
     if (g_status.statusLine3[0] != L'\0') {
         AppendMenuW(hMenu, MF_STRING | MF_GRAYED, 0, g_status.statusLine3);
     }
+    if (g_status.statusLine4[0] != L'\0') {
+        AppendMenuW(hMenu, MF_STRING | MF_GRAYED, 0, g_status.statusLine4);
+    }
+    if (g_status.statusLine5[0] != L'\0') {
+        AppendMenuW(hMenu, MF_STRING | MF_GRAYED, 0, g_status.statusLine5);
+    }
+    if (g_status.statusLine6[0] != L'\0') {
+        AppendMenuW(hMenu, MF_STRING | MF_GRAYED, 0, g_status.statusLine6);
+    }
+    if (g_hBrokerThread) {
+        wchar_t brokerLine[MAX_STATUS_TEXT];
+        FormatBrokerStatus(brokerLine, MAX_STATUS_TEXT);
+        AppendMenuW(hMenu, MF_STRING | MF_GRAYED, 0, brokerLine);
+        if (g_config.contextPoolSize > 0 && g_broker.listening) {
+            FormatContextPoolStatus(brokerLine, MAX_STATUS_TEXT);
+            AppendMenuW(hMenu, MF_STRING | MF_GRAYED, 0, brokerLine);
+        }
+        if (g_config.tabPoolSize > 0 && g_broker.listening) {
+            FormatTabPoolStatus(brokerLine, MAX_STATUS_TEXT);
+            AppendMenuW(hMenu, MF_STRING | MF_GRAYED, 0, brokerLine);
+        }
+    }
+    if (g_config.instanceCount > 1) {
+        AppendInstancesMenu(hMenu);
+    }
+    if (g_status.activeForwardCount > 0) {
+        AppendForwardingMenu(hMenu);
+    }
+    if (g_config.goldenProfile || g_janitor.runs > 0 || g_config.memoryProfilePath[0] != L'\0') {
+        AppendProfileMenu(hMenu);
+    }
+    if (g_telemetry.lastSweep != 0) {
+        AppendProcessesMenu(hMenu);
+    }
+    if (!g_config.headless) {
+        AppendPagesMenu(hMenu);
+    }
     AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
     AppendMenuW(hMenu, MF_STRING, ID_TRAY_MENU_CONFIGURE, L"Configure");
     AppendMenuW(hMenu, MF_SEPARATOR, 0, NULL);
@@ -1202,237 +2497,3322 @@ static void ShowContextMenu(HWND hwnd) {
 }
 
 // ============================================================================
-// Network Interface Enumeration
+// Worker Task Queue
 // ============================================================================
 
-static int EnumerateNonLoopbackInterfaces(PortForwardEntry* entries, int maxCount) {
-    int count = 0;
-
-    ULONG bufferSize = 15000;
-    PIP_ADAPTER_ADDRESSES pAddresses = (PIP_ADAPTER_ADDRESSES)malloc(bufferSize);
-    if (!pAddresses) return 0;
-
-    ULONG result = GetAdaptersAddresses(AF_INET, GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST,
-                                         NULL, pAddresses, &bufferSize);
+// Tasks run on a small worker pool fed through an I/O completion port. A task
+// with a completion routine is posted back to g_hwnd as WM_TASK_COMPLETE, so
+// the routine runs on the UI thread and may touch tray/hook state. Workers
+// read the task's copy of the configuration, which the UI thread may change
+// meanwhile, and leave what they measured in the task for g_status.
 
-    if (result == ERROR_BUFFER_OVERFLOW) {
-        free(pAddresses);
-        pAddresses = (PIP_ADAPTER_ADDRESSES)malloc(bufferSize);
-        if (!pAddresses) return 0;
-        result = GetAdaptersAddresses(AF_INET, GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST,
-                                       NULL, pAddresses, &bufferSize);
-    }
+static DWORD WINAPI TaskWorkerThread(LPVOID param) {
+    (void)param;
 
-    if (result != NO_ERROR) {
-        free(pAddresses);
-        return 0;
-    }
+    for (;;) {
+        DWORD bytes = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* ov = NULL;
+        if (!GetQueuedCompletionStatus(g_hTaskPort, &bytes, &key, &ov, INFINITE)) break;
 
-    PIP_ADAPTER_ADDRESSES pCurrent = pAddresses;
-    while (pCurrent && count < maxCount) {
-        // Skip loopback adapter
-        if (pCurrent->IfType == IF_TYPE_SOFTWARE_LOOPBACK) {
-            pCurrent = pCurrent->Next;
-            continue;
-        }
+        Task* task = (Task*)key;
+        if (!task) break;  // Shutdown
 
-        // Skip adapters that are not up
-        if (pCurrent->OperStatus != IfOperStatusUp) {
-            pCurrent = pCurrent->Next;
-            continue;
+        if (!g_taskQueueStopping) {
+            task->run(task);
         }
 
-        // Get unicast addresses
-        PIP_ADAPTER_UNICAST_ADDRESS pUnicast = pCurrent->FirstUnicastAddress;
-        while (pUnicast && count < maxCount) {
-            if (pUnicast->Address.lpSockaddr->sa_family == AF_INET) {
-                struct sockaddr_in* addr = (struct sockaddr_in*)pUnicast->Address.lpSockaddr;
-                char* ipStr = inet_ntoa(addr->sin_addr);
-
-                // Skip 127.x.x.x addresses
-                if (strncmp(ipStr, "127.", 4) != 0) {
-                    strncpy_s(entries[count].listenIP, 16, ipStr, 15);
-                    entries[count].listenPort = 0;  // Will be set when adding forward
-                    entries[count].active = FALSE;
-                    count++;
-                }
-            }
-            pUnicast = pUnicast->Next;
+        if (g_taskQueueStopping || !task->complete || !g_hwnd ||
+            !PostMessage(g_hwnd, WM_TASK_COMPLETE, 0, (LPARAM)task)) {
+            free(task->data);
+            free(task);
         }
-
-        pCurrent = pCurrent->Next;
     }
 
-    free(pAddresses);
-    return count;
+    return 0;
 }
 
-// ============================================================================
-// Port Forwarding
-// ============================================================================
-
-static BOOL AddPortForward(const char* listenIP, int listenPort, const char* connectIP, int connectPort) {
-    char cmd[512];
-    snprintf(cmd, sizeof(cmd),
-             "netsh interface portproxy add v4tov4 listenaddress=%s listenport=%d "
-             "connectaddress=%s connectport=%d",
-             listenIP, listenPort, connectIP, connectPort);
-
-    STARTUPINFOA si = {0};
-    PROCESS_INFORMATION pi = {0};
-    si.cb = sizeof(si);
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
+static BOOL StartTaskQueue(void) {
+    if (g_hTaskPort) return TRUE;
 
-    BOOL success = CreateProcessA(NULL, cmd, NULL, NULL, FALSE,
-                                   CREATE_NO_WINDOW, NULL, NULL, &si, &pi);
+    g_hTaskPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+    if (!g_hTaskPort) return FALSE;
 
-    if (success) {
-        WaitForSingleObject(pi.hProcess, 5000);
-        DWORD exitCode;
-        GetExitCodeProcess(pi.hProcess, &exitCode);
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
-        return (exitCode == 0);
+    g_taskQueueStopping = FALSE;
+    g_taskWorkerCount = 0;
+    for (int i = 0; i < TASK_WORKER_COUNT; i++) {
+        HANDLE hThread = CreateThread(NULL, 0, TaskWorkerThread, NULL, 0, NULL);
+        if (hThread) {
+            g_taskWorkers[g_taskWorkerCount++] = hThread;
+        }
     }
 
-    return FALSE;
+    if (g_taskWorkerCount == 0) {
+        CloseHandle(g_hTaskPort);
+        g_hTaskPort = NULL;
+        return FALSE;
+    }
+    return TRUE;
 }
 
-static BOOL RemovePortForward(const char* listenIP, int listenPort) {
-    char cmd[512];
-    snprintf(cmd, sizeof(cmd),
-             "netsh interface portproxy delete v4tov4 listenaddress=%s listenport=%d",
-             listenIP, listenPort);
-
-    STARTUPINFOA si = {0};
-    PROCESS_INFORMATION pi = {0};
-    si.cb = sizeof(si);
-    si.dwFlags = STARTF_USESHOWWINDOW;
-    si.wShowWindow = SW_HIDE;
-
-    BOOL success = CreateProcessA(NULL, cmd, NULL, NULL, FALSE,
-                                   CREATE_NO_WINDOW, NULL, NULL, &si, &pi);
+// Lets running tasks finish, discards queued ones and joins the workers
+static void StopTaskQueue(void) {
+    if (!g_hTaskPort) return;
 
-    if (success) {
-        WaitForSingleObject(pi.hProcess, 5000);
-        CloseHandle(pi.hProcess);
-        CloseHandle(pi.hThread);
-        return TRUE;
+    g_taskQueueStopping = TRUE;
+    for (int i = 0; i < g_taskWorkerCount; i++) {
+        PostQueuedCompletionStatus(g_hTaskPort, 0, 0, NULL);
     }
+    WaitForMultipleObjects((DWORD)g_taskWorkerCount, g_taskWorkers, TRUE, TASK_SHUTDOWN_TIMEOUT_MS);
+    for (int i = 0; i < g_taskWorkerCount; i++) {
+        CloseHandle(g_taskWorkers[i]);
+        g_taskWorkers[i] = NULL;
+    }
+    g_taskWorkerCount = 0;
 
-    return FALSE;
+    CloseHandle(g_hTaskPort);
+    g_hTaskPort = NULL;
 }
 
-static void SetupPortForwards(void) {
-    // First, clean up any existing forwards
-    CleanupAllPortForwards();
+static void ResetTaskStatus(TaskStatus* status) {
+    status->forwardSetupMs = -1;
+    status->goldenColdStartMs = -1;
+    status->cloneMs = -1;
+    status->cloneLinked = status->cloneBlockCloned = status->cloneCopied = 0;
+}
 
-    // Enumerate interfaces
-    g_portForwardCount = EnumerateNonLoopbackInterfaces(g_portForwards, MAX_INTERFACES);
+// UI thread only
+static void ApplyTaskStatus(const TaskStatus* status) {
+    if (status->forwardSetupMs >= 0) g_status.forwardSetupMs = status->forwardSetupMs;
+    if (status->goldenColdStartMs >= 0) g_status.goldenColdStartMs = status->goldenColdStartMs;
+    if (status->cloneMs >= 0) {
+        g_status.lastCloneMs = status->cloneMs;
+        g_status.lastCloneLinked = status->cloneLinked;
+        g_status.lastCloneBlockCloned = status->cloneBlockCloned;
+        g_status.lastCloneCopied = status->cloneCopied;
+    }
+}
 
-    // Convert connect address to narrow string
-    char connectAddr[64];
-    WideCharToMultiByte(CP_UTF8, 0, g_config.connectAddress, -1, connectAddr, 64, NULL, NULL);
+// Queues run() on a worker; complete() (optional) then runs on the UI thread.
+// data is owned by the task and freed after completion, also on failure.
+// Called on the UI thread, the only writer of g_config.
+static BOOL QueueTask(TaskRunProc run, TaskCompleteProc complete, LONG_PTR param, void* data) {
+    Task* task = (Task*)calloc(1, sizeof(Task));
+    if (!task || !g_hTaskPort || g_taskQueueStopping) {
+        free(task);
+        free(data);
+        return FALSE;
+    }
 
-    // Add port forward for each interface
-    for (int i = 0; i < g_portForwardCount; i++) {
-        g_portForwards[i].listenPort = g_config.debugPort;
+    task->run = run;
+    task->complete = complete;
+    task->param = param;
+    task->data = data;
+    task->config = g_config;
+    ResetTaskStatus(&task->status);
 
-        if (AddPortForward(g_portForwards[i].listenIP, g_portForwards[i].listenPort,
-                           connectAddr, g_config.debugPort)) {
-            g_portForwards[i].active = TRUE;
-        } else {
-            // Log failure but continue (graceful handling)
-            g_portForwards[i].active = FALSE;
-        }
+    if (!PostQueuedCompletionStatus(g_hTaskPort, 0, (ULONG_PTR)task, NULL)) {
+        free(task->data);
+        free(task);
+        return FALSE;
     }
+    return TRUE;
 }
 
-static void CleanupAllPortForwards(void) {
-    for (int i = 0; i < g_portForwardCount; i++) {
-        if (g_portForwards[i].active) {
-            RemovePortForward(g_portForwards[i].listenIP, g_portForwards[i].listenPort);
-            g_portForwards[i].active = FALSE;
-        }
+// Runs a completed task's UI-side routine (WM_TASK_COMPLETE)
+static void CompleteTask(Task* task) {
+    // Results that arrive after shutdown began are dropped
+    if (!g_taskQueueStopping) {
+        ApplyTaskStatus(&task->status);
+        task->complete(task);
     }
+    free(task->data);
+    free(task);
+}
+
+// ============================================================================
+// Chrome Pool
+// ============================================================================
+
+// Instance i of the pool starts out on port debugPort + i with profile
+// chrome_debug[_i]; the hot standby on the port after the pool with profile
+// chrome_debug_standby. Slots past g_config.instanceCount are idle, but keep
+// their state so a pool that shrinks can still stop them.
+
+// Directory the profiles are created in: memoryPath (a RAM disk, say) when it
+// names an existing directory, otherwise %TEMP%. Returns TRUE if memoryPath was
+// used. root always ends in a backslash (or is empty if both fail).
+static BOOL GetProfileRoot(const wchar_t* memoryPath, wchar_t* root, size_t rootLen) {
+    if (memoryPath && memoryPath[0] != L'\0') {
+        DWORD attributes = GetFileAttributesW(memoryPath);
+        size_t len = wcslen(memoryPath);
+        // Leave room for "chrome_debug_standby" and what Chrome nests below it
+        if (attributes != INVALID_FILE_ATTRIBUTES && (attributes & FILE_ATTRIBUTE_DIRECTORY) &&
+            len + 1 < rootLen && len < MAX_PATH - 64) {
+            wcscpy_s(root, rootLen, memoryPath);
+            if (root[len - 1] != L'\\' && root[len - 1] != L'/') {
+                wcscat_s(root, rootLen, L"\\");
+            }
+            return TRUE;
+        }
+    }
+
+    if (!GetTempPathW((DWORD)rootLen, root)) {
+        root[0] = L'\0';
+    }
+    return FALSE;
+}
+
+// Assigns every instance its home port and profile directory. Only called
+// while the whole pool is down. Returns TRUE if any instance moved.
+static BOOL ResetInstanceHomes(void) {
+    wchar_t tempPath[MAX_PATH];
+    g_status.profileInMemory = GetProfileRoot(g_config.memoryProfilePath, tempPath, MAX_PATH);
+    g_status.profileFallback = !g_status.profileInMemory && g_config.memoryProfilePath[0] != L'\0';
+    wcscpy_s(g_status.profileRoot, MAX_PATH, tempPath);
+
+    BOOL changed = FALSE;
+    for (int i = 0; i <= GOLDEN_INDEX; i++) {
+        ChromeInstance* inst = &g_instances[i];
+        wchar_t profileDir[MAX_PATH];
+        int port;
+
+        // Fixed directory names keep profiles across runs; the first instance
+        // keeps the name a single-Chrome setup always used
+        if (i == GOLDEN_INDEX) {
+            port = 0;  // Any free port; only used while the profile is prepared
+            swprintf_s(profileDir, MAX_PATH, L"%schrome_debug_golden", tempPath);
+        } else if (i == STANDBY_INDEX) {
+            port = g_config.debugPort + g_config.instanceCount;
+            swprintf_s(profileDir, MAX_PATH, L"%schrome_debug_standby", tempPath);
+        } else if (i == 0) {
+            port = g_config.debugPort;
+            swprintf_s(profileDir, MAX_PATH, L"%schrome_debug", tempPath);
+        } else {
+            port = g_config.debugPort + i;
+            swprintf_s(profileDir, MAX_PATH, L"%schrome_debug_%d", tempPath, i);
+        }
+
+        if (inst->debugPort != port || wcscmp(inst->profileDir, profileDir) != 0) {
+            changed = TRUE;
+        }
+        inst->index = i;
+        inst->debugPort = port;
+        wcscpy_s(inst->profileDir, MAX_PATH, profileDir);
+    }
+    return changed;
+}
+
+static ChromeInstance* FindInstanceByGeneration(LONG generation) {
+    if (generation == 0) return NULL;
+    for (int i = 0; i <= STANDBY_INDEX; i++) {
+        if (g_instances[i].generation == generation) return &g_instances[i];
+    }
+    return NULL;
+}
+
+static int CountRunningInstances(void) {
+    int count = 0;
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        if (g_instances[i].running) count++;
+    }
+    return count;
+}
+
+static int CountReadyInstances(void) {
+    int count = 0;
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        if (g_instances[i].running && g_instances[i].ready) count++;
+    }
+    return count;
+}
+
+// TRUE if the process belongs to the job of an instance in [first, last]
+static BOOL IsProcessInInstances(DWORD pid, int first, int last) {
+    LONG generation = LookupJobProcess(pid);
+    if (generation == 0) return FALSE;
+
+    for (int i = first; i <= last; i++) {
+        if (g_instances[i].hJob && g_instances[i].generation == generation) return TRUE;
+    }
+    return FALSE;
+}
+
+static BOOL IsProcessInPool(DWORD pid) {
+    return IsProcessInInstances(pid, 0, MAX_INSTANCES - 1);
+}
+
+// Hot standby and golden-profile preparation - never shown
+static BOOL IsProcessInBackground(DWORD pid) {
+    return IsProcessInInstances(pid, STANDBY_INDEX, GOLDEN_INDEX);
+}
+
+// Ports are 16-bit; the standby sits just past the pool
+static BOOL IsStandbyConfigured(void) {
+    return g_config.hotStandby && g_config.debugPort + g_config.instanceCount <= 65535;
+}
+
+// The standby is usable once launched; a failover may still have to wait for
+// its DevTools endpoint, but never for a cold start
+static BOOL IsStandbyAvailable(void) {
+    return IsStandbyConfigured() && g_standby->running && g_standby->tasksPending == 0;
+}
+
+// ============================================================================
+// Log
+// ============================================================================
+
+// Events worth keeping past the tray menu (limit hits, restarts) go to
+// %TEMP%\ChromeDevLauncher\ChromeDevLauncher.log as UTF-8 lines
+
+static BOOL GetLogPath(wchar_t* path, size_t size) {
+    wchar_t tempDir[MAX_PATH];
+    DWORD tempLen = GetTempPathW(MAX_PATH, tempDir);
+    if (tempLen == 0 || tempLen >= MAX_PATH - 50) return FALSE;
+
+    swprintf_s(path, size, L"%sChromeDevLauncher", tempDir);
+    CreateDirectoryW(path, NULL);
+    swprintf_s(path, size, L"%sChromeDevLauncher\\%s", tempDir, LOG_FILE_NAME);
+    return TRUE;
+}
+
+static void LogMessage(const wchar_t* format, ...) {
+    SYSTEMTIME now;
+    GetLocalTime(&now);
+
+    wchar_t line[LOG_LINE_MAX];
+    int len = swprintf_s(line, LOG_LINE_MAX, L"%04d-%02d-%02d %02d:%02d:%02d.%03d ",
+                         now.wYear, now.wMonth, now.wDay, now.wHour, now.wMinute,
+                         now.wSecond, now.wMilliseconds);
+    va_list args;
+    va_start(args, format);
+    int written = _vsnwprintf_s(line + len, LOG_LINE_MAX - len - 2, _TRUNCATE, format, args);
+    va_end(args);
+    len = written >= 0 ? len + written : (int)wcslen(line);
+    wcscpy_s(line + len, LOG_LINE_MAX - len, L"\r\n");
+
+    char utf8[LOG_LINE_MAX * 3];
+    int bytes = WideCharToMultiByte(CP_UTF8, 0, line, -1, utf8, sizeof(utf8), NULL, NULL);
+    if (bytes <= 1) return;
+
+    wchar_t path[MAX_PATH];
+    if (!GetLogPath(path, MAX_PATH)) return;
+
+    AcquireSRWLockExclusive(&g_logLock);
+    HANDLE hFile = CreateFileW(path, FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                               OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER size = {0};
+        if (GetFileSizeEx(hFile, &size) && size.QuadPart >= LOG_MAX_BYTES) {
+            // Keep one previous file, then start over
+            CloseHandle(hFile);
+            wchar_t oldPath[MAX_PATH];
+            swprintf_s(oldPath, MAX_PATH, L"%s.old", path);
+            MoveFileExW(path, oldPath, MOVEFILE_REPLACE_EXISTING);
+            hFile = CreateFileW(path, FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                                OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+        }
+    }
+    if (hFile != INVALID_HANDLE_VALUE) {
+        DWORD written = 0;
+        WriteFile(hFile, utf8, (DWORD)(bytes - 1), &written, NULL);
+        CloseHandle(hFile);
+    }
+    ReleaseSRWLockExclusive(&g_logLock);
+}
+
+// ============================================================================
+// Job Monitor
+// ============================================================================
+
+// Each job is associated with g_hJobPort using its launch generation as the
+// completion key, so notifications from a job that was already replaced (e.g.
+// the ACTIVE_PROCESS_ZERO raised by TerminateJobObject) can be told apart.
+// Generations are unique across the pool and also identify the instance.
+
+static void PostJobLimit(LONG generation, int limit, DWORD pid) {
+    JobLimitEvent* event = (JobLimitEvent*)malloc(sizeof(JobLimitEvent));
+    if (!event) return;
+    event->generation = generation;
+    event->limit = limit;
+    event->pid = pid;
+    if (!PostMessage(g_hwnd, WM_CHROME_LIMIT, 0, (LPARAM)event)) {
+        free(event);
+    }
+}
+
+// Job membership set. PIDs are multiples of 4; the multiplicative hash
+// spreads them over the table, collisions probe linearly.
+static int JobProcessSlot(DWORD pid) {
+    return (int)(((pid >> 2) * 2654435761u) & (JOB_PROCESS_SET_SIZE - 1));
+}
+
+// Generation of the job the process belongs to, 0 if it is not a Chrome
+static LONG LookupJobProcess(DWORD pid) {
+    LONG generation = 0;
+    if (pid == 0) return 0;
+
+    AcquireSRWLockShared(&g_jobProcesses.lock);
+    for (int slot = JobProcessSlot(pid);; slot = (slot + 1) & (JOB_PROCESS_SET_SIZE - 1)) {
+        const JobProcessEntry* entry = &g_jobProcesses.entries[slot];
+        if (entry->pid == 0) break;
+        if (entry->pid == pid) {
+            generation = entry->generation;
+            break;
+        }
+    }
+    ReleaseSRWLockShared(&g_jobProcesses.lock);
+    return generation;
+}
+
+// Caller holds the lock exclusively
+static void InsertJobProcessLocked(DWORD pid, LONG generation) {
+    int slot = JobProcessSlot(pid);
+    while (g_jobProcesses.entries[slot].pid != 0 && g_jobProcesses.entries[slot].pid != pid) {
+        slot = (slot + 1) & (JOB_PROCESS_SET_SIZE - 1);
+    }
+    if (g_jobProcesses.entries[slot].pid == 0) g_jobProcesses.count++;
+    g_jobProcesses.entries[slot].pid = pid;
+    g_jobProcesses.entries[slot].generation = generation;
+}
+
+static void AddJobProcess(DWORD pid, LONG generation) {
+    if (pid == 0) return;
+
+    AcquireSRWLockExclusive(&g_jobProcesses.lock);
+    // Keep a quarter free so probes stay short and always end at a free slot
+    BOOL full = g_jobProcesses.count >= JOB_PROCESS_SET_SIZE * 3 / 4;
+    if (!full) InsertJobProcessLocked(pid, generation);
+    BOOL logOverflow = full && !g_jobProcesses.overflowLogged;
+    if (logOverflow) g_jobProcesses.overflowLogged = TRUE;
+    ReleaseSRWLockExclusive(&g_jobProcesses.lock);
+
+    if (logOverflow) {
+        LogMessage(L"Job process set full (%d PIDs); windows of further Chrome processes are not hidden",
+                   JOB_PROCESS_SET_SIZE * 3 / 4);
+    }
+}
+
+// Removes the process if it is still recorded for that job; later entries of
+// its probe run move up so lookups never stop early at the freed slot
+static void RemoveJobProcess(DWORD pid, LONG generation) {
+    AcquireSRWLockExclusive(&g_jobProcesses.lock);
+    int slot = JobProcessSlot(pid);
+    while (g_jobProcesses.entries[slot].pid != 0 && g_jobProcesses.entries[slot].pid != pid) {
+        slot = (slot + 1) & (JOB_PROCESS_SET_SIZE - 1);
+    }
+    if (g_jobProcesses.entries[slot].pid == pid && g_jobProcesses.entries[slot].generation == generation) {
+        g_jobProcesses.entries[slot].pid = 0;
+        g_jobProcesses.count--;
+        for (int next = (slot + 1) & (JOB_PROCESS_SET_SIZE - 1); g_jobProcesses.entries[next].pid != 0;
+             next = (next + 1) & (JOB_PROCESS_SET_SIZE - 1)) {
+            // Move the entry into the hole unless its home lies after the hole
+            int home = JobProcessSlot(g_jobProcesses.entries[next].pid);
+            BOOL homeInRange = (slot <= next) ? (home > slot && home <= next)
+                                              : (home > slot || home <= next);
+            if (!homeInRange) {
+                g_jobProcesses.entries[slot] = g_jobProcesses.entries[next];
+                g_jobProcesses.entries[next].pid = 0;
+                slot = next;
+            }
+        }
+    }
+    ReleaseSRWLockExclusive(&g_jobProcesses.lock);
+}
+
+// Drops every process of a job that is going away (its exit messages may
+// arrive after a new job reused the PIDs)
+static void RemoveJobProcesses(LONG generation) {
+    if (generation == 0) return;
+
+    AcquireSRWLockExclusive(&g_jobProcesses.lock);
+    JobProcessEntry* kept = (JobProcessEntry*)malloc(sizeof(g_jobProcesses.entries));
+    if (kept) {
+        int keptCount = 0;
+        for (int i = 0; i < JOB_PROCESS_SET_SIZE; i++) {
+            const JobProcessEntry* entry = &g_jobProcesses.entries[i];
+            if (entry->pid != 0 && entry->generation != generation) kept[keptCount++] = *entry;
+        }
+        memset(g_jobProcesses.entries, 0, sizeof(g_jobProcesses.entries));
+        g_jobProcesses.count = 0;
+        for (int i = 0; i < keptCount; i++) {
+            InsertJobProcessLocked(kept[i].pid, kept[i].generation);
+        }
+        free(kept);
+    }
+    ReleaseSRWLockExclusive(&g_jobProcesses.lock);
+}
+
+static DWORD WINAPI JobMonitorThread(LPVOID param) {
+    (void)param;
+
+    for (;;) {
+        DWORD message = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* ov = NULL;
+        if (!GetQueuedCompletionStatus(g_hJobPort, &message, &key, &ov, INFINITE)) break;
+        if (key == 0) break;  // Shutdown
+
+        // Membership for the window hook; the OVERLAPPED pointer carries the PID
+        if (message == JOB_OBJECT_MSG_NEW_PROCESS) {
+            AddJobProcess((DWORD)(ULONG_PTR)ov, (LONG)key);
+        } else if (message == JOB_OBJECT_MSG_EXIT_PROCESS || message == JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS) {
+            RemoveJobProcess((DWORD)(ULONG_PTR)ov, (LONG)key);
+        }
+
+        if (!g_hwnd) continue;
+
+        switch (message) {
+            case JOB_OBJECT_MSG_ACTIVE_PROCESS_ZERO:
+                PostMessage(g_hwnd, WM_CHROME_EXITED, (WPARAM)key, 0);
+                break;
+            case JOB_OBJECT_MSG_ABNORMAL_EXIT_PROCESS:
+                // For process messages the OVERLAPPED pointer carries the PID
+                PostMessage(g_hwnd, WM_CHROME_CRASHED, (WPARAM)key, (LPARAM)ov);
+                break;
+            case JOB_OBJECT_MSG_JOB_MEMORY_LIMIT:
+                PostJobLimit((LONG)key, JOB_LIMIT_JOB_MEMORY, (DWORD)(ULONG_PTR)ov);
+                break;
+            case JOB_OBJECT_MSG_PROCESS_MEMORY_LIMIT:
+                PostJobLimit((LONG)key, JOB_LIMIT_PROCESS_MEMORY, (DWORD)(ULONG_PTR)ov);
+                break;
+            case JOB_OBJECT_MSG_ACTIVE_PROCESS_LIMIT:
+                PostJobLimit((LONG)key, JOB_LIMIT_ACTIVE_PROCESSES, 0);
+                break;
+        }
+    }
+
+    return 0;
+}
+
+static BOOL StartJobMonitor(void) {
+    if (g_hJobPort) return TRUE;
+
+    g_hJobPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 1);
+    if (!g_hJobPort) return FALSE;
+
+    g_hJobMonitorThread = CreateThread(NULL, 0, JobMonitorThread, NULL, 0, NULL);
+    if (!g_hJobMonitorThread) {
+        CloseHandle(g_hJobPort);
+        g_hJobPort = NULL;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void StopJobMonitor(void) {
+    if (!g_hJobPort) return;
+
+    PostQueuedCompletionStatus(g_hJobPort, 0, 0, NULL);
+    if (g_hJobMonitorThread) {
+        WaitForSingleObject(g_hJobMonitorThread, 5000);
+        CloseHandle(g_hJobMonitorThread);
+        g_hJobMonitorThread = NULL;
+    }
+    CloseHandle(g_hJobPort);
+    g_hJobPort = NULL;
+}
+
+// Kill-on-close plus the configured resource limits. Memory and process
+// limits make the failing allocation or CreateProcess fail inside Chrome and
+// are reported to the job monitor; the CPU cap just throttles.
+static void ConfigureJobLimits(HANDLE hJob, const Configuration* config) {
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobInfo = {0};
+    jobInfo.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
+    if (config->jobMemoryMB > 0) {
+        jobInfo.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_JOB_MEMORY;
+        jobInfo.JobMemoryLimit = (SIZE_T)config->jobMemoryMB * 1024 * 1024;
+    }
+    if (config->processMemoryMB > 0) {
+        jobInfo.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_PROCESS_MEMORY;
+        jobInfo.ProcessMemoryLimit = (SIZE_T)config->processMemoryMB * 1024 * 1024;
+    }
+    if (config->activeProcessLimit > 0) {
+        jobInfo.BasicLimitInformation.LimitFlags |= JOB_OBJECT_LIMIT_ACTIVE_PROCESS;
+        jobInfo.BasicLimitInformation.ActiveProcessLimit = (DWORD)config->activeProcessLimit;
+    }
+    SetInformationJobObject(hJob, JobObjectExtendedLimitInformation, &jobInfo, sizeof(jobInfo));
+
+    if (config->cpuRatePercent > 0) {
+        JOBOBJECT_CPU_RATE_CONTROL_INFORMATION cpuInfo = {0};
+        cpuInfo.ControlFlags = JOB_OBJECT_CPU_RATE_CONTROL_ENABLE | JOB_OBJECT_CPU_RATE_CONTROL_HARD_CAP;
+        cpuInfo.CpuRate = (DWORD)config->cpuRatePercent * 100;  // In 1/100 of a percent
+        SetInformationJobObject(hJob, JobObjectCpuRateControlInformation, &cpuInfo, sizeof(cpuInfo));
+    }
+}
+
+// Routes notifications for the instance's newly created job to the monitor
+// thread and gives the instance its new generation
+static void AssociateJobWithMonitor(ChromeInstance* inst) {
+    inst->generation = InterlockedIncrement(&g_jobGeneration);
+    if (!g_hJobPort) return;
+
+    JOBOBJECT_ASSOCIATE_COMPLETION_PORT port = {0};
+    port.CompletionKey = (PVOID)(ULONG_PTR)inst->generation;
+    port.CompletionPort = g_hJobPort;
+    SetInformationJobObject(inst->hJob, JobObjectAssociateCompletionPortInformation,
+                            &port, sizeof(port));
+}
+
+// WM_CHROME_EXITED: the last process of an instance's current job has exited
+static void OnChromeExited(LONG generation) {
+    // Stale job, or a launch/restart of this instance is already underway
+    ChromeInstance* inst = FindInstanceByGeneration(generation);
+    if (!inst || !inst->running || inst->tasksPending > 0 || g_poolRestartPending) return;
+
+    // All processes in the job have exited - hand the forwards to the hot
+    // standby if there is one, otherwise relaunch (forwards stay up)
+    if (inst != g_standby && IsStandbyAvailable()) {
+        FailoverResult* failover = (FailoverResult*)calloc(1, sizeof(FailoverResult));
+        if (failover) {
+            failover->exitUs = CdpNowUs();
+            QueueChromeLifecycleTaskWithData(CHROME_TASK_FAILOVER, inst->index, failover);
+            UpdateStatus();
+            return;
+        }
+    }
+    QueueChromeLifecycleTask(CHROME_TASK_RELAUNCH, inst->index);
+    UpdateStatus();
+}
+
+// WM_CHROME_CRASHED: a process in an instance's job (typically a renderer) crashed
+static void OnChromeProcessCrashed(LONG generation, DWORD pid) {
+    ChromeInstance* inst = FindInstanceByGeneration(generation);
+    if (!inst) return;
+
+    inst->abnormalExitCount++;
+    inst->lastAbnormalExitPID = pid;
+    GetLocalTime(&inst->lastAbnormalExitTime);
+    RefreshStatusText();
+    UpdateTrayTooltip();
+}
+
+static const wchar_t* GetJobLimitName(int limit) {
+    switch (limit) {
+        case JOB_LIMIT_JOB_MEMORY: return L"Memory";
+        case JOB_LIMIT_PROCESS_MEMORY: return L"Process memory";
+        default: return L"Process count";
+    }
+}
+
+// Logs a limit hit with the page its process renders, "unknown" if that
+// could not be told
+static void LogJobLimitHit(const ChromeInstance* inst, int limit, DWORD pid, const char* targetId) {
+    wchar_t process[32] = L"";
+    if (pid) swprintf_s(process, 32, L" by PID %lu", pid);
+    const char* page = targetId ? FindTargetUrl(inst, targetId) : NULL;
+    if (!page) page = targetId && targetId[0] ? targetId : "unknown";
+    LogMessage(L"Instance #%d (:%d): %ls limit hit%ls; page: %hs", inst->index + 1, inst->debugPort,
+               GetJobLimitName(limit), process, page);
+}
+
+// Restarts an instance over a limit hit, if configured and nothing else is under way
+static BOOL RestartOnJobLimit(ChromeInstance* inst) {
+    if (!g_config.restartOnLimit || !inst->running || inst->tasksPending > 0 || g_poolRestartPending) {
+        return FALSE;
+    }
+    LogMessage(L"Instance #%d (:%d): restarting Chrome", inst->index + 1, inst->debugPort);
+    QueueChromeLifecycleTask(CHROME_TASK_RELAUNCH, inst->index);
+    UpdateStatus();
+    return TRUE;
+}
+
+// The job only names the process; a short trace of the instance lists which
+// process renders which frame
+static void JobLimitLookupRun(Task* task) {
+    JobLimitLookup* lookup = (JobLimitLookup*)task->data;
+    char host[CDP_HOST_MAX];
+    GetDevToolsEndpoint(&task->config, host, sizeof(host));
+
+    CdpSession session;
+    CdpSessionInit(&session, JOB_LIMIT_LOOKUP_TIMEOUT_MS);
+    if (CdpSessionOpen(&session, host, lookup->port) != CDP_OK ||
+        CdpSessionFindRenderer(&session, (long)lookup->pid, lookup->targetId, sizeof(lookup->targetId)) != CDP_OK) {
+        lookup->targetId[0] = '\0';
+    }
+    CdpSessionClose(&session);
+}
+
+static void JobLimitLookupComplete(Task* task) {
+    const JobLimitLookup* lookup = (const JobLimitLookup*)task->data;
+    ChromeInstance* inst = &g_instances[lookup->instance];
+    inst->limitLookupPending = FALSE;
+    if (inst->generation != lookup->generation) return;  // Relaunched meanwhile
+
+    LogJobLimitHit(inst, lookup->limit, lookup->pid, lookup->targetId);
+    if (RestartOnJobLimit(inst)) return;
+    RefreshStatusText();
+    UpdateTrayTooltip();
+}
+
+// Queues the page lookup for a limit hit. Returns FALSE if there is nothing
+// to look up or it could not be queued.
+static BOOL StartJobLimitLookup(ChromeInstance* inst, const JobLimitEvent* event) {
+    if (!event->pid || !inst->running) return FALSE;
+    JobLimitLookup* lookup = (JobLimitLookup*)calloc(1, sizeof(JobLimitLookup));
+    if (!lookup) return FALSE;
+    lookup->instance = inst->index;
+    lookup->generation = event->generation;
+    lookup->port = inst->debugPort;
+    lookup->limit = event->limit;
+    lookup->pid = event->pid;
+    if (!QueueTask(JobLimitLookupRun, JobLimitLookupComplete, 0, lookup)) return FALSE;
+    inst->limitLookupPending = TRUE;
+    return TRUE;
+}
+
+// WM_CHROME_LIMIT: an instance's job ran into a memory or process limit
+static void OnJobLimitHit(const JobLimitEvent* event) {
+    ChromeInstance* inst = FindInstanceByGeneration(event->generation);
+    if (!inst) return;
+
+    inst->limitHitCount++;
+    inst->lastLimit = event->limit;
+    inst->lastLimitPID = event->pid;
+    GetLocalTime(&inst->lastLimitTime);
+    ULONGLONG now = GetTickCount64();
+    inst->lastLimitTick = now;
+
+    // A page over its budget keeps failing allocations; one line per burst.
+    // A restart waits for the lookup of the page, which needs Chrome up.
+    if (now - inst->lastLimitLogTick >= JOB_LIMIT_LOG_INTERVAL_MS || inst->lastLimitLogTick == 0) {
+        inst->lastLimitLogTick = now;
+        if (!inst->limitLookupPending && !StartJobLimitLookup(inst, event)) {
+            LogJobLimitHit(inst, event->limit, event->pid, NULL);
+        }
+    }
+    if (!inst->limitLookupPending && RestartOnJobLimit(inst)) return;
+    RefreshStatusText();
+    UpdateTrayTooltip();
+}
+
+// ============================================================================
+// Readiness Watch
+// ============================================================================
+
+// Chrome creates DevToolsActivePort in the profile directory once the debug
+// endpoint is listening. A directory change notification catches that moment
+// without probing; WM_CHROME_READY then flips the UI into the ready state.
+
+static void GetActivePortPath(const ChromeInstance* inst, wchar_t* path, size_t size) {
+    swprintf_s(path, size, L"%s\\%s", inst->profileDir, DEVTOOLS_ACTIVE_PORT_FILE);
+}
+
+// TRUE once the file holds the instance's debug port on its first line. Chrome
+// may still be writing it when the first notification arrives.
+static BOOL ReadActivePortFile(const ChromeInstance* inst) {
+    wchar_t path[MAX_PATH];
+    GetActivePortPath(inst, path, MAX_PATH);
+
+    HANDLE hFile = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                               NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return FALSE;
+
+    char buffer[128] = {0};
+    DWORD bytesRead = 0;
+    BOOL ok = ReadFile(hFile, buffer, sizeof(buffer) - 1, &bytesRead, NULL);
+    CloseHandle(hFile);
+    if (!ok || bytesRead == 0 || !strchr(buffer, '\n')) return FALSE;
+
+    // Port 0 lets Chrome pick one, which is then the one in the file
+    return inst->debugPort == 0 ? atoi(buffer) > 0 : atoi(buffer) == inst->debugPort;
+}
+
+static DWORD WINAPI ReadyWatchThread(LPVOID param) {
+    ChromeInstance* inst = (ChromeInstance*)param;
+    LONG generation = inst->generation;
+
+    HANDLE hDir = CreateFileW(inst->profileDir, FILE_LIST_DIRECTORY,
+                              FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, NULL,
+                              OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, NULL);
+    if (hDir == INVALID_HANDLE_VALUE) return 0;
+
+    OVERLAPPED ov = {0};
+    ov.hEvent = CreateEventW(NULL, TRUE, FALSE, NULL);
+    HANDLE waits[2] = { inst->hReadyWatchStop, ov.hEvent };
+    DWORD buffer[READY_WATCH_BUFFER_SIZE / sizeof(DWORD)];
+    BOOL ready = FALSE;
+
+    while (ov.hEvent && !ready) {
+        ResetEvent(ov.hEvent);
+        if (!ReadDirectoryChangesW(hDir, buffer, sizeof(buffer), FALSE,
+                                   FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_LAST_WRITE |
+                                   FILE_NOTIFY_CHANGE_SIZE, NULL, &ov, NULL)) {
+            break;
+        }
+
+        // The file may have been written before the watch was armed
+        BOOL stopped = FALSE;
+        if (ReadActivePortFile(inst)) {
+            ready = TRUE;
+        } else {
+            stopped = WaitForMultipleObjects(2, waits, FALSE, INFINITE) != WAIT_OBJECT_0 + 1;
+        }
+
+        DWORD bytes = 0;
+        if (ready || stopped) {
+            // Cancel and drain the pending read before its buffer goes away
+            CancelIo(hDir);
+            GetOverlappedResult(hDir, &ov, &bytes, TRUE);
+            break;
+        }
+        if (!GetOverlappedResult(hDir, &ov, &bytes, FALSE)) break;
+
+        // An overflowed buffer (bytes == 0) just means: check the file
+        const FILE_NOTIFY_INFORMATION* info = (const FILE_NOTIFY_INFORMATION*)buffer;
+        BOOL relevant = (bytes == 0);
+        while (bytes > 0) {
+            size_t nameLen = info->FileNameLength / sizeof(wchar_t);
+            if (nameLen == wcslen(DEVTOOLS_ACTIVE_PORT_FILE) &&
+                _wcsnicmp(info->FileName, DEVTOOLS_ACTIVE_PORT_FILE, nameLen) == 0) {
+                relevant = TRUE;
+            }
+            if (info->NextEntryOffset == 0) break;
+            info = (const FILE_NOTIFY_INFORMATION*)((const BYTE*)info + info->NextEntryOffset);
+        }
+
+        if (relevant && ReadActivePortFile(inst)) {
+            ready = TRUE;
+        }
+    }
+
+    if (ready) inst->readyAtUs = CdpNowUs();
+    if (ov.hEvent) CloseHandle(ov.hEvent);
+    CloseHandle(hDir);
+
+    if (ready && g_hwnd) {
+        PostMessage(g_hwnd, WM_CHROME_READY, (WPARAM)generation, 0);
+    }
+    return 0;
+}
+
+// Watches the instance's profile for its current generation. The file is
+// checked right away, so an already running Chrome is picked up too.
+static void ArmReadyWatch(ChromeInstance* inst) {
+    StopReadyWatch(inst);
+
+    inst->readyAtUs = 0;
+    inst->hReadyWatchStop = CreateEventW(NULL, TRUE, FALSE, NULL);
+    if (!inst->hReadyWatchStop) return;
+
+    inst->hReadyWatchThread = CreateThread(NULL, 0, ReadyWatchThread, inst, 0, NULL);
+    if (!inst->hReadyWatchThread) {
+        CloseHandle(inst->hReadyWatchStop);
+        inst->hReadyWatchStop = NULL;
+    }
+}
+
+// Called by LaunchChrome before the process starts, after the instance got
+// its generation
+static void StartReadyWatch(ChromeInstance* inst) {
+    StopReadyWatch(inst);
+
+    // A file left over from the previous run would signal ready too early
+    wchar_t path[MAX_PATH];
+    GetActivePortPath(inst, path, MAX_PATH);
+    DeleteFileW(path);
+
+    ArmReadyWatch(inst);
+}
+
+static void StopReadyWatch(ChromeInstance* inst) {
+    if (inst->hReadyWatchThread) {
+        SetEvent(inst->hReadyWatchStop);
+        WaitForSingleObject(inst->hReadyWatchThread, INFINITE);
+        CloseHandle(inst->hReadyWatchThread);
+        inst->hReadyWatchThread = NULL;
+    }
+    if (inst->hReadyWatchStop) {
+        CloseHandle(inst->hReadyWatchStop);
+        inst->hReadyWatchStop = NULL;
+    }
+}
+
+// WM_CHROME_READY
+static void OnChromeReady(LONG generation) {
+    ChromeInstance* inst = FindInstanceByGeneration(generation);
+    if (!inst || !inst->running || inst->ready) return;
+
+    inst->ready = TRUE;
+    if (inst->launchUs && inst->readyAtUs > inst->launchUs) {
+        inst->timeToReadyMs = (double)(inst->readyAtUs - inst->launchUs) / 1000.0;
+    }
+
+    // Fetch the version right away
+    ScheduleStatusProbe(0);
+    RefreshStatusText();
+    UpdateTrayTooltip();
+}
+
+// ============================================================================
+// Status Probe Scheduler
+// ============================================================================
+
+// ID_TIMER_STATUS_CHECK is a one-shot timer re-armed after every probe result.
+// Probing is fast while Chrome starts up, backs off while it is healthy and
+// bursts after a failure; statusCheckInterval caps every interval.
+
+static UINT ProbeCeilingMs(void) {
+    return (UINT)g_config.statusCheckInterval * 1000;
+}
+
+static void ScheduleStatusProbe(UINT delayMs) {
+    if (!g_hwnd) return;
+    UINT ceiling = ProbeCeilingMs();
+    if (delayMs > ceiling) delayMs = ceiling;
+    if (delayMs < USER_TIMER_MINIMUM) delayMs = USER_TIMER_MINIMUM;
+    SetTimer(g_hwnd, ID_TIMER_STATUS_CHECK, delayMs, NULL);  // Replaces a pending one
+}
+
+static void SetProbeMode(int mode) {
+    g_probeMode = mode;
+    switch (mode) {
+        case PROBE_MODE_HEALTHY:
+            g_probeIntervalMs = PROBE_HEALTHY_MIN_MS;
+            break;
+        case PROBE_MODE_BURST:
+            g_probeBurstLeft = PROBE_BURST_COUNT;
+            g_probeIntervalMs = PROBE_FAST_INTERVAL_MS;
+            break;
+        case PROBE_MODE_BACKOFF:
+            g_probeIntervalMs = PROBE_FAST_INTERVAL_MS * 2;
+            break;
+        default:
+            g_probeIntervalMs = PROBE_FAST_INTERVAL_MS;
+            break;
+    }
+    ScheduleStatusProbe(g_probeIntervalMs);
+}
+
+static UINT DoubleProbeInterval(UINT interval) {
+    UINT ceiling = ProbeCeilingMs();
+    return interval >= ceiling / 2 ? ceiling : interval * 2;
+}
+
+// Most recent launch in the pool, 0 if nothing was launched
+static unsigned long long LatestLaunchUs(void) {
+    unsigned long long latest = 0;
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        if (g_instances[i].running && g_instances[i].launchUs > latest) {
+            latest = g_instances[i].launchUs;
+        }
+    }
+    return latest;
+}
+
+// Advances the scheduler after a probe completed and arms the next one.
+// success means every running instance answered.
+static void OnStatusProbeResult(BOOL success) {
+    // Nothing to watch - poll at the configured rate
+    if (CountRunningInstances() == 0 && g_lifecycleTasksPending == 0) {
+        g_probeMode = PROBE_MODE_BACKOFF;
+        g_probeIntervalMs = ProbeCeilingMs();
+        ScheduleStatusProbe(g_probeIntervalMs);
+        return;
+    }
+
+    switch (g_probeMode) {
+        case PROBE_MODE_STARTUP:
+            if (success) {
+                SetProbeMode(PROBE_MODE_HEALTHY);
+                return;
+            }
+            if (LatestLaunchUs() && CdpNowUs() - LatestLaunchUs() > PROBE_STARTUP_TIMEOUT_MS * 1000ULL) {
+                SetProbeMode(PROBE_MODE_BACKOFF);  // Chrome never came up
+                return;
+            }
+            break;
+
+        case PROBE_MODE_HEALTHY:
+            if (!success) {
+                SetProbeMode(PROBE_MODE_BURST);
+                return;
+            }
+            g_probeIntervalMs = DoubleProbeInterval(g_probeIntervalMs);
+            break;
+
+        case PROBE_MODE_BURST:
+            if (success) {
+                SetProbeMode(PROBE_MODE_HEALTHY);
+                return;
+            }
+            if (--g_probeBurstLeft <= 0) {
+                SetProbeMode(PROBE_MODE_BACKOFF);
+                return;
+            }
+            break;
+
+        case PROBE_MODE_BACKOFF:
+            if (success) {
+                SetProbeMode(PROBE_MODE_HEALTHY);
+                return;
+            }
+            g_probeIntervalMs = DoubleProbeInterval(g_probeIntervalMs);
+            break;
+    }
+
+    ScheduleStatusProbe(g_probeIntervalMs);
+}
+
+// ID_TIMER_STATUS_CHECK
+static void OnStatusProbeTimer(void) {
+    KillTimer(g_hwnd, ID_TIMER_STATUS_CHECK);
+    UpdateStatus();
+
+    // The probe's completion re-arms the timer; keep polling if none was queued
+    if (!g_statusProbePending) {
+        ScheduleStatusProbe(g_probeIntervalMs);
+    }
+}
+
+// ============================================================================
+// CDP Liveness
+// ============================================================================
+
+// A browser-level CDP session reports a dropped socket or a missed ping
+// deadline the moment it happens, instead of at the next status poll.
+
+static void LivenessChanged(CdpMonitor* monitor, void* context) {
+    ChromeInstance* inst = (ChromeInstance*)context;
+    if (!g_hwnd) return;
+
+    LivenessSnapshot* snapshot = (LivenessSnapshot*)malloc(sizeof(LivenessSnapshot));
+    if (!snapshot) return;
+    snapshot->instance = inst->index;
+    snapshot->state = monitor->state;
+    snapshot->targetCount = monitor->targetCount;
+    snapshot->pingRttUs = monitor->lastPingRttUs;
+    strcpy_s(snapshot->browser, sizeof(snapshot->browser), monitor->browser);
+    memcpy(snapshot->targets, monitor->targets, sizeof(snapshot->targets));
+
+    if (!PostMessage(g_hwnd, WM_CDP_LIVENESS, 0, (LPARAM)snapshot)) {
+        free(snapshot);
+    }
+}
+
+static DWORD WINAPI LivenessMonitorThread(LPVOID param) {
+    CdpMonitorRun((CdpMonitor*)param);
+    return 0;
+}
+
+static void GetDevToolsEndpoint(const Configuration* config, char* host, size_t hostLen) {
+    WideCharToMultiByte(CP_UTF8, 0, config->connectAddress, -1, host, (int)hostLen, NULL, NULL);
+}
+
+static BOOL StartLivenessMonitor(ChromeInstance* inst) {
+    if (inst->hMonitorThread) return TRUE;
+
+    char host[64];
+    GetDevToolsEndpoint(&g_config, host, sizeof(host));
+    CdpMonitorInit(&inst->monitor, host, inst->debugPort);
+    inst->monitor.pingIntervalMs = CDP_PING_INTERVAL_MS;
+    inst->monitor.pingDeadlineMs = CDP_PING_DEADLINE_MS;
+    inst->monitor.reconnectDelayMs = CDP_RECONNECT_DELAY_MS;
+    inst->monitor.connectTimeoutMs = DEVTOOLS_CONNECT_TIMEOUT_MS;
+    inst->monitor.onChange = LivenessChanged;
+    inst->monitor.context = inst;
+    strcpy_s(inst->monitorHost, sizeof(inst->monitorHost), host);
+    inst->monitorPort = inst->debugPort;
+
+    inst->hMonitorThread = CreateThread(NULL, 0, LivenessMonitorThread, &inst->monitor, 0, NULL);
+    return inst->hMonitorThread != NULL;
+}
+
+// Waits for the monitor thread to exit: a connect or ping in progress ends
+// within its own timeout, and the monitor is only freed up after that
+static void StopLivenessMonitor(ChromeInstance* inst) {
+    if (!inst->hMonitorThread) return;
+
+    inst->monitor.stop = 1;
+    WaitForSingleObject(inst->hMonitorThread, INFINITE);
+    CloseHandle(inst->hMonitorThread);
+    inst->hMonitorThread = NULL;
+    inst->cdpLinkState = CDP_LINK_DOWN;
+    inst->targetCount = 0;
+}
+
+// Runs one monitor per pool instance and follows address/port changes from
+// the configuration dialog and failovers
+static void SyncLivenessMonitors(void) {
+    if (!g_winsockStarted) return;
+
+    char host[64];
+    GetDevToolsEndpoint(&g_config, host, sizeof(host));
+
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        ChromeInstance* inst = &g_instances[i];
+        if (i >= g_config.instanceCount) {
+            StopLivenessMonitor(inst);
+            continue;
+        }
+        if (!inst->hMonitorThread) {
+            StartLivenessMonitor(inst);
+            continue;
+        }
+
+        int port = inst->debugPort;
+        if (strcmp(host, inst->monitorHost) == 0 && inst->monitorPort == port) continue;
+
+        if (CdpMonitorRetarget(&inst->monitor, host, port)) {
+            strcpy_s(inst->monitorHost, sizeof(inst->monitorHost), host);
+            inst->monitorPort = port;
+        }
+    }
+
+    // The broker follows the same endpoints
+    SyncCdpBroker();
+}
+
+// WM_CDP_LIVENESS
+static void OnLivenessChanged(const LivenessSnapshot* snapshot) {
+    if (snapshot->instance < 0 || snapshot->instance >= MAX_INSTANCES) return;
+    ChromeInstance* inst = &g_instances[snapshot->instance];
+    if (!inst->hMonitorThread) return;  // Posted before its monitor stopped
+
+    inst->cdpLinkState = snapshot->state;
+    inst->targetCount = snapshot->targetCount;
+    inst->cdpPingRttUs = snapshot->pingRttUs;
+    memcpy(inst->targets, snapshot->targets, sizeof(inst->targets));
+    PublishPageTarget(inst);
+
+    if (snapshot->state == CDP_LINK_UP) {
+        inst->apiResponding = TRUE;
+        strcpy_s(inst->version, sizeof(inst->version), snapshot->browser);
+    } else {
+        // Dropped socket or missed ping deadline - don't wait for the next poll
+        inst->apiResponding = FALSE;
+        if (g_probeMode == PROBE_MODE_HEALTHY) {
+            SetProbeMode(PROBE_MODE_BURST);
+        }
+    }
+
+    RefreshStatusText();
+    UpdateTrayTooltip();
+}
+
+// ============================================================================
+// CDP Broker
+// ============================================================================
+
+// Agents connect to the broker instead of Chrome's own endpoint, so each
+// Chrome serves one browser-level WebSocket however many agents use it. The
+// broker runs on its own thread; the UI thread only points its upstreams at
+// the pool's debug ports.
+
+static DWORD WINAPI BrokerThread(LPVOID param) {
+    CdpBroker* broker = (CdpBroker*)param;
+    if (CdpBrokerRun(broker) == CDP_ERR_CONNECT) {
+        LogMessage(L"CDP broker: can't listen on port %d", broker->listenPort);
+    }
+    return 0;
+}
+
+static void StopCdpBroker(void) {
+    if (!g_hBrokerThread) return;
+
+    // The loop notices within a select slice and settles its cleanup calls in
+    // bounded time; g_broker may only be reused once the thread is gone
+    g_broker.stop = 1;
+    WaitForSingleObject(g_hBrokerThread, INFINITE);
+    CloseHandle(g_hBrokerThread);
+    g_hBrokerThread = NULL;
+}
+
+// Starts, stops or re-points the broker after configuration changes, restarts
+// and failovers. Agents of a Chrome that moved are dropped and reconnect.
+static void SyncCdpBroker(void) {
+    if (g_hBrokerThread && g_broker.listenPort != g_config.brokerPort) {
+        StopCdpBroker();
+    }
+    if (!g_winsockStarted || g_config.brokerPort == 0) return;
+
+    BOOL start = g_hBrokerThread == NULL;
+    if (start) {
+        CdpBrokerInit(&g_broker, BROKER_LISTEN_ADDRESS, g_config.brokerPort);
+        ZeroMemory(g_brokerUpstreams, sizeof(g_brokerUpstreams));
+        g_brokerTabUrls[0] = '\0';
+    }
+
+    char host[CDP_HOST_MAX];
+    GetDevToolsEndpoint(&g_config, host, sizeof(host));
+    for (int i = 0; i < g_config.instanceCount; i++) {
+        CdpEndpoint* handed = &g_brokerUpstreams[i];
+        int port = g_instances[i].debugPort;
+        if (handed->port == port && strcmp(handed->host, host) == 0) continue;
+        if (CdpBrokerSetUpstream(&g_broker, i, host, port)) {
+            strcpy_s(handed->host, sizeof(handed->host), host);
+            handed->port = port;
+        }
+    }
+    g_broker.upstreamCount = g_config.instanceCount;
+    g_broker.poolSize = g_config.contextPoolSize;
+    g_broker.tabPoolSize = g_config.tabPoolSize;
+    char tabPoolUrls[CDP_BROKER_TAB_URL_LIST_MAX];
+    if (!WideCharToMultiByte(CP_UTF8, 0, g_config.tabPoolUrls, -1, tabPoolUrls, sizeof(tabPoolUrls), NULL, NULL)) {
+        tabPoolUrls[0] = '\0';
+    }
+    if (strcmp(tabPoolUrls, g_brokerTabUrls) != 0 && CdpBrokerSetTabUrls(&g_broker, tabPoolUrls)) {
+        strcpy_s(g_brokerTabUrls, sizeof(g_brokerTabUrls), tabPoolUrls);
+    }
+
+    if (start) {
+        g_hBrokerThread = CreateThread(NULL, 0, BrokerThread, &g_broker, 0, NULL);
+    }
+}
+
+static void FormatBrokerStatus(wchar_t* buffer, size_t size) {
+    if (!g_broker.listening) {
+        BOOL failed = WaitForSingleObject(g_hBrokerThread, 0) == WAIT_OBJECT_0;
+        swprintf_s(buffer, size, L"Broker: %ls on :%d", failed ? L"Port unavailable" : L"Starting",
+                   g_config.brokerPort);
+        return;
+    }
+
+    int connected = 0;
+    int sessions = 0;
+    for (int i = 0; i < g_broker.upstreamCount; i++) {
+        if (g_broker.upstreams[i].state == CDP_LINK_UP) connected++;
+        sessions += g_broker.upstreams[i].sessionCount;
+    }
+    swprintf_s(buffer, size, L"Broker: :%d - %d agent%ls, %d session%ls, %d/%d connected",
+               g_config.brokerPort, g_broker.agentCount, g_broker.agentCount == 1 ? L"" : L"s",
+               sessions, sessions == 1 ? L"" : L"s", connected, g_broker.upstreamCount);
+}
+
+// Hits are allocations answered from a ready context; misses waited for one
+// to be created, which is what the pool saves
+static void FormatContextPoolStatus(wchar_t* buffer, size_t size) {
+    int ready = 0;
+    int leased = 0;
+    for (int i = 0; i < g_broker.upstreamCount; i++) {
+        ready += g_broker.upstreams[i].poolReady;
+        leased += g_broker.upstreams[i].poolLeased;
+    }
+    unsigned long allocations = g_broker.allocations;
+    unsigned long hits = g_broker.poolHits;
+    if (allocations == 0) {
+        swprintf_s(buffer, size, L"Contexts: %d ready, none allocated yet", ready);
+        return;
+    }
+    swprintf_s(buffer, size, L"Contexts: %d ready, %d leased - %lu hit%ls of %lu (%lu%%), %.2f ms hit / %.0f ms miss",
+               ready, leased, hits, hits == 1 ? L"" : L"s", allocations, hits * 100 / allocations,
+               hits ? g_broker.hitLatencyUs / 1000.0 / hits : 0.0,
+               allocations > hits ? g_broker.missLatencyUs / 1000.0 / (allocations - hits) : 0.0);
+}
+
+// Time to first interaction: with the pool, how long an allocation of a
+// loaded tab took; without, how long tabs took from creation to their load
+// event
+static void FormatTabPoolStatus(wchar_t* buffer, size_t size) {
+    int ready = 0;
+    int leased = 0;
+    for (int i = 0; i < g_broker.upstreamCount; i++) {
+        ready += g_broker.upstreams[i].tabsReady;
+        leased += g_broker.upstreams[i].tabsLeased;
+    }
+    unsigned long allocations = g_broker.tabAllocations;
+    unsigned long hits = g_broker.tabHits;
+    unsigned long loads = g_broker.tabLoads;
+    double coldMs = loads ? g_broker.tabLoadUs / 1000.0 / loads : 0.0;
+    if (allocations == 0) {
+        swprintf_s(buffer, size, L"Tabs: %d ready, loaded in %.0f ms, none allocated yet", ready, coldMs);
+        return;
+    }
+    swprintf_s(buffer, size, L"Tabs: %d ready, %d leased - %lu hit%ls of %lu (%lu%%), ready in %.2f ms pooled / %.0f ms cold",
+               ready, leased, hits, hits == 1 ? L"" : L"s", allocations, hits * 100 / allocations,
+               hits ? g_broker.tabHitLatencyUs / 1000.0 / hits : 0.0, coldMs);
+}
+
+// ============================================================================
+// Process Telemetry
+// ============================================================================
+
+// Every TELEMETRY_INTERVAL_MS a worker walks the members of each Chrome job
+// and records per-process memory, CPU and I/O plus the job's accounting
+// totals. CDP does not tell which renderer hosts which target; a renderer is
+// attributed to a page only when it is the instance's only renderer and the
+// instance has only one page.
+
+typedef LONG (NTAPI* PFN_NtQueryInformationProcess)(HANDLE, ULONG, PVOID, ULONG, PULONG);
+
+// Layout of the ProcessCommandLineInformation result (a UNICODE_STRING)
+typedef struct {
+    USHORT length;
+    USHORT maximumLength;
+    PWSTR buffer;
+} CommandLineString;
+
+static const wchar_t* GetChromeProcessTypeName(int type) {
+    static const wchar_t* names[] = {
+        L"unknown", L"browser", L"renderer", L"extension", L"GPU", L"utility", L"crashpad"
+    };
+    return (type >= 0 && type < (int)(sizeof(names) / sizeof(names[0]))) ? names[type] : names[0];
+}
+
+static ULONGLONG FileTimeToULL(FILETIME ft) {
+    return ((ULONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+// Role of a Chrome process from its --type switch
+static int QueryChromeProcessType(HANDLE hProcess) {
+    static PFN_NtQueryInformationProcess queryProcess = NULL;
+    if (!queryProcess) {
+        HMODULE ntdll = GetModuleHandleW(L"ntdll.dll");
+        queryProcess = ntdll ? (PFN_NtQueryInformationProcess)(void*)GetProcAddress(ntdll, "NtQueryInformationProcess") : NULL;
+        if (!queryProcess) return CHROME_PROCESS_UNKNOWN;
+    }
+
+    BYTE* buffer = (BYTE*)malloc(TELEMETRY_COMMAND_LINE_MAX);
+    if (!buffer) return CHROME_PROCESS_UNKNOWN;
+
+    int type = CHROME_PROCESS_UNKNOWN;
+    ULONG returned = 0;
+    if (queryProcess(hProcess, PROCESS_COMMAND_LINE_INFORMATION, buffer,
+                     TELEMETRY_COMMAND_LINE_MAX - sizeof(wchar_t), &returned) >= 0) {
+        CommandLineString* commandLine = (CommandLineString*)buffer;
+        size_t chars = commandLine->length / sizeof(wchar_t);
+        wchar_t* text = commandLine->buffer;
+        if (text && (BYTE*)(text + chars) <= buffer + TELEMETRY_COMMAND_LINE_MAX - sizeof(wchar_t)) {
+            text[chars] = L'\0';
+            const wchar_t* value = wcsstr(text, L" --type=");
+            if (!value) {
+                type = CHROME_PROCESS_BROWSER;
+            } else {
+                value += 8;
+                if (wcsncmp(value, L"renderer", 8) == 0) {
+                    type = wcsstr(text, L" --extension-process") ? CHROME_PROCESS_EXTENSION
+                                                                  : CHROME_PROCESS_RENDERER;
+                } else if (wcsncmp(value, L"gpu-process", 11) == 0) {
+                    type = CHROME_PROCESS_GPU;
+                } else if (wcsncmp(value, L"utility", 7) == 0) {
+                    type = CHROME_PROCESS_UTILITY;
+                } else if (wcsncmp(value, L"crashpad-handler", 16) == 0) {
+                    type = CHROME_PROCESS_CRASHPAD;
+                }
+            }
+        }
+    }
+    free(buffer);
+    return type;
+}
+
+static const TrackedProcess* FindTrackedProcess(DWORD pid, ULONGLONG createTime) {
+    for (int i = 0; i < g_telemetry.trackedCount; i++) {
+        const TrackedProcess* tracked = &g_telemetry.tracked[i];
+        if (tracked->pid == pid && tracked->createTime == createTime) return tracked;
+    }
+    return NULL;
+}
+
+// Samples the members of one job. Caller holds the instance lock shared.
+static int SampleJobProcesses(const ChromeInstance* inst, ULONGLONG time, DWORD cpuCount,
+                              ProcessSample* samples, int maxSamples, TrackedProcess* tracked,
+                              int* trackedCount) {
+    size_t listSize = sizeof(JOBOBJECT_BASIC_PROCESS_ID_LIST) + sizeof(ULONG_PTR) * TELEMETRY_MAX_PROCESSES;
+    JOBOBJECT_BASIC_PROCESS_ID_LIST* list = (JOBOBJECT_BASIC_PROCESS_ID_LIST*)malloc(listSize);
+    if (!list) return 0;
+
+    int count = 0;
+    if (QueryInformationJobObject(inst->hJob, JobObjectBasicProcessIdList, list, (DWORD)listSize, NULL) ||
+        GetLastError() == ERROR_MORE_DATA) {
+        for (DWORD i = 0; i < list->NumberOfProcessIdsInList && count < maxSamples; i++) {
+            DWORD pid = (DWORD)list->ProcessIdList[i];
+            HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION | PROCESS_VM_READ, FALSE, pid);
+            if (!hProcess) continue;
+
+            FILETIME created, exited, kernel, user;
+            PROCESS_MEMORY_COUNTERS_EX memory = {0};
+            IO_COUNTERS io = {0};
+            memory.cb = sizeof(memory);
+            if (GetProcessTimes(hProcess, &created, &exited, &kernel, &user)) {
+                ProcessSample* sample = &samples[count++];
+                memset(sample, 0, sizeof(*sample));
+                sample->time = time;
+                sample->instance = inst->index;
+                sample->pid = pid;
+                sample->cpuTime = FileTimeToULL(kernel) + FileTimeToULL(user);
+                if (GetProcessMemoryInfo(hProcess, (PROCESS_MEMORY_COUNTERS*)&memory, sizeof(memory))) {
+                    sample->workingSet = memory.WorkingSetSize;
+                    sample->privateBytes = memory.PrivateUsage;
+                }
+                if (GetProcessIoCounters(hProcess, &io)) {
+                    sample->readBytes = io.ReadTransferCount;
+                    sample->writeBytes = io.WriteTransferCount;
+                }
+
+                // The role never changes; rates need the previous sweep
+                ULONGLONG createTime = FileTimeToULL(created);
+                const TrackedProcess* previous = FindTrackedProcess(pid, createTime);
+                sample->type = previous ? previous->type : QueryChromeProcessType(hProcess);
+                if (previous && time > previous->time && sample->cpuTime >= previous->cpuTime) {
+                    sample->cpuPercent = (double)(sample->cpuTime - previous->cpuTime) * 100.0 /
+                                         ((double)(time - previous->time) * cpuCount);
+                }
+                if (*trackedCount < TELEMETRY_MAX_PROCESSES) {
+                    TrackedProcess* entry = &tracked[(*trackedCount)++];
+                    entry->pid = pid;
+                    entry->createTime = createTime;
+                    entry->type = sample->type;
+                    entry->cpuTime = sample->cpuTime;
+                    entry->time = time;
+                }
+            }
+            CloseHandle(hProcess);
+        }
+    }
+    free(list);
+    return count;
+}
+
+// Job totals. Caller holds the instance lock shared.
+static void SampleJob(const ChromeInstance* inst, ULONGLONG time, DWORD cpuCount, JobSample* job) {
+    JOBOBJECT_BASIC_AND_IO_ACCOUNTING_INFORMATION accounting = {0};
+    JOBOBJECT_EXTENDED_LIMIT_INFORMATION limits = {0};
+
+    memset(job, 0, sizeof(*job));
+    job->time = time;
+    job->instance = inst->index;
+    if (QueryInformationJobObject(inst->hJob, JobObjectBasicAndIoAccountingInformation,
+                                  &accounting, sizeof(accounting), NULL)) {
+        job->activeProcesses = accounting.BasicInfo.ActiveProcesses;
+        job->totalProcesses = accounting.BasicInfo.TotalProcesses;
+        job->cpuTime = (ULONGLONG)accounting.BasicInfo.TotalUserTime.QuadPart +
+                       (ULONGLONG)accounting.BasicInfo.TotalKernelTime.QuadPart;
+        job->readBytes = accounting.IoInfo.ReadTransferCount;
+        job->writeBytes = accounting.IoInfo.WriteTransferCount;
+    }
+    if (QueryInformationJobObject(inst->hJob, JobObjectExtendedLimitInformation,
+                                  &limits, sizeof(limits), NULL)) {
+        job->peakJobMemory = limits.PeakJobMemoryUsed;
+    }
+
+    // Rates only within the same job; a relaunch starts the totals over
+    int i = inst->index;
+    if (g_telemetry.jobGeneration[i] == inst->generation && time > g_telemetry.jobTime[i] &&
+        job->cpuTime >= g_telemetry.jobCpuTime[i]) {
+        job->cpuPercent = (double)(job->cpuTime - g_telemetry.jobCpuTime[i]) * 100.0 /
+                          ((double)(time - g_telemetry.jobTime[i]) * cpuCount);
+    }
+    g_telemetry.jobGeneration[i] = inst->generation;
+    g_telemetry.jobCpuTime[i] = job->cpuTime;
+    g_telemetry.jobTime[i] = time;
+}
+
+// Task.param: bit i set = sample instance i (running, no lifecycle task queued)
+static void TelemetryRun(Task* task) {
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    ULONGLONG time = FileTimeToULL(now);
+    SYSTEM_INFO system;
+    GetSystemInfo(&system);
+    DWORD cpuCount = system.dwNumberOfProcessors ? system.dwNumberOfProcessors : 1;
+
+    ProcessSample* samples = (ProcessSample*)malloc(sizeof(ProcessSample) * TELEMETRY_MAX_PROCESSES);
+    TrackedProcess* tracked = (TrackedProcess*)malloc(sizeof(TrackedProcess) * TELEMETRY_MAX_PROCESSES);
+    if (!samples || !tracked) {
+        free(samples);
+        free(tracked);
+        return;
+    }
+
+    JobSample jobs[STANDBY_INDEX + 1];
+    int jobCount = 0, sampleCount = 0, trackedCount = 0;
+    for (int i = 0; i <= STANDBY_INDEX; i++) {
+        if (!(task->param & ((LONG_PTR)1 << i))) continue;
+        ChromeInstance* inst = &g_instances[i];
+
+        // A lifecycle task queued since only waits for this one instance
+        AcquireSRWLockShared(&inst->lock);
+        if (inst->hJob) {
+            SampleJob(inst, time, cpuCount, &jobs[jobCount++]);
+            int first = sampleCount;
+            sampleCount += SampleJobProcesses(inst, time, cpuCount, samples + sampleCount,
+                                              TELEMETRY_MAX_PROCESSES - sampleCount, tracked, &trackedCount);
+
+            // Attribute the renderer when it can only be rendering the one page
+            int renderers = 0, renderer = -1;
+            for (int n = first; n < sampleCount; n++) {
+                if (samples[n].type == CHROME_PROCESS_RENDERER) {
+                    renderers++;
+                    renderer = n;
+                }
+            }
+            if (renderers == 1) {
+                AcquireSRWLockShared(&g_telemetry.lock);
+                strcpy_s(samples[renderer].targetId, sizeof(samples[renderer].targetId),
+                         g_telemetry.pageTargets[i]);
+                ReleaseSRWLockShared(&g_telemetry.lock);
+            }
+        }
+        ReleaseSRWLockShared(&inst->lock);
+    }
+
+    memcpy(g_telemetry.tracked, tracked, sizeof(TrackedProcess) * trackedCount);
+    g_telemetry.trackedCount = trackedCount;
+
+    AcquireSRWLockExclusive(&g_telemetry.lock);
+    for (int j = 0; j < jobCount; j++) {
+        g_telemetry.jobs[g_telemetry.jobCount++ % TELEMETRY_JOB_RING] = jobs[j];
+    }
+    for (int n = 0; n < sampleCount; n++) {
+        g_telemetry.processes[g_telemetry.processCount++ % TELEMETRY_PROCESS_RING] = samples[n];
+    }
+    if (jobCount > 0) g_telemetry.lastSweep = time;
+    ReleaseSRWLockExclusive(&g_telemetry.lock);
+
+    free(samples);
+    free(tracked);
+}
+
+static void TelemetryComplete(Task* task) {
+    (void)task;
+    g_telemetryPending = FALSE;
+}
+
+// ID_TIMER_TELEMETRY
+static void QueueTelemetrySweep(void) {
+    if (g_telemetryPending) return;
+
+    LONG_PTR instances = 0;
+    for (int i = 0; i <= STANDBY_INDEX; i++) {
+        const ChromeInstance* inst = &g_instances[i];
+        if (i < MAX_INSTANCES && i >= g_config.instanceCount) continue;
+        if (inst->running && inst->tasksPending == 0) instances |= (LONG_PTR)1 << i;
+    }
+    if (instances && QueueTask(TelemetryRun, TelemetryComplete, instances, NULL)) {
+        g_telemetryPending = TRUE;
+    }
+}
+
+// The instance's page target for renderer attribution, "" unless it has exactly one
+static void PublishPageTarget(const ChromeInstance* inst) {
+    const char* targetId = "";
+    int pages = 0;
+    for (int i = 0; i < inst->targetCount && i < CDP_MAX_TARGETS; i++) {
+        if (strcmp(inst->targets[i].type, "page") == 0 && pages++ == 0) {
+            targetId = inst->targets[i].targetId;
+        }
+    }
+
+    AcquireSRWLockExclusive(&g_telemetry.lock);
+    strcpy_s(g_telemetry.pageTargets[inst->index], sizeof(g_telemetry.pageTargets[0]),
+             pages == 1 ? targetId : "");
+    ReleaseSRWLockExclusive(&g_telemetry.lock);
+}
+
+// The launcher's own CPU use since it started, to compare windowed Chrome
+// (the show hook runs in this process) with headless
+static void FormatLauncherCpu(wchar_t* buffer, size_t size) {
+    FILETIME created, exited, kernel, user, now;
+    buffer[0] = L'\0';
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return;
+    GetSystemTimeAsFileTime(&now);
+
+    ULONGLONG cpu = FileTimeToULL(kernel) + FileTimeToULL(user);
+    ULONGLONG wall = FileTimeToULL(now) - FileTimeToULL(created);
+    swprintf_s(buffer, size, L"Launcher: %.2f s CPU in %.0f min (%.3f%% of one CPU), %ls",
+               (double)cpu / 1e7, (double)wall / 6e8, wall ? (double)cpu * 100.0 / (double)wall : 0.0,
+               g_config.headless ? L"headless" : L"windowed");
+}
+
+static const char* FindTargetUrl(const ChromeInstance* inst, const char* targetId) {
+    if (!targetId[0]) return NULL;
+    for (int i = 0; i < inst->targetCount && i < CDP_MAX_TARGETS; i++) {
+        if (strcmp(inst->targets[i].targetId, targetId) == 0) return inst->targets[i].url;
+    }
+    return NULL;
+}
+
+// ISO 8601 UTC with milliseconds
+static void FormatSampleTime(ULONGLONG time, char* buffer, size_t size) {
+    FILETIME ft;
+    SYSTEMTIME st;
+    ft.dwLowDateTime = (DWORD)time;
+    ft.dwHighDateTime = (DWORD)(time >> 32);
+    FileTimeToSystemTime(&ft, &st);
+    snprintf(buffer, size, "%04d-%02d-%02dT%02d:%02d:%02d.%03dZ", st.wYear, st.wMonth, st.wDay,
+             st.wHour, st.wMinute, st.wSecond, st.wMilliseconds);
+}
+
+static void FormatSampleInstance(int instance, char* buffer, size_t size) {
+    if (instance == STANDBY_INDEX) {
+        strcpy_s(buffer, size, "standby");
+    } else {
+        snprintf(buffer, size, "%d", instance + 1);
+    }
+}
+
+// System time (FILETIME units) of a CdpNowUs() reading
+static ULONGLONG MonotonicToSystemTime(unsigned long long us) {
+    FILETIME now;
+    GetSystemTimeAsFileTime(&now);
+    unsigned long long elapsed = CdpNowUs() - us;
+    return FileTimeToULL(now) - (ULONGLONG)elapsed * 10;
+}
+
+// Writes both rings, oldest first, as one CSV: "job" rows carry the job
+// columns, "process" rows the per-process ones. A "launch" row per running
+// Chrome carries its startup latency, a "failover" row the last failover.
+static BOOL WriteTelemetryCsv(const wchar_t* path) {
+    HANDLE hFile = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return FALSE;
+
+    char line[768];
+    DWORD written = 0;
+    BOOL ok = TRUE;
+    int len = snprintf(line, sizeof(line),
+                       "record,time,instance,pid,type,target_id,target_url,working_set,private_bytes,"
+                       "cpu_time_ms,cpu_percent,read_bytes,write_bytes,active_processes,total_processes,"
+                       "peak_job_memory,time_to_ready_ms,failover_ms\r\n");
+    ok = WriteFile(hFile, line, (DWORD)len, &written, NULL);
+
+    AcquireSRWLockShared(&g_telemetry.lock);
+    ULONG first = g_telemetry.jobCount > TELEMETRY_JOB_RING ? g_telemetry.jobCount - TELEMETRY_JOB_RING : 0;
+    for (ULONG j = first; ok && j < g_telemetry.jobCount; j++) {
+        const JobSample* job = &g_telemetry.jobs[j % TELEMETRY_JOB_RING];
+        char time[32], instance[16];
+        FormatSampleTime(job->time, time, sizeof(time));
+        FormatSampleInstance(job->instance, instance, sizeof(instance));
+        len = snprintf(line, sizeof(line), "job,%s,%s,,,,,,,%llu,%.1f,%llu,%llu,%lu,%lu,%llu,,\r\n",
+                       time, instance, job->cpuTime / 10000, job->cpuPercent, job->readBytes,
+                       job->writeBytes, job->activeProcesses, job->totalProcesses,
+                       (ULONGLONG)job->peakJobMemory);
+        ok = len > 0 && WriteFile(hFile, line, (DWORD)len, &written, NULL);
+    }
+
+    first = g_telemetry.processCount > TELEMETRY_PROCESS_RING ? g_telemetry.processCount - TELEMETRY_PROCESS_RING : 0;
+    for (ULONG n = first; ok && n < g_telemetry.processCount; n++) {
+        const ProcessSample* sample = &g_telemetry.processes[n % TELEMETRY_PROCESS_RING];
+        char time[32], instance[16], type[16];
+        FormatSampleTime(sample->time, time, sizeof(time));
+        FormatSampleInstance(sample->instance, instance, sizeof(instance));
+        WideCharToMultiByte(CP_UTF8, 0, GetChromeProcessTypeName(sample->type), -1, type, sizeof(type), NULL, NULL);
+
+        // URLs may contain commas; quote them (and double embedded quotes)
+        char url[2 * sizeof(((CdpTargetInfo*)0)->url) + 3] = "";
+        const char* targetUrl = FindTargetUrl(&g_instances[sample->instance], sample->targetId);
+        if (targetUrl) {
+            size_t u = 0;
+            url[u++] = '"';
+            for (const char* c = targetUrl; *c && u < sizeof(url) - 3; c++) {
+                if (*c == '"') url[u++] = '"';
+                url[u++] = *c;
+            }
+            url[u++] = '"';
+            url[u] = '\0';
+        }
+        len = snprintf(line, sizeof(line), "process,%s,%s,%lu,%s,%s,%s,%llu,%llu,%llu,%.1f,%llu,%llu,,,,,\r\n",
+                       time, instance, sample->pid, type, sample->targetId, url,
+                       (ULONGLONG)sample->workingSet, (ULONGLONG)sample->privateBytes,
+                       sample->cpuTime / 10000, sample->cpuPercent, sample->readBytes, sample->writeBytes);
+        ok = len > 0 && (size_t)len < sizeof(line) && WriteFile(hFile, line, (DWORD)len, &written, NULL);
+    }
+    ReleaseSRWLockShared(&g_telemetry.lock);
+
+    // Startup latency, empty while a Chrome is not ready yet
+    for (int i = 0; ok && i <= STANDBY_INDEX; i++) {
+        const ChromeInstance* inst = &g_instances[i];
+        if (!inst->running || !inst->launchUs) continue;
+        char time[32], instance[16], ready[32] = "";
+        FormatSampleTime(MonotonicToSystemTime(inst->launchUs), time, sizeof(time));
+        FormatSampleInstance(i, instance, sizeof(instance));
+        if (inst->timeToReadyMs > 0) snprintf(ready, sizeof(ready), "%.0f", inst->timeToReadyMs);
+        len = snprintf(line, sizeof(line), "launch,%s,%s,%lu,,,,,,,,,,,,,%s,\r\n",
+                       time, instance, inst->pid, ready);
+        ok = len > 0 && WriteFile(hFile, line, (DWORD)len, &written, NULL);
+    }
+    if (ok && g_status.failoverCount > 0) {
+        char time[32], instance[16];
+        FormatSampleTime(MonotonicToSystemTime(g_status.lastFailoverUs), time, sizeof(time));
+        FormatSampleInstance(g_status.lastFailoverInstance, instance, sizeof(instance));
+        len = snprintf(line, sizeof(line), "failover,%s,%s,,,,,,,,,,,,,,,%.0f\r\n",
+                       time, instance, g_status.lastFailoverMs);
+        ok = len > 0 && WriteFile(hFile, line, (DWORD)len, &written, NULL);
+    }
+
+    CloseHandle(hFile);
+    return ok;
+}
+
+// Tray "Processes > Export...": saves the sample rings as CSV
+static void ExportTelemetry(HWND hwnd) {
+    OPENFILENAMEW ofn = {0};
+    wchar_t path[MAX_PATH] = L"chrome-telemetry.csv";
+
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = hwnd;
+    ofn.lpstrFile = path;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.lpstrFilter = L"CSV Files (*.csv)\0*.csv\0All Files (*.*)\0*.*\0";
+    ofn.nFilterIndex = 1;
+    ofn.lpstrDefExt = L"csv";
+    ofn.lpstrTitle = L"Export Process Telemetry";
+    ofn.Flags = OFN_OVERWRITEPROMPT | OFN_PATHMUSTEXIST;
+
+    if (GetSaveFileNameW(&ofn) && !WriteTelemetryCsv(path)) {
+        MessageBoxW(hwnd, L"Failed to write the telemetry file.", APP_NAME, MB_OK | MB_ICONERROR);
+    }
+}
+
+// ============================================================================
+// Network Interface Enumeration
+// ============================================================================
+
+static int EnumerateNonLoopbackInterfaces(PortForwardEntry* entries, int maxCount) {
+    int count = 0;
+
+    ULONG bufferSize = 15000;
+    PIP_ADAPTER_ADDRESSES pAddresses = (PIP_ADAPTER_ADDRESSES)malloc(bufferSize);
+    if (!pAddresses) return 0;
+
+    ULONG result = GetAdaptersAddresses(AF_INET, GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST,
+                                         NULL, pAddresses, &bufferSize);
+
+    if (result == ERROR_BUFFER_OVERFLOW) {
+        free(pAddresses);
+        pAddresses = (PIP_ADAPTER_ADDRESSES)malloc(bufferSize);
+        if (!pAddresses) return 0;
+        result = GetAdaptersAddresses(AF_INET, GAA_FLAG_SKIP_ANYCAST | GAA_FLAG_SKIP_MULTICAST,
+                                       NULL, pAddresses, &bufferSize);
+    }
+
+    if (result != NO_ERROR) {
+        free(pAddresses);
+        return 0;
+    }
+
+    PIP_ADAPTER_ADDRESSES pCurrent = pAddresses;
+    while (pCurrent && count < maxCount) {
+        // Skip loopback adapter
+        if (pCurrent->IfType == IF_TYPE_SOFTWARE_LOOPBACK) {
+            pCurrent = pCurrent->Next;
+            continue;
+        }
+
+        // Skip adapters that are not up
+        if (pCurrent->OperStatus != IfOperStatusUp) {
+            pCurrent = pCurrent->Next;
+            continue;
+        }
+
+        // Get unicast addresses
+        PIP_ADAPTER_UNICAST_ADDRESS pUnicast = pCurrent->FirstUnicastAddress;
+        while (pUnicast && count < maxCount) {
+            if (pUnicast->Address.lpSockaddr->sa_family == AF_INET) {
+                struct sockaddr_in* addr = (struct sockaddr_in*)pUnicast->Address.lpSockaddr;
+                char* ipStr = inet_ntoa(addr->sin_addr);
+
+                // Skip 127.x.x.x addresses
+                if (strncmp(ipStr, "127.", 4) != 0) {
+                    strncpy_s(entries[count].listenIP, 16, ipStr, 15);
+                    entries[count].listenPort = 0;  // Will be set when adding forward
+                    entries[count].active = FALSE;
+                    entries[count].backend = FORWARD_BACKEND_NONE;
+                    entries[count].relay = NULL;
+                    entries[count].failures = 0;
+                    entries[count].retryTick = 0;
+                    count++;
+                }
+            }
+            pUnicast = pUnicast->Next;
+        }
+
+        pCurrent = pCurrent->Next;
+    }
+
+    free(pAddresses);
+    return count;
+}
+
+// ============================================================================
+// Built-in TCP Relay (IOCP)
+// ============================================================================
+
+static void RelayReleaseListener(RelayListener* listener) {
+    if (InterlockedDecrement(&listener->refCount) == 0) {
+        DeleteCriticalSection(&listener->lock);
+        free(listener);
+        InterlockedDecrement(&g_relayLiveObjects);
+    }
+}
+
+static void RelayCloseConnection(RelayConnection* conn) {
+    if (InterlockedExchange(&conn->closed, 1) != 0) return;
+
+    // Fail any new operation fast and cancel the pending ones; the sockets
+    // themselves are closed once the last completion has been consumed
+    shutdown(conn->client, SD_BOTH);
+    shutdown(conn->upstream, SD_BOTH);
+    CancelIoEx((HANDLE)conn->client, NULL);
+    CancelIoEx((HANDLE)conn->upstream, NULL);
+}
+
+static void RelayReleaseConnection(RelayConnection* conn) {
+    if (InterlockedDecrement(&conn->refCount) != 0) return;
+
+    RelayListener* listener = conn->listener;
+
+    EnterCriticalSection(&listener->lock);
+    if (conn->prev) conn->prev->next = conn->next;
+    else listener->connections = conn->next;
+    if (conn->next) conn->next->prev = conn->prev;
+    LeaveCriticalSection(&listener->lock);
+
+    closesocket(conn->client);
+    closesocket(conn->upstream);
+    InterlockedDecrement(&listener->connectionsActive);
+    free(conn);
+    InterlockedDecrement(&g_relayLiveObjects);
+
+    RelayReleaseListener(listener);
+}
+
+static BOOL RelayPostRecv(RelayConnection* conn, int direction) {
+    RelayIo* io = &conn->io[direction];
+    SOCKET src = (direction == RELAY_DIR_UPSTREAM) ? conn->client : conn->upstream;
+
+    ZeroMemory(&io->ov, sizeof(io->ov));
+    io->op = RELAY_OP_RECV;
+    io->length = 0;
+    io->sent = 0;
+
+    WSABUF wsaBuf = { RELAY_BUFFER_SIZE, io->buffer };
+    DWORD flags = 0;
+
+    InterlockedIncrement(&conn->refCount);
+    if (WSARecv(src, &wsaBuf, 1, NULL, &flags, &io->ov, NULL) == SOCKET_ERROR &&
+        WSAGetLastError() != WSA_IO_PENDING) {
+        InterlockedDecrement(&conn->refCount);  // Caller still holds a reference
+        RelayCloseConnection(conn);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static BOOL RelayPostSend(RelayConnection* conn, int direction) {
+    RelayIo* io = &conn->io[direction];
+    SOCKET dst = (direction == RELAY_DIR_UPSTREAM) ? conn->upstream : conn->client;
+
+    ZeroMemory(&io->ov, sizeof(io->ov));
+    io->op = RELAY_OP_SEND;
+
+    WSABUF wsaBuf = { io->length - io->sent, io->buffer + io->sent };
+
+    InterlockedIncrement(&conn->refCount);
+    if (WSASend(dst, &wsaBuf, 1, NULL, 0, &io->ov, NULL) == SOCKET_ERROR &&
+        WSAGetLastError() != WSA_IO_PENDING) {
+        InterlockedDecrement(&conn->refCount);
+        RelayCloseConnection(conn);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static BOOL RelayPostAccept(RelayListener* listener) {
+    if (listener->closed) return FALSE;
+
+    listener->acceptSock = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_OVERLAPPED);
+    if (listener->acceptSock == INVALID_SOCKET) return FALSE;
+
+    ZeroMemory(&listener->acceptIo.ov, sizeof(listener->acceptIo.ov));
+    listener->acceptIo.op = RELAY_OP_ACCEPT;
+    listener->acceptIo.conn = NULL;
+
+    InterlockedIncrement(&listener->refCount);
+    DWORD bytes = 0;
+    if (!g_pfnAcceptEx(listener->sock, listener->acceptSock, listener->acceptIo.buffer, 0,
+                       RELAY_ADDR_LEN, RELAY_ADDR_LEN, &bytes, &listener->acceptIo.ov) &&
+        WSAGetLastError() != WSA_IO_PENDING) {
+        closesocket(listener->acceptSock);
+        listener->acceptSock = INVALID_SOCKET;
+        RelayReleaseListener(listener);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+static void RelayOnAccept(RelayListener* listener, BOOL ok) {
+    SOCKET client = listener->acceptSock;
+    listener->acceptSock = INVALID_SOCKET;
+
+    if (!ok || listener->closed) {
+        closesocket(client);
+        RelayPostAccept(listener);
+        RelayReleaseListener(listener);
+        return;
+    }
+
+    setsockopt(client, SOL_SOCKET, SO_UPDATE_ACCEPT_CONTEXT,
+               (const char*)&listener->sock, sizeof(listener->sock));
+
+    // Keep the listener accepting while this connection is being set up
+    RelayPostAccept(listener);
+
+    RelayConnection* conn = (RelayConnection*)calloc(1, sizeof(RelayConnection));
+    SOCKET upstream = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_OVERLAPPED);
+    struct sockaddr_in anyAddr = {0};
+    anyAddr.sin_family = AF_INET;
+
+    if (!conn || upstream == INVALID_SOCKET ||
+        bind(upstream, (struct sockaddr*)&anyAddr, sizeof(anyAddr)) == SOCKET_ERROR ||
+        !CreateIoCompletionPort((HANDLE)client, g_hRelayPort, RELAY_KEY_IO, 0) ||
+        !CreateIoCompletionPort((HANDLE)upstream, g_hRelayPort, RELAY_KEY_IO, 0)) {
+        if (upstream != INVALID_SOCKET) closesocket(upstream);
+        closesocket(client);
+        free(conn);
+        RelayReleaseListener(listener);
+        return;
+    }
+
+    // CDP traffic is small request/response messages - don't let Nagle batch them
+    BOOL noDelay = TRUE;
+    setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+    setsockopt(upstream, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+    // The accept reference now belongs to the connection
+    conn->listener = listener;
+    conn->client = client;
+    conn->upstream = upstream;
+    AcquireSRWLockShared(&listener->upstreamLock);
+    conn->upstreamAddr = listener->upstream;
+    ReleaseSRWLockShared(&listener->upstreamLock);
+    conn->refCount = 1;  // Pending connect
+    conn->io[RELAY_DIR_UPSTREAM].conn = conn;
+    conn->io[RELAY_DIR_UPSTREAM].direction = RELAY_DIR_UPSTREAM;
+    conn->io[RELAY_DIR_DOWNSTREAM].conn = conn;
+    conn->io[RELAY_DIR_DOWNSTREAM].direction = RELAY_DIR_DOWNSTREAM;
+    InterlockedIncrement(&g_relayLiveObjects);
+    InterlockedIncrement(&listener->connectionsActive);
+    InterlockedIncrement(&listener->connectionsTotal);
+
+    EnterCriticalSection(&listener->lock);
+    conn->next = listener->connections;
+    if (conn->next) conn->next->prev = conn;
+    listener->connections = conn;
+    LeaveCriticalSection(&listener->lock);
+
+    // Listener stopped while we were setting up - it will not see this connection
+    if (listener->closed) {
+        RelayCloseConnection(conn);
+        RelayReleaseConnection(conn);
+        return;
+    }
+
+    RelayIo* io = &conn->io[RELAY_DIR_UPSTREAM];
+    ZeroMemory(&io->ov, sizeof(io->ov));
+    io->op = RELAY_OP_CONNECT;
+
+    if (!g_pfnConnectEx(upstream, (struct sockaddr*)&conn->upstreamAddr, sizeof(conn->upstreamAddr),
+                        NULL, 0, NULL, &io->ov) &&
+        WSAGetLastError() != WSA_IO_PENDING) {
+        RelayCloseConnection(conn);
+        RelayReleaseConnection(conn);
+    }
+}
+
+static void RelayOnConnect(RelayConnection* conn, BOOL ok) {
+    if (ok && !conn->closed) {
+        setsockopt(conn->upstream, SOL_SOCKET, SO_UPDATE_CONNECT_CONTEXT, NULL, 0);
+        if (RelayPostRecv(conn, RELAY_DIR_UPSTREAM)) {
+            RelayPostRecv(conn, RELAY_DIR_DOWNSTREAM);
+        }
+    } else {
+        RelayCloseConnection(conn);
+    }
+    RelayReleaseConnection(conn);
+}
+
+static void RelayOnRecv(RelayConnection* conn, RelayIo* io, DWORD bytes, BOOL ok) {
+    if (!ok || conn->closed) {
+        RelayCloseConnection(conn);
+    } else if (bytes == 0) {
+        // Peer half-closed: propagate it and let the other direction drain
+        SOCKET dst = (io->direction == RELAY_DIR_UPSTREAM) ? conn->upstream : conn->client;
+        shutdown(dst, SD_SEND);
+        if (InterlockedIncrement(&conn->eofCount) == 2) {
+            RelayCloseConnection(conn);
+        }
+    } else {
+        RelayListener* listener = conn->listener;
+        InterlockedExchangeAdd64(io->direction == RELAY_DIR_UPSTREAM ? &listener->bytesUp
+                                                                     : &listener->bytesDown,
+                                 (LONG64)bytes);
+        io->length = bytes;
+        io->sent = 0;
+        RelayPostSend(conn, io->direction);
+    }
+    RelayReleaseConnection(conn);
+}
+
+static void RelayOnSend(RelayConnection* conn, RelayIo* io, DWORD bytes, BOOL ok) {
+    if (!ok || conn->closed || bytes == 0) {
+        RelayCloseConnection(conn);
+    } else {
+        io->sent += bytes;
+        if (io->sent < io->length) {
+            RelayPostSend(conn, io->direction);  // Partial send - push the rest
+        } else {
+            RelayPostRecv(conn, io->direction);
+        }
+    }
+    RelayReleaseConnection(conn);
+}
+
+static DWORD WINAPI RelayWorkerThread(LPVOID param) {
+    (void)param;
+
+    for (;;) {
+        DWORD bytes = 0;
+        ULONG_PTR key = 0;
+        OVERLAPPED* ov = NULL;
+        BOOL ok = GetQueuedCompletionStatus(g_hRelayPort, &bytes, &key, &ov, INFINITE);
+
+        if (!ov) {
+            if (key == RELAY_KEY_SHUTDOWN) break;
+            continue;
+        }
+
+        RelayIo* io = (RelayIo*)ov;
+        switch (io->op) {
+            case RELAY_OP_ACCEPT: {
+                // acceptIo is embedded in the listener
+                RelayListener* listener = (RelayListener*)((char*)io - offsetof(RelayListener, acceptIo));
+                RelayOnAccept(listener, ok);
+                break;
+            }
+            case RELAY_OP_CONNECT:
+                RelayOnConnect(io->conn, ok);
+                break;
+            case RELAY_OP_RECV:
+                RelayOnRecv(io->conn, io, bytes, ok);
+                break;
+            case RELAY_OP_SEND:
+                RelayOnSend(io->conn, io, bytes, ok);
+                break;
+        }
+    }
+
+    return 0;
+}
+
+static BOOL RelayLoadExtension(SOCKET sock, GUID guid, void** fn) {
+    DWORD bytes = 0;
+    return WSAIoctl(sock, SIO_GET_EXTENSION_FUNCTION_POINTER, &guid, sizeof(guid),
+                    fn, sizeof(*fn), &bytes, NULL, NULL) == 0 && *fn != NULL;
+}
+
+static BOOL RelayStartup(void) {
+    if (g_hRelayPort) return TRUE;
+
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) {
+        return FALSE;
+    }
+
+    // AcceptEx/ConnectEx are Winsock extensions - resolve them at runtime
+    SOCKET probe = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_OVERLAPPED);
+    if (probe == INVALID_SOCKET) {
+        WSACleanup();
+        return FALSE;
+    }
+    GUID acceptExGuid = WSAID_ACCEPTEX;
+    GUID connectExGuid = WSAID_CONNECTEX;
+    BOOL loaded = RelayLoadExtension(probe, acceptExGuid, (void**)&g_pfnAcceptEx) &&
+                  RelayLoadExtension(probe, connectExGuid, (void**)&g_pfnConnectEx);
+    closesocket(probe);
+    if (!loaded) {
+        WSACleanup();
+        return FALSE;
+    }
+
+    g_hRelayPort = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0);
+    if (!g_hRelayPort) {
+        WSACleanup();
+        return FALSE;
+    }
+
+    SYSTEM_INFO sysInfo;
+    GetSystemInfo(&sysInfo);
+    int workers = (int)sysInfo.dwNumberOfProcessors;
+    if (workers < RELAY_MIN_WORKERS) workers = RELAY_MIN_WORKERS;
+    if (workers > RELAY_MAX_WORKERS) workers = RELAY_MAX_WORKERS;
+
+    g_relayWorkerCount = 0;
+    for (int i = 0; i < workers; i++) {
+        HANDLE hThread = CreateThread(NULL, 0, RelayWorkerThread, NULL, 0, NULL);
+        if (hThread) {
+            g_relayWorkers[g_relayWorkerCount++] = hThread;
+        }
+    }
+
+    if (g_relayWorkerCount == 0) {
+        CloseHandle(g_hRelayPort);
+        g_hRelayPort = NULL;
+        WSACleanup();
+        return FALSE;
+    }
+
+    return TRUE;
+}
+
+static void RelayShutdown(void) {
+    if (!g_hRelayPort) return;
+
+    // Give the workers a moment to consume the cancellations of closed listeners
+    ULONGLONG deadline = GetTickCount64() + RELAY_DRAIN_TIMEOUT_MS;
+    while (g_relayLiveObjects > 0 && GetTickCount64() < deadline) {
+        Sleep(10);
+    }
+
+    for (int i = 0; i < g_relayWorkerCount; i++) {
+        PostQueuedCompletionStatus(g_hRelayPort, 0, RELAY_KEY_SHUTDOWN, NULL);
+    }
+    WaitForMultipleObjects((DWORD)g_relayWorkerCount, g_relayWorkers, TRUE, RELAY_DRAIN_TIMEOUT_MS);
+    for (int i = 0; i < g_relayWorkerCount; i++) {
+        CloseHandle(g_relayWorkers[i]);
+        g_relayWorkers[i] = NULL;
+    }
+    g_relayWorkerCount = 0;
+
+    CloseHandle(g_hRelayPort);
+    g_hRelayPort = NULL;
+    WSACleanup();
+}
+
+static RelayListener* RelayStartListener(const char* listenIP, int listenPort,
+                                         const char* connectIP, int connectPort) {
+    if (!RelayStartup()) return NULL;
+
+    RelayListener* listener = (RelayListener*)calloc(1, sizeof(RelayListener));
+    if (!listener) return NULL;
+
+    strncpy_s(listener->listenIP, sizeof(listener->listenIP), listenIP, sizeof(listener->listenIP) - 1);
+    listener->listenPort = listenPort;
+    listener->acceptSock = INVALID_SOCKET;
+    listener->refCount = 1;  // Owner reference, dropped by RelayStopListener
+    listener->upstream.sin_family = AF_INET;
+    listener->upstream.sin_port = htons((USHORT)connectPort);
+    InitializeSRWLock(&listener->upstreamLock);
+    InitializeCriticalSection(&listener->lock);
+    InterlockedIncrement(&g_relayLiveObjects);
+
+    struct sockaddr_in bindAddr = {0};
+    bindAddr.sin_family = AF_INET;
+    bindAddr.sin_port = htons((USHORT)listenPort);
+
+    BOOL exclusive = TRUE;
+    listener->sock = WSASocketW(AF_INET, SOCK_STREAM, IPPROTO_TCP, NULL, 0, WSA_FLAG_OVERLAPPED);
+    if (listener->sock == INVALID_SOCKET ||
+        inet_pton(AF_INET, listenIP, &bindAddr.sin_addr) != 1 ||
+        inet_pton(AF_INET, connectIP, &listener->upstream.sin_addr) != 1 ||
+        setsockopt(listener->sock, SOL_SOCKET, SO_EXCLUSIVEADDRUSE,
+                   (const char*)&exclusive, sizeof(exclusive)) == SOCKET_ERROR ||
+        bind(listener->sock, (struct sockaddr*)&bindAddr, sizeof(bindAddr)) == SOCKET_ERROR ||
+        listen(listener->sock, SOMAXCONN) == SOCKET_ERROR ||
+        !CreateIoCompletionPort((HANDLE)listener->sock, g_hRelayPort, RELAY_KEY_IO, 0) ||
+        !RelayPostAccept(listener)) {
+        if (listener->sock != INVALID_SOCKET) closesocket(listener->sock);
+        listener->closed = 1;
+        RelayReleaseListener(listener);
+        return NULL;
+    }
+
+    return listener;
+}
+
+static void RelayStopListener(RelayListener* listener) {
+    if (!listener) return;
+    if (InterlockedExchange(&listener->closed, 1) != 0) return;
+
+    // Cancels the pending AcceptEx; its completion drops that reference
+    closesocket(listener->sock);
+
+    EnterCriticalSection(&listener->lock);
+    for (RelayConnection* conn = listener->connections; conn; conn = conn->next) {
+        RelayCloseConnection(conn);
+    }
+    LeaveCriticalSection(&listener->lock);
+
+    RelayReleaseListener(listener);
+}
+
+// Points new connections at another upstream port. Established connections
+// keep their upstream; each accepted client copies the address for its
+// ConnectEx under upstreamLock.
+static void RelaySetUpstreamPort(RelayListener* listener, int connectPort) {
+    if (!listener) return;
+    AcquireSRWLockExclusive(&listener->upstreamLock);
+    listener->upstream.sin_port = htons((USHORT)connectPort);
+    ReleaseSRWLockExclusive(&listener->upstreamLock);
+}
+
+// ============================================================================
+// Port Forwarding
+// ============================================================================
+
+// Runs a hidden console process and waits for it; returns FALSE if it could not be
+// started or did not finish within timeoutMs
+static BOOL RunHiddenProcess(char* cmd, DWORD timeoutMs, DWORD* exitCode) {
+    STARTUPINFOA si = {0};
+    PROCESS_INFORMATION pi = {0};
+    si.cb = sizeof(si);
+    si.dwFlags = STARTF_USESHOWWINDOW;
+    si.wShowWindow = SW_HIDE;
+
+    if (!CreateProcessA(NULL, cmd, NULL, NULL, FALSE,
+                        CREATE_NO_WINDOW, NULL, NULL, &si, &pi)) {
+        return FALSE;
+    }
+
+    BOOL finished = (WaitForSingleObject(pi.hProcess, timeoutMs) == WAIT_OBJECT_0);
+    DWORD code = (DWORD)-1;
+    GetExitCodeProcess(pi.hProcess, &code);
+    CloseHandle(pi.hProcess);
+    CloseHandle(pi.hThread);
+
+    if (exitCode) *exitCode = code;
+    return finished;
+}
+
+static BOOL AddPortForward(const char* listenIP, int listenPort, const char* connectIP, int connectPort) {
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd),
+             "netsh interface portproxy add v4tov4 listenaddress=%s listenport=%d "
+             "connectaddress=%s connectport=%d",
+             listenIP, listenPort, connectIP, connectPort);
+
+    DWORD exitCode;
+    return RunHiddenProcess(cmd, NETSH_TIMEOUT_MS, &exitCode) && exitCode == 0;
+}
+
+static BOOL SetPortForward(const char* listenIP, int listenPort, const char* connectIP, int connectPort) {
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd),
+             "netsh interface portproxy set v4tov4 listenaddress=%s listenport=%d "
+             "connectaddress=%s connectport=%d",
+             listenIP, listenPort, connectIP, connectPort);
+
+    DWORD exitCode;
+    return RunHiddenProcess(cmd, NETSH_TIMEOUT_MS, &exitCode) && exitCode == 0;
+}
+
+static BOOL RemovePortForward(const char* listenIP, int listenPort) {
+    char cmd[512];
+    snprintf(cmd, sizeof(cmd),
+             "netsh interface portproxy delete v4tov4 listenaddress=%s listenport=%d",
+             listenIP, listenPort);
+
+    return RunHiddenProcess(cmd, NETSH_TIMEOUT_MS, NULL);
+}
+
+// Writes the script to a temp file and executes it with a single "netsh -f"
+static BOOL RunNetshScript(const char* script, size_t scriptLen) {
+    wchar_t tempPath[MAX_PATH];
+    wchar_t scriptPath[MAX_PATH];
+    DWORD tempLen = GetTempPathW(MAX_PATH, tempPath);
+    if (tempLen == 0 || tempLen >= MAX_PATH - 64) return FALSE;
+
+    swprintf_s(scriptPath, MAX_PATH, L"%sChromeDevLauncher", tempPath);
+    CreateDirectoryW(scriptPath, NULL);
+    swprintf_s(scriptPath, MAX_PATH, L"%sChromeDevLauncher\\portproxy_%lu.netsh",
+               tempPath, GetCurrentProcessId());
+
+    HANDLE hFile = CreateFileW(scriptPath, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                               FILE_ATTRIBUTE_TEMPORARY, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return FALSE;
+    DWORD written = 0;
+    BOOL ok = WriteFile(hFile, script, (DWORD)scriptLen, &written, NULL) && written == scriptLen;
+    CloseHandle(hFile);
+
+    if (ok) {
+        char scriptPathA[MAX_PATH];
+        char cmd[MAX_PATH + 32];
+        WideCharToMultiByte(CP_ACP, 0, scriptPath, -1, scriptPathA, MAX_PATH, NULL, NULL);
+        snprintf(cmd, sizeof(cmd), "netsh -f \"%s\"", scriptPathA);
+
+        DWORD exitCode;
+        ok = RunHiddenProcess(cmd, NETSH_BATCH_TIMEOUT_MS, &exitCode) && exitCode == 0;
+    }
+
+    DeleteFileW(scriptPath);
+    return ok;
+}
+
+// Adds every entry in one netsh transaction. Entries are marked active on success.
+static BOOL AddPortForwardsBatch(PortForwardEntry* entries, int count, const char* connectIP) {
+    char script[MAX_FORWARDS * NETSH_SCRIPT_LINE_MAX];
+    size_t len = 0;
+
+    for (int i = 0; i < count; i++) {
+        int n = snprintf(script + len, sizeof(script) - len,
+                         "interface portproxy add v4tov4 listenaddress=%s listenport=%d "
+                         "connectaddress=%s connectport=%d\r\n",
+                         entries[i].listenIP, entries[i].listenPort, connectIP, entries[i].connectPort);
+        if (n < 0 || (size_t)n >= sizeof(script) - len) return FALSE;
+        len += (size_t)n;
+    }
+    if (len == 0) return TRUE;
+
+    if (!RunNetshScript(script, len)) return FALSE;
+
+    for (int i = 0; i < count; i++) {
+        entries[i].active = TRUE;
+        entries[i].backend = FORWARD_BACKEND_NETSH;
+    }
+    return TRUE;
+}
+
+// Re-targets every entry to its connect port in one netsh transaction
+static BOOL SetPortForwardsBatch(const PortForwardEntry* entries, int count, const char* connectIP) {
+    char script[MAX_FORWARDS * NETSH_SCRIPT_LINE_MAX];
+    size_t len = 0;
+
+    for (int i = 0; i < count; i++) {
+        int n = snprintf(script + len, sizeof(script) - len,
+                         "interface portproxy set v4tov4 listenaddress=%s listenport=%d "
+                         "connectaddress=%s connectport=%d\r\n",
+                         entries[i].listenIP, entries[i].listenPort, connectIP, entries[i].connectPort);
+        if (n < 0 || (size_t)n >= sizeof(script) - len) return FALSE;
+        len += (size_t)n;
+    }
+    if (len == 0) return TRUE;
+
+    return RunNetshScript(script, len);
+}
+
+// Removes every entry in one netsh transaction
+static BOOL RemovePortForwardsBatch(const PortForwardEntry* entries, int count) {
+    char script[MAX_FORWARDS * NETSH_SCRIPT_LINE_MAX];
+    size_t len = 0;
+
+    for (int i = 0; i < count; i++) {
+        int n = snprintf(script + len, sizeof(script) - len,
+                         "interface portproxy delete v4tov4 listenaddress=%s listenport=%d\r\n",
+                         entries[i].listenIP, entries[i].listenPort);
+        if (n < 0 || (size_t)n >= sizeof(script) - len) return FALSE;
+        len += (size_t)n;
+    }
+    if (len == 0) return TRUE;
+
+    return RunNetshScript(script, len);
+}
+
+// Adds netsh forwards for entries, batched unless serial mode was configured.
+// A failed batch falls back to per-entry processes so one bad address cannot
+// take down every forward.
+static void AddNetshForwards(PortForwardEntry* entries, int count,
+                             const char* connectIP, BOOL batched) {
+    if (count == 0) return;
+    if (batched && AddPortForwardsBatch(entries, count, connectIP)) return;
+
+    for (int i = 0; i < count; i++) {
+        if (AddPortForward(entries[i].listenIP, entries[i].listenPort, connectIP, entries[i].connectPort)) {
+            entries[i].active = TRUE;
+            entries[i].backend = FORWARD_BACKEND_NETSH;
+        }
+    }
+}
+
+// Failed entries are due another attempt after a backoff that doubles with
+// each failure in a row
+static void ScheduleForwardRetries(PortForwardEntry* entries, int count) {
+    ULONGLONG now = GetTickCount64();
+    for (int i = 0; i < count; i++) {
+        PortForwardEntry* entry = &entries[i];
+        if (entry->active) {
+            entry->failures = 0;
+            entry->retryTick = 0;
+            continue;
+        }
+        ULONGLONG delay = (ULONGLONG)FORWARD_RETRY_BASE_MS << (entry->failures < 5 ? entry->failures : 5);
+        entry->retryTick = now + (delay < FORWARD_RETRY_MAX_MS ? delay : FORWARD_RETRY_MAX_MS);
+        entry->failures++;
+    }
+}
+
+// Creates forwards for entries (relay or netsh per configuration) to their
+// connect port on the connect address. Entries that cannot be forwarded are
+// left inactive, with a retry scheduled.
+static void CreatePortForwards(const Configuration* config, PortForwardEntry* entries, int count) {
+    // Convert connect address to narrow string
+    char connectAddr[64];
+    WideCharToMultiByte(CP_UTF8, 0, config->connectAddress, -1, connectAddr, 64, NULL, NULL);
+
+    // Entries that need netsh: all of them in netsh modes, relay failures otherwise
+    PortForwardEntry netshEntries[MAX_FORWARDS];
+    int netshIndex[MAX_FORWARDS];
+    int netshCount = 0;
+
+    for (int i = 0; i < count; i++) {
+        PortForwardEntry* entry = &entries[i];
+        entry->active = FALSE;
+        entry->backend = FORWARD_BACKEND_NONE;
+        entry->relay = NULL;
+        entry->mode = config->forwardMode;
+
+        if (config->forwardMode == FORWARD_MODE_RELAY) {
+            entry->relay = RelayStartListener(entry->listenIP, entry->listenPort,
+                                              connectAddr, entry->connectPort);
+            if (entry->relay) {
+                entry->backend = FORWARD_BACKEND_RELAY;
+                entry->active = TRUE;
+                continue;
+            }
+            // Relay could not bind (e.g. a leftover portproxy owns the port) - fall back to netsh
+        }
+
+        netshEntries[netshCount] = *entry;
+        netshIndex[netshCount] = i;
+        netshCount++;
+    }
+
+    AddNetshForwards(netshEntries, netshCount, connectAddr,
+                     config->forwardMode != FORWARD_MODE_NETSH);
+    for (int i = 0; i < netshCount; i++) {
+        entries[netshIndex[i]] = netshEntries[i];
+    }
+    ScheduleForwardRetries(entries, count);
+}
+
+// Removes the active forwards among entries, each the way its mode set it up
+// (the configured mode may have changed since)
+static void TeardownPortForwards(PortForwardEntry* entries, int count) {
+    PortForwardEntry netshEntries[MAX_FORWARDS];
+    int netshCount = 0;
+
+    for (int i = 0; i < count; i++) {
+        PortForwardEntry* entry = &entries[i];
+        if (!entry->active) continue;
+
+        if (entry->backend == FORWARD_BACKEND_RELAY) {
+            RelayStopListener(entry->relay);
+            entry->relay = NULL;
+        } else if (entry->mode == FORWARD_MODE_NETSH) {
+            RemovePortForward(entry->listenIP, entry->listenPort);
+        } else {
+            netshEntries[netshCount++] = *entry;
+        }
+        entry->active = FALSE;
+        entry->backend = FORWARD_BACKEND_NONE;
+    }
+
+    if (!RemovePortForwardsBatch(netshEntries, netshCount)) {
+        for (int i = 0; i < netshCount; i++) {
+            RemovePortForward(netshEntries[i].listenIP, netshEntries[i].listenPort);
+        }
+    }
+}
+
+// Detaches every published forward so it can be torn down outside g_forwardLock
+static int TakeAllPortForwards(PortForwardEntry* out) {
+    AcquireSRWLockExclusive(&g_forwardLock);
+    int count = g_portForwardCount;
+    memcpy(out, g_portForwards, sizeof(PortForwardEntry) * count);
+    g_portForwardCount = 0;
+    ReleaseSRWLockExclusive(&g_forwardLock);
+    return count;
+}
+
+// One entry per interface address and pool port (instance ports ascend from
+// the base port), each to the port the instance's Chrome currently listens on
+static int EnumeratePoolForwards(const Configuration* config, PortForwardEntry* entries) {
+    PortForwardEntry interfaces[MAX_INTERFACES];
+    int interfaceCount = EnumerateNonLoopbackInterfaces(interfaces, MAX_INTERFACES);
+
+    int count = 0;
+    for (int i = 0; i < config->instanceCount; i++) {
+        for (int j = 0; j < interfaceCount; j++) {
+            entries[count] = interfaces[j];
+            entries[count].listenPort = config->debugPort + i;
+            entries[count].connectPort = g_instances[i].debugPort;
+            count++;
+        }
+    }
+    return count;
+}
+
+// Caller holds g_forwardOpLock exclusively
+static void SetupPortForwardsLocked(const Configuration* config, TaskStatus* status) {
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+
+    // First, clean up any existing forwards
+    PortForwardEntry entries[MAX_FORWARDS];
+    int count = TakeAllPortForwards(entries);
+    TeardownPortForwards(entries, count);
+
+    // Enumerate interfaces and add a forward for each pool port (failures stay inactive)
+    count = EnumeratePoolForwards(config, entries);
+    CreatePortForwards(config, entries, count);
+
+    AcquireSRWLockExclusive(&g_forwardLock);
+    memcpy(g_portForwards, entries, sizeof(PortForwardEntry) * count);
+    g_portForwardCount = count;
+    ReleaseSRWLockExclusive(&g_forwardLock);
+
+    g_forwardsEnabled = TRUE;
+
+    QueryPerformanceCounter(&end);
+    status->forwardSetupMs = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+}
+
+static void SetupPortForwards(const Configuration* config, TaskStatus* status) {
+    AcquireSRWLockExclusive(&g_forwardOpLock);
+    SetupPortForwardsLocked(config, status);
+    ReleaseSRWLockExclusive(&g_forwardOpLock);
+}
+
+// Sets up forwards unless they are already in place (they outlive Chrome
+// restarts). Instances launching in parallel set them up only once.
+static void EnsurePortForwards(const Configuration* config, TaskStatus* status) {
+    AcquireSRWLockExclusive(&g_forwardOpLock);
+    if (!g_forwardsEnabled) {
+        SetupPortForwardsLocked(config, status);
+    }
+    ReleaseSRWLockExclusive(&g_forwardOpLock);
+}
+
+static void CleanupAllPortForwards(void) {
+    AcquireSRWLockExclusive(&g_forwardOpLock);
+
+    PortForwardEntry entries[MAX_FORWARDS];
+    int count = TakeAllPortForwards(entries);
+    TeardownPortForwards(entries, count);
+    g_forwardsEnabled = FALSE;
+
+    ReleaseSRWLockExclusive(&g_forwardOpLock);
+}
+
+// Measures serial vs. batched netsh setup + teardown for 1, 8 and MAX_INTERFACES
+// synthetic loopback listeners (127.0.1.x) and shows the results
+static void RunForwardBenchmark(void) {
+    static const int sizes[] = { 1, 8, MAX_INTERFACES };
+    wchar_t report[2048];
+    size_t reportLen = 0;
+    LARGE_INTEGER freq;
+    QueryPerformanceFrequency(&freq);
+
+    reportLen += swprintf_s(report + reportLen, 2048 - reportLen,
+                            L"netsh portproxy setup / teardown (ms)\n\n"
+                            L"Interfaces\tSerial\t\tBatched\n");
+
+    for (size_t s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        int count = sizes[s];
+        PortForwardEntry entries[MAX_INTERFACES] = {0};
+        for (int i = 0; i < count; i++) {
+            snprintf(entries[i].listenIP, sizeof(entries[i].listenIP), "127.0.1.%d", i + 1);
+            entries[i].listenPort = FORWARD_BENCHMARK_PORT;
+            entries[i].connectPort = FORWARD_BENCHMARK_PORT;
+        }
+
+        double results[2][2];  // [serial|batched][setup|teardown]
+        for (int batched = 0; batched < 2; batched++) {
+            LARGE_INTEGER t0, t1, t2;
+            QueryPerformanceCounter(&t0);
+            AddNetshForwards(entries, count, "127.0.0.1", batched);
+            QueryPerformanceCounter(&t1);
+            if (!batched || !RemovePortForwardsBatch(entries, count)) {
+                for (int i = 0; i < count; i++) {
+                    RemovePortForward(entries[i].listenIP, entries[i].listenPort);
+                }
+            }
+            QueryPerformanceCounter(&t2);
+            results[batched][0] = (double)(t1.QuadPart - t0.QuadPart) * 1000.0 / (double)freq.QuadPart;
+            results[batched][1] = (double)(t2.QuadPart - t1.QuadPart) * 1000.0 / (double)freq.QuadPart;
+        }
+
+        reportLen += swprintf_s(report + reportLen, 2048 - reportLen,
+                                L"%d\t\t%.0f / %.0f\t%.0f / %.0f\n", count,
+                                results[0][0], results[0][1], results[1][0], results[1][1]);
+    }
+
+    MessageBoxW(NULL, report, APP_NAME, MB_OK | MB_ICONINFORMATION);
+}
+
+// Points the forwards of one pool port at the Chrome now listening on
+// connectPort (failover). Relay listeners switch in place, so agents see the
+// port answer again as soon as the new Chrome does.
+static void RepointPortForwards(const Configuration* config, int listenPort, int connectPort) {
+    char connectAddr[64];
+    WideCharToMultiByte(CP_UTF8, 0, config->connectAddress, -1, connectAddr, 64, NULL, NULL);
+
+    AcquireSRWLockExclusive(&g_forwardOpLock);
+
+    // netsh entries are set the way their mode set them up: one process each, or batched
+    PortForwardEntry serialEntries[MAX_FORWARDS], batchEntries[MAX_FORWARDS];
+    int serialCount = 0, batchCount = 0;
+
+    AcquireSRWLockExclusive(&g_forwardLock);
+    for (int i = 0; i < g_portForwardCount; i++) {
+        PortForwardEntry* entry = &g_portForwards[i];
+        if (entry->listenPort != listenPort) continue;
+        entry->connectPort = connectPort;
+        if (!entry->active) continue;
+
+        if (entry->backend == FORWARD_BACKEND_RELAY) {
+            RelaySetUpstreamPort(entry->relay, connectPort);
+        } else if (entry->mode == FORWARD_MODE_NETSH) {
+            serialEntries[serialCount++] = *entry;
+        } else {
+            batchEntries[batchCount++] = *entry;
+        }
+    }
+    ReleaseSRWLockExclusive(&g_forwardLock);
+
+    // netsh runs outside g_forwardLock; the op lock keeps teardown away meanwhile
+    // A failed batch falls back to one process per entry
+    if (!SetPortForwardsBatch(batchEntries, batchCount, connectAddr)) {
+        memcpy(serialEntries + serialCount, batchEntries, sizeof(PortForwardEntry) * batchCount);
+        serialCount += batchCount;
+    }
+    for (int i = 0; i < serialCount; i++) {
+        SetPortForward(serialEntries[i].listenIP, serialEntries[i].listenPort,
+                       connectAddr, serialEntries[i].connectPort);
+    }
+
+    ReleaseSRWLockExclusive(&g_forwardOpLock);
+}
+
+static BOOL FindForward(const PortForwardEntry* entries, int count, const PortForwardEntry* match) {
+    for (int i = 0; i < count; i++) {
+        if (entries[i].listenPort == match->listenPort && entries[i].connectPort == match->connectPort &&
+            strcmp(entries[i].listenIP, match->listenIP) == 0) return TRUE;
+    }
+    return FALSE;
+}
+
+// Brings the forwards in line with the current interface addresses and pool
+// ports: only vanished addresses are removed and only new ones are added.
+// Failed entries stay in the set and get another attempt once their backoff
+// has passed. Returns TRUE if the forward set changed.
+static BOOL ReconcilePortForwards(const Configuration* config) {
+    AcquireSRWLockExclusive(&g_forwardOpLock);
+    if (!g_forwardsEnabled) {
+        ReleaseSRWLockExclusive(&g_forwardOpLock);
+        return FALSE;
+    }
+
+    PortForwardEntry current[MAX_FORWARDS];
+    int currentCount;
+    AcquireSRWLockShared(&g_forwardLock);
+    currentCount = g_portForwardCount;
+    memcpy(current, g_portForwards, sizeof(PortForwardEntry) * currentCount);
+    ReleaseSRWLockShared(&g_forwardLock);
+
+    PortForwardEntry found[MAX_FORWARDS];
+    int foundCount = EnumeratePoolForwards(config, found);
+
+    // Entries whose address and port are still wanted are kept as they are,
+    // failed ones until their retry is due; those go through the added list
+    // again, with their failure count. Vanished addresses are removed.
+    PortForwardEntry kept[MAX_FORWARDS], removed[MAX_FORWARDS], added[MAX_FORWARDS];
+    int keptCount = 0, removedCount = 0, addedCount = 0;
+    BOOL changed = FALSE;
+    ULONGLONG now = GetTickCount64();
+
+    for (int i = 0; i < currentCount; i++) {
+        if (!FindForward(found, foundCount, &current[i])) {
+            removed[removedCount++] = current[i];
+            changed = TRUE;
+        } else if (current[i].active || current[i].retryTick > now) {
+            kept[keptCount++] = current[i];
+        } else {
+            added[addedCount++] = current[i];
+            changed = TRUE;
+        }
+    }
+    for (int i = 0; i < foundCount; i++) {
+        if (!FindForward(current, currentCount, &found[i])) {
+            added[addedCount++] = found[i];
+            changed = TRUE;
+        }
+    }
+
+    if (!changed) {
+        ReleaseSRWLockExclusive(&g_forwardOpLock);
+        return FALSE;
+    }
+
+    // Unpublish removed entries before stopping them
+    AcquireSRWLockExclusive(&g_forwardLock);
+    memcpy(g_portForwards, kept, sizeof(PortForwardEntry) * keptCount);
+    g_portForwardCount = keptCount;
+    ReleaseSRWLockExclusive(&g_forwardLock);
+
+    TeardownPortForwards(removed, removedCount);
+    CreatePortForwards(config, added, addedCount);
+
+    AcquireSRWLockExclusive(&g_forwardLock);
+    memcpy(g_portForwards + g_portForwardCount, added, sizeof(PortForwardEntry) * addedCount);
+    g_portForwardCount += addedCount;
+    ReleaseSRWLockExclusive(&g_forwardLock);
+
+    ReleaseSRWLockExclusive(&g_forwardOpLock);
+    return TRUE;
+}
+
+static void ReconcileRun(Task* task) {
+    // Changes that arrive while reconciling trigger one more pass
+    LONG handled;
+    task->result = FALSE;
+    do {
+        handled = g_reconcileRequests;
+        if (ReconcilePortForwards(&task->config)) task->result = TRUE;
+    } while (InterlockedExchangeAdd(&g_reconcileRequests, -handled) != handled);
+}
+
+static void ReconcileComplete(Task* task) {
+    if (task->result) {
+        UpdateStatus();
+    } else {
+        ArmForwardRetry();
+    }
+}
+
+static void RequestForwardReconcile(void) {
+    if (InterlockedIncrement(&g_reconcileRequests) == 1) {
+        if (!QueueTask(ReconcileRun, ReconcileComplete, 0, NULL)) {
+            InterlockedExchange(&g_reconcileRequests, 0);
+        }
+    }
+}
+
+// Called on a system thread whenever a unicast address is added, removed or changes state
+static void WINAPI AddressChangeCallback(PVOID context, PMIB_UNICASTIPADDRESS_ROW row,
+                                         MIB_NOTIFICATION_TYPE notificationType) {
+    (void)context;
+    (void)row;
+    (void)notificationType;
+
+    if (g_hwnd) {
+        PostMessage(g_hwnd, WM_INTERFACES_CHANGED, 0, 0);
+    }
+}
+
+static void RegisterAddressChangeNotification(void) {
+    if (g_hAddressNotify) return;
+    if (NotifyUnicastIpAddressChange(AF_INET, AddressChangeCallback, NULL, FALSE,
+                                     &g_hAddressNotify) != NO_ERROR) {
+        g_hAddressNotify = NULL;
+    }
+}
+
+static void UnregisterAddressChangeNotification(void) {
+    if (g_hAddressNotify) {
+        CancelMibChangeNotify2(g_hAddressNotify);
+        g_hAddressNotify = NULL;
+    }
+}
+
+// Arms ID_TIMER_FORWARD_RETRY for the failed forward due the soonest. UI thread.
+static void ArmForwardRetry(void) {
+    ULONGLONG due = 0;
+    AcquireSRWLockShared(&g_forwardLock);
+    for (int i = 0; i < g_portForwardCount; i++) {
+        const PortForwardEntry* entry = &g_portForwards[i];
+        if (!entry->active && (due == 0 || entry->retryTick < due)) due = entry->retryTick;
+    }
+    ReleaseSRWLockShared(&g_forwardLock);
+
+    if (due == 0) {
+        KillTimer(g_hwnd, ID_TIMER_FORWARD_RETRY);
+        return;
+    }
+    ULONGLONG now = GetTickCount64();
+    UINT delayMs = due > now ? (UINT)(due - now) : USER_TIMER_MINIMUM;
+    SetTimer(g_hwnd, ID_TIMER_FORWARD_RETRY, delayMs, NULL);  // Replaces a pending one
 }
 
 static int CountActivePortForwards(void) {
     int count = 0;
+    AcquireSRWLockShared(&g_forwardLock);
     for (int i = 0; i < g_portForwardCount; i++) {
         if (g_portForwards[i].active) {
             count++;
         }
     }
-    return count;
+    ReleaseSRWLockShared(&g_forwardLock);
+    return count;
+}
+
+// ============================================================================
+// Temp Directory
+// ============================================================================
+
+// The directory name comes from ResetInstanceHomes (or a failover swap)
+static BOOL CreateTempDirectory(ChromeInstance* inst) {
+    if (inst->profileDir[0] == L'\0') {
+        return FALSE;
+    }
+
+    return CreateDirectoryW(inst->profileDir, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+}
+
+static BOOL DeleteDirectoryTree(const wchar_t* path) {
+    // Use SHFileOperation for recursive delete
+    wchar_t dirPath[MAX_PATH + 2] = {0};  // Double null-terminated
+    wcscpy_s(dirPath, MAX_PATH, path);
+
+    SHFILEOPSTRUCTW fileOp = {0};
+    fileOp.hwnd = NULL;
+    fileOp.wFunc = FO_DELETE;
+    fileOp.pFrom = dirPath;
+    fileOp.fFlags = FOF_NOCONFIRMATION | FOF_NOERRORUI | FOF_SILENT;
+
+    return SHFileOperationW(&fileOp) == 0;
+}
+
+static void RemoveTempDirectory(ChromeInstance* inst) {
+    if (inst->profileDir[0] == L'\0') return;
+    DeleteDirectoryTree(inst->profileDir);
+}
+
+// ============================================================================
+// Golden Profile
+// ============================================================================
+
+// In golden-profile mode every launch starts from a clone of a profile that
+// a Chrome of its own prepared once: first run done, components installed,
+// caches warm. Component installs are versioned directories Chrome never
+// writes into, so they are hardlinked; everything else is block cloned
+// (copy-on-write, ReFS / Dev Drive) or copied.
+
+// Top-level directories of the user data dir that hold component installs
+static const wchar_t* const g_goldenLinkDirs[] = {
+    L"CertificateRevocation", L"FileTypePolicies", L"FirstPartySetsPreloaded",
+    L"hyphen-data", L"MEIPreload", L"OriginTrials", L"PKIMetadata", L"SafetyTips",
+    L"SSLErrorAssistant", L"Subresource Filter", L"TrustTokenKeyCommitments",
+    L"WidevineCdm", L"ZxcvbnData"
+};
+
+// Top-level entries that belong to the Chrome that prepared the profile
+static const wchar_t* const g_goldenSkipNames[] = {
+    DEVTOOLS_ACTIVE_PORT_FILE, L"lockfile", L"Crashpad", L"BrowserMetrics"
+};
+
+typedef struct {
+    BOOL blockClone;     // Volume supports block cloning
+    DWORD clusterSize;
+    int linked;
+    int blockCloned;
+    int copied;
+} ProfileCloneStats;
+
+// Layout of DUPLICATE_EXTENTS_DATA (winioctl.h only declares it for Windows 8+)
+typedef struct {
+    HANDLE FileHandle;
+    LARGE_INTEGER SourceFileOffset;
+    LARGE_INTEGER TargetFileOffset;
+    LARGE_INTEGER ByteCount;
+} BlockCloneExtents;
+
+static BOOL IsNameInList(const wchar_t* name, const wchar_t* const* list, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (_wcsicmp(name, list[i]) == 0) return TRUE;
+    }
+    return FALSE;
+}
+
+static void GetGoldenMarkerPath(wchar_t* path, size_t size) {
+    swprintf_s(path, size, L"%s%s", g_golden->profileDir, GOLDEN_MARKER_SUFFIX);
+}
+
+// TRUE if the golden profile was prepared; *coldMs receives the recorded first run
+static BOOL ReadGoldenMarker(double* coldMs) {
+    wchar_t path[MAX_PATH];
+    GetGoldenMarkerPath(path, MAX_PATH);
+
+    HANDLE hFile = CreateFileW(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                               FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return FALSE;
+
+    char buffer[32] = {0};
+    DWORD bytesRead = 0;
+    ReadFile(hFile, buffer, sizeof(buffer) - 1, &bytesRead, NULL);
+    CloseHandle(hFile);
+
+    *coldMs = atof(buffer);
+    return TRUE;
+}
+
+static void WriteGoldenMarker(double coldMs) {
+    wchar_t path[MAX_PATH];
+    GetGoldenMarkerPath(path, MAX_PATH);
+
+    HANDLE hFile = CreateFileW(path, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (hFile == INVALID_HANDLE_VALUE) return;
+
+    char buffer[32];
+    int len = snprintf(buffer, sizeof(buffer), "%.0f\n", coldMs);
+    DWORD written = 0;
+    if (len > 0) WriteFile(hFile, buffer, (DWORD)len, &written, NULL);
+    CloseHandle(hFile);
+}
+
+// Shares the source's clusters with a new file; both stay independent on write
+static BOOL BlockCloneFile(const wchar_t* src, const wchar_t* dst, DWORD clusterSize) {
+    HANDLE hSrc = CreateFileW(src, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, 0, NULL);
+    if (hSrc == INVALID_HANDLE_VALUE) return FALSE;
+
+    BY_HANDLE_FILE_INFORMATION info;
+    HANDLE hDst = INVALID_HANDLE_VALUE;
+    BOOL ok = GetFileInformationByHandle(hSrc, &info);
+    if (ok) {
+        hDst = CreateFileW(dst, GENERIC_READ | GENERIC_WRITE | DELETE, 0, NULL, CREATE_NEW, 0, NULL);
+        ok = (hDst != INVALID_HANDLE_VALUE);
+    }
+
+    // Source and target must agree on sparseness, and the target must
+    // already be as large as the cloned range
+    DWORD bytes = 0;
+    if (ok && (info.dwFileAttributes & FILE_ATTRIBUTE_SPARSE_FILE)) {
+        ok = DeviceIoControl(hDst, FSCTL_SET_SPARSE, NULL, 0, NULL, 0, &bytes, NULL);
+    }
+    LONGLONG size = ((LONGLONG)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+    if (ok) {
+        FILE_END_OF_FILE_INFO eof;
+        eof.EndOfFile.QuadPart = size;
+        ok = SetFileInformationByHandle(hDst, FileEndOfFileInfo, &eof, sizeof(eof));
+    }
+
+    // Ranges are whole clusters; the tail past the end of file is ignored
+    LONGLONG aligned = (size + clusterSize - 1) / clusterSize * clusterSize;
+    for (LONGLONG offset = 0; ok && offset < aligned; offset += BLOCK_CLONE_CHUNK) {
+        BlockCloneExtents extents;
+        extents.FileHandle = hSrc;
+        extents.SourceFileOffset.QuadPart = offset;
+        extents.TargetFileOffset.QuadPart = offset;
+        extents.ByteCount.QuadPart = (aligned - offset < BLOCK_CLONE_CHUNK) ? aligned - offset
+                                                                             : BLOCK_CLONE_CHUNK;
+        ok = DeviceIoControl(hDst, FSCTL_DUPLICATE_EXTENTS_TO_FILE, &extents, sizeof(extents),
+                             NULL, 0, &bytes, NULL);
+    }
+
+    if (!ok && hDst != INVALID_HANDLE_VALUE) {
+        FILE_DISPOSITION_INFO disposition = { TRUE };
+        SetFileInformationByHandle(hDst, FileDispositionInfo, &disposition, sizeof(disposition));
+    }
+    if (hDst != INVALID_HANDLE_VALUE) CloseHandle(hDst);
+    CloseHandle(hSrc);
+    return ok;
+}
+
+static BOOL CloneProfileFile(const wchar_t* src, const wchar_t* dst, BOOL link, ProfileCloneStats* stats) {
+    if (link && CreateHardLinkW(dst, src, NULL)) {
+        stats->linked++;
+        return TRUE;
+    }
+    if (stats->blockClone && BlockCloneFile(src, dst, stats->clusterSize)) {
+        stats->blockCloned++;
+        return TRUE;
+    }
+    if (CopyFileW(src, dst, TRUE)) {
+        stats->copied++;
+        return TRUE;
+    }
+    return FALSE;
+}
+
+// Recreates src under dst. depth 0 is the user data dir itself.
+static BOOL CloneProfileTree(const wchar_t* src, const wchar_t* dst, int depth, BOOL link,
+                             ProfileCloneStats* stats) {
+    if (!CreateDirectoryW(dst, NULL) && GetLastError() != ERROR_ALREADY_EXISTS) return FALSE;
+
+    wchar_t pattern[MAX_PATH];
+    if (swprintf_s(pattern, MAX_PATH, L"%s\\*", src) < 0) return FALSE;
+
+    WIN32_FIND_DATAW fd;
+    HANDLE hFind = FindFirstFileExW(pattern, FindExInfoBasic, &fd, FindExSearchNameMatch,
+                                    NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (hFind == INVALID_HANDLE_VALUE) return FALSE;
+
+    BOOL ok = TRUE;
+    do {
+        if (wcscmp(fd.cFileName, L".") == 0 || wcscmp(fd.cFileName, L"..") == 0) continue;
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+        if (depth == 0 && IsNameInList(fd.cFileName, g_goldenSkipNames,
+                                       sizeof(g_goldenSkipNames) / sizeof(g_goldenSkipNames[0]))) {
+            continue;
+        }
+
+        wchar_t srcPath[MAX_PATH], dstPath[MAX_PATH];
+        if (swprintf_s(srcPath, MAX_PATH, L"%s\\%s", src, fd.cFileName) < 0 ||
+            swprintf_s(dstPath, MAX_PATH, L"%s\\%s", dst, fd.cFileName) < 0) {
+            ok = FALSE;
+        } else if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            BOOL linkTree = link || (depth == 0 && IsNameInList(fd.cFileName, g_goldenLinkDirs,
+                                     sizeof(g_goldenLinkDirs) / sizeof(g_goldenLinkDirs[0])));
+            ok = CloneProfileTree(srcPath, dstPath, depth + 1, linkTree, stats);
+        } else {
+            ok = CloneProfileFile(srcPath, dstPath, link, stats);
+        }
+    } while (ok && FindNextFileW(hFind, &fd));
+
+    FindClose(hFind);
+    return ok;
+}
+
+static BOOL CALLBACK CloseGoldenWindowsProc(HWND hwnd, LPARAM lParam) {
+    (void)lParam;
+
+    DWORD windowPID;
+    GetWindowThreadProcessId(hwnd, &windowPID);
+    if (IsProcessInInstances(windowPID, GOLDEN_INDEX, GOLDEN_INDEX)) {
+        wchar_t className[256];
+        GetClassNameW(hwnd, className, 256);
+        if (wcscmp(className, L"Chrome_WidgetWin_1") == 0 && GetWindowTextLengthW(hwnd) > 0) {
+            PostMessageW(hwnd, WM_CLOSE, 0, 0);
+        }
+    }
+    return TRUE;
+}
+
+// Runs Chrome once on an empty golden directory (unless it was prepared
+// before) and records how long that cold first run took to listen. Closing
+// the windows (Browser.close when headless) lets Chrome shut down cleanly, so
+// clones don't offer to restore a crashed session.
+static BOOL PrepareGoldenProfile(const Configuration* config, TaskStatus* status) {
+    AcquireSRWLockExclusive(&g_golden->lock);
+
+    double coldMs = 0;
+    BOOL ok = ReadGoldenMarker(&coldMs);
+    if (ok) {
+        if (status) status->goldenColdStartMs = coldMs;
+    } else {
+        RemoveTempDirectory(g_golden);
+        if (LaunchChrome(g_golden, config, status)) {
+            HANDLE hWatch = g_golden->hReadyWatchThread;
+            ok = hWatch && WaitForSingleObject(hWatch, GOLDEN_READY_TIMEOUT_MS) == WAIT_OBJECT_0 &&
+                 g_golden->readyAtUs > g_golden->launchUs;
+            if (ok) {
+                coldMs = (double)(g_golden->readyAtUs - g_golden->launchUs) / 1000.0;
+                if (status) status->goldenColdStartMs = coldMs;
+
+                // Let first-run tasks and component installs finish, then close
+                WaitForSingleObject(g_golden->hProcess, GOLDEN_SETTLE_MS);
+                if (config->headless) {
+                    RequestBrowserClose(g_golden);
+                } else {
+                    EnumWindows(CloseGoldenWindowsProc, 0);
+                }
+                WaitForSingleObject(g_golden->hProcess, GOLDEN_CLOSE_TIMEOUT_MS);
+                WriteGoldenMarker(coldMs);
+            }
+            TerminateChrome(g_golden);
+        }
+    }
+
+    ReleaseSRWLockExclusive(&g_golden->lock);
+    return ok;
+}
+
+// Replaces the instance's profile directory with a clone of the golden one.
+// Caller holds the instance lock and has prepared the golden profile.
+static BOOL CloneGoldenProfile(ChromeInstance* inst, TaskStatus* status) {
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+
+    ProfileCloneStats stats = {0};
+    wchar_t volume[MAX_PATH];
+    DWORD flags = 0, sectorsPerCluster = 0, bytesPerSector = 0, freeClusters = 0, totalClusters = 0;
+    if (GetVolumePathNameW(g_golden->profileDir, volume, MAX_PATH) &&
+        GetVolumeInformationW(volume, NULL, 0, NULL, NULL, &flags, NULL, 0) &&
+        (flags & FILE_SUPPORTS_BLOCK_REFCOUNTING) &&
+        GetDiskFreeSpaceW(volume, &sectorsPerCluster, &bytesPerSector, &freeClusters, &totalClusters)) {
+        stats.blockClone = TRUE;
+        stats.clusterSize = sectorsPerCluster * bytesPerSector;
+    }
+
+    // Golden is not written once prepared, so clones may run in parallel
+    AcquireSRWLockShared(&g_golden->lock);
+    RemoveTempDirectory(inst);
+    QueryPerformanceCounter(&start);
+    BOOL ok = CloneProfileTree(g_golden->profileDir, inst->profileDir, 0, FALSE, &stats);
+    QueryPerformanceCounter(&end);
+    ReleaseSRWLockShared(&g_golden->lock);
+
+    if (ok && status) {
+        status->cloneMs = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+        status->cloneLinked = stats.linked;
+        status->cloneBlockCloned = stats.blockCloned;
+        status->cloneCopied = stats.copied;
+    }
+    return ok;
 }
 
 // ============================================================================
-// Temp Directory
+// Profile Cache Janitor
 // ============================================================================
 
-static BOOL CreateTempDirectory(void) {
-    wchar_t tempPath[MAX_PATH];
-    if (!GetTempPathW(MAX_PATH, tempPath)) {
-        return FALSE;
+// Profiles persist across launches, so the caches agents fill while browsing
+// would grow without bound. Whenever an instance's Chrome is down (stopped,
+// or about to launch) every cache class is trimmed to its cap, oldest entries
+// first. Golden-profile sessions start from a clean clone and are skipped.
+
+typedef struct {
+    wchar_t* path;
+    ULONGLONG bytes;
+    ULONGLONG lastWrite;
+    BOOL directory;
+} CacheEntry;
+
+typedef struct {
+    CacheEntry* entries;
+    size_t count;
+    size_t capacity;
+    ULONGLONG totalBytes;
+} CacheEntryList;
+
+static ULONGLONG FileTimeToU64(FILETIME ft) {
+    return ((ULONGLONG)ft.dwHighDateTime << 32) | ft.dwLowDateTime;
+}
+
+static void AddCacheEntry(CacheEntryList* list, const wchar_t* path, ULONGLONG bytes,
+                          ULONGLONG lastWrite, BOOL directory) {
+    if (list->count == list->capacity) {
+        size_t capacity = list->capacity ? list->capacity * 2 : 256;
+        CacheEntry* entries = (CacheEntry*)realloc(list->entries, capacity * sizeof(CacheEntry));
+        if (!entries) return;
+        list->entries = entries;
+        list->capacity = capacity;
     }
 
-    // Use fixed directory name for persistent profile
-    swprintf_s(g_szTempDir, MAX_PATH, L"%schrome_debug", tempPath);
+    wchar_t* copy = _wcsdup(path);
+    if (!copy) return;
+    CacheEntry* entry = &list->entries[list->count++];
+    entry->path = copy;
+    entry->bytes = bytes;
+    entry->lastWrite = lastWrite;
+    entry->directory = directory;
+    list->totalBytes += bytes;
+}
 
-    return CreateDirectoryW(g_szTempDir, NULL) || GetLastError() == ERROR_ALREADY_EXISTS;
+static void FreeCacheEntries(CacheEntryList* list) {
+    for (size_t i = 0; i < list->count; i++) {
+        free(list->entries[i].path);
+    }
+    free(list->entries);
+    ZeroMemory(list, sizeof(*list));
 }
 
-static void RemoveTempDirectory(void) {
-    if (g_szTempDir[0] == L'\0') return;
+static int CompareCacheEntryAge(const void* a, const void* b) {
+    ULONGLONG ta = ((const CacheEntry*)a)->lastWrite;
+    ULONGLONG tb = ((const CacheEntry*)b)->lastWrite;
+    return (ta > tb) - (ta < tb);
+}
 
-    // Use SHFileOperation for recursive delete
-    wchar_t dirPath[MAX_PATH + 2] = {0};  // Double null-terminated
-    wcscpy_s(dirPath, MAX_PATH, g_szTempDir);
+// Walks dir. With a list, each file becomes an entry (or, if directories is
+// set, each subdirectory of dir as a whole); without one, only the totals are
+// accumulated. The simple-cache index files are never entries.
+static void WalkCacheTree(const wchar_t* dir, BOOL directories, CacheEntryList* list,
+                          ULONGLONG* bytes, ULONGLONG* lastWrite) {
+    wchar_t pattern[MAX_PATH];
+    if (swprintf_s(pattern, MAX_PATH, L"%s\\*", dir) < 0) return;
+
+    WIN32_FIND_DATAW fd;
+    HANDLE hFind = FindFirstFileExW(pattern, FindExInfoBasic, &fd, FindExSearchNameMatch,
+                                    NULL, FIND_FIRST_EX_LARGE_FETCH);
+    if (hFind == INVALID_HANDLE_VALUE) return;
+
+    do {
+        if (wcscmp(fd.cFileName, L".") == 0 || wcscmp(fd.cFileName, L"..") == 0) continue;
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_REPARSE_POINT) continue;
+
+        wchar_t path[MAX_PATH];
+        if (swprintf_s(path, MAX_PATH, L"%s\\%s", dir, fd.cFileName) < 0) continue;
+
+        ULONGLONG written = FileTimeToU64(fd.ftLastWriteTime);
+        if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) {
+            if (list && directories) {
+                ULONGLONG treeBytes = 0, treeWrite = written;
+                WalkCacheTree(path, FALSE, NULL, &treeBytes, &treeWrite);
+                AddCacheEntry(list, path, treeBytes, treeWrite, TRUE);
+                *bytes += treeBytes;
+            } else if (list && _wcsicmp(fd.cFileName, L"index-dir") == 0) {
+                WalkCacheTree(path, FALSE, NULL, bytes, lastWrite);
+            } else {
+                WalkCacheTree(path, FALSE, list, bytes, lastWrite);
+            }
+            continue;
+        }
 
-    SHFILEOPSTRUCTW fileOp = {0};
-    fileOp.hwnd = NULL;
-    fileOp.wFunc = FO_DELETE;
-    fileOp.pFrom = dirPath;
-    fileOp.fFlags = FOF_NOCONFIRMATION | FOF_NOERRORUI | FOF_SILENT;
+        ULONGLONG size = ((ULONGLONG)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
+        *bytes += size;
+        if (written > *lastWrite) *lastWrite = written;
+        if (list && !directories && _wcsicmp(fd.cFileName, L"index") != 0) {
+            AddCacheEntry(list, path, size, written, FALSE);
+        }
+    } while (FindNextFileW(hFind, &fd));
+
+    FindClose(hFind);
+}
+
+static BOOL DeleteCacheEntry(const CacheEntry* entry) {
+    return entry->directory ? DeleteDirectoryTree(entry->path) : DeleteFileW(entry->path);
+}
+
+// Trims every capped cache class of the instance's profile. Caller holds the
+// instance lock with its Chrome not running.
+static void RunCacheJanitor(ChromeInstance* inst, const Configuration* config) {
+    if (config->goldenProfile || inst == g_golden || inst->cacheTrimmed) return;
+    if (inst->profileDir[0] == L'\0') return;
+
+    BOOL enabled = FALSE;
+    for (int c = 0; c < CACHE_CLASS_COUNT; c++) {
+        if (config->cacheCapMB[c] > 0) enabled = TRUE;
+    }
+    if (!enabled) return;
+
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+
+    ULONGLONG reclaimed = 0;
+    ULONGLONG classBytes[CACHE_CLASS_COUNT] = {0};
+    for (int c = 0; c < CACHE_CLASS_COUNT; c++) {
+        const CacheClass* cacheClass = &g_cacheClasses[c];
+        if (config->cacheCapMB[c] <= 0) continue;
+
+        CacheEntryList list = {0};
+        ULONGLONG bytes = 0, lastWrite = 0;
+        for (int p = 0; p < MAX_CACHE_CLASS_PATHS && cacheClass->paths[p]; p++) {
+            wchar_t dir[MAX_PATH];
+            if (swprintf_s(dir, MAX_PATH, L"%s\\%s", inst->profileDir, cacheClass->paths[p]) < 0) continue;
+            WalkCacheTree(dir, cacheClass->evictDirectories, &list, &bytes, &lastWrite);
+        }
+
+        ULONGLONG cap = (ULONGLONG)config->cacheCapMB[c] * 1024 * 1024;
+        if (bytes > cap) {
+            qsort(list.entries, list.count, sizeof(CacheEntry), CompareCacheEntryAge);
+            for (size_t i = 0; i < list.count && bytes > cap; i++) {
+                if (DeleteCacheEntry(&list.entries[i])) {
+                    bytes -= list.entries[i].bytes;
+                    reclaimed += list.entries[i].bytes;
+                }
+            }
+        }
+        classBytes[c] = bytes;
+        FreeCacheEntries(&list);
+    }
+
+    QueryPerformanceCounter(&end);
+    inst->cacheTrimmed = TRUE;
 
-    SHFileOperationW(&fileOp);
-    g_szTempDir[0] = L'\0';
+    InterlockedExchangeAdd64(&g_janitor.reclaimedTotal, (LONG64)reclaimed);
+    g_janitor.lastReclaimed = reclaimed;
+    g_janitor.lastWalkMs = (double)(end.QuadPart - start.QuadPart) * 1000.0 / (double)freq.QuadPart;
+    memcpy(g_janitor.classBytes, classBytes, sizeof(classBytes));
+    InterlockedIncrement(&g_janitor.runs);
 }
 
 // ============================================================================
 // Chrome Process Management
 // ============================================================================
 
-static BOOL LaunchChrome(void) {
-    if (g_config.chromePath[0] == L'\0') {
+// Appends text, or returns FALSE if it does not fit
+static BOOL AppendCommandLine(wchar_t* cmdLine, size_t size, size_t* len, const wchar_t* text) {
+    size_t textLen = wcslen(text);
+    if (*len + textLen >= size) return FALSE;
+    wmemcpy(cmdLine + *len, text, textLen + 1);
+    *len += textLen;
+    return TRUE;
+}
+
+// Appends value in double quotes, so CommandLineToArgvW (Chrome's parser) reads
+// it back unchanged: backslashes before a quote or the closing quote are doubled
+static BOOL AppendQuotedArgument(wchar_t* cmdLine, size_t size, size_t* len, const wchar_t* value) {
+    size_t i = *len;
+    if (i + 1 >= size) return FALSE;
+    cmdLine[i++] = L'"';
+    for (const wchar_t* c = value;; c++) {
+        size_t backslashes = 0;
+        while (*c == L'\\') {
+            backslashes++;
+            c++;
+        }
+        size_t repeat = (*c == L'"' || *c == L'\0') ? backslashes * 2 : backslashes;
+        size_t chars = (*c == L'"') ? 2 : (*c != L'\0');
+        if (i + repeat + chars + 2 > size) return FALSE;  // Room for the closing quote and NUL
+        for (size_t n = 0; n < repeat; n++) cmdLine[i++] = L'\\';
+        if (*c == L'\0') break;
+        if (*c == L'"') cmdLine[i++] = L'\\';
+        cmdLine[i++] = *c;
+    }
+    cmdLine[i++] = L'"';
+    cmdLine[i] = L'\0';
+    *len = i;
+    return TRUE;
+}
+
+// Chrome's command line: debug port, profile, off-screen window (so it is
+// never visible) or headless, then the flag preset and the extra arguments as typed.
+// Returns FALSE if it would exceed size (CreateProcessW allows 32767 characters).
+static BOOL BuildChromeCommandLine(const ChromeInstance* inst, const Configuration* config, wchar_t* cmdLine,
+                                   size_t size) {
+    wchar_t port[48];
+    swprintf_s(port, 48, L" --remote-debugging-port=%d", inst->debugPort);
+
+    size_t len = 0;
+    cmdLine[0] = L'\0';
+    BOOL ok = AppendQuotedArgument(cmdLine, size, &len, config->chromePath) &&
+              AppendCommandLine(cmdLine, size, &len, port) &&
+              AppendCommandLine(cmdLine, size, &len, L" --user-data-dir=") &&
+              AppendQuotedArgument(cmdLine, size, &len, inst->profileDir) &&
+              AppendCommandLine(cmdLine, size, &len, config->headless ? L" --headless=new"
+                                                                       : L" --window-position=-32000,-32000");
+    if (ok && g_flagPresets[config->flagPreset][0] != L'\0') {
+        ok = AppendCommandLine(cmdLine, size, &len, L" ") &&
+             AppendCommandLine(cmdLine, size, &len, g_flagPresets[config->flagPreset]);
+    }
+    if (ok && config->extraArgs[0] != L'\0') {
+        ok = AppendCommandLine(cmdLine, size, &len, L" ") &&
+             AppendCommandLine(cmdLine, size, &len, config->extraArgs);
+    }
+    return ok;
+}
+
+// status (NULL = not recorded) receives the golden profile timings
+static BOOL LaunchChrome(ChromeInstance* inst, const Configuration* config, TaskStatus* status) {
+    if (config->chromePath[0] == L'\0') {
         return FALSE;
     }
 
+    // Fresh session from the golden profile; if that fails the instance keeps
+    // whatever its directory holds
+    if (config->goldenProfile && inst != g_golden && PrepareGoldenProfile(config, status)) {
+        CloneGoldenProfile(inst, status);
+    }
+
     // Create temp directory for user data
-    if (!CreateTempDirectory()) {
+    if (!CreateTempDirectory(inst)) {
         return FALSE;
     }
+    RunCacheJanitor(inst, config);
 
     // Create job object
-    g_hJob = CreateJobObjectW(NULL, NULL);
-    if (!g_hJob) {
-        RemoveTempDirectory();
+    inst->hJob = CreateJobObjectW(NULL, NULL);
+    if (!inst->hJob) {
+        RemoveTempDirectory(inst);
         return FALSE;
     }
 
-    // Configure job to terminate all processes when closed
-    JOBOBJECT_EXTENDED_LIMIT_INFORMATION jobInfo = {0};
-    jobInfo.BasicLimitInformation.LimitFlags = JOB_OBJECT_LIMIT_KILL_ON_JOB_CLOSE;
-    SetInformationJobObject(g_hJob, JobObjectExtendedLimitInformation,
-                             &jobInfo, sizeof(jobInfo));
+    // Terminate all processes when the job is closed; resource limits
+    ConfigureJobLimits(inst->hJob, config);
+
+    // Exit and crash notifications arrive on the job monitor thread
+    AssociateJobWithMonitor(inst);
 
-    // Build command line - start off-screen so window is never visible
-    wchar_t cmdLine[MAX_PATH * 2];
-    swprintf_s(cmdLine, sizeof(cmdLine)/sizeof(wchar_t),
-               L"\"%s\" --remote-debugging-port=%d --user-data-dir=\"%s\" --window-position=-32000,-32000",
-               g_config.chromePath, g_config.debugPort, g_szTempDir);
+    // Watch for the debug endpoint to come up
+    StartReadyWatch(inst);
+
+    // Build command line (CreateProcessW may write to it)
+    wchar_t* cmdLine = (wchar_t*)malloc((CHROME_COMMAND_LINE_MAX + 1) * sizeof(wchar_t));
+    BOOL success = cmdLine && BuildChromeCommandLine(inst, config, cmdLine, CHROME_COMMAND_LINE_MAX + 1);
+    if (cmdLine && !success) {
+        LogMessage(L"Instance #%d (:%d): Chrome command line too long, not launched", inst->index + 1,
+                   inst->debugPort);
+    }
 
     // Launch Chrome
     STARTUPINFOW si = {0};
@@ -1441,68 +5821,607 @@ static BOOL LaunchChrome(void) {
     si.dwFlags = STARTF_USESHOWWINDOW;
     si.wShowWindow = SW_HIDE;  // Start completely hidden
 
-    BOOL success = CreateProcessW(NULL, cmdLine, NULL, NULL, FALSE,
-                                   CREATE_NEW_PROCESS_GROUP | CREATE_SUSPENDED,
-                                   NULL, NULL, &si, &pi);
+    success = success && CreateProcessW(NULL, cmdLine, NULL, NULL, FALSE,
+                                        CREATE_NEW_PROCESS_GROUP | CREATE_SUSPENDED,
+                                        NULL, NULL, &si, &pi);
+    free(cmdLine);
 
     if (!success) {
-        CloseHandle(g_hJob);
-        g_hJob = NULL;
-        RemoveTempDirectory();
+        StopReadyWatch(inst);
+        CloseHandle(inst->hJob);
+        inst->hJob = NULL;
+        RemoveTempDirectory(inst);
         return FALSE;
     }
 
-    // Assign to job
-    AssignProcessToJobObject(g_hJob, pi.hProcess);
+    // Assign to job; the browser is recorded right away, before its
+    // NEW_PROCESS notification, as it creates the windows
+    AssignProcessToJobObject(inst->hJob, pi.hProcess);
+    AddJobProcess(pi.dwProcessId, inst->generation);
 
     // Resume the process
     ResumeThread(pi.hThread);
 
-    g_hChromeProcess = pi.hProcess;
-    g_dwChromePID = pi.dwProcessId;
-    g_chromeRunning = TRUE;
-    g_chromeHidden = TRUE;  // Start hidden on every launch
-
-    // Install real-time hook to catch any new windows
-    InstallWinEventHook();
+    inst->hProcess = pi.hProcess;
+    inst->pid = pi.dwProcessId;
+    inst->running = TRUE;
+    inst->cacheTrimmed = FALSE;
+    inst->launchUs = CdpNowUs();
+    inst->abnormalExitCount = 0;
+    if (inst->index < MAX_INSTANCES) {
+        g_chromeHidden = TRUE;  // Start hidden on every launch (background browsers always are)
+    }
 
     CloseHandle(pi.hThread);
 
     return TRUE;
 }
 
-static void TerminateChrome(void) {
-    // Remove window event hook
-    RemoveWinEventHook();
+// The window event hook belongs to the UI thread; callers remove it first
+static void TerminateChrome(ChromeInstance* inst) {
+    StopReadyWatch(inst);
+
+    if (inst->hJob) {
+        TerminateJobObject(inst->hJob, 0);
+        CloseHandle(inst->hJob);
+        inst->hJob = NULL;
+        RemoveJobProcesses(inst->generation);
+    }
+
+    if (inst->hProcess) {
+        CloseHandle(inst->hProcess);
+        inst->hProcess = NULL;
+    }
+
+    inst->pid = 0;
+    inst->running = FALSE;
+
+    // Port forwards are left in place so remote agents see no gap across a
+    // restart; PerformCleanup removes them on exit
+    // Profile directory is intentionally kept for persistence
+}
+
+// Asks the browser to shut down over its debug endpoint; the exit itself is
+// awaited on the job. Chrome may drop the socket before its answer arrives,
+// which counts as accepted.
+static BOOL RequestBrowserClose(ChromeInstance* inst) {
+    if (!inst->hJob || !inst->hProcess || WaitForSingleObject(inst->hProcess, 0) != WAIT_TIMEOUT) {
+        return FALSE;
+    }
+
+    CdpSession session;
+    CdpSessionInit(&session, CLOSE_CDP_TIMEOUT_MS);
+    BOOL ok = FALSE;
+    if (CdpSessionOpen(&session, "127.0.0.1", inst->debugPort) == CDP_OK) {
+        int result = CdpSessionCall(&session, NULL, "Browser.close", NULL, NULL);
+        ok = result == CDP_OK || result == CDP_ERR_IO;
+    }
+    CdpSessionClose(&session);
+    return ok;
+}
+
+// TRUE once no process is left in the instance's job, FALSE at the deadline (GetTickCount64)
+static BOOL WaitForJobExit(ChromeInstance* inst, ULONGLONG deadline) {
+    // The browser process goes last but for stragglers; wait on it, then poll the job
+    ULONGLONG now = GetTickCount64();
+    if (inst->hProcess && now < deadline) {
+        WaitForSingleObject(inst->hProcess, (DWORD)(deadline - now));
+    }
+
+    for (;;) {
+        JOBOBJECT_BASIC_ACCOUNTING_INFORMATION info = {0};
+        if (!QueryInformationJobObject(inst->hJob, JobObjectBasicAccountingInformation,
+                                       &info, sizeof(info), NULL)) {
+            return FALSE;
+        }
+        if (info.ActiveProcesses == 0) return TRUE;
+        if (GetTickCount64() >= deadline) return FALSE;
+        Sleep(CLOSE_POLL_INTERVAL_MS);
+    }
+}
+
+// Terminates whatever outlived a close request and logs how the instance went down
+static void FinishChromeClose(ChromeInstance* inst, const Configuration* config, BOOL requested, ULONGLONG start,
+                              ULONGLONG deadline) {
+    if (!inst->running) return;
+
+    BOOL exited = requested && WaitForJobExit(inst, deadline);
+    ULONGLONG elapsed = GetTickCount64() - start;
+    if (exited) {
+        LogMessage(L"Instance #%d (:%d): closed by Browser.close in %llu ms", inst->index + 1,
+                   inst->debugPort, elapsed);
+    } else if (requested) {
+        LogMessage(L"Instance #%d (:%d): still running %llu ms after Browser.close, terminated",
+                   inst->index + 1, inst->debugPort, elapsed);
+    } else if (inst->hProcess && WaitForSingleObject(inst->hProcess, 0) == WAIT_TIMEOUT) {
+        // Not for a Chrome that already exited on its own
+        LogMessage(config->closeTimeout > 0 ? L"Instance #%d (:%d): Browser.close failed, terminated"
+                                             : L"Instance #%d (:%d): terminated", inst->index + 1,
+                   inst->debugPort);
+    }
+    TerminateChrome(inst);
+}
+
+// Stops an instance's Chrome the way a user closing it would, falling back to
+// job termination after closeTimeout. Caller holds the instance lock.
+static void CloseChrome(ChromeInstance* inst, const Configuration* config) {
+    ULONGLONG start = GetTickCount64();
+    BOOL requested = inst->running && config->closeTimeout > 0 && RequestBrowserClose(inst);
+    FinishChromeClose(inst, config, requested, start, start + (ULONGLONG)config->closeTimeout * 1000);
+}
+
+// Exit: every Chrome is asked to close first, so they shut down in parallel
+// within one shared deadline
+static void TerminateAllChrome(void) {
+    BOOL requested[GOLDEN_INDEX + 1] = {0};
+    ULONGLONG start = GetTickCount64();
+
+    for (int i = 0; i <= GOLDEN_INDEX; i++) {
+        AcquireSRWLockExclusive(&g_instances[i].lock);
+    }
+    for (int i = 0; i <= STANDBY_INDEX && g_config.closeTimeout > 0; i++) {
+        if (g_instances[i].running) requested[i] = RequestBrowserClose(&g_instances[i]);
+    }
+
+    ULONGLONG deadline = GetTickCount64() + (ULONGLONG)g_config.closeTimeout * 1000;
+    for (int i = 0; i <= GOLDEN_INDEX; i++) {
+        FinishChromeClose(&g_instances[i], &g_config, requested[i], start, deadline);
+        ReleaseSRWLockExclusive(&g_instances[i].lock);
+    }
+}
+
+static BOOL IsChromePathValid(const Configuration* config) {
+    if (config->chromePath[0] == L'\0') return FALSE;
+    DWORD attrs = GetFileAttributesW(config->chromePath);
+    return attrs != INVALID_FILE_ATTRIBUTES && !(attrs & FILE_ATTRIBUTE_DIRECTORY);
+}
+
+// Worker side of CHROME_TASK_FAILOVER. The exited instance adopts the
+// standby's running Chrome (process, job, generation, port and profile) and
+// its forwards are re-pointed there; the standby slot takes over the exited
+// instance's home so the next standby can launch in it. Returns FALSE if the
+// standby went away in the meantime.
+static BOOL FailoverToStandby(ChromeInstance* inst, const Configuration* config, FailoverResult* failover) {
+    // Lock order: pool instance (held by the caller), then standby
+    AcquireSRWLockExclusive(&g_standby->lock);
+    if (!g_standby->running) {
+        ReleaseSRWLockExclusive(&g_standby->lock);
+        return FALSE;
+    }
+
+    TerminateChrome(inst);
+    StopReadyWatch(g_standby);
+
+    int oldPort = inst->debugPort;
+    wchar_t oldProfileDir[MAX_PATH];
+    wcscpy_s(oldProfileDir, MAX_PATH, inst->profileDir);
+
+    inst->hJob = g_standby->hJob;
+    inst->hProcess = g_standby->hProcess;
+    inst->pid = g_standby->pid;
+    inst->generation = g_standby->generation;
+    inst->running = TRUE;
+    inst->launchUs = g_standby->launchUs;
+    inst->readyAtUs = g_standby->readyAtUs;
+    inst->debugPort = g_standby->debugPort;
+    wcscpy_s(inst->profileDir, MAX_PATH, g_standby->profileDir);
+
+    g_standby->hJob = NULL;
+    g_standby->hProcess = NULL;
+    g_standby->pid = 0;
+    g_standby->generation = 0;
+    g_standby->running = FALSE;
+    g_standby->launchUs = 0;
+    g_standby->readyAtUs = 0;
+    g_standby->debugPort = oldPort;
+    wcscpy_s(g_standby->profileDir, MAX_PATH, oldProfileDir);
+
+    ReleaseSRWLockExclusive(&g_standby->lock);
+
+    // A standby still starting up reports ready under the instance now (its
+    // generation moved along)
+    failover->standbyReady = (inst->readyAtUs != 0);
+    if (!failover->standbyReady) {
+        ArmReadyWatch(inst);
+    }
+
+    RepointPortForwards(config, config->debugPort + inst->index, inst->debugPort);
+    failover->repointedUs = CdpNowUs();
+    failover->adopted = TRUE;
+    return TRUE;
+}
+
+// Worker side of a lifecycle task (CHROME_TASK_*); result = Chrome launched
+// (or adopted). Instances have their own locks, so a pool starts its browsers
+// in parallel.
+static void ChromeLifecycleRun(Task* task) {
+    int kind = CHROME_TASK_KIND(task->param);
+
+    task->result = FALSE;
+    if (kind == CHROME_TASK_FORWARDS) {
+        // Forwarding settings changed - rebuild against the new ports/address/mode
+        SetupPortForwards(&task->config, &task->status);
+        return;
+    }
+
+    ChromeInstance* inst = &g_instances[CHROME_TASK_INSTANCE(task->param)];
+    AcquireSRWLockExclusive(&inst->lock);
+
+    if (kind == CHROME_TASK_FAILOVER && FailoverToStandby(inst, &task->config, (FailoverResult*)task->data)) {
+        task->result = TRUE;
+        ReleaseSRWLockExclusive(&inst->lock);
+        return;
+    }
+
+    BOOL launch = TRUE;
+    if (kind != CHROME_TASK_START) {
+        CloseChrome(inst, &task->config);
+        if (kind == CHROME_TASK_STOP) RunCacheJanitor(inst, &task->config);
+        // After an unexpected exit, validate the chrome path still exists
+        launch = (kind == CHROME_TASK_RELAUNCH || kind == CHROME_TASK_FAILOVER) &&
+                 IsChromePathValid(&task->config);
+        if (launch) Sleep(CHROME_RELAUNCH_DELAY_MS);  // Brief pause
+    }
+
+    if (launch) {
+        if (inst != g_standby) EnsurePortForwards(&task->config, &task->status);
+        task->result = LaunchChrome(inst, &task->config, &task->status);
+    }
+    if (!task->result && kind != CHROME_TASK_START && kind != CHROME_TASK_STOP &&
+        CountRunningInstances() == 0) {
+        // The whole pool is gone - don't keep forwarding to nothing
+        CleanupAllPortForwards();
+    }
+
+    ReleaseSRWLockExclusive(&inst->lock);
+}
+
+static void OnFailoverComplete(ChromeInstance* inst, const FailoverResult* failover) {
+    g_standby->tasksPending--;
+    g_standby->ready = FALSE;
+
+    if (failover->adopted) {
+        inst->ready = inst->ready || failover->standbyReady;
+        inst->timeToReadyMs = 0;
+        g_status.failoverCount++;
+        g_status.lastFailoverMs = (double)(failover->repointedUs - failover->exitUs) / 1000.0;
+        g_status.lastFailoverUs = failover->exitUs;
+        g_status.lastFailoverInstance = inst->index;
+
+        // Forwards already point at the adopted Chrome; warm up the next standby
+        // in the background
+        SyncLivenessMonitors();
+        ScheduleStatusProbe(0);
+        if (IsStandbyConfigured() && !g_poolRestartPending) {
+            QueueChromeLifecycleTask(CHROME_TASK_START, STANDBY_INDEX);
+        }
+    }
+}
+
+static void ChromeLifecycleComplete(Task* task) {
+    int kind = CHROME_TASK_KIND(task->param);
+    g_lifecycleTasksPending--;
+
+    if (kind == CHROME_TASK_FORWARDS) {
+        UpdateStatus();
+        return;
+    }
+
+    ChromeInstance* inst = &g_instances[CHROME_TASK_INSTANCE(task->param)];
+    inst->tasksPending--;
+
+    if (kind == CHROME_TASK_FAILOVER) {
+        OnFailoverComplete(inst, (const FailoverResult*)task->data);
+    }
+
+    if (task->result) {
+        // Probe fast until the debug endpoint answers (or the watch reports
+        // ready); the standby is not probed
+        if (!inst->ready && inst != g_standby) {
+            inst->timeToReadyMs = 0;
+            SetProbeMode(PROBE_MODE_STARTUP);
+        }
+    } else if (kind == CHROME_TASK_START && inst->index == 0) {
+        MessageBoxW(NULL, L"Failed to launch Chrome.\n\n"
+                         L"Please check your Chrome path in Configuration.",
+                   L"Error", MB_OK | MB_ICONERROR);
+    }
+
+    // Second phase of a pool restart: start again once every instance is down
+    if (g_poolRestartPending) {
+        BOOL idle = TRUE;
+        for (int i = 0; i <= STANDBY_INDEX; i++) {
+            if (g_instances[i].tasksPending > 0) idle = FALSE;
+        }
+        if (idle) {
+            g_poolRestartPending = FALSE;
+            StartChrome();
+        }
+    }
+
+    // Hook each idle instance's browser for new windows (unhooked while it
+    // restarts); the all-process hook only covers golden profile preparation
+    if (g_lifecycleTasksPending == 0) {
+        RemoveWinEventHook();
+    }
+    SyncWinEventHooks();
+
+    UpdateStatus();
+}
+
+static void QueueChromeLifecycleTaskWithData(int kind, int index, void* data) {
+    if (kind != CHROME_TASK_FORWARDS) {
+        g_instances[index].ready = FALSE;
+    }
+
+    // Hooks are owned by this (UI) thread and must go before Chrome does.
+    // A start may prepare the golden profile first; its browser is not known
+    // here, so all processes are hooked until then.
+    if (kind == CHROME_TASK_START && g_config.goldenProfile) {
+        InstallWinEventHook();
+    } else if (kind != CHROME_TASK_START && kind != CHROME_TASK_FORWARDS) {
+        RemoveProcessHook(index);
+        if (kind == CHROME_TASK_FAILOVER) RemoveProcessHook(STANDBY_INDEX);
+    }
+    if (QueueTask(ChromeLifecycleRun, ChromeLifecycleComplete, CHROME_TASK_PARAM(kind, index), data)) {
+        g_lifecycleTasksPending++;
+        if (kind != CHROME_TASK_FORWARDS) {
+            g_instances[index].tasksPending++;
+        }
+        // The standby is handed over - keep OnChromeExited and the config
+        // dialog off it until then
+        if (kind == CHROME_TASK_FAILOVER) {
+            g_standby->tasksPending++;
+        }
+    }
+}
+
+static void QueueChromeLifecycleTask(int kind, int index) {
+    QueueChromeLifecycleTaskWithData(kind, index, NULL);
+}
+
+// Starts the pool at its configured size (and the standby, if enabled).
+// Homes are reset first, so forwards left over from a failover are rebuilt.
+static void StartChrome(void) {
+    // A standby still up would keep its home - take it down with the rest
+    if (g_standby->running || g_standby->tasksPending > 0) {
+        RestartChrome(FALSE);
+        return;
+    }
+
+    BOOL homesChanged = ResetInstanceHomes();
+    if (g_forwardsEnabled && (homesChanged || g_poolRestartRebuild)) {
+        RebuildPortForwards();
+    }
+    g_poolRestartRebuild = FALSE;
+
+    for (int i = 0; i < g_config.instanceCount; i++) {
+        QueueChromeLifecycleTask(CHROME_TASK_START, i);
+    }
+    if (IsStandbyConfigured()) {
+        QueueChromeLifecycleTask(CHROME_TASK_START, STANDBY_INDEX);
+    }
+    SyncLivenessMonitors();
+}
+
+// Restarts the pool at its configured size. Everything is stopped first and
+// started again once the last instance is down, so no launch can collide with
+// a port still held by another instance after a failover swapped homes.
+static void RestartChrome(BOOL rebuildForwards) {
+    g_poolRestartRebuild = g_poolRestartRebuild || rebuildForwards;
+    if (g_poolRestartPending) return;
+
+    g_poolRestartPending = TRUE;
+    BOOL queued = FALSE;
+    for (int i = 0; i <= STANDBY_INDEX; i++) {
+        if (g_instances[i].running || g_instances[i].tasksPending > 0) {
+            QueueChromeLifecycleTask(CHROME_TASK_STOP, i);
+            queued = TRUE;
+        }
+    }
+    if (!queued) {
+        g_poolRestartPending = FALSE;
+        StartChrome();
+    }
+}
+
+static void RebuildPortForwards(void) {
+    QueueChromeLifecycleTask(CHROME_TASK_FORWARDS, 0);
+}
+
+// ============================================================================
+// Profile Location Benchmark
+// ============================================================================
+
+// Times launch-to-DevTools and page loads of a Chrome on a fresh profile below
+// root. Load times run from Page.navigate (or Page.reload) to the load event
+// of a tab driven over a flat CDP session.
+static BOOL RunProfileBenchmarkRound(ChromeInstance* inst, const Configuration* config, const wchar_t* root,
+                                     const char* url, double* launchMs, double* loadMs, double* reloadMs) {
+    swprintf_s(inst->profileDir, MAX_PATH, L"%schrome_debug_benchmark", root);
+    DeleteDirectoryTree(inst->profileDir);
+    if (!LaunchChrome(inst, config, NULL)) return FALSE;
+
+    BOOL ok = inst->hReadyWatchThread &&
+              WaitForSingleObject(inst->hReadyWatchThread, PROFILE_BENCHMARK_TIMEOUT_MS) == WAIT_OBJECT_0 &&
+              inst->readyAtUs > inst->launchUs;
+    if (ok) {
+        *launchMs = (double)(inst->readyAtUs - inst->launchUs) / 1000.0;
+
+        CdpSession session;
+        CdpSessionInit(&session, PROFILE_BENCHMARK_TIMEOUT_MS);
+        const char* response = NULL;
+        char targetId[64], sessionId[CDP_SESSION_ID_MAX], params[PROFILE_BENCHMARK_URL_MAX + 64];
+
+        ok = CdpSessionOpen(&session, "127.0.0.1", inst->debugPort) == CDP_OK &&
+             CdpSessionCall(&session, NULL, "Target.createTarget", "{\"url\":\"about:blank\"}",
+                            &response) == CDP_OK &&
+             CdpJsonGetString(response, "targetId", targetId, sizeof(targetId));
+        if (ok) {
+            snprintf(params, sizeof(params), "{\"targetId\":\"%s\",\"flatten\":true}", targetId);
+            ok = CdpSessionCall(&session, NULL, "Target.attachToTarget", params, &response) == CDP_OK &&
+                 CdpJsonGetString(response, "sessionId", sessionId, sizeof(sessionId)) &&
+                 CdpSessionCall(&session, sessionId, "Page.enable", NULL, NULL) == CDP_OK;
+        }
+        if (ok) {
+            snprintf(params, sizeof(params), "{\"url\":\"%s\"}", url);
+            unsigned long long start = CdpNowUs();
+            ok = CdpSessionCall(&session, sessionId, "Page.navigate", params, NULL) == CDP_OK &&
+                 CdpSessionWaitEvent(&session, sessionId, "Page.loadEventFired", NULL) == CDP_OK;
+            *loadMs = (double)(CdpNowUs() - start) / 1000.0;
+        }
+        if (ok) {
+            unsigned long long start = CdpNowUs();
+            ok = CdpSessionCall(&session, sessionId, "Page.reload", NULL, NULL) == CDP_OK &&
+                 CdpSessionWaitEvent(&session, sessionId, "Page.loadEventFired", NULL) == CDP_OK;
+            *reloadMs = (double)(CdpNowUs() - start) / 1000.0;
+        }
+        CdpSessionClose(&session);
+    }
+
+    // Let the browser go before its profile is deleted
+    if (inst->hJob) TerminateJobObject(inst->hJob, 0);
+    if (inst->hProcess) WaitForSingleObject(inst->hProcess, GOLDEN_CLOSE_TIMEOUT_MS);
+    TerminateChrome(inst);
+    DeleteDirectoryTree(inst->profileDir);
+    return ok;
+}
+
+// Compares profiles under %TEMP% with the configured memory-backed location
+static void RunProfileBenchmark(const char* url) {
+    if (!IsChromePathValid(&g_config)) {
+        MessageBoxW(NULL, L"Chrome path is not configured.", APP_NAME, MB_OK | MB_ICONERROR);
+        return;
+    }
+
+    // Measure plain launches: no golden clone, no janitor walk
+    Configuration config = g_config;
+    config.goldenProfile = FALSE;
+    for (int c = 0; c < CACHE_CLASS_COUNT; c++) {
+        config.cacheCapMB[c] = 0;
+    }
+
+    WSADATA wsaData;
+    BOOL winsock = (WSAStartup(MAKEWORD(2, 2), &wsaData) == 0);
+
+    wchar_t report[2048];
+    size_t reportLen = 0;
+    reportLen += swprintf_s(report + reportLen, 2048 - reportLen,
+                            L"Launch / first load / reload of %hs (ms, average of %d)\n\n",
+                            url, PROFILE_BENCHMARK_ROUNDS);
+
+    for (int memory = 0; memory < 2; memory++) {
+        wchar_t root[MAX_PATH];
+        BOOL inMemory = GetProfileRoot(memory ? config.memoryProfilePath : NULL, root, MAX_PATH);
+        if (memory && !inMemory) {
+            reportLen += swprintf_s(report + reportLen, 2048 - reportLen,
+                                    L"Memory-backed:\tnot configured or unavailable\n");
+            continue;
+        }
+
+        ChromeInstance inst = {0};
+        inst.index = GOLDEN_INDEX;  // Off the pool: never hides windows or takes the hook
+        inst.debugPort = PROFILE_BENCHMARK_PORT;
+
+        double totals[3] = {0};
+        int completed = 0;
+        for (int round = 0; round < PROFILE_BENCHMARK_ROUNDS; round++) {
+            double launchMs = 0, loadMs = 0, reloadMs = 0;
+            if (RunProfileBenchmarkRound(&inst, &config, root, url, &launchMs, &loadMs, &reloadMs)) {
+                totals[0] += launchMs;
+                totals[1] += loadMs;
+                totals[2] += reloadMs;
+                completed++;
+            }
+        }
+
+        if (completed > 0) {
+            reportLen += swprintf_s(report + reportLen, 2048 - reportLen,
+                                    L"%ls\t%.0f / %.0f / %.0f\t(%ls)\n",
+                                    memory ? L"Memory-backed:" : L"Disk:\t",
+                                    totals[0] / completed, totals[1] / completed, totals[2] / completed, root);
+        } else {
+            reportLen += swprintf_s(report + reportLen, 2048 - reportLen,
+                                    L"%ls\tfailed\t(%ls)\n", memory ? L"Memory-backed:" : L"Disk:\t", root);
+        }
+    }
+
+    if (winsock) WSACleanup();
+    MessageBoxW(NULL, report, APP_NAME, MB_OK | MB_ICONINFORMATION);
+}
+
+// ============================================================================
+// Chrome Taskbar Hiding
+// ============================================================================
+
+static BOOL IsChromeTopLevelWindow(HWND hwnd) {
+    wchar_t className[256];
+    return !(GetWindowLongPtrW(hwnd, GWL_STYLE) & WS_CHILD) &&
+           GetClassNameW(hwnd, className, 256) > 0 && wcscmp(className, CHROME_WINDOW_CLASS) == 0;
+}
+
+// Records a window next to the others of its process, so each browser's
+// windows form one run of g_chromeWindows
+static void TrackChromeWindow(HWND hwnd, DWORD pid) {
+    int insertAt = g_chromeWindowCount;
+    for (int i = 0; i < g_chromeWindowCount; i++) {
+        if (g_chromeWindows[i].hwnd == hwnd) {
+            if (g_chromeWindows[i].pid == pid) return;
+            // Handle reused by another browser - record it afresh
+            memmove(&g_chromeWindows[i], &g_chromeWindows[i + 1],
+                    (g_chromeWindowCount - i - 1) * sizeof(ChromeWindow));
+            g_chromeWindowCount--;
+            TrackChromeWindow(hwnd, pid);
+            return;
+        }
+        if (g_chromeWindows[i].pid == pid) insertAt = i + 1;
+    }
+    if (g_chromeWindowCount >= CHROME_WINDOW_MAX) return;
+
+    memmove(&g_chromeWindows[insertAt + 1], &g_chromeWindows[insertAt],
+            (g_chromeWindowCount - insertAt) * sizeof(ChromeWindow));
+    g_chromeWindows[insertAt].hwnd = hwnd;
+    g_chromeWindows[insertAt].pid = pid;
+    g_chromeWindowCount++;
+}
 
-    if (g_hJob) {
-        TerminateJobObject(g_hJob, 0);
-        CloseHandle(g_hJob);
-        g_hJob = NULL;
+static void UntrackChromeWindow(HWND hwnd) {
+    for (int i = 0; i < g_chromeWindowCount; i++) {
+        if (g_chromeWindows[i].hwnd == hwnd) {
+            memmove(&g_chromeWindows[i], &g_chromeWindows[i + 1],
+                    (g_chromeWindowCount - i - 1) * sizeof(ChromeWindow));
+            g_chromeWindowCount--;
+            return;
+        }
     }
+}
 
-    if (g_hChromeProcess) {
-        CloseHandle(g_hChromeProcess);
-        g_hChromeProcess = NULL;
+// Drops windows whose destroy event was missed (unhooked during a restart)
+static void PruneChromeWindows(void) {
+    int kept = 0;
+    for (int i = 0; i < g_chromeWindowCount; i++) {
+        DWORD pid = 0;
+        HWND hwnd = g_chromeWindows[i].hwnd;
+        if (IsWindow(hwnd) && GetWindowThreadProcessId(hwnd, &pid) && pid == g_chromeWindows[i].pid) {
+            g_chromeWindows[kept++] = g_chromeWindows[i];
+        }
     }
-
-    g_dwChromePID = 0;
-    g_chromeRunning = FALSE;
-
-    CleanupAllPortForwards();
-    // Profile directory is intentionally kept for persistence
+    g_chromeWindowCount = kept;
 }
 
-static void RestartChrome(void) {
-    TerminateChrome();
-    Sleep(500);  // Brief pause
-    SetupPortForwards();
-    LaunchChrome();
+static BOOL CALLBACK SeedChromeWindowsProc(HWND hwnd, LPARAM lParam) {
+    DWORD pid = 0;
+    GetWindowThreadProcessId(hwnd, &pid);
+    if (pid == (DWORD)lParam && IsChromeTopLevelWindow(hwnd)) {
+        TrackChromeWindow(hwnd, pid);
+    }
+    return TRUE;
 }
 
-// ============================================================================
-// Chrome Taskbar Hiding
-// ============================================================================
+// Windows a browser showed before its hook was installed; one walk per hook
+static void SeedChromeWindows(DWORD pid) {
+    EnumWindows(SeedChromeWindowsProc, (LPARAM)pid);
+}
 
 // Real-time hook callback - fires when any window is shown
 static void CALLBACK WinEventProc(
@@ -1515,43 +6434,40 @@ static void CALLBACK WinEventProc(
     DWORD dwmsEventTime)
 {
     (void)hWinEventHook;
-    (void)event;
     (void)idChild;
     (void)idEventThread;
     (void)dwmsEventTime;
 
     // Only care about window objects
     if (idObject != OBJID_WINDOW || !hwnd) return;
-    if (!g_chromeHidden || !g_hJob) return;
 
-    // Check if this window belongs to our Chrome job
+    if (event == EVENT_OBJECT_DESTROY) {
+        UntrackChromeWindow(hwnd);
+        return;
+    }
+
+    // Check if this window belongs to one of our Chrome jobs; background
+    // browsers stay hidden even after the pool was brought to front. Other
+    // processes only reach here through the golden profile's global hook.
     DWORD windowPID;
     GetWindowThreadProcessId(hwnd, &windowPID);
-
-    HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION, FALSE, windowPID);
-    if (hProcess) {
-        BOOL isInJob = FALSE;
-        IsProcessInJob(hProcess, g_hJob, &isInJob);
-        CloseHandle(hProcess);
-
-        if (isInJob) {
-            wchar_t className[256];
-            GetClassNameW(hwnd, className, 256);
-            if (wcscmp(className, L"Chrome_WidgetWin_1") == 0) {
-                // Move off-screen immediately, then hide
-                SetWindowPos(hwnd, NULL, -32000, -32000, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
-                ShowWindow(hwnd, SW_HIDE);
-                LONG_PTR exStyle = GetWindowLongPtrW(hwnd, GWL_EXSTYLE);
-                if (!(exStyle & WS_EX_TOOLWINDOW)) {
-                    SetWindowLongPtrW(hwnd, GWL_EXSTYLE, exStyle | WS_EX_TOOLWINDOW);
-                }
-            }
+    if (LookupJobProcess(windowPID) == 0 || !IsChromeTopLevelWindow(hwnd)) return;
+    TrackChromeWindow(hwnd, windowPID);
+
+    if ((g_chromeHidden && IsProcessInPool(windowPID)) || IsProcessInBackground(windowPID)) {
+        // Move off-screen immediately, then hide
+        SetWindowPos(hwnd, NULL, -32000, -32000, 0, 0, SWP_NOSIZE | SWP_NOZORDER | SWP_NOACTIVATE);
+        ShowWindow(hwnd, SW_HIDE);
+        LONG_PTR exStyle = GetWindowLongPtrW(hwnd, GWL_EXSTYLE);
+        if (!(exStyle & WS_EX_TOOLWINDOW)) {
+            SetWindowLongPtrW(hwnd, GWL_EXSTYLE, exStyle | WS_EX_TOOLWINDOW);
         }
     }
 }
 
 static void InstallWinEventHook(void) {
     if (g_hWinEventHook) return;  // Already installed
+    if (g_config.headless) return;  // Headless Chrome never creates a window
 
     g_hWinEventHook = SetWinEventHook(
         EVENT_OBJECT_SHOW, EVENT_OBJECT_SHOW,  // Only catch show events
@@ -1570,70 +6486,214 @@ static void RemoveWinEventHook(void) {
     }
 }
 
+static void RemoveProcessHook(int index) {
+    if (g_processHooks[index]) {
+        UnhookWinEvent(g_processHooks[index]);
+        g_processHooks[index] = NULL;
+        g_processHookPids[index] = 0;
+    }
+}
+
+// Hooks show and destroy events of each idle, running instance's browser
+// process only - it owns all of Chrome's top-level windows - so events from
+// the rest of the desktop are never delivered
+static void SyncWinEventHooks(void) {
+    for (int i = 0; i <= STANDBY_INDEX; i++) {
+        const ChromeInstance* inst = &g_instances[i];
+        DWORD pid = (!g_config.headless && inst->running && inst->tasksPending == 0) ? inst->pid : 0;
+        if (g_processHookPids[i] == pid) continue;
+
+        RemoveProcessHook(i);
+        if (pid != 0) {
+            // EVENT_OBJECT_DESTROY and EVENT_OBJECT_SHOW are adjacent
+            g_processHooks[i] = SetWinEventHook(EVENT_OBJECT_DESTROY, EVENT_OBJECT_SHOW, NULL, WinEventProc,
+                                                pid, 0, WINEVENT_OUTOFCONTEXT);
+            if (g_processHooks[i]) g_processHookPids[i] = pid;
+            SeedChromeWindows(pid);
+        }
+    }
+}
+
+static void RemoveAllWinEventHooks(void) {
+    RemoveWinEventHook();
+    for (int i = 0; i <= STANDBY_INDEX; i++) {
+        RemoveProcessHook(i);
+    }
+}
+
 // ============================================================================
-// Chrome Window Management
+// Window Hook Benchmark
 // ============================================================================
 
-static HWND g_lastChromeWindow = NULL;  // Track last window for SetForegroundWindow
+// A storm thread shows and hides a popup HOOK_BENCHMARK_EVENTS times. For each
+// show event the callback times the membership check the hook used to do for
+// a process outside every job (open it, ask the pool's and the background
+// jobs, twice) against the PID-set lookup it does now. Per-process hooks are
+// not timed: events of other processes are not delivered to them at all.
 
-static BOOL CALLBACK RestoreChromeWindowsProc(HWND hwnd, LPARAM lParam) {
-    (void)lParam;
+typedef struct {
+    HANDLE hJob;                     // Empty job standing in for each Chrome job
+    DWORD stormThreadId;
+    DWORD mainThreadId;
+    LONG events;
+    LONGLONG jobCheckTicks;
+    LONGLONG setLookupTicks;
+} HookBenchmark;
+
+static HookBenchmark g_hookBenchmark = {0};
+
+static void CALLBACK HookBenchmarkProc(HWINEVENTHOOK hWinEventHook, DWORD event, HWND hwnd, LONG idObject,
+                                       LONG idChild, DWORD idEventThread, DWORD dwmsEventTime) {
+    (void)hWinEventHook;
+    (void)event;
+    (void)idChild;
+    (void)dwmsEventTime;
+    if (idObject != OBJID_WINDOW || !hwnd || idEventThread != g_hookBenchmark.stormThreadId) return;
 
     DWORD windowPID;
     GetWindowThreadProcessId(hwnd, &windowPID);
 
-    if (g_hJob) {
+    LARGE_INTEGER start, jobChecked, setChecked;
+    QueryPerformanceCounter(&start);
+    int jobCounts[2] = { g_config.instanceCount, GOLDEN_INDEX - STANDBY_INDEX + 1 };
+    for (int pass = 0; pass < 2; pass++) {
         HANDLE hProcess = OpenProcess(PROCESS_QUERY_INFORMATION, FALSE, windowPID);
-        if (hProcess) {
-            BOOL isInJob = FALSE;
-            IsProcessInJob(hProcess, g_hJob, &isInJob);
-            CloseHandle(hProcess);
+        if (!hProcess) continue;
+        BOOL found = FALSE;
+        for (int i = 0; i < jobCounts[pass] && !found; i++) {
+            IsProcessInJob(hProcess, g_hookBenchmark.hJob, &found);
+        }
+        CloseHandle(hProcess);
+    }
+    QueryPerformanceCounter(&jobChecked);
+    volatile LONG generation = LookupJobProcess(windowPID);
+    (void)generation;
+    QueryPerformanceCounter(&setChecked);
+
+    g_hookBenchmark.events++;
+    g_hookBenchmark.jobCheckTicks += jobChecked.QuadPart - start.QuadPart;
+    g_hookBenchmark.setLookupTicks += setChecked.QuadPart - jobChecked.QuadPart;
+}
 
-            if (isInJob) {
-                wchar_t className[256];
-                GetClassNameW(hwnd, className, 256);
-                if (wcscmp(className, L"Chrome_WidgetWin_1") == 0) {
-                    // Check if window is off-screen and move it back
-                    RECT rect;
-                    if (GetWindowRect(hwnd, &rect)) {
-                        if (rect.left < -10000 || rect.top < -10000) {
-                            // Move to center of screen
-                            int screenW = GetSystemMetrics(SM_CXSCREEN);
-                            int screenH = GetSystemMetrics(SM_CYSCREEN);
-                            int winW = rect.right - rect.left;
-                            int winH = rect.bottom - rect.top;
-                            int x = (screenW - winW) / 2;
-                            int y = (screenH - winH) / 2;
-                            SetWindowPos(hwnd, NULL, x, y, 0, 0, SWP_NOSIZE | SWP_NOZORDER);
-                        }
-                    }
-
-                    // Show and restore the window
-                    ShowWindow(hwnd, SW_SHOW);
-                    if (IsIconic(hwnd)) {
-                        ShowWindow(hwnd, SW_RESTORE);
-                    }
-                    // Track window with title as main window
-                    wchar_t title[256];
-                    if (GetWindowTextW(hwnd, title, 256) > 0) {
-                        g_lastChromeWindow = hwnd;
-                    }
-                }
-            }
+static DWORD WINAPI HookStormThread(LPVOID param) {
+    (void)param;
+    HWND hwnd = CreateWindowExW(WS_EX_TOOLWINDOW | WS_EX_NOACTIVATE, L"STATIC", L"", WS_POPUP,
+                                -32000, -32000, 16, 16, NULL, NULL, g_hInstance, NULL);
+    if (hwnd) {
+        for (int i = 0; i < HOOK_BENCHMARK_EVENTS; i++) {
+            ShowWindow(hwnd, SW_SHOWNOACTIVATE);
+            ShowWindow(hwnd, SW_HIDE);
+        }
+        DestroyWindow(hwnd);
+    }
+
+    // Out-of-context events are still queued for the main thread
+    Sleep(1000);
+    PostThreadMessage(g_hookBenchmark.mainThreadId, WM_QUIT, 0, 0);
+    return 0;
+}
+
+static void RunHookBenchmark(void) {
+    // Chrome processes in the set, as a busy pool would have
+    for (int i = 0; i < HOOK_BENCHMARK_MEMBERS; i++) {
+        AddJobProcess(0x40000000 + (DWORD)i * 4, 1);
+    }
+    g_hookBenchmark.hJob = CreateJobObjectW(NULL, NULL);
+    g_hookBenchmark.mainThreadId = GetCurrentThreadId();
+
+    // Events of this process only (the storm thread); the real hooks skip it
+    HWINEVENTHOOK hook = SetWinEventHook(EVENT_OBJECT_SHOW, EVENT_OBJECT_SHOW, NULL, HookBenchmarkProc,
+                                         GetCurrentProcessId(), 0, WINEVENT_OUTOFCONTEXT);
+    HANDLE hThread = (hook && g_hookBenchmark.hJob)
+                     ? CreateThread(NULL, 0, HookStormThread, NULL, CREATE_SUSPENDED, &g_hookBenchmark.stormThreadId)
+                     : NULL;
+
+    LARGE_INTEGER freq, start, end;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&start);
+    if (hThread) {
+        ResumeThread(hThread);
+        MSG msg;
+        while (GetMessage(&msg, NULL, 0, 0) > 0) {
+            DispatchMessage(&msg);
+        }
+        WaitForSingleObject(hThread, INFINITE);
+        CloseHandle(hThread);
+    }
+    QueryPerformanceCounter(&end);
+    if (hook) UnhookWinEvent(hook);
+    if (g_hookBenchmark.hJob) CloseHandle(g_hookBenchmark.hJob);
+
+    wchar_t report[1024];
+    LONG events = g_hookBenchmark.events;
+    if (events == 0) {
+        swprintf_s(report, 1024, L"Window hook benchmark failed: no show events received.");
+    } else {
+        double jobUs = (double)g_hookBenchmark.jobCheckTicks * 1e6 / freq.QuadPart / events;
+        double setUs = (double)g_hookBenchmark.setLookupTicks * 1e6 / freq.QuadPart / events;
+        swprintf_s(report, 1024,
+                   L"Window hook overhead per non-Chrome show event\n"
+                   L"(%ld events in %.1f s, %d instances, %d PIDs in the set)\n\n"
+                   L"Job membership check (before):\t%.2f us\n"
+                   L"PID set lookup (now):\t\t%.3f us\n"
+                   L"Per-process hooks:\t\tnot delivered\n\n"
+                   L"Speedup of the lookup: %.0fx",
+                   events, (double)(end.QuadPart - start.QuadPart) / freq.QuadPart - 1.0,
+                   g_config.instanceCount, HOOK_BENCHMARK_MEMBERS, jobUs, setUs,
+                   setUs > 0 ? jobUs / setUs : 0.0);
+    }
+    MessageBoxW(NULL, report, APP_NAME, MB_OK | MB_ICONINFORMATION);
+}
+
+// ============================================================================
+// Chrome Window Management
+// ============================================================================
+
+static HWND g_lastChromeWindow = NULL;  // Track last window for SetForegroundWindow
+
+static void RestoreChromeWindow(HWND hwnd) {
+    // Check if window is off-screen and move it back
+    RECT rect;
+    if (GetWindowRect(hwnd, &rect)) {
+        if (rect.left < -10000 || rect.top < -10000) {
+            // Move to center of screen
+            int screenW = GetSystemMetrics(SM_CXSCREEN);
+            int screenH = GetSystemMetrics(SM_CYSCREEN);
+            int winW = rect.right - rect.left;
+            int winH = rect.bottom - rect.top;
+            int x = (screenW - winW) / 2;
+            int y = (screenH - winH) / 2;
+            SetWindowPos(hwnd, NULL, x, y, 0, 0, SWP_NOSIZE | SWP_NOZORDER);
         }
     }
-    return TRUE;  // Continue enumeration to restore all windows
+
+    // Show and restore the window
+    ShowWindow(hwnd, SW_SHOW);
+    if (IsIconic(hwnd)) {
+        ShowWindow(hwnd, SW_RESTORE);
+    }
+    // Track window with title as main window
+    wchar_t title[256];
+    if (GetWindowTextW(hwnd, title, 256) > 0) {
+        g_lastChromeWindow = hwnd;
+    }
 }
 
+// Only the tracked Chrome windows are touched, no desktop-wide walk
 static void BringChromeToFront(void) {
-    if (!g_chromeRunning || !g_hJob) return;
+    if (CountRunningInstances() == 0) return;
 
     // Mark as no longer hidden
     g_chromeHidden = FALSE;
 
-    // Restore all Chrome windows
+    // Restore all Chrome windows of every instance
     g_lastChromeWindow = NULL;
-    EnumWindows(RestoreChromeWindowsProc, 0);
+    PruneChromeWindows();
+    for (int i = 0; i < g_chromeWindowCount; i++) {
+        if (IsProcessInPool(g_chromeWindows[i].pid)) {
+            RestoreChromeWindow(g_chromeWindows[i].hwnd);
+        }
+    }
 
     // Bring the main window to front
     if (g_lastChromeWindow) {
@@ -1641,127 +6701,458 @@ static void BringChromeToFront(void) {
     }
 }
 
+// Selects the target's tab and reads the bounds of the window holding it
+static void BringTargetRun(Task* task) {
+    BringTargetRequest* request = (BringTargetRequest*)task->data;
+    char host[CDP_HOST_MAX];
+    GetDevToolsEndpoint(&task->config, host, sizeof(host));
+
+    char params[128];
+    snprintf(params, sizeof(params), "{\"targetId\":\"%s\"}", request->targetId);
+
+    CdpSession session;
+    CdpSessionInit(&session, BRING_TARGET_TIMEOUT_MS);
+    const char* response = NULL;
+    if (CdpSessionOpen(&session, host, request->port) == CDP_OK &&
+        CdpSessionCall(&session, NULL, "Target.activateTarget", params, NULL) == CDP_OK &&
+        CdpSessionCall(&session, NULL, "Browser.getWindowForTarget", params, &response) == CDP_OK) {
+        request->found = CdpJsonGetInt(response, "left", &request->left) &&
+                         CdpJsonGetInt(response, "top", &request->top) &&
+                         CdpJsonGetInt(response, "width", &request->width) &&
+                         CdpJsonGetInt(response, "height", &request->height);
+    }
+    CdpSessionClose(&session);
+}
+
+// Matches the bounds (DIPs, so compared unscaled and at the system DPI)
+// against the instance's tracked windows and raises the closest one
+static void BringTargetComplete(Task* task) {
+    const BringTargetRequest* request = (const BringTargetRequest*)task->data;
+    const ChromeInstance* inst = &g_instances[request->instance];
+    if (!request->found || !inst->running) return;
+
+    HDC hdc = GetDC(NULL);
+    int dpi = hdc ? GetDeviceCaps(hdc, LOGPIXELSX) : 96;
+    if (hdc) ReleaseDC(NULL, hdc);
+
+    HWND best = NULL;
+    long bestError = 0;
+    PruneChromeWindows();
+    for (int i = 0; i < g_chromeWindowCount; i++) {
+        HWND hwnd = g_chromeWindows[i].hwnd;
+        RECT rect;
+        if (g_chromeWindows[i].pid != inst->pid || !IsWindowVisible(hwnd) || !GetWindowRect(hwnd, &rect)) continue;
+        for (int pass = 0; pass < 2; pass++) {
+            int f = pass ? dpi : 96;
+            long error = labs(rect.left - MulDiv(request->left, f, 96)) +
+                         labs(rect.top - MulDiv(request->top, f, 96)) +
+                         labs((rect.right - rect.left) - MulDiv(request->width, f, 96)) +
+                         labs((rect.bottom - rect.top) - MulDiv(request->height, f, 96));
+            if (!best || error < bestError) {
+                best = hwnd;
+                bestError = error;
+            }
+        }
+    }
+    if (best) {
+        if (IsIconic(best)) ShowWindow(best, SW_RESTORE);
+        SetForegroundWindow(best);
+    }
+}
+
+// Tray "Pages": shows the pool, then raises the window with the target's tab
+static void BringTargetToFront(int instance, int target) {
+    const ChromeInstance* inst = &g_instances[instance];
+    if (!inst->running || target >= inst->targetCount) return;
+
+    BringChromeToFront();
+
+    BringTargetRequest* request = (BringTargetRequest*)calloc(1, sizeof(BringTargetRequest));
+    if (!request) return;
+    request->instance = instance;
+    request->port = inst->debugPort;
+    strcpy_s(request->targetId, sizeof(request->targetId), inst->targets[target].targetId);
+    QueueTask(BringTargetRun, BringTargetComplete, 0, request);
+}
+
+// Headless Chrome has no window to show; open the DevTools frontend it serves
+// for its first page target in the default browser instead. The liveness
+// monitor's target list carries no focus, so with several pages open the
+// first one reported wins. Without a page, the target list is opened.
+static void OpenDevToolsInspector(void) {
+    const ChromeInstance* inst = NULL;
+    const CdpTargetInfo* target = NULL;
+    for (int i = 0; i < g_config.instanceCount && !target; i++) {
+        const ChromeInstance* candidate = &g_instances[i];
+        if (!candidate->running) continue;
+        if (!inst) inst = candidate;
+        for (int t = 0; t < candidate->targetCount && t < CDP_MAX_TARGETS; t++) {
+            if (strcmp(candidate->targets[t].type, "page") == 0) {
+                inst = candidate;
+                target = &candidate->targets[t];
+                break;
+            }
+        }
+    }
+    if (!inst) return;
+
+    wchar_t url[512];
+    if (target) {
+        swprintf_s(url, 512, L"http://%ls:%d/devtools/inspector.html?ws=%ls:%d/devtools/page/%hs",
+                   g_config.connectAddress, inst->debugPort, g_config.connectAddress, inst->debugPort,
+                   target->targetId);
+    } else {
+        swprintf_s(url, 512, L"http://%ls:%d/json/list", g_config.connectAddress, inst->debugPort);
+    }
+    ShellExecuteW(NULL, L"open", url, NULL, NULL, SW_SHOWNORMAL);
+}
+
+// Tray double-click and a second launcher start
+static void ShowChrome(void) {
+    if (g_config.headless) {
+        OpenDevToolsInspector();
+    } else {
+        BringChromeToFront();
+    }
+}
+
 // ============================================================================
 // Status Checking
 // ============================================================================
 
-static BOOL CheckChromeApiStatus(void) {
-    char url[128];
+// Fetches /json/version over the instance's persistent DevTools connection
+static BOOL CheckChromeApiStatus(ChromeInstance* inst, const Configuration* config, char* version,
+                                 size_t versionLen, unsigned long long* latencyUs) {
     char connectAddr[64];
-    WideCharToMultiByte(CP_UTF8, 0, g_config.connectAddress, -1, connectAddr, 64, NULL, NULL);
-
-    // Fetch /json/version to get Chrome version
-    snprintf(url, sizeof(url), "http://%s:%d/json/version", connectAddr, g_config.debugPort);
-
-    HINTERNET hInternet = InternetOpenA("ChromeDevLauncher",
-                                         INTERNET_OPEN_TYPE_DIRECT,
-                                         NULL, NULL, 0);
-    if (!hInternet) return FALSE;
-
-    HINTERNET hConnect = InternetOpenUrlA(hInternet, url, NULL, 0,
-                                           INTERNET_FLAG_RELOAD | INTERNET_FLAG_NO_CACHE_WRITE,
-                                           0);
-
-    BOOL success = FALSE;
-    g_status.chromeVersion[0] = '\0';
-
-    if (hConnect) {
-        char buffer[1024];
-        DWORD bytesRead;
-        if (InternetReadFile(hConnect, buffer, sizeof(buffer) - 1, &bytesRead)) {
-            buffer[bytesRead] = '\0';
-            // Check for Browser field in JSON response
-            char* browserField = strstr(buffer, "\"Browser\"");
-            if (browserField) {
-                success = TRUE;
-                // Parse version: "Browser": "Chrome/141.0.7390.123"
-                char* colonPos = strchr(browserField, ':');
-                if (colonPos) {
-                    char* startQuote = strchr(colonPos, '"');
-                    if (startQuote) {
-                        startQuote++; // Skip opening quote
-                        char* endQuote = strchr(startQuote, '"');
-                        if (endQuote) {
-                            size_t len = endQuote - startQuote;
-                            if (len < sizeof(g_status.chromeVersion)) {
-                                strncpy(g_status.chromeVersion, startQuote, len);
-                                g_status.chromeVersion[len] = '\0';
-                            }
-                        }
-                    }
-                }
-            }
+    WideCharToMultiByte(CP_UTF8, 0, config->connectAddress, -1, connectAddr, 64, NULL, NULL);
+
+    version[0] = '\0';
+    *latencyUs = 0;
+
+    // Reconnects only if the address or port changed (or the connection dropped)
+    CdpHttpSetTarget(&inst->http, connectAddr, inst->debugPort);
+
+    char body[DEVTOOLS_RESPONSE_MAX];
+    int httpStatus = 0;
+    if (CdpHttpGet(&inst->http, "/json/version", body, sizeof(body), &httpStatus) != CDP_OK ||
+        httpStatus != 200) {
+        return FALSE;
+    }
+
+    // Browser field, e.g. "Browser": "Chrome/141.0.7390.123"
+    if (!CdpJsonGetString(body, "Browser", version, versionLen)) {
+        return FALSE;
+    }
+
+    *latencyUs = inst->http.lastLatencyUs;
+    return TRUE;
+}
+
+// Probes every instance of the pool (task->param = instance count); stopped
+// instances are reported as not responding without a connection attempt
+static void StatusProbeRun(Task* task) {
+    StatusProbeResult* results = (StatusProbeResult*)task->data;
+    for (int i = 0; i < (int)task->param; i++) {
+        StatusProbeResult* result = &results[i];
+        if (g_instances[i].running) {
+            result->responding = CheckChromeApiStatus(&g_instances[i], &task->config, result->version,
+                                                      sizeof(result->version), &result->latencyUs);
+        }
+        result->completedUs = CdpNowUs();
+    }
+}
+
+static void StatusProbeComplete(Task* task) {
+    const StatusProbeResult* results = (const StatusProbeResult*)task->data;
+    int running = 0, responding = 0;
+    g_statusProbePending = FALSE;
+
+    for (int i = 0; i < (int)task->param; i++) {
+        const StatusProbeResult* result = &results[i];
+        ChromeInstance* inst = &g_instances[i];
+
+        inst->apiResponding = result->responding;
+        strcpy_s(inst->version, sizeof(inst->version), result->version);
+        if (result->responding) inst->probeLatencyUs = result->latencyUs;
+
+        // Fallback for when the DevToolsActivePort watch could not be armed
+        if (result->responding && inst->running && !inst->ready && inst->launchUs) {
+            inst->ready = TRUE;
+            inst->timeToReadyMs = (double)(result->completedUs - inst->launchUs) / 1000.0;
+        }
+
+        if (inst->running) {
+            running++;
+            if (result->responding) responding++;
         }
-        InternetCloseHandle(hConnect);
     }
+    OnStatusProbeResult(running > 0 && responding == running);
 
-    InternetCloseHandle(hInternet);
-    return success;
+    RefreshStatusText();
+    UpdateTrayTooltip();
 }
 
+// Refreshes status text from local state right away and probes the Chrome API
+// on a worker; the probe result updates status and tooltip when it arrives
 static void UpdateStatus(void) {
-    // Check Chrome API
-    g_status.chromeApiResponding = CheckChromeApiStatus();
+    RefreshStatusText();
+    UpdateTrayTooltip();
+
+    if (g_statusProbePending) return;  // One probe in flight is enough
+
+    int count = g_config.instanceCount;
+    StatusProbeResult* results = (StatusProbeResult*)calloc(count, sizeof(StatusProbeResult));
+    if (results && QueueTask(StatusProbeRun, StatusProbeComplete, count, results)) {
+        g_statusProbePending = TRUE;
+    }
+}
+
+// Version without the "Chrome/" prefix, "Connected" if unknown
+static void FormatInstanceVersion(const ChromeInstance* inst, wchar_t* buffer, size_t size) {
+    const char* versionStr = inst->version;
+    if (strncmp(versionStr, "Chrome/", 7) == 0) {
+        versionStr += 7;  // Skip "Chrome/"
+    }
+    if (versionStr[0]) {
+        MultiByteToWideChar(CP_UTF8, 0, versionStr, -1, buffer, (int)size);
+    } else {
+        wcscpy_s(buffer, size, L"Connected");
+    }
+}
+
+// "Chrome: <version>", plus how long the last launch took to answer
+static void FormatChromeStatus(const ChromeInstance* inst, wchar_t* buffer, size_t size) {
+    wchar_t versionW[64];
+    FormatInstanceVersion(inst, versionW, 64);
+    if (inst->timeToReadyMs > 0) {
+        swprintf_s(buffer, size, L"Chrome: %ls (ready in %.0f ms)", versionW, inst->timeToReadyMs);
+    } else {
+        swprintf_s(buffer, size, L"Chrome: %ls", versionW);
+    }
+}
+
+// "API: Responding" with probe latency and, once the CDP session is up, the target count
+static void FormatApiStatus(const ChromeInstance* inst, wchar_t* buffer, size_t size) {
+    if (inst->cdpLinkState == CDP_LINK_UP) {
+        swprintf_s(buffer, size, L"API: Responding (%.1f ms, %d targets)",
+                   inst->probeLatencyUs / 1000.0, inst->targetCount);
+    } else {
+        swprintf_s(buffer, size, L"API: Responding (%.1f ms)", inst->probeLatencyUs / 1000.0);
+    }
+}
+
+// One line per pool instance for the tray menu, e.g.
+// "#2 :9223 - 141.0.7390.123, ready in 812 ms, 1.2 ms, 3 targets"
+static void FormatInstanceSummary(const ChromeInstance* inst, wchar_t* buffer, size_t size) {
+    int port = g_config.debugPort + inst->index;
+    int len;
+
+    if (!inst->running) {
+        len = swprintf_s(buffer, size, L"#%d :%d - Not running", inst->index + 1, port);
+    } else if (!inst->ready && !inst->apiResponding) {
+        len = swprintf_s(buffer, size, L"#%d :%d - Starting...", inst->index + 1, port);
+    } else if (!inst->apiResponding) {
+        len = swprintf_s(buffer, size, L"#%d :%d - Not responding", inst->index + 1, port);
+    } else {
+        wchar_t versionW[64];
+        FormatInstanceVersion(inst, versionW, 64);
+        len = swprintf_s(buffer, size, L"#%d :%d - %ls, ready in %.0f ms, %.1f ms",
+                         inst->index + 1, port, versionW, inst->timeToReadyMs,
+                         inst->probeLatencyUs / 1000.0);
+        if (len > 0 && inst->cdpLinkState == CDP_LINK_UP) {
+            len += swprintf_s(buffer + len, size - len, L", %d targets", inst->targetCount);
+        }
+    }
+
+    if (len > 0 && inst->running && inst->abnormalExitCount > 0) {
+        len += swprintf_s(buffer + len, size - len, L", %d crashes", inst->abnormalExitCount);
+    }
+    if (len > 0 && inst->limitHitCount > 0) {
+        swprintf_s(buffer + len, size - len, L", %d limit hits", inst->limitHitCount);
+    }
+}
+
+// Job limit line, e.g. "Limits: 3 hits (last: Process memory, PID 1234 at 12:03:04)"
+static void FormatLimitStatus(wchar_t* buffer, size_t size) {
+    const ChromeInstance* last = NULL;
+    int hits = 0;
+    for (int i = 0; i <= STANDBY_INDEX; i++) {
+        const ChromeInstance* inst = &g_instances[i];
+        if (inst->limitHitCount == 0) continue;
+        hits += inst->limitHitCount;
+        if (!last || inst->lastLimitTick > last->lastLimitTick) last = inst;
+    }
+
+    buffer[0] = L'\0';
+    if (!last) return;
+    int written = swprintf_s(buffer, size, L"Limits: %d hit%ls (last: %ls", hits, hits == 1 ? L"" : L"s",
+                             GetJobLimitName(last->lastLimit));
+    if (written > 0 && last->lastLimitPID) {
+        written += swprintf_s(buffer + written, size - (size_t)written, L", PID %lu", last->lastLimitPID);
+    }
+    if (written > 0) {
+        swprintf_s(buffer + written, size - (size_t)written, L" at %02d:%02d:%02d)",
+                   last->lastLimitTime.wHour, last->lastLimitTime.wMinute, last->lastLimitTime.wSecond);
+    }
+}
+
+// Active forward ports in ascending order, consecutive ports as ranges
+// ("9222-9225"); forwards on several interfaces share a port
+static void FormatForwardPorts(wchar_t* buffer, size_t size) {
+    int ports[MAX_FORWARDS];
+    int count = 0;
+
+    AcquireSRWLockShared(&g_forwardLock);
+    for (int i = 0; i < g_portForwardCount; i++) {
+        if (!g_portForwards[i].active) continue;
+        int port = g_portForwards[i].listenPort;
+        int pos = count;
+        while (pos > 0 && ports[pos - 1] > port) pos--;
+        if (pos > 0 && ports[pos - 1] == port) continue;
+        memmove(&ports[pos + 1], &ports[pos], sizeof(int) * (count - pos));
+        ports[pos] = port;
+        count++;
+    }
+    ReleaseSRWLockShared(&g_forwardLock);
+
+    size_t used = 0;
+    buffer[0] = L'\0';
+    for (int i = 0; i < count; i++) {
+        int first = ports[i];
+        while (i + 1 < count && ports[i + 1] == ports[i] + 1) i++;
+
+        int written = (first == ports[i])
+            ? swprintf_s(buffer + used, size - used, L"%ls%d", used ? L"," : L"", first)
+            : swprintf_s(buffer + used, size - used, L"%ls%d-%d", used ? L"," : L"", first, ports[i]);
+        if (written <= 0) break;
+        used += (size_t)written;
+    }
+}
+
+// Pool of more than one instance: aggregate lines; per-instance health goes
+// to the tray's Instances submenu
+static void RefreshPoolStatusText(const wchar_t* portList) {
+    int running = CountRunningInstances();
+    int ready = CountReadyInstances();
+    int responding = 0, crashes = 0;
+    double slowestReadyMs = 0;
+    const ChromeInstance* versionSource = NULL;
+
+    for (int i = 0; i < g_config.instanceCount; i++) {
+        const ChromeInstance* inst = &g_instances[i];
+        if (!inst->running) continue;
+        crashes += inst->abnormalExitCount;
+        if (inst->timeToReadyMs > slowestReadyMs) slowestReadyMs = inst->timeToReadyMs;
+        if (inst->apiResponding) {
+            responding++;
+            if (!versionSource) versionSource = inst;
+        }
+    }
+
+    if (versionSource) {
+        // The slowest launch bounds how long the pool took to come up
+        wchar_t versionW[64];
+        wchar_t latency[48] = L"";
+        FormatInstanceVersion(versionSource, versionW, 64);
+        if (slowestReadyMs > 0) swprintf_s(latency, 48, L", slowest start %.0f ms", slowestReadyMs);
+        swprintf_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Chrome pool: %d/%d ready (%ls%ls)",
+                   ready, g_config.instanceCount, versionW, latency);
+    } else if (ready < running) {
+        swprintf_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Chrome pool: Starting (%d/%d running)",
+                   running, g_config.instanceCount);
+    } else {
+        swprintf_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Chrome pool: Not responding (%d/%d running)",
+                   running, g_config.instanceCount);
+    }
+
+    swprintf_s(g_status.statusLine2, MAX_STATUS_TEXT, L"API: %d/%d responding",
+               responding, g_config.instanceCount);
+
+    if (g_status.portForwardsActive) {
+        swprintf_s(g_status.statusLine3, MAX_STATUS_TEXT, L"Ports: Active (%ls)", portList);
+    } else {
+        wcscpy_s(g_status.statusLine3, MAX_STATUS_TEXT, L"Ports: None active");
+    }
+
+    if (crashes > 0) {
+        swprintf_s(g_status.statusLine4, MAX_STATUS_TEXT, L"Crashes: %d (see Instances)", crashes);
+    }
+}
+
+// Hot standby line, e.g. "Standby: Ready on :9223 (2 failovers, last 35 ms)"
+static void FormatStandbyStatus(wchar_t* buffer, size_t size) {
+    const wchar_t* state = L"Down";
+    if (g_standby->tasksPending > 0) {
+        state = L"Starting";
+    } else if (g_standby->running) {
+        state = g_standby->ready ? L"Ready" : L"Starting";
+    }
+
+    int written = swprintf_s(buffer, size, L"Standby: %ls on :%d", state, g_standby->debugPort);
+    if (written > 0 && g_status.failoverCount > 0) {
+        swprintf_s(buffer + written, size - (size_t)written, L" (%d failover%ls, last %.0f ms)",
+                   g_status.failoverCount, g_status.failoverCount == 1 ? L"" : L"s",
+                   g_status.lastFailoverMs);
+    }
+}
+
+// Rebuilds the status lines from the last probe result (no I/O)
+static void RefreshStatusText(void) {
+    const ChromeInstance* inst = &g_instances[0];
 
     // Check port forwards
     g_status.activeForwardCount = CountActivePortForwards();
     g_status.portForwardsActive = (g_status.activeForwardCount > 0);
+    ArmForwardRetry();
 
     // Build status text lines
     g_status.statusLine2[0] = L'\0';
     g_status.statusLine3[0] = L'\0';
+    g_status.statusLine4[0] = L'\0';
+    g_status.statusLine5[0] = L'\0';
+    g_status.statusLine6[0] = L'\0';
 
     // Build port list string for active ports
     wchar_t portList[128] = {0};
     if (g_status.portForwardsActive) {
-        wchar_t* ptr = portList;
-        size_t remaining = sizeof(portList) / sizeof(wchar_t);
-        BOOL first = TRUE;
-        for (int i = 0; i < g_portForwardCount && remaining > 10; i++) {
-            if (g_portForwards[i].active) {
-                if (!first) {
-                    *ptr++ = L',';
-                    remaining--;
-                }
-                int written = swprintf_s(ptr, remaining, L"%d", g_portForwards[i].listenPort);
-                if (written > 0) {
-                    ptr += written;
-                    remaining -= written;
-                }
-                first = FALSE;
-            }
-        }
-    }
-
-    // Get version without "Chrome/" prefix
-    const char* versionStr = g_status.chromeVersion;
-    if (strncmp(versionStr, "Chrome/", 7) == 0) {
-        versionStr += 7;  // Skip "Chrome/"
+        FormatForwardPorts(portList, sizeof(portList) / sizeof(wchar_t));
     }
 
     if (g_config.chromePath[0] == L'\0') {
         wcscpy_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Not configured");
-    } else if (!g_chromeRunning) {
+        return;
+    }
+    if (CountRunningInstances() == 0) {
         wcscpy_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Chrome not running");
-    } else if (g_status.chromeApiResponding && g_status.portForwardsActive) {
-        if (versionStr[0]) {
-            wchar_t versionW[64];
-            MultiByteToWideChar(CP_UTF8, 0, versionStr, -1, versionW, 64);
-            swprintf_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Chrome: %ls", versionW);
-        } else {
-            wcscpy_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Chrome: Connected");
-        }
-        wcscpy_s(g_status.statusLine2, MAX_STATUS_TEXT, L"API: Responding");
+        return;
+    }
+    if (IsStandbyConfigured()) {
+        FormatStandbyStatus(g_status.statusLine5, MAX_STATUS_TEXT);
+    }
+    FormatLimitStatus(g_status.statusLine6, MAX_STATUS_TEXT);
+    if (g_config.instanceCount > 1) {
+        RefreshPoolStatusText(portList);
+        return;
+    }
+
+    if (inst->abnormalExitCount > 0) {
+        swprintf_s(g_status.statusLine4, MAX_STATUS_TEXT, L"Crashes: %d (last PID %lu at %02d:%02d:%02d)",
+                   inst->abnormalExitCount, inst->lastAbnormalExitPID,
+                   inst->lastAbnormalExitTime.wHour, inst->lastAbnormalExitTime.wMinute,
+                   inst->lastAbnormalExitTime.wSecond);
+    }
+
+    if (!inst->ready && !inst->apiResponding) {
+        // Process is up but the debug endpoint is not listening yet
+        wcscpy_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Chrome: Starting...");
+        wcscpy_s(g_status.statusLine2, MAX_STATUS_TEXT, L"API: Not listening yet");
+    } else if (inst->apiResponding && g_status.portForwardsActive) {
+        FormatChromeStatus(inst, g_status.statusLine1, MAX_STATUS_TEXT);
+        FormatApiStatus(inst, g_status.statusLine2, MAX_STATUS_TEXT);
         swprintf_s(g_status.statusLine3, MAX_STATUS_TEXT, L"Ports: Active (%ls)", portList);
-    } else if (g_status.chromeApiResponding) {
-        if (versionStr[0]) {
-            wchar_t versionW[64];
-            MultiByteToWideChar(CP_UTF8, 0, versionStr, -1, versionW, 64);
-            swprintf_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Chrome: %ls", versionW);
-        } else {
-            wcscpy_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Chrome: Connected");
-        }
-        wcscpy_s(g_status.statusLine2, MAX_STATUS_TEXT, L"API: Responding");
+    } else if (inst->apiResponding) {
+        FormatChromeStatus(inst, g_status.statusLine1, MAX_STATUS_TEXT);
+        FormatApiStatus(inst, g_status.statusLine2, MAX_STATUS_TEXT);
         wcscpy_s(g_status.statusLine3, MAX_STATUS_TEXT, L"Ports: None active");
     } else if (g_status.portForwardsActive) {
         wcscpy_s(g_status.statusLine1, MAX_STATUS_TEXT, L"Chrome: Not responding");
@@ -1811,8 +7202,36 @@ static void PerformCleanup(void) {
     // Remove tray icon
     RemoveTrayIcon();
 
-    // Terminate Chrome and clean up port forwards
-    TerminateChrome();
+    // Stop following interface changes before forwards are torn down
+    UnregisterAddressChangeNotification();
+
+    // Let in-flight tasks finish; queued ones are dropped
+    StopTaskQueue();
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        g_instances[i].monitor.stop = 1;  // All at once, then wait for each
+    }
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        StopLivenessMonitor(&g_instances[i]);
+    }
+    StopCdpBroker();
+
+    // Terminate the pool and clean up port forwards
+    RemoveAllWinEventHooks();
+    wchar_t launcherCpu[MAX_STATUS_TEXT];
+    FormatLauncherCpu(launcherCpu, MAX_STATUS_TEXT);
+    LogMessage(L"%ls", launcherCpu);
+    TerminateAllChrome();
+    CleanupAllPortForwards();
+    StopJobMonitor();
+    RelayShutdown();
+
+    if (g_winsockStarted) {
+        for (int i = 0; i < MAX_INSTANCES; i++) {
+            CdpHttpClose(&g_instances[i].http);
+        }
+        WSACleanup();
+        g_winsockStarted = FALSE;
+    }
 
     // Release mutex
     if (g_hMutex) {
@@ -1833,52 +7252,19 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
 
         case WM_TIMER:
             if (wParam == ID_TIMER_STATUS_CHECK) {
-                UpdateStatus();
-                UpdateTrayTooltip();
-            } else if (wParam == ID_TIMER_CHROME_EXIT) {
-                // Check if Chrome is still running by querying Job Object
-                if (g_hJob && g_chromeRunning) {
-                    JOBOBJECT_BASIC_ACCOUNTING_INFORMATION jobInfo;
-                    if (QueryInformationJobObject(g_hJob, JobObjectBasicAccountingInformation,
-                                                   &jobInfo, sizeof(jobInfo), NULL)) {
-                        if (jobInfo.ActiveProcesses == 0) {
-                            // All processes in the job have exited
-                            TerminateChrome();
-
-                            // Always attempt relaunch with fresh firewall rules
-                            // First validate the chrome path exists
-                            BOOL canRelaunch = FALSE;
-                            if (g_config.chromePath[0] != L'\0') {
-                                DWORD attrs = GetFileAttributesW(g_config.chromePath);
-                                if (attrs != INVALID_FILE_ATTRIBUTES &&
-                                    !(attrs & FILE_ATTRIBUTE_DIRECTORY)) {
-                                    canRelaunch = TRUE;
-                                }
-                            }
-
-                            if (canRelaunch) {
-                                Sleep(500);
-                                // Reset firewall rules (remove and re-add)
-                                CleanupAllPortForwards();
-                                SetupPortForwards();
-                                if (!LaunchChrome()) {
-                                    // Launch failed - don't retry
-                                    CleanupAllPortForwards();
-                                }
-                            }
-
-                            UpdateStatus();
-                            UpdateTrayTooltip();
-                        }
-                    }
-                }
+                OnStatusProbeTimer();
+            } else if (wParam == ID_TIMER_RECONCILE || wParam == ID_TIMER_FORWARD_RETRY) {
+                KillTimer(hwnd, (UINT_PTR)wParam);
+                RequestForwardReconcile();
+            } else if (wParam == ID_TIMER_TELEMETRY) {
+                QueueTelemetrySweep();
             }
             return 0;
 
         case WM_TRAYICON:
             switch (lParam) {
                 case WM_LBUTTONDBLCLK:
-                    BringChromeToFront();
+                    ShowChrome();
                     break;
                 case WM_RBUTTONUP:
                     ShowContextMenu(hwnd);
@@ -1891,20 +7277,61 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
                 case ID_TRAY_MENU_CONFIGURE:
                     ShowConfigDialog(hwnd);
                     return 0;
+                case ID_TRAY_MENU_EXPORT_TELEMETRY:
+                    ExportTelemetry(hwnd);
+                    return 0;
                 case ID_TRAY_MENU_EXIT:
                     PerformCleanup();
                     PostQuitMessage(0);
                     return 0;
             }
+            if (LOWORD(wParam) >= ID_TRAY_MENU_PAGE_FIRST && LOWORD(wParam) <= ID_TRAY_MENU_PAGE_LAST) {
+                int item = LOWORD(wParam) - ID_TRAY_MENU_PAGE_FIRST;
+                BringTargetToFront(item / CDP_MAX_TARGETS, item % CDP_MAX_TARGETS);
+                return 0;
+            }
             break;
 
         case WM_BRING_CHROME_TO_FRONT:
-            BringChromeToFront();
+            ShowChrome();
+            return 0;
+
+        case WM_INTERFACES_CHANGED:
+            // Debounce: restart the timer on every notification of a burst
+            SetTimer(hwnd, ID_TIMER_RECONCILE, RECONCILE_DEBOUNCE_MS, NULL);
+            return 0;
+
+        case WM_TASK_COMPLETE:
+            CompleteTask((Task*)lParam);
+            return 0;
+
+        case WM_CHROME_EXITED:
+            OnChromeExited((LONG)wParam);
+            return 0;
+
+        case WM_CHROME_CRASHED:
+            OnChromeProcessCrashed((LONG)wParam, (DWORD)lParam);
+            return 0;
+
+        case WM_CHROME_READY:
+            OnChromeReady((LONG)wParam);
+            return 0;
+
+        case WM_CDP_LIVENESS:
+            OnLivenessChanged((const LivenessSnapshot*)lParam);
+            free((void*)lParam);
+            return 0;
+
+        case WM_CHROME_LIMIT:
+            OnJobLimitHit((const JobLimitEvent*)lParam);
+            free((void*)lParam);
             return 0;
 
         case WM_DESTROY:
             KillTimer(hwnd, ID_TIMER_STATUS_CHECK);
-            KillTimer(hwnd, ID_TIMER_CHROME_EXIT);
+            KillTimer(hwnd, ID_TIMER_RECONCILE);
+            KillTimer(hwnd, ID_TIMER_FORWARD_RETRY);
+            KillTimer(hwnd, ID_TIMER_TELEMETRY);
             PostQuitMessage(0);
             return 0;
     }
@@ -1919,7 +7346,6 @@ static LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM l
 int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
                     LPSTR lpCmdLine, int nCmdShow) {
     (void)hPrevInstance;
-    (void)lpCmdLine;
     (void)nCmdShow;
 
     g_hInstance = hInstance;
@@ -1937,6 +7363,13 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
         return 0;
     }
 
+    // Timing report for the netsh backends, then exit
+    if (lpCmdLine && strstr(lpCmdLine, "--benchmark-forwards")) {
+        RunForwardBenchmark();
+        PerformCleanup();
+        return 0;
+    }
+
     // Register cleanup handlers
     RegisterCleanupHandlers();
 
@@ -1945,6 +7378,30 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
         SetDefaultConfig(&g_config);
     }
 
+    // Disk vs. memory-backed profile timings, then exit
+    const char* profileBenchmark = lpCmdLine ? strstr(lpCmdLine, "--benchmark-profile") : NULL;
+    if (profileBenchmark) {
+        char url[PROFILE_BENCHMARK_URL_MAX] = PROFILE_BENCHMARK_URL;
+        const char* arg = profileBenchmark + strlen("--benchmark-profile");
+        if (*arg == '=' && arg[1] != '\0' && arg[1] != ' ') {
+            size_t len = strcspn(arg + 1, " \"\\");
+            if (len < sizeof(url)) {
+                memcpy(url, arg + 1, len);
+                url[len] = '\0';
+            }
+        }
+        RunProfileBenchmark(url);
+        PerformCleanup();
+        return 0;
+    }
+
+    // Window hook cost per event, before and after the PID set, then exit
+    if (lpCmdLine && strstr(lpCmdLine, "--benchmark-hook")) {
+        RunHookBenchmark();
+        PerformCleanup();
+        return 0;
+    }
+
     // First launch check - just mark as configured, user can configure via tray menu
     BOOL isFirstLaunch = IsFirstLaunch();
 
@@ -1992,23 +7449,41 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance,
     // Create tray icon
     CreateTrayIcon(g_hwnd);
 
-    // Setup port forwards and launch Chrome if configured
+    // Winsock for the DevTools clients (the relay takes its own reference)
+    WSADATA wsaData;
+    g_winsockStarted = (WSAStartup(MAKEWORD(2, 2), &wsaData) == 0);
+    ResetInstanceHomes();
+    for (int i = 0; i < MAX_INSTANCES; i++) {
+        CdpHttpInit(&g_instances[i].http, DEVTOOLS_CONNECT_TIMEOUT_MS, DEVTOOLS_READ_TIMEOUT_MS);
+    }
+
+    // Blocking work (forwards, launch, status probes) runs on worker threads;
+    // Chrome exits are reported by the job monitor as they happen
+    if (!StartTaskQueue() || !StartJobMonitor()) {
+        PerformCleanup();
+        return 1;
+    }
+
+    // Setup port forwards and launch the pool if configured
     if (g_config.chromePath[0] != L'\0') {
-        SetupPortForwards();
-        if (!LaunchChrome()) {
-            MessageBoxW(NULL, L"Failed to launch Chrome.\n\n"
-                             L"Please check your Chrome path in Configuration.",
-                       L"Error", MB_OK | MB_ICONERROR);
-        }
+        StartChrome();
     }
 
+    // Push-based health: one session per instance, follows Chrome across
+    // restarts by reconnecting
+    SyncLivenessMonitors();
+
+    // Keep forwards in sync as addresses come and go (Wi-Fi, VPN, DHCP)
+    RegisterAddressChangeNotification();
+
     // Initial status update
     UpdateStatus();
-    UpdateTrayTooltip();
 
-    // Start timers
-    SetTimer(g_hwnd, ID_TIMER_STATUS_CHECK, g_config.statusCheckInterval * 1000, NULL);
-    SetTimer(g_hwnd, ID_TIMER_CHROME_EXIT, CHROME_EXIT_CHECK_INTERVAL, NULL);
+    // Start the status probe scheduler (launch completion switches it to startup mode)
+    ScheduleStatusProbe(g_probeIntervalMs);
+
+    // Per-process resource samples of every Chrome job
+    SetTimer(g_hwnd, ID_TIMER_TELEMETRY, TELEMETRY_INTERVAL_MS, NULL);
 
     // Message loop
     MSG msg;
@@ -5,10 +5,23 @@ import {
   browseFile,
   closeDialog,
   onBrowseResult,
+  FORWARD_MODE_RELAY,
+  FORWARD_MODE_NETSH,
+  FORWARD_MODE_NETSH_BATCH,
+  FLAG_PRESET_NONE,
+  FLAG_PRESET_MAX_THROUGHPUT,
+  FLAG_PRESET_LOW_MEMORY,
+  EXTRA_ARGS_MAX,
+  MAX_INSTANCES,
+  CONTEXT_POOL_MAX,
+  TAB_POOL_MAX,
+  TAB_POOL_URLS_MAX,
+  TAB_POOL_URL_LIST_MAX,
 } from "./lib/bridge";
 import { Button } from "./components/ui/button";
 import { Input } from "./components/ui/input";
 import { Label } from "./components/ui/label";
+import { Select } from "./components/ui/select";
 
 interface Props {
   config: ConfigData;
@@ -17,10 +30,36 @@ interface Props {
 export default function ConfigView({ config }: Props) {
   const [chromePath, setChromePath] = useState(config.chromePath);
   const [debugPort, setDebugPort] = useState(String(config.debugPort));
+  const [instanceCount, setInstanceCount] = useState(String(config.instanceCount));
   const [connectAddress, setConnectAddress] = useState(config.connectAddress);
   const [statusCheckInterval, setStatusCheckInterval] = useState(
     String(config.statusCheckInterval)
   );
+  const [forwardMode, setForwardMode] = useState(String(config.forwardMode));
+  const [hotStandby, setHotStandby] = useState(config.hotStandby);
+  const [goldenProfile, setGoldenProfile] = useState(config.goldenProfile);
+  const [memoryProfilePath, setMemoryProfilePath] = useState(config.memoryProfilePath);
+  const [jobLimits, setJobLimits] = useState({
+    jobMemoryMB: String(config.jobMemoryMB),
+    processMemoryMB: String(config.processMemoryMB),
+    cpuRatePercent: String(config.cpuRatePercent),
+    activeProcessLimit: String(config.activeProcessLimit),
+  });
+  const [restartOnLimit, setRestartOnLimit] = useState(config.restartOnLimit);
+  const [closeTimeout, setCloseTimeout] = useState(String(config.closeTimeout));
+  const [flagPreset, setFlagPreset] = useState(String(config.flagPreset));
+  const [extraArgs, setExtraArgs] = useState(config.extraArgs);
+  const [headless, setHeadless] = useState(config.headless);
+  const [brokerPort, setBrokerPort] = useState(String(config.brokerPort));
+  const [contextPoolSize, setContextPoolSize] = useState(String(config.contextPoolSize));
+  const [tabPoolSize, setTabPoolSize] = useState(String(config.tabPoolSize));
+  const [tabPoolUrls, setTabPoolUrls] = useState(config.tabPoolUrls);
+  const [cacheCaps, setCacheCaps] = useState({
+    cacheCapMB: String(config.cacheCapMB),
+    codeCacheCapMB: String(config.codeCacheCapMB),
+    gpuCacheCapMB: String(config.gpuCacheCapMB),
+    cacheStorageCapMB: String(config.cacheStorageCapMB),
+  });
 
   const [errors, setErrors] = useState<Record<string, string>>({});
 
@@ -40,9 +79,75 @@ export default function ConfigView({ config }: Props) {
       newErrors.debugPort = "Port must be between 1 and 65535";
     }
 
+    const instances = parseInt(instanceCount, 10);
+    if (isNaN(instances) || instances < 1 || instances > MAX_INSTANCES) {
+      newErrors.instanceCount = `Instances must be between 1 and ${MAX_INSTANCES}`;
+    } else if (!newErrors.debugPort && port + instances - 1 > 65535) {
+      newErrors.instanceCount = "Port range must end at or below 65535";
+    } else if (!newErrors.debugPort && hotStandby && port + instances > 65535) {
+      newErrors.instanceCount = "No port left for the hot standby below 65535";
+    }
+
+    for (const value of Object.values(cacheCaps)) {
+      const cap = parseInt(value, 10);
+      if (isNaN(cap) || cap < 0) {
+        newErrors.cacheCaps = "Cache limits must be 0 (unlimited) or more";
+      }
+    }
+
+    for (const value of Object.values(jobLimits)) {
+      const limit = parseInt(value, 10);
+      if (isNaN(limit) || limit < 0) {
+        newErrors.jobLimits = "Limits must be 0 (unlimited) or more";
+      }
+    }
+    if (!newErrors.jobLimits && parseInt(jobLimits.cpuRatePercent, 10) > 100) {
+      newErrors.jobLimits = "CPU limit must be at most 100%";
+    }
+
+    const broker = parseInt(brokerPort, 10);
+    if (isNaN(broker) || broker < 0 || broker > 65535) {
+      newErrors.brokerPort = "Port must be 0 (off) or between 1 and 65535";
+    } else if (!newErrors.debugPort && !newErrors.instanceCount && broker >= port &&
+               broker <= port + instances - (hotStandby ? 0 : 1)) {
+      newErrors.brokerPort = "Port is used by the Chrome pool";
+    }
+
+    const poolSize = parseInt(contextPoolSize, 10);
+    if (isNaN(poolSize) || poolSize < 0 || poolSize > CONTEXT_POOL_MAX) {
+      newErrors.contextPoolSize = `Pool size must be between 0 and ${CONTEXT_POOL_MAX}`;
+    } else if (poolSize > 0 && broker === 0) {
+      newErrors.contextPoolSize = "The context pool is served by the CDP broker - set a broker port";
+    }
+
+    const tabs = parseInt(tabPoolSize, 10);
+    if (isNaN(tabs) || tabs < 0 || tabs > TAB_POOL_MAX) {
+      newErrors.tabPoolSize = `Pool size must be between 0 and ${TAB_POOL_MAX}`;
+    } else if (tabs > 0 && broker === 0) {
+      newErrors.tabPoolSize = "The tab pool is served by the CDP broker - set a broker port";
+    }
+
+    const urls = tabPoolUrls.trim().split(/\s+/).filter((url) => url.length > 0);
+    if (tabPoolUrls.trim().length > TAB_POOL_URL_LIST_MAX) {
+      newErrors.tabPoolUrls = `Start URLs must be at most ${TAB_POOL_URL_LIST_MAX} characters`;
+    } else if (urls.length > TAB_POOL_URLS_MAX) {
+      newErrors.tabPoolUrls = `At most ${TAB_POOL_URLS_MAX} start URLs`;
+    } else if (urls.some((url) => /["\\]/.test(url))) {
+      newErrors.tabPoolUrls = "Start URLs cannot contain quotes or backslashes";
+    }
+
     const interval = parseInt(statusCheckInterval, 10);
-    if (isNaN(interval) || interval < 5) {
-      newErrors.statusCheckInterval = "Interval must be at least 5 seconds";
+    if (isNaN(interval) || interval < 1) {
+      newErrors.statusCheckInterval = "Interval must be at least 1 second";
+    }
+
+    const timeout = parseInt(closeTimeout, 10);
+    if (isNaN(timeout) || timeout < 0 || timeout > 60) {
+      newErrors.closeTimeout = "Timeout must be between 0 and 60 seconds";
+    }
+
+    if (extraArgs.trim().length > EXTRA_ARGS_MAX) {
+      newErrors.extraArgs = `Extra arguments must be at most ${EXTRA_ARGS_MAX} characters`;
     }
 
     setErrors(newErrors);
@@ -55,8 +160,30 @@ export default function ConfigView({ config }: Props) {
     saveSettings({
       chromePath,
       debugPort: parseInt(debugPort, 10),
+      instanceCount: parseInt(instanceCount, 10),
       connectAddress: connectAddress || "127.0.0.1",
       statusCheckInterval: parseInt(statusCheckInterval, 10),
+      forwardMode: parseInt(forwardMode, 10),
+      hotStandby,
+      goldenProfile,
+      memoryProfilePath: memoryProfilePath.trim(),
+      jobMemoryMB: parseInt(jobLimits.jobMemoryMB, 10),
+      processMemoryMB: parseInt(jobLimits.processMemoryMB, 10),
+      cpuRatePercent: parseInt(jobLimits.cpuRatePercent, 10),
+      activeProcessLimit: parseInt(jobLimits.activeProcessLimit, 10),
+      restartOnLimit,
+      closeTimeout: parseInt(closeTimeout, 10),
+      flagPreset: parseInt(flagPreset, 10),
+      extraArgs: extraArgs.trim(),
+      headless,
+      brokerPort: parseInt(brokerPort, 10),
+      contextPoolSize: parseInt(contextPoolSize, 10),
+      tabPoolSize: parseInt(tabPoolSize, 10),
+      tabPoolUrls: tabPoolUrls.trim(),
+      cacheCapMB: parseInt(cacheCaps.cacheCapMB, 10),
+      codeCacheCapMB: parseInt(cacheCaps.codeCacheCapMB, 10),
+      gpuCacheCapMB: parseInt(cacheCaps.gpuCacheCapMB, 10),
+      cacheStorageCapMB: parseInt(cacheCaps.cacheStorageCapMB, 10),
     });
   };
 
@@ -76,18 +203,34 @@ export default function ConfigView({ config }: Props) {
         </div>
       </div>
 
-      <div className="space-y-1">
-        <Label>Debug Port</Label>
-        <Input
-          type="number"
-          value={debugPort}
-          onChange={(e) => setDebugPort(e.target.value)}
-          min={1}
-          max={65535}
-        />
-        {errors.debugPort && (
-          <p className="text-red-500 text-xs">{errors.debugPort}</p>
-        )}
+      <div className="flex gap-3">
+        <div className="space-y-1 flex-1">
+          <Label>Debug Port</Label>
+          <Input
+            type="number"
+            value={debugPort}
+            onChange={(e) => setDebugPort(e.target.value)}
+            min={1}
+            max={65535}
+          />
+          {errors.debugPort && (
+            <p className="text-red-500 text-xs">{errors.debugPort}</p>
+          )}
+        </div>
+
+        <div className="space-y-1 flex-1">
+          <Label>Chrome Instances</Label>
+          <Input
+            type="number"
+            value={instanceCount}
+            onChange={(e) => setInstanceCount(e.target.value)}
+            min={1}
+            max={MAX_INSTANCES}
+          />
+          {errors.instanceCount && (
+            <p className="text-red-500 text-xs">{errors.instanceCount}</p>
+          )}
+        </div>
       </div>
 
       <div className="space-y-1">
@@ -105,13 +248,208 @@ export default function ConfigView({ config }: Props) {
           type="number"
           value={statusCheckInterval}
           onChange={(e) => setStatusCheckInterval(e.target.value)}
-          min={5}
+          min={1}
         />
         {errors.statusCheckInterval && (
           <p className="text-red-500 text-xs">{errors.statusCheckInterval}</p>
         )}
       </div>
 
+      <div className="space-y-1">
+        <Label>Graceful Close Timeout (seconds, 0 = terminate)</Label>
+        <Input
+          type="number"
+          value={closeTimeout}
+          onChange={(e) => setCloseTimeout(e.target.value)}
+          min={0}
+          max={60}
+        />
+        {errors.closeTimeout && (
+          <p className="text-red-500 text-xs">{errors.closeTimeout}</p>
+        )}
+      </div>
+
+      <div className="space-y-1">
+        <Label>CDP Broker Port (0 = off)</Label>
+        <Input
+          type="number"
+          value={brokerPort}
+          onChange={(e) => setBrokerPort(e.target.value)}
+          min={0}
+          max={65535}
+        />
+        {errors.brokerPort && (
+          <p className="text-red-500 text-xs">{errors.brokerPort}</p>
+        )}
+      </div>
+
+      <div className="space-y-1">
+        <Label>Browser Context Pool (per instance, 0 = off)</Label>
+        <Input
+          type="number"
+          value={contextPoolSize}
+          onChange={(e) => setContextPoolSize(e.target.value)}
+          min={0}
+          max={CONTEXT_POOL_MAX}
+        />
+        {errors.contextPoolSize && (
+          <p className="text-red-500 text-xs">{errors.contextPoolSize}</p>
+        )}
+      </div>
+
+      <div className="space-y-1">
+        <Label>Tab Pool (per instance, 0 = off)</Label>
+        <Input
+          type="number"
+          value={tabPoolSize}
+          onChange={(e) => setTabPoolSize(e.target.value)}
+          min={0}
+          max={TAB_POOL_MAX}
+        />
+        {errors.tabPoolSize && (
+          <p className="text-red-500 text-xs">{errors.tabPoolSize}</p>
+        )}
+        <Input
+          value={tabPoolUrls}
+          onChange={(e) => setTabPoolUrls(e.target.value)}
+          placeholder="Start URLs, space-separated (about:blank if empty)"
+        />
+        {errors.tabPoolUrls && (
+          <p className="text-red-500 text-xs">{errors.tabPoolUrls}</p>
+        )}
+      </div>
+
+      <div className="space-y-1">
+        <Label>Port Forwarding</Label>
+        <Select
+          value={forwardMode}
+          onChange={(e) => setForwardMode(e.target.value)}
+        >
+          <option value={FORWARD_MODE_RELAY}>Built-in relay</option>
+          <option value={FORWARD_MODE_NETSH_BATCH}>netsh portproxy (batched)</option>
+          <option value={FORWARD_MODE_NETSH}>netsh portproxy (one process per interface)</option>
+        </Select>
+      </div>
+
+      <div className="space-y-1">
+        <Label>Chrome Flags</Label>
+        <Select
+          value={flagPreset}
+          onChange={(e) => setFlagPreset(e.target.value)}
+        >
+          <option value={FLAG_PRESET_NONE}>Default</option>
+          <option value={FLAG_PRESET_MAX_THROUGHPUT}>Max throughput (no background throttling)</option>
+          <option value={FLAG_PRESET_LOW_MEMORY}>Low memory (fewer renderers, smaller heaps)</option>
+        </Select>
+        <Input
+          value={extraArgs}
+          onChange={(e) => setExtraArgs(e.target.value)}
+          placeholder="Extra arguments, e.g. --disable-gpu --lang=en-US"
+        />
+        {errors.extraArgs && (
+          <p className="text-red-500 text-xs">{errors.extraArgs}</p>
+        )}
+      </div>
+
+      <label className="flex items-center gap-2">
+        <input
+          type="checkbox"
+          checked={headless}
+          onChange={(e) => setHeadless(e.target.checked)}
+        />
+        <span>Run Chrome headless (no windows to hide)</span>
+      </label>
+
+      <label className="flex items-center gap-2">
+        <input
+          type="checkbox"
+          checked={hotStandby}
+          onChange={(e) => setHotStandby(e.target.checked)}
+        />
+        <span>Keep a hot-standby Chrome for instant failover</span>
+      </label>
+
+      <label className="flex items-center gap-2">
+        <input
+          type="checkbox"
+          checked={goldenProfile}
+          onChange={(e) => setGoldenProfile(e.target.checked)}
+        />
+        <span>Start every session from a clean golden profile</span>
+      </label>
+
+      <div className="space-y-1">
+        <Label>Memory-Backed Profile Location</Label>
+        <Input
+          value={memoryProfilePath}
+          onChange={(e) => setMemoryProfilePath(e.target.value)}
+          placeholder="e.g. R:\ (RAM disk) - empty uses %TEMP%"
+        />
+      </div>
+
+      <div className="space-y-1">
+        <Label>Profile Cache Limits (MB, 0 = unlimited)</Label>
+        <div className="grid grid-cols-2 gap-x-3 gap-y-1">
+          {(
+            [
+              ["cacheCapMB", "Cache"],
+              ["codeCacheCapMB", "Code Cache"],
+              ["gpuCacheCapMB", "GPU caches"],
+              ["cacheStorageCapMB", "CacheStorage"],
+            ] as const
+          ).map(([key, label]) => (
+            <div key={key} className="flex items-center gap-2">
+              <span className="w-24 shrink-0">{label}</span>
+              <Input
+                type="number"
+                value={cacheCaps[key]}
+                onChange={(e) => setCacheCaps({ ...cacheCaps, [key]: e.target.value })}
+                min={0}
+              />
+            </div>
+          ))}
+        </div>
+        {errors.cacheCaps && (
+          <p className="text-red-500 text-xs">{errors.cacheCaps}</p>
+        )}
+      </div>
+
+      <div className="space-y-1">
+        <Label>Resource Limits per Chrome (0 = unlimited)</Label>
+        <div className="grid grid-cols-2 gap-x-3 gap-y-1">
+          {(
+            [
+              ["jobMemoryMB", "Memory (MB)"],
+              ["processMemoryMB", "Per process (MB)"],
+              ["cpuRatePercent", "CPU (%)"],
+              ["activeProcessLimit", "Processes"],
+            ] as const
+          ).map(([key, label]) => (
+            <div key={key} className="flex items-center gap-2">
+              <span className="w-24 shrink-0">{label}</span>
+              <Input
+                type="number"
+                value={jobLimits[key]}
+                onChange={(e) => setJobLimits({ ...jobLimits, [key]: e.target.value })}
+                min={0}
+              />
+            </div>
+          ))}
+        </div>
+        {errors.jobLimits && (
+          <p className="text-red-500 text-xs">{errors.jobLimits}</p>
+        )}
+      </div>
+
+      <label className="flex items-center gap-2">
+        <input
+          type="checkbox"
+          checked={restartOnLimit}
+          onChange={(e) => setRestartOnLimit(e.target.checked)}
+        />
+        <span>Restart Chrome when it hits a limit</span>
+      </label>
+
       <div className="flex justify-end gap-2 pt-1">
         <Button variant="outline" size="sm" className="min-w-[5rem]" onClick={() => closeDialog()}>
           Cancel
@@ -0,0 +1,19 @@
+import { forwardRef, type SelectHTMLAttributes } from "react";
+import { cn } from "../../lib/utils";
+
+const Select = forwardRef<
+  HTMLSelectElement,
+  SelectHTMLAttributes<HTMLSelectElement>
+>(({ className, ...props }, ref) => (
+  <select
+    className={cn(
+      "flex h-8 w-full rounded-md border border-neutral-300 bg-transparent px-2 py-1 text-xs shadow-sm transition-colors focus-visible:outline-none focus-visible:ring-1 focus-visible:ring-neutral-400 disabled:cursor-not-allowed disabled:opacity-50",
+      className
+    )}
+    ref={ref}
+    {...props}
+  />
+));
+Select.displayName = "Select";
+
+export { Select };
@@ -1,10 +1,64 @@
 export interface ConfigData {
   chromePath: string;
   debugPort: number;
+  instanceCount: number;
   connectAddress: string;
   statusCheckInterval: number;
+  forwardMode: number;
+  hotStandby: boolean;
+  goldenProfile: boolean;
+  // Memory-backed profile root (RAM disk), "" = %TEMP%
+  memoryProfilePath: string;
+  // Job limits per Chrome, 0 = unlimited
+  jobMemoryMB: number;
+  processMemoryMB: number;
+  cpuRatePercent: number;
+  activeProcessLimit: number;
+  restartOnLimit: boolean;
+  // Seconds Chrome gets to exit after Browser.close, 0 = terminate right away
+  closeTimeout: number;
+  // Chrome switches: FLAG_PRESET_* plus free-form arguments
+  flagPreset: number;
+  extraArgs: string;
+  headless: boolean;
+  // Port of the CDP broker agents share the pool through, 0 = off
+  brokerPort: number;
+  // Browser contexts the broker keeps ready per Chrome, 0 = off
+  contextPoolSize: number;
+  // Loaded tabs the broker keeps ready per Chrome, 0 = off, and the URLs
+  // they are loaded with, whitespace-separated (about:blank if none)
+  tabPoolSize: number;
+  tabPoolUrls: string;
+  // Profile cache caps in MB, 0 = unlimited
+  cacheCapMB: number;
+  codeCacheCapMB: number;
+  gpuCacheCapMB: number;
+  cacheStorageCapMB: number;
 }
 
+// Mirrors FORWARD_MODE_* in ChromeDevLauncher.c
+export const FORWARD_MODE_RELAY = 0;
+export const FORWARD_MODE_NETSH = 1;
+export const FORWARD_MODE_NETSH_BATCH = 2;
+
+// Mirrors FLAG_PRESET_* and CHROME_EXTRA_ARGS_MAX in ChromeDevLauncher.c
+export const FLAG_PRESET_NONE = 0;
+export const FLAG_PRESET_MAX_THROUGHPUT = 1;
+export const FLAG_PRESET_LOW_MEMORY = 2;
+export const EXTRA_ARGS_MAX = 1023;
+
+// Mirrors MAX_INSTANCES in ChromeDevLauncher.c
+export const MAX_INSTANCES = 16;
+
+// Mirrors CDP_BROKER_POOL_MAX in cdp.h
+export const CONTEXT_POOL_MAX = 32;
+
+// Mirrors CDP_BROKER_TAB_POOL_MAX, CDP_BROKER_TAB_URLS and
+// CDP_BROKER_TAB_URL_LIST_MAX in cdp.h
+export const TAB_POOL_MAX = 16;
+export const TAB_POOL_URLS_MAX = 8;
+export const TAB_POOL_URL_LIST_MAX = 1023;
+
 export interface InitData {
   view: "config";
   config: ConfigData;
@@ -67,8 +121,30 @@ export function saveSettings(config: ConfigData) {
     action: "saveSettings",
     chromePath: config.chromePath,
     debugPort: config.debugPort,
+    instanceCount: config.instanceCount,
     connectAddress: config.connectAddress,
     statusCheckInterval: config.statusCheckInterval,
+    forwardMode: config.forwardMode,
+    hotStandby: config.hotStandby,
+    goldenProfile: config.goldenProfile,
+    memoryProfilePath: config.memoryProfilePath,
+    jobMemoryMB: config.jobMemoryMB,
+    processMemoryMB: config.processMemoryMB,
+    cpuRatePercent: config.cpuRatePercent,
+    activeProcessLimit: config.activeProcessLimit,
+    restartOnLimit: config.restartOnLimit,
+    closeTimeout: config.closeTimeout,
+    flagPreset: config.flagPreset,
+    extraArgs: config.extraArgs,
+    headless: config.headless,
+    brokerPort: config.brokerPort,
+    contextPoolSize: config.contextPoolSize,
+    tabPoolSize: config.tabPoolSize,
+    tabPoolUrls: config.tabPoolUrls,
+    cacheCapMB: config.cacheCapMB,
+    codeCacheCapMB: config.codeCacheCapMB,
+    gpuCacheCapMB: config.gpuCacheCapMB,
+    cacheStorageCapMB: config.cacheStorageCapMB,
   });
 }
 
@@ -0,0 +1,3459 @@
+/**
+ * Chrome DevTools client - see cdp.h
+ */
+
+#ifdef _WIN32
+#ifndef _WIN32_WINNT
+#define _WIN32_WINNT 0x0600
+#endif
+#define FD_SETSIZE 256  // The broker selects on its listener, upstreams and agents at once
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#include <ntsecapi.h>
+#else
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "cdp.h"
+
+// ============================================================================
+// Platform helpers
+// ============================================================================
+
+unsigned long long CdpNowUs(void) {
+#ifdef _WIN32
+    static LARGE_INTEGER freq;
+    LARGE_INTEGER now;
+    if (freq.QuadPart == 0) QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&now);
+    return (unsigned long long)(now.QuadPart / freq.QuadPart) * 1000000ULL +
+           (unsigned long long)(now.QuadPart % freq.QuadPart) * 1000000ULL / (unsigned long long)freq.QuadPart;
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long long)ts.tv_sec * 1000000ULL + (unsigned long long)ts.tv_nsec / 1000ULL;
+#endif
+}
+
+// Stores value in *slot and returns what was there, atomically
+static void* CdpExchangePointer(void* volatile* slot, void* value) {
+#ifdef _WIN32
+    return InterlockedExchangePointer((PVOID volatile*)slot, value);
+#else
+    return __atomic_exchange_n(slot, value, __ATOMIC_SEQ_CST);
+#endif
+}
+
+static void CdpCloseSocket(CdpSocket s) {
+#ifdef _WIN32
+    closesocket(s);
+#else
+    close(s);
+#endif
+}
+
+static int CdpSetNonBlocking(CdpSocket s) {
+#ifdef _WIN32
+    u_long mode = 1;
+    return ioctlsocket(s, FIONBIO, &mode) == 0;
+#else
+    int flags = fcntl(s, F_GETFL, 0);
+    return flags >= 0 && fcntl(s, F_SETFL, flags | O_NONBLOCK) == 0;
+#endif
+}
+
+// Fills buf from the system's secure random source. Returns 0 if it failed.
+static int CdpRandom(unsigned char* buf, size_t len) {
+#ifdef _WIN32
+    return RtlGenRandom(buf, (ULONG)len) != FALSE;
+#else
+    FILE* f = fopen("/dev/urandom", "rb");
+    if (!f) return 0;
+    size_t got = fread(buf, 1, len, f);
+    fclose(f);
+    return got == len;
+#endif
+}
+
+static int CdpWouldBlock(void) {
+#ifdef _WIN32
+    int err = WSAGetLastError();
+    return err == WSAEWOULDBLOCK || err == WSAEINPROGRESS;
+#else
+    return errno == EWOULDBLOCK || errno == EAGAIN || errno == EINPROGRESS || errno == EINTR;
+#endif
+}
+
+// Waits until s is readable (or writable) or the deadline passes. Returns 1 if
+// ready, 0 on timeout, -1 on error.
+static int CdpWait(CdpSocket s, int forWrite, unsigned long long deadlineUs) {
+    for (;;) {
+        unsigned long long now = CdpNowUs();
+        if (now >= deadlineUs) return 0;
+        unsigned long long remaining = deadlineUs - now;
+
+        fd_set fds, errFds;
+        FD_ZERO(&fds);
+        FD_ZERO(&errFds);
+        FD_SET(s, &fds);
+        FD_SET(s, &errFds);
+        struct timeval tv;
+        tv.tv_sec = (long)(remaining / 1000000ULL);
+        tv.tv_usec = (long)(remaining % 1000000ULL);
+
+        int rc = select((int)s + 1, forWrite ? NULL : &fds, forWrite ? &fds : NULL, &errFds, &tv);
+        if (rc > 0) return FD_ISSET(s, &errFds) && !FD_ISSET(s, &fds) ? -1 : 1;
+        if (rc == 0) return 0;
+#ifndef _WIN32
+        if (errno == EINTR) continue;
+#endif
+        return -1;
+    }
+}
+
+// Starts a non-blocking connect to an IPv4 host:port. It is done once the
+// socket turns writable; CdpConnected tells whether it succeeded.
+static int CdpConnectStart(const char* host, int port, CdpSocket* out) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)port);
+    if (inet_pton(AF_INET, host, &addr.sin_addr) != 1) return CDP_ERR_CONNECT;
+
+    CdpSocket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == CDP_INVALID_SOCKET) return CDP_ERR_CONNECT;
+    if (!CdpSetNonBlocking(s)) {
+        CdpCloseSocket(s);
+        return CDP_ERR_CONNECT;
+    }
+
+    // Probes are tiny request/response exchanges - don't let Nagle delay them
+    int noDelay = 1;
+    setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+
+    if (connect(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 && !CdpWouldBlock()) {
+        CdpCloseSocket(s);
+        return CDP_ERR_CONNECT;
+    }
+    *out = s;
+    return CDP_OK;
+}
+
+static int CdpConnected(CdpSocket s) {
+    int err = 0;
+    socklen_t errLen = sizeof(err);
+    return getsockopt(s, SOL_SOCKET, SO_ERROR, (char*)&err, &errLen) == 0 && err == 0;
+}
+
+// Non-blocking connect to an IPv4 host:port, bounded by timeoutMs
+static int CdpConnect(const char* host, int port, int timeoutMs, CdpSocket* out) {
+    CdpSocket s;
+    int rc = CdpConnectStart(host, port, &s);
+    if (rc != CDP_OK) return rc;
+
+    unsigned long long deadline = CdpNowUs() + (unsigned long long)timeoutMs * 1000ULL;
+    if (CdpWait(s, 1, deadline) != 1 || !CdpConnected(s)) {
+        CdpCloseSocket(s);
+        return CDP_ERR_CONNECT;
+    }
+    *out = s;
+    return CDP_OK;
+}
+
+static int CdpSendAll(CdpSocket s, const char* data, size_t len, unsigned long long deadlineUs) {
+    while (len > 0) {
+        int n = send(s, data, (int)len, 0);
+        if (n > 0) {
+            data += n;
+            len -= (size_t)n;
+            continue;
+        }
+        if (n < 0 && CdpWouldBlock()) {
+            int ready = CdpWait(s, 1, deadlineUs);
+            if (ready == 0) return CDP_ERR_TIMEOUT;
+            if (ready < 0) return CDP_ERR_IO;
+            continue;
+        }
+        return CDP_ERR_IO;
+    }
+    return CDP_OK;
+}
+
+// Reads whatever is available, waiting up to the deadline. Returns bytes read,
+// 0 if the peer closed, or a CDP_ERR_* code.
+static int CdpRecvSome(CdpSocket s, char* buf, size_t len, unsigned long long deadlineUs) {
+    for (;;) {
+        int n = recv(s, buf, (int)len, 0);
+        if (n >= 0) return n;
+        if (!CdpWouldBlock()) return CDP_ERR_IO;
+
+        int ready = CdpWait(s, 0, deadlineUs);
+        if (ready == 0) return CDP_ERR_TIMEOUT;
+        if (ready < 0) return CDP_ERR_IO;
+    }
+}
+
+// ============================================================================
+// HTTP client
+// ============================================================================
+
+void CdpHttpInit(CdpHttpClient* client, int connectTimeoutMs, int readTimeoutMs) {
+    memset(client, 0, sizeof(*client));
+    client->sock = CDP_INVALID_SOCKET;
+    client->connectTimeoutMs = connectTimeoutMs;
+    client->readTimeoutMs = readTimeoutMs;
+}
+
+void CdpHttpClose(CdpHttpClient* client) {
+    if (client->sock != CDP_INVALID_SOCKET) {
+        CdpCloseSocket(client->sock);
+        client->sock = CDP_INVALID_SOCKET;
+    }
+}
+
+void CdpHttpSetTarget(CdpHttpClient* client, const char* host, int port) {
+    if (client->port == port && strcmp(client->host, host) == 0) return;
+
+    CdpHttpClose(client);
+    snprintf(client->host, sizeof(client->host), "%s", host);
+    client->port = port;
+}
+
+static int CdpHttpConnect(CdpHttpClient* client) {
+    int rc = CdpConnect(client->host, client->port, client->connectTimeoutMs, &client->sock);
+    if (rc == CDP_OK) client->connectCount++;
+    return rc;
+}
+
+// An idle keep-alive connection that became readable was closed by the peer
+// (or has stray data) - either way it can't be reused
+static int CdpHttpConnectionStale(CdpHttpClient* client) {
+    char probe;
+    if (CdpWait(client->sock, 0, CdpNowUs()) == 0) return 0;
+    int n = recv(client->sock, &probe, 1, MSG_PEEK);
+    return !(n < 0 && CdpWouldBlock());
+}
+
+// Case-insensitive lookup of a header value within the header block
+static const char* CdpFindHeader(const char* headers, const char* name) {
+    size_t nameLen = strlen(name);
+    const char* line = strstr(headers, "\r\n");
+    while (line) {
+        line += 2;
+        if (line[0] == '\r') break;  // End of headers
+        size_t i = 0;
+        while (i < nameLen && line[i] && tolower((unsigned char)line[i]) == tolower((unsigned char)name[i])) i++;
+        if (i == nameLen && line[i] == ':') {
+            const char* value = line + i + 1;
+            while (*value == ' ' || *value == '\t') value++;
+            return value;
+        }
+        line = strstr(line, "\r\n");
+    }
+    return NULL;
+}
+
+static int CdpHeaderHasToken(const char* value, const char* token) {
+    if (!value) return 0;
+    size_t tokenLen = strlen(token);
+    for (const char* p = value; *p && *p != '\r'; p++) {
+        size_t i = 0;
+        while (i < tokenLen && tolower((unsigned char)p[i]) == tolower((unsigned char)token[i])) i++;
+        if (i == tokenLen) return 1;
+    }
+    return 0;
+}
+
+// One request/response exchange on the current connection. *gotResponse is set
+// once any response byte has arrived (a retry is no longer safe after that).
+static int CdpHttpExchange(CdpHttpClient* client, const char* path, char* body, size_t bodyLen,
+                           int* httpStatus, int* gotResponse) {
+    unsigned long long deadline = CdpNowUs() + (unsigned long long)client->readTimeoutMs * 1000ULL;
+    *gotResponse = 0;
+
+    char request[512];
+    int reqLen = snprintf(request, sizeof(request),
+                          "GET %s HTTP/1.1\r\nHost: %s:%d\r\nConnection: keep-alive\r\n\r\n",
+                          path, client->host, client->port);
+    if (reqLen < 0 || reqLen >= (int)sizeof(request)) return CDP_ERR_PROTOCOL;
+
+    int rc = CdpSendAll(client->sock, request, (size_t)reqLen, deadline);
+    if (rc != CDP_OK) return rc;
+
+    // Headers may arrive split over several reads
+    char headers[CDP_HTTP_HEADER_MAX];
+    size_t headerLen = 0;
+    char* headerEnd = NULL;
+    while (!headerEnd) {
+        if (headerLen >= sizeof(headers) - 1) return CDP_ERR_PROTOCOL;
+        int n = CdpRecvSome(client->sock, headers + headerLen, sizeof(headers) - 1 - headerLen, deadline);
+        if (n < 0) return n;
+        if (n == 0) return CDP_ERR_IO;
+        *gotResponse = 1;
+        headerLen += (size_t)n;
+        headers[headerLen] = '\0';
+        headerEnd = strstr(headers, "\r\n\r\n");
+    }
+
+    int status = 0;
+    if (sscanf(headers, "HTTP/1.%*d %d", &status) != 1) return CDP_ERR_PROTOCOL;
+    *httpStatus = status;
+
+    // The DevTools server frames bodies with Content-Length; chunked encoding
+    // is not expected and not supported
+    if (CdpHeaderHasToken(CdpFindHeader(headers, "Transfer-Encoding"), "chunked")) return CDP_ERR_PROTOCOL;
+
+    const char* lengthHeader = CdpFindHeader(headers, "Content-Length");
+    long contentLength = lengthHeader ? strtol(lengthHeader, NULL, 10) : -1;
+    int keepAlive = !CdpHeaderHasToken(CdpFindHeader(headers, "Connection"), "close") &&
+                    contentLength >= 0;
+
+    // Body bytes that arrived together with the headers
+    size_t bodyUsed = headerLen - (size_t)(headerEnd + 4 - headers);
+    if (bodyUsed >= bodyLen) return CDP_ERR_OVERFLOW;
+    memcpy(body, headerEnd + 4, bodyUsed);
+
+    while (contentLength < 0 || bodyUsed < (size_t)contentLength) {
+        if (bodyUsed >= bodyLen - 1) return CDP_ERR_OVERFLOW;
+        int n = CdpRecvSome(client->sock, body + bodyUsed, bodyLen - 1 - bodyUsed, deadline);
+        if (n < 0) return n;
+        if (n == 0) {
+            if (contentLength < 0) break;  // Body delimited by connection close
+            return CDP_ERR_IO;
+        }
+        bodyUsed += (size_t)n;
+    }
+    if (contentLength >= 0 && bodyUsed > (size_t)contentLength) {
+        // More than announced - the stream is out of sync
+        keepAlive = 0;
+        bodyUsed = (size_t)contentLength;
+    }
+    body[bodyUsed] = '\0';
+
+    if (!keepAlive) CdpHttpClose(client);
+    return CDP_OK;
+}
+
+int CdpHttpGet(CdpHttpClient* client, const char* path, char* body, size_t bodyLen,
+               int* httpStatus) {
+    unsigned long long start = CdpNowUs();
+    *httpStatus = 0;
+    if (bodyLen == 0) return CDP_ERR_OVERFLOW;
+    body[0] = '\0';
+    client->requestCount++;
+
+    if (client->sock != CDP_INVALID_SOCKET && CdpHttpConnectionStale(client)) {
+        CdpHttpClose(client);
+    }
+
+    for (int attempt = 0; attempt < 2; attempt++) {
+        int reused = client->sock != CDP_INVALID_SOCKET;
+        if (!reused) {
+            int rc = CdpHttpConnect(client);
+            if (rc != CDP_OK) return rc;
+        }
+
+        int gotResponse = 0;
+        int rc = CdpHttpExchange(client, path, body, bodyLen, httpStatus, &gotResponse);
+        if (rc == CDP_OK) {
+            client->lastReused = reused;
+            client->lastLatencyUs = CdpNowUs() - start;
+            return CDP_OK;
+        }
+
+        CdpHttpClose(client);
+        // The server may have dropped an idle connection just as we sent
+        if (!reused || gotResponse || rc == CDP_ERR_TIMEOUT) return rc;
+    }
+    return CDP_ERR_IO;
+}
+
+// ============================================================================
+// JSON
+// ============================================================================
+
+int CdpJsonGetString(const char* json, const char* key, char* out, size_t outLen) {
+    char pattern[128];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char* pos = strstr(json, pattern);
+    if (!pos) return 0;
+    pos += strlen(pattern);
+    while (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n') pos++;
+    if (*pos != ':') return 0;
+    pos++;
+    while (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n') pos++;
+    if (*pos != '"') return 0;
+    pos++;
+
+    const char* end = pos;
+    while (*end && *end != '"') {
+        if (*end == '\\' && end[1]) end++;
+        end++;
+    }
+    if (*end != '"') return 0;
+
+    size_t len = (size_t)(end - pos);
+    if (len >= outLen) return 0;
+    memcpy(out, pos, len);
+    out[len] = '\0';
+    return 1;
+}
+
+int CdpJsonGetInt(const char* json, const char* key, long* out) {
+    char pattern[128];
+    snprintf(pattern, sizeof(pattern), "\"%s\"", key);
+    const char* pos = strstr(json, pattern);
+    if (!pos) return 0;
+    pos += strlen(pattern);
+    while (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n') pos++;
+    if (*pos != ':') return 0;
+    pos++;
+
+    char* end;
+    long value = strtol(pos, &end, 10);
+    if (end == pos) return 0;
+    *out = value;
+    return 1;
+}
+
+static const char* CdpJsonSkipSpace(const char* p) {
+    while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') p++;
+    return p;
+}
+
+// Returns the end of the JSON value at p, or NULL if it is malformed
+static const char* CdpJsonSkipValue(const char* p) {
+    if (*p == '"') {
+        for (p++; *p && *p != '"'; p++) {
+            if (*p == '\\' && p[1]) p++;
+        }
+        return *p == '"' ? p + 1 : NULL;
+    }
+    if (*p == '{' || *p == '[') {
+        int depth = 0;
+        while (*p) {
+            if (*p == '"') {
+                p = CdpJsonSkipValue(p);
+                if (!p) return NULL;
+                continue;
+            }
+            if (*p == '{' || *p == '[') {
+                depth++;
+            } else if ((*p == '}' || *p == ']') && --depth == 0) {
+                return p + 1;
+            }
+            p++;
+        }
+        return NULL;
+    }
+    const char* start = p;
+    while (*p && *p != ',' && *p != '}' && *p != ']' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') p++;
+    return p > start ? p : NULL;
+}
+
+// Iterates the members of the object at *cursor, one per call; unlike
+// CdpJsonGetString it never looks into nested values. Returns 0 at the end of
+// the object or on malformed input.
+static int CdpJsonNextMember(const char** cursor, const char** name, size_t* nameLen,
+                             const char** value, size_t* valueLen) {
+    const char* p = CdpJsonSkipSpace(*cursor);
+    if (*p != '{' && *p != ',') return 0;
+    p = CdpJsonSkipSpace(p + 1);
+    if (*p != '"') return 0;
+
+    const char* end = CdpJsonSkipValue(p);
+    if (!end) return 0;
+    *name = p + 1;
+    *nameLen = (size_t)(end - p) - 2;
+
+    p = CdpJsonSkipSpace(end);
+    if (*p != ':') return 0;
+    p = CdpJsonSkipSpace(p + 1);
+    end = CdpJsonSkipValue(p);
+    if (!end) return 0;
+
+    *value = p;
+    *valueLen = (size_t)(end - p);
+    *cursor = end;
+    return 1;
+}
+
+static size_t CdpJsonFindMember(const char* json, const char* key, const char** value) {
+    const char* cursor = json;
+    const char* name;
+    size_t nameLen, valueLen;
+    size_t keyLen = strlen(key);
+    while (CdpJsonNextMember(&cursor, &name, &nameLen, value, &valueLen)) {
+        if (nameLen == keyLen && memcmp(name, key, keyLen) == 0) return valueLen;
+    }
+    return 0;
+}
+
+// Copies a string value without its quotes (escapes are kept)
+static int CdpJsonSpanString(const char* value, size_t valueLen, char* out, size_t outLen) {
+    if (valueLen < 2 || value[0] != '"' || valueLen - 2 >= outLen) return 0;
+    memcpy(out, value + 1, valueLen - 2);
+    out[valueLen - 2] = '\0';
+    return 1;
+}
+
+static int CdpJsonMemberString(const char* json, const char* key, char* out, size_t outLen) {
+    const char* value;
+    size_t valueLen = CdpJsonFindMember(json, key, &value);
+    return valueLen > 0 && CdpJsonSpanString(value, valueLen, out, outLen);
+}
+
+// ============================================================================
+// WebSocket client
+// ============================================================================
+
+#define CDP_WS_OP_CONTINUATION 0x0
+#define CDP_WS_OP_TEXT 0x1
+#define CDP_WS_OP_BINARY 0x2
+#define CDP_WS_OP_CLOSE 0x8
+#define CDP_WS_OP_PING 0x9
+#define CDP_WS_OP_PONG 0xA
+
+#define CDP_WS_READ_CHUNK 16384
+
+void CdpWsInit(CdpWebSocket* ws) {
+    memset(ws, 0, sizeof(*ws));
+    ws->sock = CDP_INVALID_SOCKET;
+}
+
+void CdpWsClose(CdpWebSocket* ws) {
+    if (ws->sock != CDP_INVALID_SOCKET) {
+        CdpCloseSocket(ws->sock);
+        ws->sock = CDP_INVALID_SOCKET;
+    }
+    free(ws->rx);
+    free(ws->msg);
+    ws->rx = NULL;
+    ws->msg = NULL;
+    ws->rxLen = ws->rxCap = 0;
+    ws->msgLen = ws->msgCap = 0;
+}
+
+static int CdpGrow(void** buf, size_t* cap, size_t needed) {
+    if (needed <= *cap) return 1;
+    size_t newCap = *cap ? *cap : 4096;
+    while (newCap < needed) newCap *= 2;
+    void* p = realloc(*buf, newCap);
+    if (!p) return 0;
+    *buf = p;
+    *cap = newCap;
+    return 1;
+}
+
+static void CdpBase64(const unsigned char* in, size_t len, char* out) {
+    static const char table[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        unsigned v = (unsigned)in[i] << 16;
+        if (i + 1 < len) v |= (unsigned)in[i + 1] << 8;
+        if (i + 2 < len) v |= in[i + 2];
+        out[o++] = table[(v >> 18) & 63];
+        out[o++] = table[(v >> 12) & 63];
+        out[o++] = i + 1 < len ? table[(v >> 6) & 63] : '=';
+        out[o++] = i + 2 < len ? table[v & 63] : '=';
+    }
+    out[o] = '\0';
+}
+
+// Client frames must be masked; the key only needs to be unpredictable to
+// intermediaries, which don't exist on this local connection
+static void CdpWsMaskKey(unsigned char key[4]) {
+    unsigned long long seed = CdpNowUs();
+    for (int i = 0; i < 4; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        key[i] = (unsigned char)(seed >> 56);
+    }
+}
+
+static int CdpWsSendFrame(CdpWebSocket* ws, int opcode, const char* payload, size_t len, int timeoutMs) {
+    if (ws->sock == CDP_INVALID_SOCKET) return CDP_ERR_IO;
+
+    unsigned char header[14];
+    size_t headerLen = 0;
+    header[headerLen++] = (unsigned char)(0x80 | opcode);  // FIN
+    if (len < 126) {
+        header[headerLen++] = (unsigned char)(0x80 | len);
+    } else if (len <= 0xFFFF) {
+        header[headerLen++] = 0x80 | 126;
+        header[headerLen++] = (unsigned char)(len >> 8);
+        header[headerLen++] = (unsigned char)len;
+    } else {
+        header[headerLen++] = 0x80 | 127;
+        for (int i = 7; i >= 0; i--) header[headerLen++] = (unsigned char)((unsigned long long)len >> (i * 8));
+    }
+    unsigned char* key = header + headerLen;
+    CdpWsMaskKey(key);
+    headerLen += 4;
+
+    char* frame = (char*)malloc(headerLen + len);
+    if (!frame) return CDP_ERR_IO;
+    memcpy(frame, header, headerLen);
+    for (size_t i = 0; i < len; i++) frame[headerLen + i] = (char)(payload[i] ^ key[i & 3]);
+
+    unsigned long long deadline = CdpNowUs() + (unsigned long long)timeoutMs * 1000ULL;
+    int rc = CdpSendAll(ws->sock, frame, headerLen + len, deadline);
+    free(frame);
+    return rc;
+}
+
+int CdpWsSendText(CdpWebSocket* ws, const char* text, size_t len, int timeoutMs) {
+    return CdpWsSendFrame(ws, CDP_WS_OP_TEXT, text, len, timeoutMs);
+}
+
+// Builds the client handshake for path. Returns its length, or -1 if it
+// doesn't fit.
+static int CdpWsHandshake(CdpWebSocket* ws, const char* host, int port, const char* path,
+                          char* request, size_t requestLen) {
+    unsigned char nonce[16];
+    unsigned long long seed = CdpNowUs() ^ (unsigned long long)(size_t)ws;
+    for (int i = 0; i < 16; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        nonce[i] = (unsigned char)(seed >> 56);
+    }
+    char key[32];
+    CdpBase64(nonce, sizeof(nonce), key);
+
+    int len = snprintf(request, requestLen,
+                       "GET %s HTTP/1.1\r\n"
+                       "Host: %s:%d\r\n"
+                       "Upgrade: websocket\r\n"
+                       "Connection: Upgrade\r\n"
+                       "Sec-WebSocket-Key: %s\r\n"
+                       "Sec-WebSocket-Version: 13\r\n\r\n",
+                       path, host, port, key);
+    return len < 0 || len >= (int)requestLen ? -1 : len;
+}
+
+// Checks the handshake response, headerLen bytes of headers (terminated, and
+// complete through the blank line), and keeps frames that arrived behind it.
+// headers may be ws->rx itself.
+static int CdpWsAccepted(CdpWebSocket* ws, char* headers, size_t headerLen) {
+    // The server is trusted (it is the Chrome we launched), so the
+    // Sec-WebSocket-Accept digest is not verified
+    char* headerEnd = strstr(headers, "\r\n\r\n");
+    int status = 0;
+    if (!headerEnd || sscanf(headers, "HTTP/1.%*d %d", &status) != 1 || status != 101 ||
+        !CdpHeaderHasToken(CdpFindHeader(headers, "Upgrade"), "websocket")) {
+        return CDP_ERR_PROTOCOL;
+    }
+
+    // Frames may already have arrived behind the handshake response
+    size_t consumed = (size_t)(headerEnd + 4 - headers);
+    size_t extra = headerLen - consumed;
+    if (headers == (char*)ws->rx) {
+        memmove(ws->rx, ws->rx + consumed, extra);
+    } else if (extra > 0) {
+        if (!CdpGrow((void**)&ws->rx, &ws->rxCap, extra)) return CDP_ERR_IO;
+        memcpy(ws->rx, headerEnd + 4, extra);
+    }
+    ws->rxLen = extra;
+    return CDP_OK;
+}
+
+int CdpWsConnect(CdpWebSocket* ws, const char* host, int port, const char* path, int timeoutMs) {
+    CdpWsClose(ws);
+
+    int rc = CdpConnect(host, port, timeoutMs, &ws->sock);
+    if (rc != CDP_OK) return rc;
+
+    char request[768];
+    int reqLen = CdpWsHandshake(ws, host, port, path, request, sizeof(request));
+    if (reqLen < 0) {
+        CdpWsClose(ws);
+        return CDP_ERR_PROTOCOL;
+    }
+
+    unsigned long long deadline = CdpNowUs() + (unsigned long long)timeoutMs * 1000ULL;
+    rc = CdpSendAll(ws->sock, request, (size_t)reqLen, deadline);
+
+    char headers[CDP_HTTP_HEADER_MAX];
+    size_t headerLen = 0;
+    char* headerEnd = NULL;
+    while (rc == CDP_OK && !headerEnd) {
+        if (headerLen >= sizeof(headers) - 1) {
+            rc = CDP_ERR_PROTOCOL;
+            break;
+        }
+        int n = CdpRecvSome(ws->sock, headers + headerLen, sizeof(headers) - 1 - headerLen, deadline);
+        if (n <= 0) {
+            rc = n < 0 ? n : CDP_ERR_IO;
+            break;
+        }
+        headerLen += (size_t)n;
+        headers[headerLen] = '\0';
+        headerEnd = strstr(headers, "\r\n\r\n");
+    }
+    if (rc == CDP_OK) rc = CdpWsAccepted(ws, headers, headerLen);
+
+    if (rc != CDP_OK) CdpWsClose(ws);
+    return rc;
+}
+
+// Parses one complete frame from the receive buffer. Returns 1 and fills the
+// out-parameters if a whole frame is buffered, 0 if more bytes are needed.
+static int CdpWsParseFrame(CdpWebSocket* ws, int* fin, int* opcode, size_t* payloadOffset,
+                           unsigned long long* payloadLen) {
+    if (ws->rxLen < 2) return 0;
+    const unsigned char* b = ws->rx;
+    *fin = (b[0] & 0x80) != 0;
+    *opcode = b[0] & 0x0F;
+    int masked = (b[1] & 0x80) != 0;
+    unsigned long long len = b[1] & 0x7F;
+    size_t offset = 2;
+
+    if (len == 126) {
+        if (ws->rxLen < 4) return 0;
+        len = ((unsigned long long)b[2] << 8) | b[3];
+        offset = 4;
+    } else if (len == 127) {
+        if (ws->rxLen < 10) return 0;
+        len = 0;
+        for (int i = 0; i < 8; i++) len = (len << 8) | b[2 + i];
+        offset = 10;
+    }
+    if (masked) offset += 4;  // Servers don't mask, but tolerate it
+    if (len > CDP_WS_MESSAGE_MAX) return -1;
+    if (ws->rxLen < offset + len) return 0;
+
+    if (masked) {
+        unsigned char* key = ws->rx + offset - 4;
+        for (unsigned long long i = 0; i < len; i++) ws->rx[offset + i] ^= key[i & 3];
+    }
+
+    *payloadOffset = offset;
+    *payloadLen = len;
+    return 1;
+}
+
+int CdpWsReceive(CdpWebSocket* ws, int timeoutMs, const char** message) {
+    if (ws->sock == CDP_INVALID_SOCKET) return CDP_ERR_IO;
+    unsigned long long deadline = CdpNowUs() + (unsigned long long)timeoutMs * 1000ULL;
+
+    for (;;) {
+        int fin, opcode;
+        size_t offset;
+        unsigned long long len;
+        int parsed = CdpWsParseFrame(ws, &fin, &opcode, &offset, &len);
+        if (parsed < 0) return CDP_ERR_OVERFLOW;
+
+        if (parsed == 0) {
+            // Need more bytes
+            if (!CdpGrow((void**)&ws->rx, &ws->rxCap, ws->rxLen + CDP_WS_READ_CHUNK)) return CDP_ERR_IO;
+            int n = CdpRecvSome(ws->sock, (char*)ws->rx + ws->rxLen, ws->rxCap - ws->rxLen, deadline);
+            if (n < 0) return n;
+            if (n == 0) return CDP_ERR_IO;
+            ws->rxLen += (size_t)n;
+            continue;
+        }
+
+        const char* payload = (const char*)ws->rx + offset;
+        size_t frameLen = offset + (size_t)len;
+        int complete = 0;
+
+        switch (opcode) {
+            case CDP_WS_OP_TEXT:
+            case CDP_WS_OP_BINARY:
+            case CDP_WS_OP_CONTINUATION:
+                if (opcode != CDP_WS_OP_CONTINUATION) ws->msgLen = 0;
+                if (ws->msgLen + len + 1 > CDP_WS_MESSAGE_MAX ||
+                    !CdpGrow((void**)&ws->msg, &ws->msgCap, ws->msgLen + (size_t)len + 1)) {
+                    return CDP_ERR_OVERFLOW;
+                }
+                memcpy(ws->msg + ws->msgLen, payload, (size_t)len);
+                ws->msgLen += (size_t)len;
+                ws->msg[ws->msgLen] = '\0';
+                complete = fin;
+                break;
+            case CDP_WS_OP_PING: {
+                int rc = CdpWsSendFrame(ws, CDP_WS_OP_PONG, payload, (size_t)len, timeoutMs);
+                if (rc != CDP_OK) return rc;
+                break;
+            }
+            case CDP_WS_OP_CLOSE:
+                CdpWsSendFrame(ws, CDP_WS_OP_CLOSE, payload, len >= 2 ? 2 : 0, timeoutMs);
+                return CDP_ERR_IO;
+            default:
+                break;  // Pong or reserved - ignore
+        }
+
+        // Consume the frame
+        memmove(ws->rx, ws->rx + frameLen, ws->rxLen - frameLen);
+        ws->rxLen -= frameLen;
+
+        if (complete) {
+            *message = ws->msg;
+            return (int)ws->msgLen;
+        }
+    }
+}
+
+// ============================================================================
+// Browser endpoint
+// ============================================================================
+
+// Takes the path of the browser WebSocket endpoint from a /json/version body
+// (ws://host:port/devtools/browser/<id>). Callers connect to their own
+// host:port, the advertised host may not be reachable from here.
+static int CdpParseBrowserVersion(const char* body, char* path, size_t pathLen, char* browser, size_t browserLen) {
+    char wsUrl[256];
+    if (!CdpJsonGetString(body, "webSocketDebuggerUrl", wsUrl, sizeof(wsUrl))) return CDP_ERR_PROTOCOL;
+    if (browser && !CdpJsonGetString(body, "Browser", browser, browserLen)) {
+        browser[0] = '\0';
+    }
+
+    const char* start = strstr(wsUrl, "://");
+    start = start ? strchr(start + 3, '/') : NULL;
+    if (!start || strlen(start) >= pathLen) return CDP_ERR_PROTOCOL;
+    memcpy(path, start, strlen(start) + 1);
+    return CDP_OK;
+}
+
+// Reads /json/version and returns the path of the browser WebSocket endpoint
+static int CdpResolveBrowserPath(CdpHttpClient* http, const char* host, int port,
+                                 char* path, size_t pathLen, char* browser, size_t browserLen) {
+    char body[4096];
+    int httpStatus = 0;
+
+    CdpHttpSetTarget(http, host, port);
+    int rc = CdpHttpGet(http, "/json/version", body, sizeof(body), &httpStatus);
+    CdpHttpClose(http);
+    if (rc != CDP_OK) return rc;
+    if (httpStatus != 200) return CDP_ERR_PROTOCOL;
+    return CdpParseBrowserVersion(body, path, pathLen, browser, browserLen);
+}
+
+// ============================================================================
+// Command session
+// ============================================================================
+
+static int CdpIsResponse(const char* message) {
+    // Chrome serializes responses as {"id":N,...} and events as {"method":...}
+    while (*message == ' ' || *message == '\n' || *message == '\r' || *message == '\t') message++;
+    return strncmp(message, "{\"id\"", 5) == 0;
+}
+
+void CdpSessionInit(CdpSession* session, int timeoutMs) {
+    memset(session, 0, sizeof(*session));
+    CdpWsInit(&session->ws);
+    session->timeoutMs = timeoutMs;
+}
+
+int CdpSessionOpen(CdpSession* session, const char* host, int port) {
+    CdpHttpClient http;
+    char path[256];
+    CdpHttpInit(&http, session->timeoutMs, session->timeoutMs);
+    int rc = CdpResolveBrowserPath(&http, host, port, path, sizeof(path), NULL, 0);
+    if (rc != CDP_OK) return rc;
+
+    session->nextId = 0;
+    return CdpWsConnect(&session->ws, host, port, path, session->timeoutMs);
+}
+
+int CdpSessionCall(CdpSession* session, const char* sessionId, const char* method,
+                   const char* params, const char** response) {
+    size_t size = strlen(method) + (params ? strlen(params) : 0) +
+                  (sessionId ? strlen(sessionId) : 0) + 96;
+    char* request = (char*)malloc(size);
+    if (!request) return CDP_ERR_IO;
+
+    long id = ++session->nextId;
+    int len = snprintf(request, size, "{\"id\":%ld,\"method\":\"%s\"%s%s%s%s%s}",
+                       id, method, params ? ",\"params\":" : "", params ? params : "",
+                       sessionId ? ",\"sessionId\":\"" : "", sessionId ? sessionId : "",
+                       sessionId ? "\"" : "");
+    int rc = (len > 0 && (size_t)len < size)
+        ? CdpWsSendText(&session->ws, request, (size_t)len, session->timeoutMs)
+        : CDP_ERR_OVERFLOW;
+    free(request);
+    if (rc != CDP_OK) return rc;
+
+    unsigned long long deadline = CdpNowUs() + (unsigned long long)session->timeoutMs * 1000ULL;
+    for (;;) {
+        unsigned long long now = CdpNowUs();
+        if (now >= deadline) return CDP_ERR_TIMEOUT;
+
+        const char* message = NULL;
+        rc = CdpWsReceive(&session->ws, (int)((deadline - now + 999) / 1000), &message);
+        if (rc < 0) return rc;
+
+        long messageId = 0;
+        if (!CdpIsResponse(message) || !CdpJsonGetInt(message, "id", &messageId) || messageId != id) {
+            continue;  // An event, or the answer to an abandoned call
+        }
+        if (response) *response = message;
+
+        // {"id":N,"error":{...}} - the error member directly follows the id
+        const char* next = strchr(message, ',');
+        if (!next) return CDP_OK;
+        next++;
+        while (*next == ' ' || *next == '\n' || *next == '\r' || *next == '\t') next++;
+        return strncmp(next, "\"error\"", 7) == 0 ? CDP_ERR_PROTOCOL : CDP_OK;
+    }
+}
+
+int CdpSessionWaitEvent(CdpSession* session, const char* sessionId, const char* method,
+                        const char** event) {
+    unsigned long long deadline = CdpNowUs() + (unsigned long long)session->timeoutMs * 1000ULL;
+    for (;;) {
+        unsigned long long now = CdpNowUs();
+        if (now >= deadline) return CDP_ERR_TIMEOUT;
+
+        const char* message = NULL;
+        int rc = CdpWsReceive(&session->ws, (int)((deadline - now + 999) / 1000), &message);
+        if (rc < 0) return rc;
+        if (CdpIsResponse(message)) continue;
+
+        char name[128];
+        char messageSession[CDP_SESSION_ID_MAX];
+        if (!CdpJsonGetString(message, "method", name, sizeof(name)) || strcmp(name, method) != 0) continue;
+        if (sessionId && (!CdpJsonGetString(message, "sessionId", messageSession, sizeof(messageSession)) ||
+                          strcmp(messageSession, sessionId) != 0)) {
+            continue;
+        }
+        if (event) *event = message;
+        return CDP_OK;
+    }
+}
+
+typedef struct {
+    char frame[64];
+    char parent[64];  // Empty for a main frame
+    long processId;
+} CdpTraceFrame;
+
+// Collects the frames of every "frames" array in a trace message - the
+// TracingStartedInBrowser event lists each frame with its renderer process
+static void CdpTraceCollectFrames(const char* message, CdpTraceFrame* frames, int* count) {
+    for (const char* pos = strstr(message, "\"frames\""); pos; pos = strstr(pos + 1, "\"frames\"")) {
+        const char* p = CdpJsonSkipSpace(pos + 8);
+        if (*p != ':') continue;
+        p = CdpJsonSkipSpace(p + 1);
+        if (*p != '[') continue;
+
+        for (p = CdpJsonSkipSpace(p + 1); *p == '{' && *count < CDP_TRACE_FRAMES;) {
+            const char* end = CdpJsonSkipValue(p);
+            if (!end) break;
+            CdpTraceFrame* frame = &frames[*count];
+            memset(frame, 0, sizeof(*frame));
+            const char* value;
+            size_t valueLen = CdpJsonFindMember(p, "processId", &value);
+            if (CdpJsonMemberString(p, "frame", frame->frame, sizeof(frame->frame)) && valueLen > 0) {
+                frame->processId = strtol(value, NULL, 10);
+                CdpJsonMemberString(p, "parent", frame->parent, sizeof(frame->parent));
+                (*count)++;
+            }
+            p = CdpJsonSkipSpace(end);
+            if (*p != ',') break;
+            p = CdpJsonSkipSpace(p + 1);
+        }
+    }
+}
+
+// The main frame a renderer process hosts, or else the main frame above a
+// subframe it hosts (an out-of-process iframe)
+static const CdpTraceFrame* CdpTraceFindPage(const CdpTraceFrame* frames, int count, long pid) {
+    for (int i = 0; i < count; i++) {
+        if (frames[i].processId == pid && !frames[i].parent[0]) return &frames[i];
+    }
+    for (int i = 0; i < count; i++) {
+        if (frames[i].processId != pid) continue;
+        const CdpTraceFrame* frame = &frames[i];
+        for (int depth = 0; frame && frame->parent[0] && depth < count; depth++) {
+            const CdpTraceFrame* parent = NULL;
+            for (int k = 0; k < count && !parent; k++) {
+                if (strcmp(frames[k].frame, frame->parent) == 0) parent = &frames[k];
+            }
+            frame = parent;
+        }
+        if (frame && !frame->parent[0]) return frame;
+    }
+    return NULL;
+}
+
+int CdpSessionFindRenderer(CdpSession* session, long pid, char* targetId, size_t targetIdLen) {
+    int rc = CdpSessionCall(session, NULL, "Tracing.start",
+                            "{\"categories\":\"disabled-by-default-devtools.timeline\","
+                            "\"transferMode\":\"ReportEvents\"}", NULL);
+    if (rc != CDP_OK) return rc;
+
+    // The collected data arrives before the answer to Tracing.end, so the
+    // answer is not waited for
+    char request[64];
+    int len = snprintf(request, sizeof(request), "{\"id\":%ld,\"method\":\"Tracing.end\"}", ++session->nextId);
+    rc = CdpWsSendText(&session->ws, request, (size_t)len, session->timeoutMs);
+    if (rc != CDP_OK) return rc;
+
+    CdpTraceFrame* frames = (CdpTraceFrame*)malloc(CDP_TRACE_FRAMES * sizeof(CdpTraceFrame));
+    if (!frames) return CDP_ERR_IO;
+    int count = 0;
+    unsigned long long deadline = CdpNowUs() + (unsigned long long)session->timeoutMs * 1000ULL;
+    for (;;) {
+        unsigned long long now = CdpNowUs();
+        if (now >= deadline) {
+            rc = CDP_ERR_TIMEOUT;
+            break;
+        }
+
+        const char* message = NULL;
+        rc = CdpWsReceive(&session->ws, (int)((deadline - now + 999) / 1000), &message);
+        if (rc < 0) break;
+        if (CdpIsResponse(message)) continue;
+
+        char method[64];
+        if (!CdpJsonGetString(message, "method", method, sizeof(method))) continue;
+        if (strcmp(method, "Tracing.dataCollected") == 0) {
+            CdpTraceCollectFrames(message, frames, &count);
+        } else if (strcmp(method, "Tracing.tracingComplete") == 0) {
+            const CdpTraceFrame* page = CdpTraceFindPage(frames, count, pid);
+            rc = CDP_ERR_PROTOCOL;
+            if (page && strlen(page->frame) < targetIdLen) {
+                strcpy(targetId, page->frame);
+                rc = CDP_OK;
+            }
+            break;
+        }
+    }
+    free(frames);
+    return rc;
+}
+
+void CdpSessionClose(CdpSession* session) {
+    CdpWsClose(&session->ws);
+}
+
+// ============================================================================
+// Liveness monitor
+// ============================================================================
+
+#define CDP_MONITOR_SLICE_MS 200  // Longest wait before stop/reconnect are rechecked
+
+void CdpMonitorInit(CdpMonitor* monitor, const char* host, int port) {
+    memset(monitor, 0, sizeof(*monitor));
+    snprintf(monitor->host, sizeof(monitor->host), "%s", host);
+    monitor->port = port;
+    monitor->connectTimeoutMs = 1000;
+    monitor->pingIntervalMs = 2000;
+    monitor->pingDeadlineMs = 1000;
+    monitor->reconnectDelayMs = 500;
+    monitor->state = CDP_LINK_DOWN;
+    CdpHttpInit(&monitor->http, monitor->connectTimeoutMs, 2000);
+    CdpWsInit(&monitor->ws);
+}
+
+static void CdpMonitorNotify(CdpMonitor* monitor) {
+    if (monitor->onChange) monitor->onChange(monitor, monitor->context);
+}
+
+static void CdpMonitorSetState(CdpMonitor* monitor, int state) {
+    if (monitor->state == state) return;
+    monitor->state = state;
+    CdpMonitorNotify(monitor);
+}
+
+static int CdpMonitorFindTarget(CdpMonitor* monitor, const char* targetId) {
+    for (int i = 0; i < monitor->targetCount; i++) {
+        if (strcmp(monitor->targets[i].targetId, targetId) == 0) return i;
+    }
+    return -1;
+}
+
+// Target.* events carry a targetInfo object (or just a targetId)
+static void CdpMonitorHandleEvent(CdpMonitor* monitor, const char* message) {
+    char method[64];
+    char targetId[64];
+    if (!CdpJsonGetString(message, "method", method, sizeof(method))) return;
+    if (!CdpJsonGetString(message, "targetId", targetId, sizeof(targetId))) return;
+
+    int index = CdpMonitorFindTarget(monitor, targetId);
+
+    if (strcmp(method, "Target.targetCreated") == 0 || strcmp(method, "Target.targetInfoChanged") == 0) {
+        int added = 0;
+        if (index < 0) {
+            if (monitor->targetCount >= CDP_MAX_TARGETS) return;
+            index = monitor->targetCount++;
+            snprintf(monitor->targets[index].targetId, sizeof(monitor->targets[index].targetId), "%s", targetId);
+            added = 1;
+        }
+        CdpTargetInfo* target = &monitor->targets[index];
+        CdpJsonGetString(message, "type", target->type, sizeof(target->type));
+        if (!CdpJsonGetString(message, "url", target->url, sizeof(target->url))) target->url[0] = '\0';
+        if (added) CdpMonitorNotify(monitor);
+    } else if (strcmp(method, "Target.targetDestroyed") == 0 && index >= 0) {
+        monitor->targets[index] = monitor->targets[--monitor->targetCount];
+        CdpMonitorNotify(monitor);
+    }
+}
+
+static void CdpMonitorHandleMessage(CdpMonitor* monitor, const char* message) {
+    if (!CdpIsResponse(message)) {
+        CdpMonitorHandleEvent(monitor, message);
+        return;
+    }
+
+    long id = 0;
+    if (!CdpJsonGetInt(message, "id", &id)) return;
+    if (monitor->pingId != 0 && id == monitor->pingId) {
+        monitor->lastPingRttUs = CdpNowUs() - monitor->pingSentUs;
+        monitor->pingId = 0;
+        CdpMonitorSetState(monitor, CDP_LINK_UP);
+    }
+}
+
+static int CdpMonitorSend(CdpMonitor* monitor, const char* method, const char* params) {
+    char request[256];
+    long id = ++monitor->nextId;
+    int len = snprintf(request, sizeof(request), "{\"id\":%ld,\"method\":\"%s\"%s%s}",
+                       id, method, params ? ",\"params\":" : "", params ? params : "");
+    if (len < 0 || len >= (int)sizeof(request)) return 0;
+    if (CdpWsSendText(&monitor->ws, request, (size_t)len, monitor->pingDeadlineMs) != CDP_OK) return 0;
+    return (int)id;
+}
+
+// Resolves the browser endpoint and runs one session. Returns 1 if a session
+// was established (before it ended), 0 if the connection attempt failed.
+static int CdpMonitorSession(CdpMonitor* monitor) {
+    char path[256];
+    if (CdpResolveBrowserPath(&monitor->http, monitor->host, monitor->port, path, sizeof(path),
+                              monitor->browser, sizeof(monitor->browser)) != CDP_OK) {
+        return 0;
+    }
+
+    if (CdpWsConnect(&monitor->ws, monitor->host, monitor->port, path, monitor->connectTimeoutMs) != CDP_OK) {
+        return 0;
+    }
+
+    monitor->nextId = 0;
+    monitor->pingId = 0;
+    monitor->targetCount = 0;
+    if (!CdpMonitorSend(monitor, "Target.setDiscoverTargets", "{\"discover\":true}")) {
+        CdpWsClose(&monitor->ws);
+        return 0;
+    }
+    CdpMonitorSetState(monitor, CDP_LINK_UP);
+
+    unsigned long long nextPingUs = CdpNowUs() + (unsigned long long)monitor->pingIntervalMs * 1000ULL;
+    while (!monitor->stop && !monitor->reconnect) {
+        unsigned long long now = CdpNowUs();
+
+        if (monitor->pingId == 0 && now >= nextPingUs) {
+            // Browser.getVersion is answered by the browser process itself
+            monitor->pingId = CdpMonitorSend(monitor, "Browser.getVersion", NULL);
+            if (!monitor->pingId) break;
+            monitor->pingSentUs = now;
+            nextPingUs = now + (unsigned long long)monitor->pingIntervalMs * 1000ULL;
+        }
+
+        if (monitor->pingId != 0) {
+            unsigned long long waited = now - monitor->pingSentUs;
+            unsigned long long deadline = (unsigned long long)monitor->pingDeadlineMs * 1000ULL;
+            if (waited > deadline * CDP_STALL_LIMIT) break;  // Give up on this session
+            if (waited > deadline && monitor->state == CDP_LINK_UP) {
+                monitor->missedPings++;
+                CdpMonitorSetState(monitor, CDP_LINK_STALLED);
+            }
+        }
+
+        // Sleep until the next ping or deadline, rechecking stop regularly
+        unsigned long long wakeUs = monitor->pingId != 0
+            ? monitor->pingSentUs + (unsigned long long)monitor->pingDeadlineMs * 1000ULL
+            : nextPingUs;
+        if (monitor->pingId != 0 && monitor->state == CDP_LINK_STALLED) {
+            wakeUs = monitor->pingSentUs + (unsigned long long)monitor->pingDeadlineMs * 1000ULL * CDP_STALL_LIMIT;
+        }
+        int waitMs = wakeUs > now ? (int)((wakeUs - now + 999) / 1000) : 0;
+        if (waitMs > CDP_MONITOR_SLICE_MS) waitMs = CDP_MONITOR_SLICE_MS;
+
+        const char* message = NULL;
+        int rc = CdpWsReceive(&monitor->ws, waitMs, &message);
+        if (rc >= 0) {
+            CdpMonitorHandleMessage(monitor, message);
+        } else if (rc != CDP_ERR_TIMEOUT) {
+            break;  // Socket dropped - the browser is gone or restarting
+        }
+    }
+
+    CdpWsClose(&monitor->ws);
+    return 1;
+}
+
+// Swaps the pending endpoint of the monitor, returns the previous one
+static CdpEndpoint* CdpMonitorExchangeTarget(CdpMonitor* monitor, CdpEndpoint* endpoint) {
+    return (CdpEndpoint*)CdpExchangePointer((void* volatile*)&monitor->retarget, endpoint);
+}
+
+int CdpMonitorRetarget(CdpMonitor* monitor, const char* host, int port) {
+    CdpEndpoint* endpoint = (CdpEndpoint*)malloc(sizeof(CdpEndpoint));
+    if (!endpoint) return 0;
+    snprintf(endpoint->host, sizeof(endpoint->host), "%s", host);
+    endpoint->port = port;
+    free(CdpMonitorExchangeTarget(monitor, endpoint));
+    monitor->reconnect = 1;
+    return 1;
+}
+
+static void CdpMonitorSleep(CdpMonitor* monitor, int ms) {
+    while (ms > 0 && !monitor->stop && !monitor->reconnect) {
+        int slice = ms < CDP_MONITOR_SLICE_MS ? ms : CDP_MONITOR_SLICE_MS;
+#ifdef _WIN32
+        Sleep((DWORD)slice);
+#else
+        struct timespec ts = { slice / 1000, (long)(slice % 1000) * 1000000L };
+        nanosleep(&ts, NULL);
+#endif
+        ms -= slice;
+    }
+}
+
+void CdpMonitorRun(CdpMonitor* monitor) {
+    int delayMs = monitor->reconnectDelayMs;
+
+    while (!monitor->stop) {
+        monitor->reconnect = 0;
+        CdpEndpoint* endpoint = CdpMonitorExchangeTarget(monitor, NULL);
+        if (endpoint) {
+            memcpy(monitor->host, endpoint->host, sizeof(monitor->host));
+            monitor->port = endpoint->port;
+            free(endpoint);
+        }
+        if (CdpMonitorSession(monitor)) {
+            // Lost an established session - report it right away and retry soon
+            monitor->disconnects++;
+            delayMs = monitor->reconnectDelayMs;
+        } else if (delayMs < monitor->reconnectDelayMs * 8) {
+            delayMs *= 2;
+        }
+
+        monitor->targetCount = 0;
+        monitor->pingId = 0;
+        CdpMonitorSetState(monitor, CDP_LINK_DOWN);
+
+        if (!monitor->stop && !monitor->reconnect) CdpMonitorSleep(monitor, delayMs);
+    }
+
+    free(CdpMonitorExchangeTarget(monitor, NULL));
+    CdpWsClose(&monitor->ws);
+    CdpHttpClose(&monitor->http);
+}
+
+// ============================================================================
+// Broker
+// ============================================================================
+
+#define CDP_BROKER_SLICE_MS 200            // Longest select wait before stop/settings are rechecked
+#define CDP_BROKER_CONNECT_TIMEOUT_MS 1000 // Per step of connecting to a browser
+#define CDP_BROKER_VERSION_MAX 4096        // Longest /json/version body
+#define CDP_BROKER_RETRY_MS 500            // First upstream retry delay; doubles up to 8x
+#define CDP_BROKER_BACKLOG_MAX (64 * 1024 * 1024)  // Unsent bytes before a slow agent is dropped
+#define CDP_BROKER_SEND_CHUNK (1024 * 1024)
+#define CDP_BROKER_POOL_WAIT_MS 10000      // Longest an allocation waits for a context being created
+#define CDP_BROKER_TAB_WAIT_MS 30000       // ... or for a tab to load
+#define CDP_BROKER_TAB_LOAD_MS 30000       // A tab still loading by then is taken as it is
+#define CDP_BROKER_TAB_LOADING 2           // Tabs loading at once per upstream
+#define CDP_BROKER_SETTLE_MS 1000          // Wait for answers to the cleanup calls when stopping
+
+#define CDP_BROKER_AGENT_FREE 0
+#define CDP_BROKER_AGENT_HTTP 1     // Reading the request head
+#define CDP_BROKER_AGENT_OPEN 2     // WebSocket established
+#define CDP_BROKER_AGENT_CLOSING 3  // Closed as soon as the queued bytes are out
+#define CDP_BROKER_AGENT_WAITING 4  // Allocation request parked until its context is created
+#define CDP_BROKER_AGENT_WAITING_TAB 5  // ... until its tab has loaded
+
+#define CDP_BROKER_DIAL_NONE 0
+#define CDP_BROKER_DIAL_VERSION 1  // GET /json/version
+#define CDP_BROKER_DIAL_UPGRADE 2  // WebSocket handshake on the browser endpoint it names
+
+#define CDP_BROKER_CALL_PLAIN 0
+#define CDP_BROKER_CALL_ATTACH 1          // Target.attachToTarget
+#define CDP_BROKER_CALL_CREATE_CONTEXT 2  // Target.createBrowserContext
+#define CDP_BROKER_CALL_CLOSE_TAB 3       // Target.closeTarget of a leased tab
+#define CDP_BROKER_CALL_DISPOSE_CONTEXT 4 // Target.disposeBrowserContext
+#define CDP_BROKER_CALL_POOL_CONTEXT 5    // The pool's own calls, answered to the pool
+#define CDP_BROKER_CALL_POOL_TARGET 6
+#define CDP_BROKER_CALL_POOL_DISPOSE 7
+#define CDP_BROKER_CALL_TAB_CREATE 8      // The tab pool's own calls
+#define CDP_BROKER_CALL_TAB_CLOSE 9
+
+#define CDP_POOL_FREE 0
+#define CDP_POOL_CREATING 1   // Context or its page still being created
+#define CDP_POOL_READY 2
+#define CDP_POOL_LEASED 3
+#define CDP_POOL_DISPOSING 4
+
+#define CDP_TAB_FREE 0
+#define CDP_TAB_CREATING 1  // Target.createTarget in flight
+#define CDP_TAB_CREATED 2     // On about:blank, waiting for its turn to load
+#define CDP_TAB_CONNECTING 3  // Page connection being set up
+#define CDP_TAB_LOADING 4     // Navigated, waiting for the load event
+#define CDP_TAB_READY 5
+#define CDP_TAB_LEASED 6
+#define CDP_TAB_CLOSING 7
+
+// A peer that disappears must not raise SIGPIPE
+#ifdef MSG_NOSIGNAL
+#define CDP_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define CDP_SEND_FLAGS 0
+#endif
+
+// Top-level fields of a message, as spans into it
+typedef struct {
+    const char* id;
+    size_t idLen;
+    long idValue;
+    char method[128];
+    char sessionId[CDP_SESSION_ID_MAX];
+    const char* params;
+    size_t paramsLen;
+    const char* result;
+    size_t resultLen;
+} CdpBrokerMessage;
+
+static void CdpBrokerParseMessage(const char* message, CdpBrokerMessage* fields) {
+    memset(fields, 0, sizeof(*fields));
+
+    const char* cursor = message;
+    const char* name;
+    const char* value;
+    size_t nameLen, valueLen;
+    while (CdpJsonNextMember(&cursor, &name, &nameLen, &value, &valueLen)) {
+        if (nameLen == 2 && memcmp(name, "id", 2) == 0) {
+            // Chrome only accepts integer ids
+            char* end;
+            long id = strtol(value, &end, 10);
+            if (end == value + valueLen) {
+                fields->id = value;
+                fields->idLen = valueLen;
+                fields->idValue = id;
+            }
+        } else if (nameLen == 6 && memcmp(name, "method", 6) == 0) {
+            CdpJsonSpanString(value, valueLen, fields->method, sizeof(fields->method));
+        } else if (nameLen == 9 && memcmp(name, "sessionId", 9) == 0) {
+            CdpJsonSpanString(value, valueLen, fields->sessionId, sizeof(fields->sessionId));
+        } else if (nameLen == 6 && memcmp(name, "params", 6) == 0) {
+            fields->params = value;
+            fields->paramsLen = valueLen;
+        } else if (nameLen == 6 && memcmp(name, "result", 6) == 0) {
+            fields->result = value;
+            fields->resultLen = valueLen;
+        }
+    }
+}
+
+// SHA-1, for the Sec-WebSocket-Accept digest of the server handshake
+static void CdpSha1(const unsigned char* data, size_t len, unsigned char digest[20]) {
+    unsigned int h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+    unsigned long long bits = (unsigned long long)len * 8;
+    size_t total = ((len + 8) / 64 + 1) * 64;  // Message, 0x80, zeros, 64-bit length
+
+    for (size_t block = 0; block < total; block += 64) {
+        unsigned int w[80];
+        for (int i = 0; i < 16; i++) {
+            unsigned int word = 0;
+            for (int j = 0; j < 4; j++) {
+                size_t pos = block + (size_t)(i * 4 + j);
+                unsigned char byte = 0;
+                if (pos < len) {
+                    byte = data[pos];
+                } else if (pos == len) {
+                    byte = 0x80;
+                } else if (pos >= total - 8) {
+                    byte = (unsigned char)(bits >> ((total - 1 - pos) * 8));
+                }
+                word = (word << 8) | byte;
+            }
+            w[i] = word;
+        }
+        for (int i = 16; i < 80; i++) {
+            unsigned int t = w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16];
+            w[i] = (t << 1) | (t >> 31);
+        }
+
+        unsigned int a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            unsigned int f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            unsigned int t = ((a << 5) | (a >> 27)) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = (b << 30) | (b >> 2);
+            b = a;
+            a = t;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    for (int i = 0; i < 20; i++) digest[i] = (unsigned char)(h[i / 4] >> (24 - (i % 4) * 8));
+}
+
+// ----------------------------------------------------------------------------
+// Queued output, frames read without blocking
+// ----------------------------------------------------------------------------
+
+// Appends head + mid + tail to the output, framed as a WebSocket message of
+// opcode - masked for the browser, servers don't mask - or raw for opcode < 0.
+// Returns 0 if the peer can't keep up.
+static int CdpBrokerQueue(CdpBrokerOutput* out, int opcode, int masked, const char* head, size_t headLen,
+                          const char* mid, size_t midLen, const char* tail, size_t tailLen) {
+    size_t len = headLen + midLen + tailLen;
+    if (out->len - out->head + len > CDP_BROKER_BACKLOG_MAX) return 0;
+
+    if (out->head == out->len) {
+        out->head = out->len = 0;
+    } else if (out->head > out->cap / 2) {
+        memmove(out->data, out->data + out->head, out->len - out->head);
+        out->len -= out->head;
+        out->head = 0;
+    }
+    if (!CdpGrow((void**)&out->data, &out->cap, out->len + len + 14)) return 0;
+
+    unsigned char* p = (unsigned char*)out->data + out->len;
+    unsigned char* key = NULL;
+    if (opcode >= 0) {
+        unsigned char mask = masked ? 0x80 : 0;
+        *p++ = (unsigned char)(0x80 | opcode);  // FIN
+        if (len < 126) {
+            *p++ = (unsigned char)(mask | len);
+        } else if (len <= 0xFFFF) {
+            *p++ = mask | 126;
+            *p++ = (unsigned char)(len >> 8);
+            *p++ = (unsigned char)len;
+        } else {
+            *p++ = mask | 127;
+            for (int i = 7; i >= 0; i--) *p++ = (unsigned char)((unsigned long long)len >> (i * 8));
+        }
+        if (masked) {
+            key = p;
+            CdpWsMaskKey(key);
+            p += 4;
+        }
+    }
+    if (headLen) memcpy(p, head, headLen);
+    if (midLen) memcpy(p + headLen, mid, midLen);
+    if (tailLen) memcpy(p + headLen + midLen, tail, tailLen);
+    for (size_t i = 0; key && i < len; i++) p[i] ^= key[i & 3];
+    out->len = (size_t)((char*)p - out->data) + len;
+    return 1;
+}
+
+// Sends what the socket takes without blocking. Returns 0 if the send failed.
+static int CdpBrokerFlushOutput(CdpSocket s, CdpBrokerOutput* out) {
+    while (out->head < out->len) {
+        size_t len = out->len - out->head;
+        if (len > CDP_BROKER_SEND_CHUNK) len = CDP_BROKER_SEND_CHUNK;
+        int n = send(s, out->data + out->head, (int)len, CDP_SEND_FLAGS);
+        if (n > 0) {
+            out->head += (size_t)n;
+            continue;
+        }
+        return n < 0 && CdpWouldBlock();
+    }
+    out->head = out->len = 0;
+    return 1;
+}
+
+static void CdpBrokerFreeOutput(CdpBrokerOutput* out) {
+    free(out->data);
+    memset(out, 0, sizeof(*out));
+}
+
+// Reads frames without blocking. Returns 1 and points *message at a complete
+// text message, 0 if more bytes are needed, 2 if the peer sent a close, -1 if
+// it is gone. Pings and the close are answered through out.
+static int CdpBrokerReadFrames(CdpWebSocket* ws, CdpBrokerOutput* out, int masked, const char** message) {
+    for (;;) {
+        int fin, opcode;
+        size_t offset;
+        unsigned long long len;
+        int parsed = CdpWsParseFrame(ws, &fin, &opcode, &offset, &len);
+        if (parsed < 0) return -1;
+
+        if (parsed == 0) {
+            if (!CdpGrow((void**)&ws->rx, &ws->rxCap, ws->rxLen + CDP_WS_READ_CHUNK)) return -1;
+            int n = recv(ws->sock, (char*)ws->rx + ws->rxLen, (int)(ws->rxCap - ws->rxLen), 0);
+            if (n > 0) {
+                ws->rxLen += (size_t)n;
+                continue;
+            }
+            return n < 0 && CdpWouldBlock() ? 0 : -1;
+        }
+
+        const char* payload = (const char*)ws->rx + offset;
+        size_t frameLen = offset + (size_t)len;
+        int complete = 0;
+
+        switch (opcode) {
+            case CDP_WS_OP_TEXT:
+            case CDP_WS_OP_BINARY:
+            case CDP_WS_OP_CONTINUATION:
+                if (opcode != CDP_WS_OP_CONTINUATION) ws->msgLen = 0;
+                if (ws->msgLen + len + 1 > CDP_WS_MESSAGE_MAX ||
+                    !CdpGrow((void**)&ws->msg, &ws->msgCap, ws->msgLen + (size_t)len + 1)) {
+                    return -1;
+                }
+                memcpy(ws->msg + ws->msgLen, payload, (size_t)len);
+                ws->msgLen += (size_t)len;
+                ws->msg[ws->msgLen] = '\0';
+                complete = fin;
+                break;
+            case CDP_WS_OP_PING:
+                if (!CdpBrokerQueue(out, CDP_WS_OP_PONG, masked, payload, (size_t)len, NULL, 0, NULL, 0)) return -1;
+                break;
+            case CDP_WS_OP_CLOSE:
+                CdpBrokerQueue(out, CDP_WS_OP_CLOSE, masked, payload, len >= 2 ? 2 : 0, NULL, 0, NULL, 0);
+                return 2;
+            default:
+                break;  // Pong or reserved - ignore
+        }
+
+        memmove(ws->rx, ws->rx + frameLen, ws->rxLen - frameLen);
+        ws->rxLen -= frameLen;
+
+        if (complete) {
+            *message = ws->msg;
+            return 1;
+        }
+    }
+}
+
+// Reads what has arrived of the response to a request of ours into ws->rx,
+// kept terminated. Returns 1 once the head - and with body set, the body -
+// is in, 0 if more is needed, -1 if the connection failed.
+static int CdpBrokerDialRead(CdpWebSocket* ws, int body) {
+    for (;;) {
+        if (!CdpGrow((void**)&ws->rx, &ws->rxCap, ws->rxLen + CDP_WS_READ_CHUNK + 1)) return -1;
+        int n = recv(ws->sock, (char*)ws->rx + ws->rxLen, CDP_WS_READ_CHUNK, 0);
+        if (n < 0) return CdpWouldBlock() ? 0 : -1;
+        ws->rxLen += (size_t)n;
+        ws->rx[ws->rxLen] = '\0';
+
+        const char* headers = (const char*)ws->rx;
+        const char* headerEnd = strstr(headers, "\r\n\r\n");
+        if (!headerEnd) {
+            if (n == 0 || ws->rxLen >= CDP_HTTP_HEADER_MAX) return -1;
+            continue;
+        }
+        if (!body) return 1;
+
+        // The body runs to its Content-Length, or to the end of the connection
+        const char* contentLength = CdpFindHeader(headers, "Content-Length");
+        size_t received = ws->rxLen - (size_t)(headerEnd + 4 - headers);
+        if (n == 0 || (contentLength && received >= strtoul(contentLength, NULL, 10))) return 1;
+        if (received >= CDP_BROKER_VERSION_MAX) return -1;
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Agents
+// ----------------------------------------------------------------------------
+
+// Queues or drops: an agent that can't take a message is closed without it
+static void CdpBrokerSend(CdpBrokerAgent* agent, const char* head, size_t headLen,
+                          const char* mid, size_t midLen, const char* tail, size_t tailLen) {
+    if (!CdpBrokerQueue(&agent->out, CDP_WS_OP_TEXT, 0, head, headLen, mid, midLen, tail, tailLen)) {
+        agent->out.head = agent->out.len = 0;
+        agent->state = CDP_BROKER_AGENT_CLOSING;
+    }
+}
+
+// Returns 0 once the agent is to be closed (send failed, or a closing
+// agent's output is out)
+static int CdpBrokerFlush(CdpBrokerAgent* agent) {
+    if (!CdpBrokerFlushOutput(agent->ws.sock, &agent->out)) return 0;
+    return agent->out.head < agent->out.len || agent->state != CDP_BROKER_AGENT_CLOSING;
+}
+
+// Answers a plain HTTP request and closes the connection
+static void CdpBrokerRespond(CdpBrokerAgent* agent, int status, const char* reason,
+                             const char* contentType, const char* body) {
+    char head[256];
+    size_t bodyLen = strlen(body);
+    int headLen = snprintf(head, sizeof(head),
+                           "HTTP/1.1 %d %s\r\n"
+                           "Content-Type: %s\r\n"
+                           "Content-Length: %lu\r\n"
+                           "Connection: close\r\n\r\n",
+                           status, reason, contentType, (unsigned long)bodyLen);
+    if (headLen < 0 || headLen >= (int)sizeof(head) ||
+        !CdpBrokerQueue(&agent->out, -1, 0, head, (size_t)headLen, body, bodyLen, NULL, 0)) {
+        agent->out.head = agent->out.len = 0;
+    }
+    agent->state = CDP_BROKER_AGENT_CLOSING;
+}
+
+// Percent-decodes parameter name of a query string into out, "" if there is
+// none. Returns 0 if it doesn't fit.
+static int CdpBrokerQueryParam(const char* query, const char* name, char* out, size_t outLen) {
+    size_t nameLen = strlen(name);
+    out[0] = '\0';
+    const char* p = query;
+    while (p && (strncmp(p, name, nameLen) != 0 || p[nameLen] != '=')) {
+        p = strchr(p, '&');
+        if (p) p++;
+    }
+    if (!p) return 1;
+
+    size_t len = 0;
+    for (p += nameLen + 1; *p && *p != '&'; p++) {
+        int c = (unsigned char)*p;
+        if (c == '%' && isxdigit((unsigned char)p[1]) && isxdigit((unsigned char)p[2])) {
+            char hex[3] = {p[1], p[2], '\0'};
+            c = (int)strtol(hex, NULL, 16);
+            p += 2;
+        }
+        if (len + 1 >= outLen) return 0;
+        out[len++] = (char)c;
+    }
+    out[len] = '\0';
+    return 1;
+}
+
+// A lease is handed out with a random token; binding or releasing it takes
+// the token back, so no other agent can take over or end the lease
+static int CdpBrokerNewToken(char token[CDP_BROKER_TOKEN_LEN + 1]) {
+    unsigned char bytes[CDP_BROKER_TOKEN_LEN / 2];
+    if (!CdpRandom(bytes, sizeof(bytes))) return 0;
+    for (size_t i = 0; i < sizeof(bytes); i++) snprintf(token + i * 2, 3, "%02x", bytes[i]);
+    return 1;
+}
+
+static int CdpBrokerTokenMatches(const char* query, const char* token) {
+    char given[CDP_BROKER_TOKEN_LEN + 1];
+    return token[0] && CdpBrokerQueryParam(query, "token", given, sizeof(given)) && strcmp(given, token) == 0;
+}
+
+// Reads an agent's frames without blocking. Returns 1 and points *message at a
+// complete text message, 0 if more bytes are needed, -1 if the agent is gone.
+static int CdpBrokerReceive(CdpBrokerAgent* agent, const char** message) {
+    int rc = CdpBrokerReadFrames(&agent->ws, &agent->out, 0, message);
+    if (rc == 2) {
+        agent->state = CDP_BROKER_AGENT_CLOSING;
+        return 0;
+    }
+    return rc;
+}
+
+static int CdpBrokerAgentAlive(CdpBroker* broker, int index, unsigned long serial) {
+    return index >= 0 && index < CDP_BROKER_MAX_AGENTS && broker->agents[index].serial == serial &&
+           broker->agents[index].state == CDP_BROKER_AGENT_OPEN;
+}
+
+// Browser-level events are delivered to agents that used their domain
+static void CdpBrokerSubscribe(CdpBrokerAgent* agent, const char* method) {
+    const char* dot = strchr(method, '.');
+    size_t len = dot ? (size_t)(dot - method) : 0;
+    if (len == 0 || len >= sizeof(agent->domains[0])) return;
+
+    for (int i = 0; i < agent->domainCount; i++) {
+        if (strncmp(agent->domains[i], method, len) == 0 && agent->domains[i][len] == '\0') return;
+    }
+    if (agent->domainCount >= CDP_BROKER_MAX_DOMAINS) return;
+    memcpy(agent->domains[agent->domainCount], method, len);
+    agent->domains[agent->domainCount++][len] = '\0';
+}
+
+static int CdpBrokerSubscribed(const CdpBrokerAgent* agent, const char* method) {
+    const char* dot = strchr(method, '.');
+    size_t len = dot ? (size_t)(dot - method) : 0;
+    for (int i = 0; i < agent->domainCount; i++) {
+        if (len > 0 && strncmp(agent->domains[i], method, len) == 0 && agent->domains[i][len] == '\0') return 1;
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Upstreams: sessions and calls in flight
+// ----------------------------------------------------------------------------
+
+static unsigned int CdpBrokerHash(const char* s) {
+    unsigned int h = 2166136261u;  // FNV-1a
+    while (*s) {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+static CdpBrokerSession* CdpBrokerFindSession(CdpBrokerUpstream* up, const char* sessionId) {
+    unsigned int mask = CDP_BROKER_MAX_SESSIONS - 1;
+    unsigned int i = CdpBrokerHash(sessionId) & mask;
+    for (unsigned int probes = 0; probes <= mask; probes++, i = (i + 1) & mask) {
+        if (up->sessions[i].sessionId[0] == '\0') return NULL;
+        if (strcmp(up->sessions[i].sessionId, sessionId) == 0) return &up->sessions[i];
+    }
+    return NULL;
+}
+
+static int CdpBrokerAddSession(CdpBrokerUpstream* up, const char* sessionId, int agent, unsigned long serial) {
+    CdpBrokerSession* session = CdpBrokerFindSession(up, sessionId);
+    if (!session) {
+        // Keep one slot free so lookups of absent ids end
+        if (up->sessionCount >= CDP_BROKER_MAX_SESSIONS - 1) return 0;
+        unsigned int mask = CDP_BROKER_MAX_SESSIONS - 1;
+        unsigned int i = CdpBrokerHash(sessionId) & mask;
+        while (up->sessions[i].sessionId[0] != '\0') i = (i + 1) & mask;
+        session = &up->sessions[i];
+        snprintf(session->sessionId, sizeof(session->sessionId), "%s", sessionId);
+        up->sessionCount++;
+    }
+    session->agent = agent;
+    session->agentSerial = serial;
+    return 1;
+}
+
+// Backward-shift deletion keeps probe runs unbroken without tombstones
+static void CdpBrokerRemoveSession(CdpBrokerUpstream* up, CdpBrokerSession* session) {
+    unsigned int mask = CDP_BROKER_MAX_SESSIONS - 1;
+    unsigned int hole = (unsigned int)(session - up->sessions);
+    unsigned int i = hole;
+    for (;;) {
+        i = (i + 1) & mask;
+        if (up->sessions[i].sessionId[0] == '\0') break;
+        unsigned int home = CdpBrokerHash(up->sessions[i].sessionId) & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            up->sessions[hole] = up->sessions[i];
+            hole = i;
+        }
+    }
+    up->sessions[hole].sessionId[0] = '\0';
+    up->sessionCount--;
+}
+
+static int CdpBrokerSessionOwner(CdpBroker* broker, const CdpBrokerSession* session) {
+    if (!session || !CdpBrokerAgentAlive(broker, session->agent, session->agentSerial)) return -1;
+    return session->agent;
+}
+
+// Reserves the pending slot of a fresh upstream id - the next one whose slot
+// is free, so a call that is never answered holds up only its own slot.
+// Returns NULL if every slot is waiting for an answer.
+static CdpBrokerPending* CdpBrokerReserve(CdpBrokerUpstream* up) {
+    for (int probes = 0; probes < CDP_BROKER_MAX_PENDING; probes++) {
+        if (up->nextId >= 0x7FFFFFFFL) up->nextId = 0;
+        long id = ++up->nextId;
+        CdpBrokerPending* pending = &up->pending[id & (CDP_BROKER_MAX_PENDING - 1)];
+        if (pending->upstreamId != 0) continue;
+        memset(pending, 0, sizeof(*pending));
+        pending->upstreamId = id;
+        pending->agent = -1;
+        return pending;
+    }
+    return NULL;
+}
+
+// Queues head + mid + tail as one message to the browser; it goes out as the
+// socket takes it
+static int CdpBrokerUpstreamSend(CdpBrokerUpstream* up, const char* head, size_t headLen,
+                                 const char* mid, size_t midLen, const char* tail, size_t tailLen) {
+    if (CdpBrokerQueue(&up->out, CDP_WS_OP_TEXT, 1, head, headLen, mid, midLen, tail, tailLen)) return 1;
+    up->reconnect = 1;  // Dropped with its agents on the next loop pass
+    return 0;
+}
+
+// Sends a call of the broker's own. Returns its pending slot, for the caller
+// to mark, or NULL if it couldn't be sent.
+static CdpBrokerPending* CdpBrokerRequest(CdpBrokerUpstream* up, const char* method, const char* params) {
+    if (up->state != CDP_LINK_UP) return NULL;
+    CdpBrokerPending* pending = CdpBrokerReserve(up);
+    if (!pending) return NULL;
+
+    char request[512];
+    int len = snprintf(request, sizeof(request), "{\"id\":%ld,\"method\":\"%s\",\"params\":%s}",
+                       pending->upstreamId, method, params);
+    if (len < 0 || len >= (int)sizeof(request) || !CdpBrokerUpstreamSend(up, request, (size_t)len, NULL, 0, NULL, 0)) {
+        pending->upstreamId = 0;
+        return NULL;
+    }
+    return pending;
+}
+
+// Cleanup calls with a single string parameter; answers are discarded
+static void CdpBrokerCall(CdpBrokerUpstream* up, const char* method, const char* key, const char* value) {
+    char params[192];
+    int len = snprintf(params, sizeof(params), "{\"%s\":\"%s\"}", key, value);
+    if (len > 0 && len < (int)sizeof(params)) CdpBrokerRequest(up, method, params);
+}
+
+// Agents are spread over the connected upstreams, fewest agents first
+static int CdpBrokerPickUpstream(CdpBroker* broker) {
+    int best = -1;
+    for (int u = 0; u < broker->upstreamCount && u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        const CdpBrokerUpstream* up = &broker->upstreams[u];
+        if (up->state == CDP_LINK_UP && (best < 0 || up->agentCount < broker->upstreams[best].agentCount)) best = u;
+    }
+    return best;
+}
+
+// Agent of upstream u that created (or holds the lease on) a context, -1 if none
+static int CdpBrokerContextOwner(CdpBroker* broker, int u, const char* contextId) {
+    for (int a = 0; a < CDP_BROKER_MAX_AGENTS; a++) {
+        const CdpBrokerAgent* agent = &broker->agents[a];
+        if (agent->state != CDP_BROKER_AGENT_OPEN || agent->upstream != u) continue;
+        for (int i = 0; i < agent->contextCount; i++) {
+            if (strcmp(agent->contexts[i], contextId) == 0) return a;
+        }
+    }
+    return -1;
+}
+
+static void CdpBrokerForgetContext(CdpBrokerAgent* agent, const char* contextId) {
+    for (int i = 0; i < agent->contextCount; i++) {
+        if (strcmp(agent->contexts[i], contextId) == 0) {
+            memcpy(agent->contexts[i], agent->contexts[--agent->contextCount], sizeof(agent->contexts[i]));
+            return;
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------
+// Context pool
+// ----------------------------------------------------------------------------
+//
+// Each slot goes FREE -> CREATING (createBrowserContext, then createTarget
+// with about:blank) -> READY -> LEASED -> DISPOSING -> FREE. A lease ends
+// with a release request, or when the agent it is bound to disconnects.
+
+static int CdpBrokerPoolFind(const CdpBrokerUpstream* up, const char* contextId) {
+    for (int i = 0; i < CDP_BROKER_POOL_SLOTS; i++) {
+        const CdpBrokerPoolContext* context = &up->pool[i];
+        if (context->state != CDP_POOL_FREE && strcmp(context->contextId, contextId) == 0) return i;
+    }
+    return -1;
+}
+
+static int CdpBrokerPoolCreate(CdpBrokerUpstream* up, int slot) {
+    CdpBrokerPending* pending = CdpBrokerRequest(up, "Target.createBrowserContext", "{}");
+    if (!pending) return 0;
+    pending->kind = CDP_BROKER_CALL_POOL_CONTEXT;
+    pending->slot = slot;
+
+    CdpBrokerPoolContext* context = &up->pool[slot];
+    memset(context, 0, sizeof(*context));
+    context->state = CDP_POOL_CREATING;
+    context->waiter = -1;
+    context->owner = -1;
+    return 1;
+}
+
+// Disposal runs in the background; the slot is reused once Chrome confirms
+static void CdpBrokerPoolDispose(CdpBrokerUpstream* up, int slot) {
+    CdpBrokerPoolContext* context = &up->pool[slot];
+    char params[128];
+    snprintf(params, sizeof(params), "{\"browserContextId\":\"%s\"}", context->contextId);
+    CdpBrokerPending* pending = context->contextId[0] ? CdpBrokerRequest(up, "Target.disposeBrowserContext", params) : NULL;
+    if (!pending) {
+        context->state = CDP_POOL_FREE;
+        return;
+    }
+    pending->kind = CDP_BROKER_CALL_POOL_DISPOSE;
+    pending->slot = slot;
+    context->state = CDP_POOL_DISPOSING;
+}
+
+// Answers an allocation request with a ready context
+static void CdpBrokerPoolLease(CdpBroker* broker, int index, int u, int slot, int hit) {
+    CdpBrokerAgent* agent = &broker->agents[index];
+    CdpBrokerPoolContext* context = &broker->upstreams[u].pool[slot];
+    unsigned long long latencyUs = CdpNowUs() - agent->waitStartUs;
+    if (!CdpBrokerNewToken(context->token)) {
+        context->waiter = -1;
+        CdpBrokerRespond(agent, 503, "Service Unavailable", "text/plain", "No lease token could be generated\n");
+        return;
+    }
+
+    char body[640];
+    snprintf(body, sizeof(body),
+             "{\"browserContextId\":\"%s\",\"targetId\":\"%s\",\"token\":\"%s\","
+             "\"webSocketDebuggerUrl\":\"ws://%s/devtools/browser/broker/%d/%s?token=%s\","
+             "\"pooled\":%s,\"latencyUs\":%lu}",
+             context->contextId, context->targetId, context->token, agent->waitHost, u, context->contextId,
+             context->token, hit ? "true" : "false", (unsigned long)latencyUs);
+    CdpBrokerRespond(agent, 200, "OK", "application/json; charset=UTF-8", body);
+
+    context->state = CDP_POOL_LEASED;
+    context->waiter = -1;
+    broker->allocations++;
+    if (hit) {
+        broker->poolHits++;
+        broker->hitLatencyUs += latencyUs;
+    } else {
+        broker->missLatencyUs += latencyUs;
+    }
+}
+
+static int CdpBrokerPoolWaiting(CdpBroker* broker, const CdpBrokerPoolContext* context, int u, int slot) {
+    const CdpBrokerAgent* agent = context->waiter >= 0 ? &broker->agents[context->waiter] : NULL;
+    return agent && agent->state == CDP_BROKER_AGENT_WAITING && agent->serial == context->waiterSerial &&
+           agent->waitUpstream == u && agent->waitSlot == slot;
+}
+
+// Moves a slot on when one of the pool's calls is answered
+static void CdpBrokerPoolResult(CdpBroker* broker, int u, const CdpBrokerPending* call, const char* result) {
+    CdpBrokerUpstream* up = &broker->upstreams[u];
+    CdpBrokerPoolContext* context = &up->pool[call->slot];
+
+    if (call->kind == CDP_BROKER_CALL_POOL_DISPOSE) {
+        if (context->state == CDP_POOL_DISPOSING) context->state = CDP_POOL_FREE;
+        return;
+    }
+    if (context->state != CDP_POOL_CREATING) return;
+
+    if (call->kind == CDP_BROKER_CALL_POOL_CONTEXT) {
+        if (!result || !CdpJsonMemberString(result, "browserContextId", context->contextId, sizeof(context->contextId))) {
+            context->state = CDP_POOL_FREE;
+        } else {
+            char params[192];
+            snprintf(params, sizeof(params), "{\"url\":\"about:blank\",\"browserContextId\":\"%s\"}",
+                     context->contextId);
+            CdpBrokerPending* pending = CdpBrokerRequest(up, "Target.createTarget", params);
+            if (pending) {
+                pending->kind = CDP_BROKER_CALL_POOL_TARGET;
+                pending->slot = call->slot;
+                return;
+            }
+            CdpBrokerPoolDispose(up, call->slot);
+        }
+    } else if (result && CdpJsonMemberString(result, "targetId", context->targetId, sizeof(context->targetId))) {
+        context->state = CDP_POOL_READY;
+    } else {
+        CdpBrokerPoolDispose(up, call->slot);
+    }
+
+    if (context->state != CDP_POOL_READY) up->poolRetryUs = CdpNowUs() + CDP_BROKER_RETRY_MS * 1000ULL;
+
+    // An allocation that missed the pool gets this context, or learns it failed
+    if (CdpBrokerPoolWaiting(broker, context, u, call->slot)) {
+        if (context->state == CDP_POOL_READY) {
+            CdpBrokerPoolLease(broker, context->waiter, u, call->slot, 0);
+        } else {
+            CdpBrokerRespond(&broker->agents[context->waiter], 503, "Service Unavailable", "text/plain",
+                             "Browser context could not be created\n");
+        }
+    }
+    context->waiter = -1;
+}
+
+// Tops each connected upstream up to poolSize contexts ready or on their
+// way, trims it when the size was lowered, and times out waiting requests
+static void CdpBrokerPoolMaintain(CdpBroker* broker, unsigned long long now) {
+    int size = broker->poolSize;
+    if (size < 0) size = 0;
+    if (size > CDP_BROKER_POOL_MAX) size = CDP_BROKER_POOL_MAX;
+
+    for (int u = 0; u < broker->upstreamCount && u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        CdpBrokerUpstream* up = &broker->upstreams[u];
+        if (up->state != CDP_LINK_UP) continue;
+
+        int spare = 0;
+        up->poolReady = up->poolLeased = 0;
+        for (int i = 0; i < CDP_BROKER_POOL_SLOTS; i++) {
+            const CdpBrokerPoolContext* context = &up->pool[i];
+            if (context->state == CDP_POOL_READY) up->poolReady++;
+            if (context->state == CDP_POOL_LEASED) up->poolLeased++;
+            if (context->state == CDP_POOL_READY ||
+                (context->state == CDP_POOL_CREATING && !CdpBrokerPoolWaiting(broker, context, u, i))) {
+                spare++;
+            }
+        }
+        for (int i = 0; i < CDP_BROKER_POOL_SLOTS && spare < size && now >= up->poolRetryUs; i++) {
+            if (up->pool[i].state == CDP_POOL_FREE && CdpBrokerPoolCreate(up, i)) spare++;
+        }
+        for (int i = 0; i < CDP_BROKER_POOL_SLOTS && spare > size; i++) {
+            if (up->pool[i].state == CDP_POOL_READY) {
+                CdpBrokerPoolDispose(up, i);
+                up->poolReady--;
+                spare--;
+            }
+        }
+    }
+
+    for (int a = 0; a < CDP_BROKER_MAX_AGENTS; a++) {
+        CdpBrokerAgent* agent = &broker->agents[a];
+        if (agent->state == CDP_BROKER_AGENT_WAITING &&
+            now - agent->waitStartUs > CDP_BROKER_POOL_WAIT_MS * 1000ULL) {
+            CdpBrokerRespond(agent, 503, "Service Unavailable", "text/plain", "Timed out waiting for a browser context\n");
+        }
+    }
+}
+
+// GET /json/context/new: a ready context from the upstream with the most of
+// them, else one being created for the pool, else a new one
+static void CdpBrokerPoolAllocate(CdpBroker* broker, int index, const char* host) {
+    CdpBrokerAgent* agent = &broker->agents[index];
+    if (broker->poolSize <= 0) {
+        CdpBrokerRespond(agent, 404, "Not Found", "text/plain", "The context pool is off\n");
+        return;
+    }
+    agent->waitStartUs = CdpNowUs();
+    snprintf(agent->waitHost, sizeof(agent->waitHost), "%s", host);
+
+    int best = -1, bestSlot = -1, bestReady = 0;
+    for (int u = 0; u < broker->upstreamCount && u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        const CdpBrokerUpstream* up = &broker->upstreams[u];
+        if (up->state != CDP_LINK_UP) continue;
+        int ready = 0, first = -1;
+        for (int i = 0; i < CDP_BROKER_POOL_SLOTS; i++) {
+            if (up->pool[i].state != CDP_POOL_READY) continue;
+            if (first < 0) first = i;
+            ready++;
+        }
+        if (ready > bestReady) {
+            best = u;
+            bestSlot = first;
+            bestReady = ready;
+        }
+    }
+    if (best >= 0) {
+        CdpBrokerPoolLease(broker, index, best, bestSlot, 1);
+        return;
+    }
+
+    int u = CdpBrokerPickUpstream(broker);
+    CdpBrokerUpstream* up = u >= 0 ? &broker->upstreams[u] : NULL;
+    int slot = -1;
+    for (int i = 0; up && i < CDP_BROKER_POOL_SLOTS && slot < 0; i++) {
+        if (up->pool[i].state == CDP_POOL_CREATING && !CdpBrokerPoolWaiting(broker, &up->pool[i], u, i)) slot = i;
+    }
+    for (int i = 0; up && i < CDP_BROKER_POOL_SLOTS && slot < 0; i++) {
+        if (up->pool[i].state == CDP_POOL_FREE && CdpBrokerPoolCreate(up, i)) slot = i;
+    }
+    if (slot < 0) {
+        CdpBrokerRespond(agent, 503, "Service Unavailable", "text/plain",
+                         up ? "No browser context available\n" : "No browser connected\n");
+        return;
+    }
+    up->pool[slot].waiter = index;
+    up->pool[slot].waiterSerial = agent->serial;
+    agent->state = CDP_BROKER_AGENT_WAITING;
+    agent->waitUpstream = u;
+    agent->waitSlot = slot;
+}
+
+// GET /json/context/release/<id>?token=<token>: the context is disposed and
+// replaced
+static void CdpBrokerPoolRelease(CdpBroker* broker, int index, const char* contextId, const char* query) {
+    for (int u = 0; u < broker->upstreamCount && u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        CdpBrokerUpstream* up = &broker->upstreams[u];
+        int slot = up->state == CDP_LINK_UP ? CdpBrokerPoolFind(up, contextId) : -1;
+        if (slot < 0 || up->pool[slot].state != CDP_POOL_LEASED) continue;
+
+        CdpBrokerPoolContext* context = &up->pool[slot];
+        if (!CdpBrokerTokenMatches(query, context->token)) {
+            CdpBrokerRespond(&broker->agents[index], 403, "Forbidden", "text/plain", "Wrong or missing lease token\n");
+            return;
+        }
+        if (CdpBrokerAgentAlive(broker, context->owner, context->ownerSerial)) {
+            CdpBrokerForgetContext(&broker->agents[context->owner], contextId);
+        }
+        CdpBrokerPoolDispose(up, slot);
+        CdpBrokerRespond(&broker->agents[index], 200, "OK", "application/json; charset=UTF-8", "{}");
+        return;
+    }
+    CdpBrokerRespond(&broker->agents[index], 404, "Not Found", "text/plain", "No such leased context\n");
+}
+
+// ----------------------------------------------------------------------------
+// Tab pool
+// ----------------------------------------------------------------------------
+//
+// Tabs are created in the background on about:blank, then navigated to a
+// start URL over a page connection of their own - the shared connection
+// never attaches to them - and are ready once the page fired its load
+// event: FREE -> CREATING -> CREATED -> CONNECTING -> LOADING -> READY ->
+// LEASED -> CLOSING -> FREE. At most CDP_BROKER_TAB_LOADING load at once per
+// upstream, tabs an allocation waits for first. Without start URLs tabs
+// are ready on about:blank.
+
+static int CdpBrokerUrlValid(const char* url) {
+    for (; *url; url++) {
+        if ((unsigned char)*url <= ' ' || *url == '"' || *url == '\\') return 0;
+    }
+    return 1;
+}
+
+// Parses the start URLs in broker->tabUrlList
+static void CdpBrokerParseTabUrls(CdpBroker* broker) {
+    char list[CDP_BROKER_TAB_URL_LIST_MAX];
+    memcpy(list, broker->tabUrlList, sizeof(list));
+
+    broker->tabUrlCount = 0;
+    for (char* url = strtok(list, " \t\r\n"); url && broker->tabUrlCount < CDP_BROKER_TAB_URLS;
+         url = strtok(NULL, " \t\r\n")) {
+        if (strlen(url) >= CDP_BROKER_URL_MAX || !CdpBrokerUrlValid(url)) continue;
+        memcpy(broker->tabUrls[broker->tabUrlCount++], url, strlen(url) + 1);
+    }
+}
+
+static int CdpBrokerTabUrlListed(const CdpBroker* broker, const char* url) {
+    if (broker->tabUrlCount == 0) return url[0] == '\0';
+    for (int i = 0; i < broker->tabUrlCount; i++) {
+        if (strcmp(broker->tabUrls[i], url) == 0) return 1;
+    }
+    return 0;
+}
+
+// A URL the agent asked for, "" if none. Returns 0 for one that can't be used.
+static int CdpBrokerQueryUrl(const char* query, char* out, size_t outLen) {
+    return CdpBrokerQueryParam(query, "url", out, outLen) && CdpBrokerUrlValid(out);
+}
+
+static int CdpBrokerTabFind(const CdpBrokerUpstream* up, const char* targetId) {
+    for (int i = 0; i < CDP_BROKER_TAB_SLOTS; i++) {
+        const CdpBrokerTab* tab = &up->tabs[i];
+        if (tab->state != CDP_TAB_FREE && strcmp(tab->targetId, targetId) == 0) return i;
+    }
+    return -1;
+}
+
+static int CdpBrokerTabLoading(const CdpBrokerTab* tab) {
+    return tab->state == CDP_TAB_CONNECTING || tab->state == CDP_TAB_LOADING;
+}
+
+static void CdpBrokerTabDisconnect(CdpBrokerTab* tab) {
+    CdpWsClose(&tab->ws);
+    CdpBrokerFreeOutput(&tab->out);
+}
+
+static void CdpBrokerTabFree(CdpBrokerTab* tab) {
+    CdpBrokerTabDisconnect(tab);
+    memset(tab, 0, sizeof(*tab));
+    CdpWsInit(&tab->ws);
+    tab->waiter = -1;
+    tab->owner = -1;
+}
+
+static int CdpBrokerTabWaiting(CdpBroker* broker, const CdpBrokerTab* tab, int u, int slot) {
+    const CdpBrokerAgent* agent = tab->waiter >= 0 ? &broker->agents[tab->waiter] : NULL;
+    return agent && agent->state == CDP_BROKER_AGENT_WAITING_TAB && agent->serial == tab->waiterSerial &&
+           agent->waitUpstream == u && agent->waitSlot == slot;
+}
+
+static int CdpBrokerTabCreate(CdpBrokerUpstream* up, int slot, const char* url) {
+    CdpBrokerPending* pending =
+        CdpBrokerRequest(up, "Target.createTarget", "{\"url\":\"about:blank\",\"background\":true}");
+    if (!pending) return 0;
+    pending->kind = CDP_BROKER_CALL_TAB_CREATE;
+    pending->slot = slot;
+
+    CdpBrokerTab* tab = &up->tabs[slot];
+    CdpBrokerTabFree(tab);
+    tab->state = CDP_TAB_CREATING;
+    snprintf(tab->url, sizeof(tab->url), "%s", url);
+    tab->startUs = CdpNowUs();
+    return 1;
+}
+
+static void CdpBrokerTabClose(CdpBrokerUpstream* up, int slot) {
+    CdpBrokerTab* tab = &up->tabs[slot];
+    CdpBrokerTabDisconnect(tab);
+    char params[128];
+    snprintf(params, sizeof(params), "{\"targetId\":\"%s\"}", tab->targetId);
+    CdpBrokerPending* pending = tab->targetId[0] ? CdpBrokerRequest(up, "Target.closeTarget", params) : NULL;
+    if (!pending) {
+        CdpBrokerTabFree(tab);
+        return;
+    }
+    pending->kind = CDP_BROKER_CALL_TAB_CLOSE;
+    pending->slot = slot;
+    tab->state = CDP_TAB_CLOSING;
+}
+
+// Answers an allocation request with a loaded tab
+static void CdpBrokerTabLease(CdpBroker* broker, int index, int u, int slot, int hit) {
+    CdpBrokerAgent* agent = &broker->agents[index];
+    CdpBrokerTab* tab = &broker->upstreams[u].tabs[slot];
+    unsigned long long latencyUs = CdpNowUs() - agent->waitStartUs;
+    if (!CdpBrokerNewToken(tab->token)) {
+        tab->waiter = -1;
+        CdpBrokerRespond(agent, 503, "Service Unavailable", "text/plain", "No lease token could be generated\n");
+        return;
+    }
+
+    char body[CDP_BROKER_URL_MAX + 640];
+    snprintf(body, sizeof(body),
+             "{\"targetId\":\"%s\",\"url\":\"%s\",\"token\":\"%s\","
+             "\"webSocketDebuggerUrl\":\"ws://%s/devtools/browser/broker/%d/%s?token=%s\","
+             "\"pooled\":%s,\"loadMs\":%lu,\"latencyUs\":%lu}",
+             tab->targetId, tab->url[0] ? tab->url : "about:blank", tab->token, agent->waitHost, u, tab->targetId,
+             tab->token, hit ? "true" : "false", (unsigned long)(tab->loadUs / 1000), (unsigned long)latencyUs);
+    CdpBrokerRespond(agent, 200, "OK", "application/json; charset=UTF-8", body);
+
+    tab->state = CDP_TAB_LEASED;
+    tab->waiter = -1;
+    broker->tabAllocations++;
+    if (hit) {
+        broker->tabHits++;
+        broker->tabHitLatencyUs += latencyUs;
+    } else {
+        broker->tabMissLatencyUs += latencyUs;
+    }
+}
+
+// A tab is done loading, or failed to: a waiting allocation gets it, else it
+// is kept ready
+static void CdpBrokerTabLoaded(CdpBroker* broker, int u, int slot, int ok) {
+    CdpBrokerUpstream* up = &broker->upstreams[u];
+    CdpBrokerTab* tab = &up->tabs[slot];
+    CdpBrokerTabDisconnect(tab);
+
+    if (!ok) {
+        if (CdpBrokerTabWaiting(broker, tab, u, slot)) {
+            CdpBrokerRespond(&broker->agents[tab->waiter], 503, "Service Unavailable", "text/plain",
+                             "Tab could not be created\n");
+        }
+        up->tabRetryUs = CdpNowUs() + CDP_BROKER_RETRY_MS * 1000ULL;
+        CdpBrokerTabClose(up, slot);
+        return;
+    }
+
+    tab->loadUs = CdpNowUs() - tab->startUs;
+    broker->tabLoads++;
+    broker->tabLoadUs += tab->loadUs;
+    tab->state = CDP_TAB_READY;
+    if (CdpBrokerTabWaiting(broker, tab, u, slot)) CdpBrokerTabLease(broker, tab->waiter, u, slot, 0);
+    tab->waiter = -1;
+}
+
+static void CdpBrokerTabResult(CdpBroker* broker, int u, const CdpBrokerPending* call, const char* result) {
+    CdpBrokerTab* tab = &broker->upstreams[u].tabs[call->slot];
+    if (call->kind == CDP_BROKER_CALL_TAB_CLOSE) {
+        if (tab->state == CDP_TAB_CLOSING) CdpBrokerTabFree(tab);
+        return;
+    }
+    if (tab->state != CDP_TAB_CREATING) return;
+
+    if (!result || !CdpJsonMemberString(result, "targetId", tab->targetId, sizeof(tab->targetId))) {
+        CdpBrokerTabLoaded(broker, u, call->slot, 0);
+    } else if (tab->url[0]) {
+        tab->state = CDP_TAB_CREATED;
+    } else {
+        CdpBrokerTabLoaded(broker, u, call->slot, 1);
+    }
+}
+
+// Navigates a created tab over a page connection of its own, set up without
+// blocking like the upstream's: the handshake goes out first, the commands
+// once it is answered
+static void CdpBrokerTabLoad(CdpBroker* broker, int u, int slot) {
+    CdpBrokerUpstream* up = &broker->upstreams[u];
+    CdpBrokerTab* tab = &up->tabs[slot];
+
+    char path[128];
+    char request[768];
+    snprintf(path, sizeof(path), "/devtools/page/%s", tab->targetId);
+    int len = CdpWsHandshake(&tab->ws, up->host, up->port, path, request, sizeof(request));
+
+    tab->state = CDP_TAB_CONNECTING;
+    tab->dialDeadlineUs = CdpNowUs() + CDP_BROKER_CONNECT_TIMEOUT_MS * 1000ULL;
+    int ok = len >= 0 && CdpConnectStart(up->host, up->port, &tab->ws.sock) == CDP_OK;
+#ifndef _WIN32
+    if (ok && (int)tab->ws.sock >= FD_SETSIZE) ok = 0;
+#endif
+    if (!ok || !CdpBrokerQueue(&tab->out, -1, 0, request, (size_t)len, NULL, 0, NULL, 0)) {
+        CdpBrokerTabLoaded(broker, u, slot, 0);
+    }
+}
+
+static int CdpBrokerTabNavigate(CdpBrokerTab* tab) {
+    static const char enable[] = "{\"id\":1,\"method\":\"Page.enable\"}";
+    char navigate[CDP_BROKER_URL_MAX + 128];
+    int len = snprintf(navigate, sizeof(navigate), "{\"id\":2,\"method\":\"Page.navigate\",\"params\":{\"url\":\"%s\"}}",
+                       tab->url);
+    if (CdpWsAccepted(&tab->ws, (char*)tab->ws.rx, tab->ws.rxLen) != CDP_OK ||
+        !CdpBrokerQueue(&tab->out, CDP_WS_OP_TEXT, 1, enable, sizeof(enable) - 1, NULL, 0, NULL, 0) ||
+        !CdpBrokerQueue(&tab->out, CDP_WS_OP_TEXT, 1, navigate, (size_t)len, NULL, 0, NULL, 0)) {
+        return 0;
+    }
+    tab->state = CDP_TAB_LOADING;
+    return CdpBrokerFlushOutput(tab->ws.sock, &tab->out);
+}
+
+static void CdpBrokerTabMessage(CdpBroker* broker, int u, int slot, const char* message) {
+    CdpBrokerMessage fields;
+    CdpBrokerParseMessage(message, &fields);
+
+    // A navigation that failed outright has no load event; Chrome shows its
+    // error page and the tab is as usable as any
+    const char* error = NULL;
+    if (strcmp(fields.method, "Page.loadEventFired") == 0 ||
+        (fields.id && fields.idValue == 2 && fields.result && CdpJsonFindMember(fields.result, "errorText", &error) > 0)) {
+        CdpBrokerTabLoaded(broker, u, slot, 1);
+    }
+}
+
+// Moves a tab's page connection on once its socket is ready (or failed): the
+// handshake out and answered, then the navigation out and its load event in
+static void CdpBrokerTabProgress(CdpBroker* broker, int u, int slot, int failed) {
+    CdpBrokerTab* tab = &broker->upstreams[u].tabs[slot];
+    int ok = !failed && CdpConnected(tab->ws.sock) && CdpBrokerFlushOutput(tab->ws.sock, &tab->out);
+    if (ok && tab->state == CDP_TAB_CONNECTING) {
+        int rc = CdpBrokerDialRead(&tab->ws, 0);
+        if (rc == 0) return;
+        ok = rc > 0 && CdpBrokerTabNavigate(tab);
+    }
+
+    const char* message = NULL;
+    int received = 0;
+    while (ok && tab->state == CDP_TAB_LOADING &&
+           (received = CdpBrokerReadFrames(&tab->ws, &tab->out, 1, &message)) == 1) {
+        CdpBrokerTabMessage(broker, u, slot, message);
+    }
+    if (CdpBrokerTabLoading(tab) && (!ok || received < 0 || received == 2)) CdpBrokerTabLoaded(broker, u, slot, 0);
+}
+
+// Keeps each connected upstream at tabPoolSize tabs ready or on their way,
+// spread over the start URLs, starts loads, and times out loads and waits
+static void CdpBrokerTabMaintain(CdpBroker* broker, unsigned long long now) {
+    // Adopt a list handed over by CdpBrokerSetTabUrls
+    char* urls = (char*)CdpExchangePointer((void* volatile*)&broker->tabUrlUpdate, NULL);
+    if (urls) {
+        if (strcmp(urls, broker->tabUrlList) != 0) {
+            snprintf(broker->tabUrlList, sizeof(broker->tabUrlList), "%s", urls);
+            CdpBrokerParseTabUrls(broker);
+        }
+        free(urls);
+    }
+    int size = broker->tabPoolSize;
+    if (size < 0) size = 0;
+    if (size > CDP_BROKER_TAB_POOL_MAX) size = CDP_BROKER_TAB_POOL_MAX;
+
+    for (int u = 0; u < broker->upstreamCount && u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        CdpBrokerUpstream* up = &broker->upstreams[u];
+        if (up->state != CDP_LINK_UP) continue;
+
+        int spare = 0, loading = 0;
+        int perUrl[CDP_BROKER_TAB_URLS] = {0};
+        up->tabsReady = up->tabsLeased = 0;
+        for (int i = 0; i < CDP_BROKER_TAB_SLOTS; i++) {
+            CdpBrokerTab* tab = &up->tabs[i];
+            if (tab->state == CDP_TAB_CONNECTING && now >= tab->dialDeadlineUs) {
+                CdpBrokerTabLoaded(broker, u, i, 0);
+            } else if (tab->state == CDP_TAB_LOADING && now - tab->startUs > CDP_BROKER_TAB_LOAD_MS * 1000ULL) {
+                CdpBrokerTabLoaded(broker, u, i, 1);
+            }
+            // Ready tabs of a start URL no longer listed are replaced
+            if (tab->state == CDP_TAB_READY && !CdpBrokerTabUrlListed(broker, tab->url)) CdpBrokerTabClose(up, i);
+
+            if (CdpBrokerTabLoading(tab)) loading++;
+            if (tab->state == CDP_TAB_READY) up->tabsReady++;
+            if (tab->state == CDP_TAB_LEASED) up->tabsLeased++;
+            if (tab->state == CDP_TAB_READY ||
+                ((tab->state == CDP_TAB_CREATING || tab->state == CDP_TAB_CREATED || CdpBrokerTabLoading(tab)) &&
+                 !CdpBrokerTabWaiting(broker, tab, u, i))) {
+                spare++;
+                for (int k = 0; k < broker->tabUrlCount; k++) {
+                    if (strcmp(broker->tabUrls[k], tab->url) == 0) perUrl[k]++;
+                }
+            }
+        }
+
+        for (int i = 0; i < CDP_BROKER_TAB_SLOTS && spare < size && now >= up->tabRetryUs; i++) {
+            if (up->tabs[i].state != CDP_TAB_FREE) continue;
+            int least = 0;
+            for (int k = 1; k < broker->tabUrlCount; k++) {
+                if (perUrl[k] < perUrl[least]) least = k;
+            }
+            if (!CdpBrokerTabCreate(up, i, broker->tabUrlCount ? broker->tabUrls[least] : "")) break;
+            if (broker->tabUrlCount) perUrl[least]++;
+            spare++;
+        }
+        for (int i = 0; i < CDP_BROKER_TAB_SLOTS && spare > size; i++) {
+            if (up->tabs[i].state == CDP_TAB_READY) {
+                CdpBrokerTabClose(up, i);
+                up->tabsReady--;
+                spare--;
+            }
+        }
+
+        // Loads someone waits for go first
+        for (int pass = 0; pass < 2 && loading < CDP_BROKER_TAB_LOADING; pass++) {
+            for (int i = 0; i < CDP_BROKER_TAB_SLOTS && loading < CDP_BROKER_TAB_LOADING; i++) {
+                CdpBrokerTab* tab = &up->tabs[i];
+                if (tab->state != CDP_TAB_CREATED || (pass == 0 && !CdpBrokerTabWaiting(broker, tab, u, i))) continue;
+                CdpBrokerTabLoad(broker, u, i);
+                if (CdpBrokerTabLoading(tab)) loading++;
+            }
+        }
+    }
+
+    for (int a = 0; a < CDP_BROKER_MAX_AGENTS; a++) {
+        CdpBrokerAgent* agent = &broker->agents[a];
+        if (agent->state == CDP_BROKER_AGENT_WAITING_TAB &&
+            now - agent->waitStartUs > CDP_BROKER_TAB_WAIT_MS * 1000ULL) {
+            CdpBrokerRespond(agent, 503, "Service Unavailable", "text/plain", "Timed out waiting for a tab to load\n");
+        }
+    }
+}
+
+// GET /json/tab/new[?url=<url>]: a loaded tab - of that URL if one is given -
+// from the upstream with the most of them, else one on its way, else a new one
+static void CdpBrokerTabAllocate(CdpBroker* broker, int index, const char* query, const char* host) {
+    CdpBrokerAgent* agent = &broker->agents[index];
+    char url[CDP_BROKER_URL_MAX];
+    if (broker->tabPoolSize <= 0) {
+        CdpBrokerRespond(agent, 404, "Not Found", "text/plain", "The tab pool is off\n");
+        return;
+    }
+    if (!CdpBrokerQueryUrl(query, url, sizeof(url))) {
+        CdpBrokerRespond(agent, 400, "Bad Request", "text/plain", "Invalid url parameter\n");
+        return;
+    }
+    agent->waitStartUs = CdpNowUs();
+    snprintf(agent->waitHost, sizeof(agent->waitHost), "%s", host);
+
+    int best = -1, bestSlot = -1;
+    for (int u = 0; u < broker->upstreamCount && u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        const CdpBrokerUpstream* up = &broker->upstreams[u];
+        if (up->state != CDP_LINK_UP || (best >= 0 && up->tabsReady <= broker->upstreams[best].tabsReady)) continue;
+        for (int i = 0; i < CDP_BROKER_TAB_SLOTS; i++) {
+            if (up->tabs[i].state == CDP_TAB_READY && (!url[0] || strcmp(up->tabs[i].url, url) == 0)) {
+                best = u;
+                bestSlot = i;
+                break;
+            }
+        }
+    }
+    if (best >= 0) {
+        CdpBrokerTabLease(broker, index, best, bestSlot, 1);
+        return;
+    }
+
+    int u = -1, slot = -1;
+    for (int v = 0; v < broker->upstreamCount && v < CDP_BROKER_MAX_UPSTREAMS && slot < 0; v++) {
+        const CdpBrokerUpstream* up = &broker->upstreams[v];
+        for (int i = 0; up->state == CDP_LINK_UP && i < CDP_BROKER_TAB_SLOTS && slot < 0; i++) {
+            const CdpBrokerTab* tab = &up->tabs[i];
+            if ((tab->state == CDP_TAB_CREATING || tab->state == CDP_TAB_CREATED || CdpBrokerTabLoading(tab)) &&
+                (!url[0] || strcmp(tab->url, url) == 0) && !CdpBrokerTabWaiting(broker, tab, v, i)) {
+                u = v;
+                slot = i;
+            }
+        }
+    }
+    if (slot < 0) {
+        u = CdpBrokerPickUpstream(broker);
+        const char* startUrl = url[0] ? url : broker->tabUrlCount ? broker->tabUrls[0] : "";
+        for (int i = 0; u >= 0 && i < CDP_BROKER_TAB_SLOTS && slot < 0; i++) {
+            if (broker->upstreams[u].tabs[i].state == CDP_TAB_FREE && CdpBrokerTabCreate(&broker->upstreams[u], i, startUrl)) {
+                slot = i;
+            }
+        }
+    }
+    if (slot < 0) {
+        CdpBrokerRespond(agent, 503, "Service Unavailable", "text/plain",
+                         u >= 0 ? "No tab available\n" : "No browser connected\n");
+        return;
+    }
+    broker->upstreams[u].tabs[slot].waiter = index;
+    broker->upstreams[u].tabs[slot].waiterSerial = agent->serial;
+    agent->state = CDP_BROKER_AGENT_WAITING_TAB;
+    agent->waitUpstream = u;
+    agent->waitSlot = slot;
+}
+
+// GET /json/tab/release/<targetId>?token=<token>: the tab is closed and replaced
+static void CdpBrokerTabRelease(CdpBroker* broker, int index, const char* targetId, const char* query) {
+    for (int u = 0; u < broker->upstreamCount && u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        CdpBrokerUpstream* up = &broker->upstreams[u];
+        int slot = up->state == CDP_LINK_UP ? CdpBrokerTabFind(up, targetId) : -1;
+        if (slot < 0 || up->tabs[slot].state != CDP_TAB_LEASED) continue;
+
+        if (!CdpBrokerTokenMatches(query, up->tabs[slot].token)) {
+            CdpBrokerRespond(&broker->agents[index], 403, "Forbidden", "text/plain", "Wrong or missing lease token\n");
+            return;
+        }
+        CdpBrokerTabClose(up, slot);
+        CdpBrokerRespond(&broker->agents[index], 200, "OK", "application/json; charset=UTF-8", "{}");
+        return;
+    }
+    CdpBrokerRespond(&broker->agents[index], 404, "Not Found", "text/plain", "No such leased tab\n");
+}
+
+static void CdpBrokerCloseAgent(CdpBroker* broker, int index) {
+    CdpBrokerAgent* agent = &broker->agents[index];
+
+    if (agent->upstream >= 0) {
+        // Release what the agent leaves behind, so its targets don't stay
+        // attached and its contexts don't stay open. The sessions are
+        // forgotten when Chrome reports them detached.
+        CdpBrokerUpstream* up = &broker->upstreams[agent->upstream];
+        for (int i = 0; i < CDP_BROKER_MAX_SESSIONS && up->state == CDP_LINK_UP; i++) {
+            const CdpBrokerSession* session = &up->sessions[i];
+            if (session->sessionId[0] && session->agent == index && session->agentSerial == agent->serial) {
+                CdpBrokerCall(up, "Target.detachFromTarget", "sessionId", session->sessionId);
+            }
+        }
+        for (int i = 0; i < agent->contextCount; i++) {
+            int slot = CdpBrokerPoolFind(up, agent->contexts[i]);
+            if (slot < 0) {
+                CdpBrokerCall(up, "Target.disposeBrowserContext", "browserContextId", agent->contexts[i]);
+            } else if (up->pool[slot].state == CDP_POOL_LEASED) {
+                CdpBrokerPoolDispose(up, slot);
+            }
+        }
+        for (int i = 0; i < CDP_BROKER_TAB_SLOTS; i++) {
+            const CdpBrokerTab* tab = &up->tabs[i];
+            if (tab->state == CDP_TAB_LEASED && tab->owner == index && tab->ownerSerial == agent->serial) {
+                CdpBrokerTabClose(up, i);
+            }
+        }
+        if (up->autoAttachAgent == index) up->autoAttachAgent = -1;
+        up->agentCount--;
+        broker->agentCount--;
+    }
+
+    CdpWsClose(&agent->ws);
+    CdpBrokerFreeOutput(&agent->out);
+    memset(agent, 0, sizeof(*agent));
+    CdpWsInit(&agent->ws);
+    agent->upstream = -1;
+}
+
+// ----------------------------------------------------------------------------
+// Routing
+// ----------------------------------------------------------------------------
+
+static void CdpBrokerReply(CdpBroker* broker, CdpBrokerAgent* agent, long id, int code, const char* text) {
+    char reply[256];
+    int len = code
+        ? snprintf(reply, sizeof(reply), "{\"id\":%ld,\"error\":{\"code\":%d,\"message\":\"%s\"}}", id, code, text)
+        : snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{}}", id);
+    if (len > 0 && len < (int)sizeof(reply)) CdpBrokerSend(agent, reply, (size_t)len, NULL, 0, NULL, 0);
+    if (code) broker->refused++;
+}
+
+static void CdpBrokerAgentMessage(CdpBroker* broker, int index, const char* message, size_t length) {
+    CdpBrokerAgent* agent = &broker->agents[index];
+    CdpBrokerUpstream* up = &broker->upstreams[agent->upstream];
+
+    CdpBrokerMessage fields;
+    CdpBrokerParseMessage(message, &fields);
+    if (!fields.id || !fields.method[0]) {
+        static const char invalid[] =
+            "{\"error\":{\"code\":-32600,\"message\":\"Message must have integer 'id' and string 'method' properties\"}}";
+        CdpBrokerSend(agent, invalid, sizeof(invalid) - 1, NULL, 0, NULL, 0);
+        broker->refused++;
+        return;
+    }
+
+    int kind = CDP_BROKER_CALL_PLAIN;
+    char resource[64] = "";  // Target or context the call is about
+    int slot = -1;           // ... its pool slot
+    if (fields.sessionId[0]) {
+        // Sessions of other agents don't exist as far as this one is concerned
+        if (CdpBrokerSessionOwner(broker, CdpBrokerFindSession(up, fields.sessionId)) != index) {
+            CdpBrokerReply(broker, agent, fields.idValue, -32001, "Session with given id not found.");
+            return;
+        }
+    } else {
+        if (strcmp(fields.method, "Browser.close") == 0 || strcmp(fields.method, "Browser.crash") == 0) {
+            CdpBrokerReply(broker, agent, fields.idValue, -32000, "Not allowed: the browser is shared by the broker");
+            return;
+        }
+        if (strcmp(fields.method, "Target.setDiscoverTargets") == 0) {
+            // Discovery stays on for the others; events only go to agents that asked
+            const char* discover = NULL;
+            agent->discover = fields.params && CdpJsonFindMember(fields.params, "discover", &discover) > 0 &&
+                              *discover == 't';
+            if (!agent->discover) {
+                CdpBrokerReply(broker, agent, fields.idValue, 0, NULL);
+                return;
+            }
+        } else if (strcmp(fields.method, "Target.setAutoAttach") == 0) {
+            up->autoAttachAgent = index;
+            up->autoAttachSerial = agent->serial;
+        } else if (strcmp(fields.method, "Target.attachToTarget") == 0) {
+            kind = CDP_BROKER_CALL_ATTACH;
+            if (fields.params) CdpJsonMemberString(fields.params, "targetId", resource, sizeof(resource));
+        } else if (strcmp(fields.method, "Target.createBrowserContext") == 0) {
+            kind = CDP_BROKER_CALL_CREATE_CONTEXT;
+        } else if (strcmp(fields.method, "Target.disposeBrowserContext") == 0) {
+            // Contexts of other agents aren't this one's to dispose, pooled
+            // ones only while it holds the lease; it keeps a context, and
+            // the pool its slot, until Chrome confirms
+            if (fields.params) CdpJsonMemberString(fields.params, "browserContextId", resource, sizeof(resource));
+            slot = resource[0] ? CdpBrokerPoolFind(up, resource) : -1;
+            int holder = resource[0] ? CdpBrokerContextOwner(broker, agent->upstream, resource) : -1;
+            const CdpBrokerPoolContext* context = slot >= 0 ? &up->pool[slot] : NULL;
+            if (context ? context->state != CDP_POOL_LEASED || context->owner != index ||
+                              context->ownerSerial != agent->serial
+                        : holder >= 0 && holder != index) {
+                char text[128];
+                snprintf(text, sizeof(text), "Failed to find context with id %s", resource);
+                CdpBrokerReply(broker, agent, fields.idValue, -32602, text);
+                return;
+            }
+            kind = CDP_BROKER_CALL_DISPOSE_CONTEXT;
+        } else if (strcmp(fields.method, "Target.closeTarget") == 0) {
+            // Pooled tabs are only the agent's to close while it holds the
+            // lease; the slot is freed once Chrome confirms
+            slot = fields.params && CdpJsonMemberString(fields.params, "targetId", resource, sizeof(resource))
+                       ? CdpBrokerTabFind(up, resource)
+                       : -1;
+            if (slot >= 0) {
+                const CdpBrokerTab* tab = &up->tabs[slot];
+                if (tab->state != CDP_TAB_LEASED || tab->owner != index || tab->ownerSerial != agent->serial) {
+                    CdpBrokerReply(broker, agent, fields.idValue, -32602, "No target with given id found");
+                    return;
+                }
+                kind = CDP_BROKER_CALL_CLOSE_TAB;
+            }
+        }
+        CdpBrokerSubscribe(agent, fields.method);
+    }
+
+    CdpBrokerPending* pending = CdpBrokerReserve(up);
+    if (!pending) {
+        CdpBrokerReply(broker, agent, fields.idValue, -32000, "Too many commands in flight");
+        return;
+    }
+    pending->agent = index;
+    pending->agentSerial = agent->serial;
+    pending->agentId = fields.idValue;
+    pending->kind = kind;
+    memcpy(pending->resource, resource, sizeof(resource));
+    pending->slot = slot;
+    if (kind == CDP_BROKER_CALL_CLOSE_TAB) up->tabs[slot].state = CDP_TAB_CLOSING;
+    if (kind == CDP_BROKER_CALL_DISPOSE_CONTEXT && slot >= 0) up->pool[slot].state = CDP_POOL_DISPOSING;
+
+    // The same message with the upstream's id in place of the agent's
+    char id[24];
+    int idLen = snprintf(id, sizeof(id), "%ld", pending->upstreamId);
+    size_t headLen = (size_t)(fields.id - message);
+    if (!CdpBrokerUpstreamSend(up, message, headLen, id, (size_t)idLen, fields.id + fields.idLen,
+                               length - headLen - fields.idLen)) {
+        pending->upstreamId = 0;
+        return;
+    }
+    broker->messagesIn++;
+}
+
+// A browser-level Target.attachedToTarget belongs to the agent attaching that
+// target, else to the agent that created the target's browser context, else
+// to the agent that set up auto-attach. Pooled tabs and pages of pooled
+// contexts belong to no one until handed out, then to the agent the lease
+// is bound to, if any.
+static int CdpBrokerAttachOwner(CdpBroker* broker, CdpBrokerUpstream* up, const char* params) {
+    const char* info = NULL;
+    char targetId[64] = "";
+    char contextId[64] = "";
+    if (CdpJsonFindMember(params, "targetInfo", &info) > 0) {
+        CdpJsonMemberString(info, "targetId", targetId, sizeof(targetId));
+        CdpJsonMemberString(info, "browserContextId", contextId, sizeof(contextId));
+    }
+
+    if (targetId[0]) {
+        for (int i = 0; i < CDP_BROKER_MAX_PENDING; i++) {
+            const CdpBrokerPending* pending = &up->pending[i];
+            if (pending->upstreamId != 0 && pending->kind == CDP_BROKER_CALL_ATTACH &&
+                strcmp(pending->resource, targetId) == 0 &&
+                CdpBrokerAgentAlive(broker, pending->agent, pending->agentSerial)) {
+                return pending->agent;
+            }
+        }
+        int slot = CdpBrokerTabFind(up, targetId);
+        if (slot >= 0) {
+            const CdpBrokerTab* tab = &up->tabs[slot];
+            if (tab->state != CDP_TAB_LEASED) return -1;
+            if (CdpBrokerAgentAlive(broker, tab->owner, tab->ownerSerial)) return tab->owner;
+        }
+    }
+    if (contextId[0]) {
+        int holder = CdpBrokerContextOwner(broker, (int)(up - broker->upstreams), contextId);
+        if (holder >= 0) return holder;
+        int slot = CdpBrokerPoolFind(up, contextId);
+        if (slot >= 0 && up->pool[slot].state != CDP_POOL_LEASED) return -1;
+    }
+    return CdpBrokerAgentAlive(broker, up->autoAttachAgent, up->autoAttachSerial) ? up->autoAttachAgent : -1;
+}
+
+static void CdpBrokerDeliver(CdpBroker* broker, int index, const char* message, size_t length) {
+    CdpBrokerSend(&broker->agents[index], message, length, NULL, 0, NULL, 0);
+    broker->messagesOut++;
+}
+
+static void CdpBrokerUpstreamMessage(CdpBroker* broker, int u, const char* message, size_t length) {
+    CdpBrokerUpstream* up = &broker->upstreams[u];
+    CdpBrokerMessage fields;
+    CdpBrokerParseMessage(message, &fields);
+
+    if (fields.id) {
+        CdpBrokerPending* slot = &up->pending[fields.idValue & (CDP_BROKER_MAX_PENDING - 1)];
+        if (slot->upstreamId != fields.idValue) return;
+        CdpBrokerPending call = *slot;
+        slot->upstreamId = 0;
+        if (call.kind >= CDP_BROKER_CALL_TAB_CREATE) {
+            CdpBrokerTabResult(broker, u, &call, fields.result);
+            return;
+        }
+        if (call.kind >= CDP_BROKER_CALL_POOL_CONTEXT) {
+            CdpBrokerPoolResult(broker, u, &call, fields.result);
+            return;
+        }
+
+        int owner = CdpBrokerAgentAlive(broker, call.agent, call.agentSerial) ? call.agent : -1;
+        char value[64];
+        if (call.kind == CDP_BROKER_CALL_ATTACH && fields.result &&
+            CdpJsonMemberString(fields.result, "sessionId", value, sizeof(value))) {
+            if (owner < 0 || !CdpBrokerAddSession(up, value, owner, call.agentSerial)) {
+                CdpBrokerCall(up, "Target.detachFromTarget", "sessionId", value);
+            }
+        } else if (call.kind == CDP_BROKER_CALL_CLOSE_TAB) {
+            // Kept leased if Chrome refused, unless its agent is gone meanwhile
+            CdpBrokerTab* tab = &up->tabs[call.slot];
+            if (tab->state == CDP_TAB_CLOSING && strcmp(tab->targetId, call.resource) == 0) {
+                if (fields.result) {
+                    CdpBrokerTabFree(tab);
+                } else if (owner >= 0) {
+                    tab->state = CDP_TAB_LEASED;
+                } else {
+                    CdpBrokerTabClose(up, call.slot);
+                }
+            }
+        } else if (call.kind == CDP_BROKER_CALL_DISPOSE_CONTEXT) {
+            // Likewise a pooled context
+            if (fields.result && owner >= 0) CdpBrokerForgetContext(&broker->agents[owner], call.resource);
+            CdpBrokerPoolContext* context = call.slot >= 0 ? &up->pool[call.slot] : NULL;
+            if (context && context->state == CDP_POOL_DISPOSING && strcmp(context->contextId, call.resource) == 0) {
+                if (fields.result) {
+                    context->state = CDP_POOL_FREE;
+                } else if (owner >= 0) {
+                    context->state = CDP_POOL_LEASED;
+                } else {
+                    CdpBrokerPoolDispose(up, call.slot);
+                }
+            }
+        } else if (call.kind == CDP_BROKER_CALL_CREATE_CONTEXT && fields.result &&
+                   CdpJsonMemberString(fields.result, "browserContextId", value, sizeof(value))) {
+            CdpBrokerAgent* agent = owner >= 0 ? &broker->agents[owner] : NULL;
+            if (agent && agent->contextCount < CDP_BROKER_MAX_CONTEXTS) {
+                memcpy(agent->contexts[agent->contextCount++], value, sizeof(value));
+            } else if (!agent) {
+                CdpBrokerCall(up, "Target.disposeBrowserContext", "browserContextId", value);
+            }
+        }
+        if (owner < 0) return;
+
+        // Back to the agent's own id
+        char id[24];
+        int idLen = snprintf(id, sizeof(id), "%ld", call.agentId);
+        size_t headLen = (size_t)(fields.id - message);
+        CdpBrokerSend(&broker->agents[owner], message, headLen, id, (size_t)idLen,
+                      fields.id + fields.idLen, length - headLen - fields.idLen);
+        broker->messagesOut++;
+        return;
+    }
+
+    if (!fields.method[0]) return;
+    char inner[CDP_SESSION_ID_MAX] = "";  // Session an event of the browser endpoint is about
+    if (fields.params) CdpJsonMemberString(fields.params, "sessionId", inner, sizeof(inner));
+
+    int owner = fields.sessionId[0] ? CdpBrokerSessionOwner(broker, CdpBrokerFindSession(up, fields.sessionId)) : -1;
+    if (strcmp(fields.method, "Target.attachedToTarget") == 0 && inner[0]) {
+        // Auto-attached children of a session belong to the session's owner
+        if (!fields.sessionId[0]) owner = CdpBrokerAttachOwner(broker, up, fields.params);
+        if (owner < 0 || !CdpBrokerAddSession(up, inner, owner, broker->agents[owner].serial)) {
+            CdpBrokerCall(up, "Target.detachFromTarget", "sessionId", inner);
+            return;
+        }
+    } else if (strcmp(fields.method, "Target.detachedFromTarget") == 0 && inner[0]) {
+        CdpBrokerSession* session = CdpBrokerFindSession(up, inner);
+        if (!fields.sessionId[0]) owner = CdpBrokerSessionOwner(broker, session);
+        if (session) CdpBrokerRemoveSession(up, session);
+    } else if (!fields.sessionId[0] && inner[0]) {
+        // Target.receivedMessageFromTarget and the like
+        owner = CdpBrokerSessionOwner(broker, CdpBrokerFindSession(up, inner));
+    } else if (!fields.sessionId[0]) {
+        // Plain browser-level event: discovery events to the agents that
+        // enabled discovery, the rest by domain
+        int discovery = strncmp(fields.method, "Target.target", 13) == 0;
+        for (int a = 0; a < CDP_BROKER_MAX_AGENTS; a++) {
+            const CdpBrokerAgent* agent = &broker->agents[a];
+            if (agent->state != CDP_BROKER_AGENT_OPEN || agent->upstream != u) continue;
+            if (discovery ? agent->discover : CdpBrokerSubscribed(agent, fields.method)) {
+                CdpBrokerDeliver(broker, a, message, length);
+            }
+        }
+        return;
+    }
+
+    if (owner >= 0) CdpBrokerDeliver(broker, owner, message, length);
+}
+
+// ----------------------------------------------------------------------------
+// Connections
+// ----------------------------------------------------------------------------
+
+// Connecting to a browser runs in the loop like everything else: GET
+// /json/version, then the handshake on the browser endpoint it names, each
+// on a connection of its own and bounded by CDP_BROKER_CONNECT_TIMEOUT_MS
+static int CdpBrokerDialStart(CdpBrokerUpstream* up, int step, const char* request, size_t len) {
+    CdpWsClose(&up->ws);
+    up->out.head = up->out.len = 0;
+    up->dial = step;
+    up->dialDeadlineUs = CdpNowUs() + CDP_BROKER_CONNECT_TIMEOUT_MS * 1000ULL;
+    if (CdpConnectStart(up->host, up->port, &up->ws.sock) != CDP_OK) return 0;
+#ifndef _WIN32
+    if ((int)up->ws.sock >= FD_SETSIZE) return 0;
+#endif
+    return CdpBrokerQueue(&up->out, -1, 0, request, len, NULL, 0, NULL, 0);
+}
+
+static void CdpBrokerDialStop(CdpBrokerUpstream* up) {
+    if (up->dial == CDP_BROKER_DIAL_NONE) return;
+    CdpWsClose(&up->ws);
+    up->out.head = up->out.len = 0;
+    up->dial = CDP_BROKER_DIAL_NONE;
+}
+
+static void CdpBrokerDialFailed(CdpBrokerUpstream* up) {
+    CdpBrokerDialStop(up);
+    up->retryUs = CdpNowUs() + (unsigned long long)up->retryDelayMs * 1000ULL;
+    if (up->retryDelayMs < CDP_BROKER_RETRY_MS * 8) up->retryDelayMs *= 2;
+}
+
+static void CdpBrokerConnectUpstream(CdpBrokerUpstream* up) {
+    char request[256];
+    int len = snprintf(request, sizeof(request),
+                       "GET /json/version HTTP/1.1\r\nHost: %s:%d\r\nConnection: close\r\n\r\n", up->host, up->port);
+    if (len < 0 || len >= (int)sizeof(request) ||
+        !CdpBrokerDialStart(up, CDP_BROKER_DIAL_VERSION, request, (size_t)len)) {
+        CdpBrokerDialFailed(up);
+    }
+}
+
+// Moves a connection attempt on once its socket is ready (or failed)
+static void CdpBrokerDialStep(CdpBrokerUpstream* up, int ready, int failed) {
+    int rc = failed ? -1 : 0;
+    if (rc == 0 && ready) {
+        rc = CdpConnected(up->ws.sock) && CdpBrokerFlushOutput(up->ws.sock, &up->out)
+                 ? CdpBrokerDialRead(&up->ws, up->dial == CDP_BROKER_DIAL_VERSION)
+                 : -1;
+    }
+    if (rc == 0) return;
+
+    char* response = (char*)up->ws.rx;
+    if (rc > 0 && up->dial == CDP_BROKER_DIAL_VERSION) {
+        char path[256];
+        char request[768];
+        int status = 0;
+        int len = -1;
+        if (sscanf(response, "HTTP/1.%*d %d", &status) == 1 && status == 200 &&
+            CdpParseBrowserVersion(strstr(response, "\r\n\r\n") + 4, path, sizeof(path), up->browser,
+                                   sizeof(up->browser)) == CDP_OK) {
+            len = CdpWsHandshake(&up->ws, up->host, up->port, path, request, sizeof(request));
+        }
+        if (len >= 0 && CdpBrokerDialStart(up, CDP_BROKER_DIAL_UPGRADE, request, (size_t)len)) return;
+    } else if (rc > 0 && CdpWsAccepted(&up->ws, response, up->ws.rxLen) == CDP_OK) {
+        up->dial = CDP_BROKER_DIAL_NONE;
+        up->state = CDP_LINK_UP;
+        up->nextId = 0;
+        up->retryDelayMs = CDP_BROKER_RETRY_MS;
+        up->autoAttachAgent = -1;
+        return;
+    }
+    CdpBrokerDialFailed(up);
+}
+
+// Sessions and calls in flight die with the connection, and so does what its
+// agents know about the browser - they are closed and reconnect
+static void CdpBrokerDropUpstream(CdpBroker* broker, int u) {
+    CdpBrokerUpstream* up = &broker->upstreams[u];
+    if (up->state == CDP_LINK_UP) up->disconnects++;
+    up->state = CDP_LINK_DOWN;
+    CdpWsClose(&up->ws);
+    up->out.head = up->out.len = 0;
+
+    for (int a = 0; a < CDP_BROKER_MAX_AGENTS; a++) {
+        CdpBrokerAgent* agent = &broker->agents[a];
+        if ((agent->state == CDP_BROKER_AGENT_WAITING || agent->state == CDP_BROKER_AGENT_WAITING_TAB) &&
+            agent->waitUpstream == u) {
+            CdpBrokerRespond(agent, 503, "Service Unavailable", "text/plain", "Browser disconnected\n");
+        } else if (agent->state != CDP_BROKER_AGENT_FREE && agent->upstream == u) {
+            CdpBrokerCloseAgent(broker, a);
+        }
+    }
+    memset(up->pending, 0, sizeof(CdpBrokerPending) * CDP_BROKER_MAX_PENDING);
+    memset(up->sessions, 0, sizeof(CdpBrokerSession) * CDP_BROKER_MAX_SESSIONS);
+    memset(up->pool, 0, sizeof(CdpBrokerPoolContext) * CDP_BROKER_POOL_SLOTS);
+    for (int i = 0; i < CDP_BROKER_TAB_SLOTS; i++) CdpBrokerTabFree(&up->tabs[i]);
+    up->sessionCount = 0;
+    up->poolReady = up->poolLeased = 0;
+    up->tabsReady = up->tabsLeased = 0;
+    up->autoAttachAgent = -1;
+}
+
+// Sends what is queued and reads answers until no call is in flight, so
+// cleanup calls made just before stopping aren't lost with the connection,
+// or until deadline
+static void CdpBrokerSettle(CdpBroker* broker, unsigned long long deadline) {
+    for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        CdpBrokerUpstream* up = &broker->upstreams[u];
+        if (up->state == CDP_LINK_UP && up->out.head < up->out.len &&
+            CdpSendAll(up->ws.sock, up->out.data + up->out.head, up->out.len - up->out.head, deadline) != CDP_OK) {
+            continue;
+        }
+        up->out.head = up->out.len = 0;
+        for (;;) {
+            int waiting = 0;
+            for (int i = 0; up->pending && i < CDP_BROKER_MAX_PENDING && !waiting; i++) {
+                waiting = up->pending[i].upstreamId != 0;
+            }
+            unsigned long long now = CdpNowUs();
+            if (!waiting || up->state != CDP_LINK_UP || now >= deadline) break;
+
+            const char* message = NULL;
+            int received = CdpWsReceive(&up->ws, (int)((deadline - now) / 1000) + 1, &message);
+            if (received < 0) break;
+            CdpBrokerMessage fields;
+            CdpBrokerParseMessage(message, &fields);
+            CdpBrokerPending* pending = &up->pending[fields.idValue & (CDP_BROKER_MAX_PENDING - 1)];
+            if (fields.id && pending->upstreamId == fields.idValue) pending->upstreamId = 0;
+        }
+    }
+}
+
+// Host the agent reached us on, for the endpoint we advertise
+static void CdpBrokerRequestHost(CdpBroker* broker, const char* headers, char* host, size_t hostLen) {
+    const char* value = CdpFindHeader(headers, "Host");
+    size_t len = 0;
+    while (value && value[len] && value[len] != '\r' && len < hostLen - 1) {
+        char c = value[len];
+        if (!isalnum((unsigned char)c) && c != '.' && c != ':' && c != '-' && c != '[' && c != ']') break;
+        len++;
+    }
+    if (value && len > 0 && (value[len] == '\r' || value[len] == '\0')) {
+        memcpy(host, value, len);
+        host[len] = '\0';
+    } else {
+        snprintf(host, hostLen, "%s:%d", strcmp(broker->listenHost, "0.0.0.0") == 0 ? "127.0.0.1" : broker->listenHost,
+                 broker->listenPort);
+    }
+}
+
+// Reads the request head of a new connection and answers it: /json/version
+// advertises the broker as the browser endpoint, /json/context/* and
+// /json/tab/* serve the pools, a WebSocket upgrade pins the agent to an
+// upstream - the one in the path for
+// /devtools/browser/broker/<upstream>[/<leased context or tab>]
+static void CdpBrokerReadRequest(CdpBroker* broker, int index) {
+    CdpBrokerAgent* agent = &broker->agents[index];
+    CdpWebSocket* ws = &agent->ws;
+
+    int n = recv(ws->sock, (char*)ws->rx + ws->rxLen, (int)(CDP_HTTP_HEADER_MAX - 1 - ws->rxLen), 0);
+    if (n <= 0) {
+        if (n < 0 && CdpWouldBlock()) return;
+        CdpBrokerCloseAgent(broker, index);
+        return;
+    }
+    ws->rxLen += (size_t)n;
+    ws->rx[ws->rxLen] = '\0';
+
+    char* headers = (char*)ws->rx;
+    char* headerEnd = strstr(headers, "\r\n\r\n");
+    if (!headerEnd) {
+        if (ws->rxLen >= CDP_HTTP_HEADER_MAX - 1) CdpBrokerCloseAgent(broker, index);
+        return;
+    }
+    headerEnd[2] = '\0';  // Header lookups stop here
+
+    char path[2048] = "";
+    if (strncmp(headers, "GET ", 4) != 0 || sscanf(headers + 4, "%2047s", path) != 1) {
+        CdpBrokerRespond(agent, 405, "Method Not Allowed", "text/plain", "Only GET is supported\n");
+        return;
+    }
+    char* query = strchr(path, '?');
+    if (query) *query++ = '\0';
+
+    if (!CdpHeaderHasToken(CdpFindHeader(headers, "Upgrade"), "websocket")) {
+        char host[CDP_HOST_MAX + 8];
+        CdpBrokerRequestHost(broker, headers, host, sizeof(host));
+        if (strcmp(path, "/json/context/new") == 0) {
+            CdpBrokerPoolAllocate(broker, index, host);
+            return;
+        }
+        if (strncmp(path, "/json/context/release/", 22) == 0) {
+            CdpBrokerPoolRelease(broker, index, path + 22, query);
+            return;
+        }
+        if (strcmp(path, "/json/tab/new") == 0) {
+            CdpBrokerTabAllocate(broker, index, query, host);
+            return;
+        }
+        if (strncmp(path, "/json/tab/release/", 18) == 0) {
+            CdpBrokerTabRelease(broker, index, path + 18, query);
+            return;
+        }
+        if (strcmp(path, "/json/version") != 0 && strcmp(path, "/json/version/") != 0) {
+            CdpBrokerRespond(agent, 404, "Not Found", "text/plain", "Not found\n");
+            return;
+        }
+        char body[512];
+        int u = CdpBrokerPickUpstream(broker);
+        snprintf(body, sizeof(body),
+                 "{\"Browser\":\"%s\",\"Protocol-Version\":\"1.3\","
+                 "\"webSocketDebuggerUrl\":\"ws://%s/devtools/browser/broker\"}",
+                 u >= 0 ? broker->upstreams[u].browser : "", host);
+        CdpBrokerRespond(agent, 200, "OK", "application/json; charset=UTF-8", body);
+        return;
+    }
+
+    // Page endpoints would need a session per connection - agents attach
+    // through the browser endpoint instead
+    if (strncmp(path, "/devtools/page/", 15) == 0) {
+        CdpBrokerRespond(agent, 404, "Not Found", "text/plain", "Only the browser endpoint is brokered\n");
+        return;
+    }
+
+    char key[64];
+    const char* keyValue = CdpFindHeader(headers, "Sec-WebSocket-Key");
+    size_t keyLen = 0;
+    while (keyValue && keyValue[keyLen] && keyValue[keyLen] != '\r' && keyValue[keyLen] != ' ' &&
+           keyLen < sizeof(key) - 1) {
+        key[keyLen] = keyValue[keyLen];
+        keyLen++;
+    }
+    key[keyLen] = '\0';
+    int u = CdpBrokerPickUpstream(broker);
+    const char* contextId = NULL;
+    if (strncmp(path, "/devtools/browser/broker/", 25) == 0) {
+        char* end = NULL;
+        long pinned = strtol(path + 25, &end, 10);
+        u = end != path + 25 && pinned >= 0 && pinned < broker->upstreamCount && pinned < CDP_BROKER_MAX_UPSTREAMS &&
+                    broker->upstreams[pinned].state == CDP_LINK_UP
+                ? (int)pinned
+                : -1;
+        if (*end == '/') contextId = end + 1;
+    }
+    if (keyLen == 0 || u < 0) {
+        CdpBrokerRespond(agent, keyLen == 0 ? 400 : 503, keyLen == 0 ? "Bad Request" : "Service Unavailable",
+                         "text/plain", keyLen == 0 ? "Missing Sec-WebSocket-Key\n" : "No browser connected\n");
+        return;
+    }
+
+    // A leased context or tab named in the path is bound to this agent: it
+    // is attached for it, and recycled when the agent disconnects
+    CdpBrokerPoolContext* leased = NULL;
+    CdpBrokerTab* leasedTab = NULL;
+    if (contextId) {
+        CdpBrokerUpstream* up = &broker->upstreams[u];
+        int slot = CdpBrokerPoolFind(up, contextId);
+        int tabSlot = CdpBrokerTabFind(up, contextId);
+        leased = slot >= 0 && up->pool[slot].state == CDP_POOL_LEASED ? &up->pool[slot] : NULL;
+        leasedTab = tabSlot >= 0 && up->tabs[tabSlot].state == CDP_TAB_LEASED ? &up->tabs[tabSlot] : NULL;
+        if (!leased && !leasedTab) {
+            CdpBrokerRespond(agent, 404, "Not Found", "text/plain", "No such lease\n");
+            return;
+        }
+        if ((leased && !CdpBrokerTokenMatches(query, leased->token)) ||
+            (leasedTab && !CdpBrokerTokenMatches(query, leasedTab->token))) {
+            CdpBrokerRespond(agent, 403, "Forbidden", "text/plain", "Wrong or missing lease token\n");
+            return;
+        }
+        if ((leased && CdpBrokerAgentAlive(broker, leased->owner, leased->ownerSerial)) ||
+            (leasedTab && CdpBrokerAgentAlive(broker, leasedTab->owner, leasedTab->ownerSerial))) {
+            CdpBrokerRespond(agent, 409, "Conflict", "text/plain", "The lease is bound to another connection\n");
+            return;
+        }
+    }
+
+    char input[128];
+    unsigned char digest[20];
+    char accept[32];
+    snprintf(input, sizeof(input), "%s258EAFA5-E914-47DA-95CA-C5AB0DC85B11", key);
+    CdpSha1((const unsigned char*)input, strlen(input), digest);
+    CdpBase64(digest, sizeof(digest), accept);
+
+    char response[256];
+    int responseLen = snprintf(response, sizeof(response),
+                               "HTTP/1.1 101 Switching Protocols\r\n"
+                               "Upgrade: websocket\r\n"
+                               "Connection: Upgrade\r\n"
+                               "Sec-WebSocket-Accept: %s\r\n\r\n",
+                               accept);
+    if (!CdpBrokerQueue(&agent->out, -1, 0, response, (size_t)responseLen, NULL, 0, NULL, 0)) {
+        CdpBrokerCloseAgent(broker, index);
+        return;
+    }
+
+    // Frames may already have arrived behind the request
+    size_t consumed = (size_t)(headerEnd + 4 - headers);
+    memmove(ws->rx, ws->rx + consumed, ws->rxLen - consumed);
+    ws->rxLen -= consumed;
+
+    agent->state = CDP_BROKER_AGENT_OPEN;
+    agent->upstream = u;
+    broker->upstreams[u].agentCount++;
+    broker->agentCount++;
+    if (leased) {
+        memcpy(agent->contexts[agent->contextCount++], leased->contextId, sizeof(agent->contexts[0]));
+        leased->owner = index;
+        leased->ownerSerial = agent->serial;
+    }
+    if (leasedTab) {
+        leasedTab->owner = index;
+        leasedTab->ownerSerial = agent->serial;
+    }
+}
+
+static void CdpBrokerAccept(CdpBroker* broker) {
+    for (;;) {
+        CdpSocket s = accept(broker->listener, NULL, NULL);
+        if (s == CDP_INVALID_SOCKET) return;  // Nothing left to accept
+
+        int index = -1;
+        for (int i = 0; i < CDP_BROKER_MAX_AGENTS && index < 0; i++) {
+            if (broker->agents[i].state == CDP_BROKER_AGENT_FREE) index = i;
+        }
+#ifndef _WIN32
+        if ((int)s >= FD_SETSIZE) index = -1;
+#endif
+        CdpBrokerAgent* agent = index >= 0 ? &broker->agents[index] : NULL;
+        if (!agent || !CdpSetNonBlocking(s) ||
+            !CdpGrow((void**)&agent->ws.rx, &agent->ws.rxCap, CDP_HTTP_HEADER_MAX)) {
+            CdpCloseSocket(s);
+            continue;
+        }
+
+        int noDelay = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+        agent->ws.sock = s;
+        agent->ws.rxLen = 0;
+        agent->state = CDP_BROKER_AGENT_HTTP;
+        agent->serial = ++broker->nextSerial;
+        agent->upstream = -1;
+        broker->agentsAccepted++;
+    }
+}
+
+static int CdpBrokerListen(CdpBroker* broker) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((unsigned short)broker->listenPort);
+    if (inet_pton(AF_INET, broker->listenHost, &addr.sin_addr) != 1) return 0;
+
+    CdpSocket s = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == CDP_INVALID_SOCKET) return 0;
+
+    int on = 1;
+#ifdef _WIN32
+    setsockopt(s, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char*)&on, sizeof(on));
+#else
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, (const char*)&on, sizeof(on));
+#endif
+    if (bind(s, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(s, SOMAXCONN) != 0 ||
+        !CdpSetNonBlocking(s)) {
+        CdpCloseSocket(s);
+        return 0;
+    }
+    broker->listener = s;
+    return 1;
+}
+
+// ----------------------------------------------------------------------------
+// Public
+// ----------------------------------------------------------------------------
+
+void CdpBrokerInit(CdpBroker* broker, const char* listenHost, int listenPort) {
+    memset(broker, 0, sizeof(*broker));
+    snprintf(broker->listenHost, sizeof(broker->listenHost), "%s", listenHost);
+    broker->listenPort = listenPort;
+    broker->listener = CDP_INVALID_SOCKET;
+    for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        CdpBrokerUpstream* up = &broker->upstreams[u];
+        CdpWsInit(&up->ws);
+        up->state = CDP_LINK_DOWN;
+        up->retryDelayMs = CDP_BROKER_RETRY_MS;
+        up->autoAttachAgent = -1;
+    }
+    for (int a = 0; a < CDP_BROKER_MAX_AGENTS; a++) {
+        CdpWsInit(&broker->agents[a].ws);
+        broker->agents[a].upstream = -1;
+    }
+}
+
+int CdpBrokerSetUpstream(CdpBroker* broker, int index, const char* host, int port) {
+    if (index < 0 || index >= CDP_BROKER_MAX_UPSTREAMS) return 1;
+    CdpEndpoint* endpoint = (CdpEndpoint*)malloc(sizeof(CdpEndpoint));
+    if (!endpoint) return 0;
+    snprintf(endpoint->host, sizeof(endpoint->host), "%s", host);
+    endpoint->port = port;
+    free(CdpExchangePointer((void* volatile*)&broker->upstreams[index].retarget, endpoint));
+    return 1;
+}
+
+int CdpBrokerSetTabUrls(CdpBroker* broker, const char* urls) {
+    size_t len = strlen(urls);
+    if (len >= CDP_BROKER_TAB_URL_LIST_MAX) len = CDP_BROKER_TAB_URL_LIST_MAX - 1;
+    char* copy = (char*)malloc(len + 1);
+    if (!copy) return 0;
+    memcpy(copy, urls, len);
+    copy[len] = '\0';
+    free(CdpExchangePointer((void* volatile*)&broker->tabUrlUpdate, copy));
+    return 1;
+}
+
+// Adopts an endpoint handed over by CdpBrokerSetUpstream; a different one
+// drops the connection
+static void CdpBrokerTakeEndpoint(CdpBrokerUpstream* up) {
+    CdpEndpoint* endpoint = (CdpEndpoint*)CdpExchangePointer((void* volatile*)&up->retarget, NULL);
+    if (!endpoint) return;
+    if (endpoint->port != up->port || strcmp(endpoint->host, up->host) != 0) {
+        memcpy(up->host, endpoint->host, sizeof(up->host));
+        up->port = endpoint->port;
+        up->reconnect = 1;
+    }
+    free(endpoint);
+}
+
+// Settings handed over but not taken before the broker stopped
+static void CdpBrokerFreeHandovers(CdpBroker* broker) {
+    for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        free(CdpExchangePointer((void* volatile*)&broker->upstreams[u].retarget, NULL));
+    }
+    free(CdpExchangePointer((void* volatile*)&broker->tabUrlUpdate, NULL));
+}
+
+int CdpBrokerRun(CdpBroker* broker) {
+    if (!CdpBrokerListen(broker)) {
+        CdpBrokerFreeHandovers(broker);
+        return CDP_ERR_CONNECT;
+    }
+
+    int rc = CDP_OK;
+    for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        CdpBrokerUpstream* up = &broker->upstreams[u];
+        up->pending = (CdpBrokerPending*)calloc(CDP_BROKER_MAX_PENDING, sizeof(CdpBrokerPending));
+        up->sessions = (CdpBrokerSession*)calloc(CDP_BROKER_MAX_SESSIONS, sizeof(CdpBrokerSession));
+        up->pool = (CdpBrokerPoolContext*)calloc(CDP_BROKER_POOL_SLOTS, sizeof(CdpBrokerPoolContext));
+        up->tabs = (CdpBrokerTab*)calloc(CDP_BROKER_TAB_SLOTS, sizeof(CdpBrokerTab));
+        for (int i = 0; up->tabs && i < CDP_BROKER_TAB_SLOTS; i++) {
+            CdpWsInit(&up->tabs[i].ws);
+            CdpBrokerTabFree(&up->tabs[i]);
+        }
+        if (!up->pending || !up->sessions || !up->pool || !up->tabs) rc = CDP_ERR_IO;
+    }
+    broker->listening = rc == CDP_OK;
+
+    while (rc == CDP_OK && !broker->stop) {
+        // Follow the configured upstreams
+        unsigned long long now = CdpNowUs();
+        int upstreamCount = broker->upstreamCount;
+        for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+            CdpBrokerUpstream* up = &broker->upstreams[u];
+            CdpBrokerTakeEndpoint(up);
+            if (up->reconnect) {
+                up->reconnect = 0;
+                up->retryUs = 0;
+                up->retryDelayMs = CDP_BROKER_RETRY_MS;
+                if (up->state == CDP_LINK_UP) CdpBrokerDropUpstream(broker, u);
+                CdpBrokerDialStop(up);
+            }
+            if (u >= upstreamCount) {
+                if (up->state == CDP_LINK_UP) CdpBrokerDropUpstream(broker, u);
+                CdpBrokerDialStop(up);
+            } else if (up->dial != CDP_BROKER_DIAL_NONE) {
+                if (now >= up->dialDeadlineUs) CdpBrokerDialFailed(up);
+            } else if (up->state != CDP_LINK_UP && now >= up->retryUs && up->port > 0) {
+                CdpBrokerConnectUpstream(up);
+            }
+        }
+
+        // A connect that fails shows as an exception on Windows, not as writable
+        fd_set readFds, writeFds, errorFds;
+        FD_ZERO(&readFds);
+        FD_ZERO(&writeFds);
+        FD_ZERO(&errorFds);
+        FD_SET(broker->listener, &readFds);
+        int maxFd = (int)broker->listener;
+        for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+            const CdpBrokerUpstream* up = &broker->upstreams[u];
+            if (up->state != CDP_LINK_UP && up->dial == CDP_BROKER_DIAL_NONE) continue;
+            FD_SET(up->ws.sock, &readFds);
+            if (up->out.head < up->out.len) FD_SET(up->ws.sock, &writeFds);
+            if (up->dial != CDP_BROKER_DIAL_NONE) FD_SET(up->ws.sock, &errorFds);
+            if ((int)up->ws.sock > maxFd) maxFd = (int)up->ws.sock;
+            if (up->state != CDP_LINK_UP) continue;
+            for (int i = 0; i < CDP_BROKER_TAB_SLOTS; i++) {
+                const CdpBrokerTab* tab = &up->tabs[i];
+                if (!CdpBrokerTabLoading(tab)) continue;
+                FD_SET(tab->ws.sock, &readFds);
+                if (tab->out.head < tab->out.len) FD_SET(tab->ws.sock, &writeFds);
+                if (tab->state == CDP_TAB_CONNECTING) FD_SET(tab->ws.sock, &errorFds);
+                if ((int)tab->ws.sock > maxFd) maxFd = (int)tab->ws.sock;
+            }
+        }
+        for (int a = 0; a < CDP_BROKER_MAX_AGENTS; a++) {
+            const CdpBrokerAgent* agent = &broker->agents[a];
+            if (agent->state == CDP_BROKER_AGENT_FREE) continue;
+            if (agent->state == CDP_BROKER_AGENT_HTTP || agent->state == CDP_BROKER_AGENT_OPEN) {
+                FD_SET(agent->ws.sock, &readFds);
+            }
+            if (agent->out.head < agent->out.len) FD_SET(agent->ws.sock, &writeFds);
+            if ((int)agent->ws.sock > maxFd) maxFd = (int)agent->ws.sock;
+        }
+
+        struct timeval tv;
+        tv.tv_sec = 0;
+        tv.tv_usec = CDP_BROKER_SLICE_MS * 1000;
+        int ready = select(maxFd + 1, &readFds, &writeFds, &errorFds, &tv);
+        if (ready < 0) {
+#ifndef _WIN32
+            if (errno == EINTR) continue;
+#endif
+            rc = CDP_ERR_IO;
+            break;
+        }
+
+        if (FD_ISSET(broker->listener, &readFds)) CdpBrokerAccept(broker);
+
+        for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+            CdpBrokerUpstream* up = &broker->upstreams[u];
+            if (up->dial != CDP_BROKER_DIAL_NONE) {
+                CdpBrokerDialStep(up, FD_ISSET(up->ws.sock, &readFds) || FD_ISSET(up->ws.sock, &writeFds),
+                                  FD_ISSET(up->ws.sock, &errorFds));
+                continue;
+            }
+            if (up->state != CDP_LINK_UP || !FD_ISSET(up->ws.sock, &readFds)) continue;
+
+            const char* message = NULL;
+            int received = 0;
+            while (!up->reconnect && (received = CdpBrokerReadFrames(&up->ws, &up->out, 1, &message)) == 1) {
+                CdpBrokerUpstreamMessage(broker, u, message, up->ws.msgLen);
+            }
+            if (received < 0 || received == 2) CdpBrokerDropUpstream(broker, u);
+        }
+
+        for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+            CdpBrokerUpstream* up = &broker->upstreams[u];
+            for (int i = 0; i < CDP_BROKER_TAB_SLOTS && up->state == CDP_LINK_UP; i++) {
+                CdpBrokerTab* tab = &up->tabs[i];
+                if (!CdpBrokerTabLoading(tab)) continue;
+                CdpSocket s = tab->ws.sock;
+                if (FD_ISSET(s, &readFds) || FD_ISSET(s, &writeFds) || FD_ISSET(s, &errorFds)) {
+                    CdpBrokerTabProgress(broker, u, i, FD_ISSET(s, &errorFds));
+                }
+            }
+        }
+
+        for (int a = 0; a < CDP_BROKER_MAX_AGENTS; a++) {
+            CdpBrokerAgent* agent = &broker->agents[a];
+            if (agent->state == CDP_BROKER_AGENT_FREE || agent->state == CDP_BROKER_AGENT_CLOSING ||
+                !FD_ISSET(agent->ws.sock, &readFds)) {
+                continue;
+            }
+            if (agent->state == CDP_BROKER_AGENT_HTTP) {
+                CdpBrokerReadRequest(broker, a);
+                if (agent->state != CDP_BROKER_AGENT_OPEN) continue;
+            }
+
+            const char* message = NULL;
+            int received = 0;
+            while (agent->state == CDP_BROKER_AGENT_OPEN &&
+                   !broker->upstreams[agent->upstream].reconnect &&
+                   (received = CdpBrokerReceive(agent, &message)) > 0) {
+                CdpBrokerAgentMessage(broker, a, message, agent->ws.msgLen);
+            }
+            if (agent->state == CDP_BROKER_AGENT_OPEN && received < 0) CdpBrokerCloseAgent(broker, a);
+        }
+
+        // Replace what was handed out this pass, then write out what was queued
+        CdpBrokerPoolMaintain(broker, CdpNowUs());
+        CdpBrokerTabMaintain(broker, CdpNowUs());
+        for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+            CdpBrokerUpstream* up = &broker->upstreams[u];
+            if (up->state == CDP_LINK_UP && up->out.head < up->out.len &&
+                !CdpBrokerFlushOutput(up->ws.sock, &up->out)) {
+                CdpBrokerDropUpstream(broker, u);
+            }
+        }
+        for (int a = 0; a < CDP_BROKER_MAX_AGENTS; a++) {
+            CdpBrokerAgent* agent = &broker->agents[a];
+            if (agent->state == CDP_BROKER_AGENT_FREE) continue;
+            if ((agent->out.head < agent->out.len || agent->state == CDP_BROKER_AGENT_CLOSING) &&
+                !CdpBrokerFlush(agent)) {
+                CdpBrokerCloseAgent(broker, a);
+            }
+        }
+    }
+
+    for (int a = 0; a < CDP_BROKER_MAX_AGENTS; a++) {
+        if (broker->agents[a].state != CDP_BROKER_AGENT_FREE) CdpBrokerCloseAgent(broker, a);
+    }
+    for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        CdpBrokerUpstream* up = &broker->upstreams[u];
+        // Pooled contexts outlive the connection that created them
+        for (int i = 0; up->pool && i < CDP_BROKER_POOL_SLOTS && up->state == CDP_LINK_UP; i++) {
+            if (up->pool[i].contextId[0] && up->pool[i].state != CDP_POOL_FREE && up->pool[i].state != CDP_POOL_DISPOSING) {
+                CdpBrokerCall(up, "Target.disposeBrowserContext", "browserContextId", up->pool[i].contextId);
+            }
+        }
+        for (int i = 0; up->tabs && i < CDP_BROKER_TAB_SLOTS && up->state == CDP_LINK_UP; i++) {
+            if (up->tabs[i].targetId[0] && up->tabs[i].state != CDP_TAB_CLOSING) {
+                CdpBrokerCall(up, "Target.closeTarget", "targetId", up->tabs[i].targetId);
+            }
+        }
+    }
+    CdpBrokerSettle(broker, CdpNowUs() + CDP_BROKER_SETTLE_MS * 1000ULL);
+    for (int u = 0; u < CDP_BROKER_MAX_UPSTREAMS; u++) {
+        CdpBrokerUpstream* up = &broker->upstreams[u];
+        if (up->pending && up->sessions && up->pool && up->tabs) CdpBrokerDropUpstream(broker, u);
+        for (int i = 0; up->tabs && i < CDP_BROKER_TAB_SLOTS; i++) CdpBrokerTabDisconnect(&up->tabs[i]);
+        CdpBrokerDialStop(up);
+        CdpWsClose(&up->ws);
+        CdpBrokerFreeOutput(&up->out);
+        free(up->pending);
+        free(up->sessions);
+        free(up->pool);
+        free(up->tabs);
+        up->pending = NULL;
+        up->sessions = NULL;
+        up->pool = NULL;
+        up->tabs = NULL;
+    }
+    CdpCloseSocket(broker->listener);
+    broker->listener = CDP_INVALID_SOCKET;
+    broker->listening = 0;
+    CdpBrokerFreeHandovers(broker);
+    return rc;
+}
@@ -0,0 +1,411 @@
+/**
+ * Chrome DevTools client
+ *
+ * - Keep-alive HTTP client for the DevTools HTTP endpoints (/json/version etc.)
+ * - WebSocket client for the browser-level CDP endpoint
+ * - Command session: request/response calls and event waits on that endpoint,
+ *   including flat-mode calls to attached targets
+ * - Liveness monitor: keeps a CDP session open, tracks targets through
+ *   Target.setDiscoverTargets and pings the browser with a deadline
+ * - Broker: serves many agents over one browser-level connection per browser,
+ *   routing commands by rewritten ids and events by session ownership
+ *
+ * Plain sockets only - builds with MinGW (Winsock) and on POSIX systems, so it
+ * can be exercised against a local mock server without Windows. On Windows the
+ * caller is responsible for WSAStartup.
+ */
+
+#ifndef CDP_H
+#define CDP_H
+
+#include <stddef.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+typedef SOCKET CdpSocket;
+#define CDP_INVALID_SOCKET INVALID_SOCKET
+#else
+typedef int CdpSocket;
+#define CDP_INVALID_SOCKET (-1)
+#endif
+
+#define CDP_HOST_MAX 64
+#define CDP_HTTP_HEADER_MAX 4096
+
+// Result codes (negative values are failures)
+#define CDP_OK 0
+#define CDP_ERR_CONNECT (-1)   // Could not connect within the connect timeout
+#define CDP_ERR_IO (-2)        // Send/receive failed or the peer closed early
+#define CDP_ERR_TIMEOUT (-3)   // No complete response within the read timeout
+#define CDP_ERR_PROTOCOL (-4)  // Malformed or unsupported HTTP response
+#define CDP_ERR_OVERFLOW (-5)  // Response body larger than the caller's buffer
+
+typedef struct {
+    char host[CDP_HOST_MAX];
+    int port;
+    int connectTimeoutMs;
+    int readTimeoutMs;
+    CdpSocket sock;                    // Kept open between requests
+    unsigned long long lastLatencyUs;  // Request start to last body byte
+    int lastReused;                    // Last request ran on an existing connection
+    unsigned long requestCount;
+    unsigned long connectCount;
+} CdpHttpClient;
+
+// Monotonic clock in microseconds
+unsigned long long CdpNowUs(void);
+
+void CdpHttpInit(CdpHttpClient* client, int connectTimeoutMs, int readTimeoutMs);
+
+// Points the client at host:port; an open connection to another target is closed
+void CdpHttpSetTarget(CdpHttpClient* client, const char* host, int port);
+
+// GETs path and stores the NUL-terminated body. *httpStatus receives the status
+// code. A request that fails on a reused connection before any response byte
+// arrived is retried once on a fresh connection.
+int CdpHttpGet(CdpHttpClient* client, const char* path, char* body, size_t bodyLen,
+               int* httpStatus);
+
+void CdpHttpClose(CdpHttpClient* client);
+
+// Extracts a string field from a JSON object (first match, no unescaping)
+int CdpJsonGetString(const char* json, const char* key, char* out, size_t outLen);
+
+// Extracts an integer field from a JSON object (first match)
+int CdpJsonGetInt(const char* json, const char* key, long* out);
+
+// ============================================================================
+// WebSocket client (RFC 6455 client side, text messages only)
+// ============================================================================
+
+#define CDP_WS_MESSAGE_MAX (16 * 1024 * 1024)
+
+typedef struct {
+    CdpSocket sock;
+    unsigned char* rx;  // Received bytes not yet consumed
+    size_t rxLen;
+    size_t rxCap;
+    char* msg;          // Message being assembled from fragments
+    size_t msgLen;
+    size_t msgCap;
+} CdpWebSocket;
+
+void CdpWsInit(CdpWebSocket* ws);
+
+// Connects and performs the upgrade handshake for path (e.g. /devtools/browser/<id>)
+int CdpWsConnect(CdpWebSocket* ws, const char* host, int port, const char* path, int timeoutMs);
+
+int CdpWsSendText(CdpWebSocket* ws, const char* text, size_t len, int timeoutMs);
+
+// Waits up to timeoutMs for a complete text message. Returns its length and
+// points *message at the NUL-terminated text (valid until the next call), or
+// CDP_ERR_TIMEOUT / another error. Pings are answered internally.
+int CdpWsReceive(CdpWebSocket* ws, int timeoutMs, const char** message);
+
+void CdpWsClose(CdpWebSocket* ws);
+
+// ============================================================================
+// Command session - request/response over the browser endpoint
+// ============================================================================
+
+#define CDP_SESSION_ID_MAX 64
+
+typedef struct {
+    CdpWebSocket ws;
+    int timeoutMs;  // Connect, and each call or event wait
+    long nextId;
+} CdpSession;
+
+void CdpSessionInit(CdpSession* session, int timeoutMs);
+
+// Resolves the browser endpoint of host:port and connects to it
+int CdpSessionOpen(CdpSession* session, const char* host, int port);
+
+// Sends method with params (a JSON object, or NULL) to the browser - or, with
+// a sessionId from Target.attachToTarget (flatten), to that target - and waits
+// for the response. Events arriving meanwhile are skipped. *response points at
+// the NUL-terminated message (valid until the next call). Returns
+// CDP_ERR_PROTOCOL if Chrome answered with an error.
+int CdpSessionCall(CdpSession* session, const char* sessionId, const char* method,
+                   const char* params, const char** response);
+
+// Waits for the event method (of sessionId, if set)
+int CdpSessionWaitEvent(CdpSession* session, const char* sessionId, const char* method,
+                        const char** event);
+
+#define CDP_TRACE_FRAMES 128  // Frames a renderer lookup considers
+
+// Finds the page whose renderer is process pid, from a short trace whose
+// TracingStartedInBrowser event lists every frame with its process. A main
+// frame's id is its page's target id; a process that only hosts subframes
+// maps to the page above them. Returns CDP_ERR_PROTOCOL if no page matches.
+int CdpSessionFindRenderer(CdpSession* session, long pid, char* targetId, size_t targetIdLen);
+
+void CdpSessionClose(CdpSession* session);
+
+// ============================================================================
+// Liveness monitor
+// ============================================================================
+
+#define CDP_LINK_DOWN 0     // No session with the browser endpoint
+#define CDP_LINK_UP 1       // Session open and pings answered in time
+#define CDP_LINK_STALLED 2  // Session open, but a ping missed its deadline
+
+#define CDP_MAX_TARGETS 64
+#define CDP_STALL_LIMIT 3   // Deadlines a ping may miss before the session is dropped
+
+typedef struct {
+    char targetId[64];
+    char type[32];
+    char url[256];
+} CdpTargetInfo;
+
+typedef struct CdpMonitor CdpMonitor;
+
+typedef struct {
+    char host[CDP_HOST_MAX];
+    int port;
+} CdpEndpoint;
+
+// Called on the monitor thread when the state or the set of targets changed
+typedef void (*CdpMonitorCallback)(CdpMonitor* monitor, void* context);
+
+struct CdpMonitor {
+    // Settings - host/port belong to the monitor thread once it runs; other
+    // threads change them with CdpMonitorRetarget
+    char host[CDP_HOST_MAX];
+    int port;
+    int connectTimeoutMs;
+    int pingIntervalMs;
+    int pingDeadlineMs;
+    int reconnectDelayMs;    // First retry delay; doubles up to 8x while down
+    CdpMonitorCallback onChange;
+    void* context;
+    volatile int stop;       // Set to make CdpMonitorRun return
+    volatile int reconnect;  // Set to drop the session and resolve the endpoint again
+
+    // State, written by the monitor thread
+    int state;
+    char browser[64];        // "Browser" field of /json/version
+    unsigned long long lastPingRttUs;
+    unsigned long disconnects;
+    unsigned long missedPings;
+    int targetCount;
+    CdpTargetInfo targets[CDP_MAX_TARGETS];
+
+    // Internal
+    CdpHttpClient http;
+    CdpWebSocket ws;
+    long nextId;
+    long pingId;             // Outstanding ping, 0 if none
+    unsigned long long pingSentUs;
+    CdpEndpoint* volatile retarget;  // Handed over by CdpMonitorRetarget, taken on reconnect
+};
+
+void CdpMonitorInit(CdpMonitor* monitor, const char* host, int port);
+
+// Connects, monitors and reconnects until monitor->stop is set
+void CdpMonitorRun(CdpMonitor* monitor);
+
+// Points a running monitor at another endpoint, from any thread: it drops its
+// session and reconnects there. Returns 0 if out of memory.
+int CdpMonitorRetarget(CdpMonitor* monitor, const char* host, int port);
+
+// ============================================================================
+// Broker
+// ============================================================================
+
+// Agents connect to the broker as if it were Chrome (GET /json/version, then a
+// WebSocket on the advertised browser endpoint). Each agent is pinned to one
+// upstream - a browser-level connection to one Chrome - and its command ids
+// are rewritten into that connection's id space. Flat sessions belong to the
+// agent that attached them: their events go to that agent only, and commands
+// on sessions of other agents are refused. Browser-level events go to the
+// agents that used the event's domain.
+//
+// The broker can also keep a pool of browser contexts per upstream, each
+// with an about:blank page, created ahead of time and handed out over HTTP
+// (GET /json/context/new, /json/context/release/<id>?token=<token>). The
+// token issued with a lease is needed to bind or release it. Released
+// contexts are disposed and replaced in the background.
+//
+// Likewise a pool of background tabs in the default context, each navigated
+// to one of the configured start URLs ahead of time so the page is loaded
+// and its resources are in the HTTP cache (GET /json/tab/new[?url=<url>],
+// /json/tab/release/<targetId>?token=<token>), leased the same way.
+
+#define CDP_BROKER_MAX_AGENTS 128
+#define CDP_BROKER_MAX_UPSTREAMS 16
+#define CDP_BROKER_MAX_PENDING 4096   // Commands in flight per upstream (power of two)
+#define CDP_BROKER_MAX_SESSIONS 1024  // Attached sessions per upstream (power of two)
+#define CDP_BROKER_MAX_DOMAINS 16     // Browser-level domains one agent listens to
+#define CDP_BROKER_MAX_CONTEXTS 32    // Browser contexts one agent created
+#define CDP_BROKER_POOL_SLOTS 128     // Pooled contexts per upstream, ready or leased
+#define CDP_BROKER_POOL_MAX 32        // Largest poolSize
+#define CDP_BROKER_TAB_SLOTS 64       // Pooled tabs per upstream, ready or leased
+#define CDP_BROKER_TAB_POOL_MAX 16    // Largest tabPoolSize
+#define CDP_BROKER_TAB_URLS 8         // Start URLs tabs are navigated to
+#define CDP_BROKER_URL_MAX 512
+#define CDP_BROKER_TAB_URL_LIST_MAX 1024  // Start URLs as set, separated by whitespace
+#define CDP_BROKER_TOKEN_LEN 32       // Hex digits of a lease token
+
+// Bytes queued for a non-blocking socket; data + head is next
+typedef struct {
+    char* data;
+    size_t head;
+    size_t len;
+    size_t cap;
+} CdpBrokerOutput;
+
+typedef struct {
+    long upstreamId;           // 0 = free
+    int agent;                 // Slot of the caller, -1 for the broker's own calls
+    unsigned long agentSerial;
+    long agentId;              // id the agent sent
+    int kind;                  // CDP_BROKER_CALL_* (cdp.c)
+    int slot;                  // Pool calls: the context's or tab's slot, -1 if not pooled
+    char resource[64];         // Target being attached or closed, context being disposed
+} CdpBrokerPending;
+
+typedef struct {
+    int state;                 // CDP_POOL_* (cdp.c)
+    char contextId[64];
+    char targetId[64];         // Its about:blank page
+    char token[CDP_BROKER_TOKEN_LEN + 1];  // Issued with the lease, required to bind or release it
+    int waiter;                // Agent whose allocation missed the pool and waits for it, -1 if none
+    unsigned long waiterSerial;
+    int owner;                 // Agent the lease is bound to, -1 if none
+    unsigned long ownerSerial;
+} CdpBrokerPoolContext;
+
+typedef struct {
+    int state;                 // CDP_TAB_* (cdp.c)
+    char targetId[64];
+    char url[CDP_BROKER_URL_MAX];  // Navigated to, "" = about:blank
+    char token[CDP_BROKER_TOKEN_LEN + 1];  // Issued with the lease, required to bind or release it
+    CdpWebSocket ws;           // Page connection while it loads
+    CdpBrokerOutput out;       // ... the handshake and commands not yet sent on it
+    unsigned long long dialDeadlineUs;  // Handshake answered by then
+    unsigned long long startUs;    // Creation requested
+    unsigned long long loadUs;     // From then until its load event
+    int waiter;                // Agent whose allocation missed the pool and waits for it, -1 if none
+    unsigned long waiterSerial;
+    int owner;                 // Agent the lease is bound to, -1 if none
+    unsigned long ownerSerial;
+} CdpBrokerTab;
+
+typedef struct {
+    char sessionId[CDP_SESSION_ID_MAX];  // "" = free
+    int agent;
+    unsigned long agentSerial;
+} CdpBrokerSession;
+
+typedef struct {
+    // Settings - host/port belong to the broker thread once it runs; other
+    // threads change them with CdpBrokerSetUpstream
+    char host[CDP_HOST_MAX];
+    int port;
+    int reconnect;             // Set by the broker thread to drop the connection and its agents
+
+    // State, written by the broker thread
+    int state;                 // CDP_LINK_DOWN or CDP_LINK_UP
+    char browser[64];
+    int agentCount;
+    int sessionCount;
+    unsigned long disconnects;
+
+    // Internal
+    CdpWebSocket ws;
+    CdpBrokerOutput out;       // Frames (or the handshake) not yet sent
+    int dial;                  // CDP_BROKER_DIAL_* (cdp.c) while connecting
+    unsigned long long dialDeadlineUs;
+    long nextId;
+    int retryDelayMs;
+    unsigned long long retryUs;
+    int autoAttachAgent;       // Last agent to call Target.setAutoAttach, -1 if none
+    unsigned long autoAttachSerial;
+    CdpBrokerPending* pending;   // CDP_BROKER_MAX_PENDING, indexed by upstream id
+    CdpBrokerSession* sessions;  // CDP_BROKER_MAX_SESSIONS, open addressing on the id
+    CdpBrokerPoolContext* pool;  // CDP_BROKER_POOL_SLOTS
+    int poolReady;
+    int poolLeased;
+    unsigned long long poolRetryUs;  // Refills pause until then after a failed creation
+    CdpBrokerTab* tabs;          // CDP_BROKER_TAB_SLOTS
+    int tabsReady;
+    int tabsLeased;
+    unsigned long long tabRetryUs;
+    CdpEndpoint* volatile retarget;  // Handed over by CdpBrokerSetUpstream, taken every loop pass
+} CdpBrokerUpstream;
+
+typedef struct {
+    CdpWebSocket ws;
+    int state;                 // CDP_BROKER_AGENT_* (cdp.c)
+    unsigned long serial;      // Tells a reused slot from the agent that left it
+    int upstream;
+    int discover;              // Called Target.setDiscoverTargets
+    int domainCount;
+    char domains[CDP_BROKER_MAX_DOMAINS][32];
+    int contextCount;
+    char contexts[CDP_BROKER_MAX_CONTEXTS][64];
+    int waitUpstream;          // Allocation waiting for a context: upstream and slot
+    int waitSlot;
+    unsigned long long waitStartUs;
+    char waitHost[CDP_HOST_MAX + 8];
+    CdpBrokerOutput out;       // Frames not yet sent
+} CdpBrokerAgent;
+
+typedef struct {
+    // Settings
+    char listenHost[CDP_HOST_MAX];
+    int listenPort;
+    volatile int upstreamCount;  // Upstreams in use, followed on every loop pass
+    volatile int poolSize;       // Ready contexts kept per upstream, 0 = no pool
+    volatile int tabPoolSize;    // Ready tabs kept per upstream, 0 = no pool
+    volatile int stop;           // Set to make CdpBrokerRun return
+    CdpBrokerUpstream upstreams[CDP_BROKER_MAX_UPSTREAMS];
+
+    // State, written by the broker thread
+    int listening;
+    int agentCount;
+    unsigned long agentsAccepted;
+    unsigned long long messagesIn;   // Agents to browsers
+    unsigned long long messagesOut;  // Browsers to agents
+    unsigned long refused;           // Commands answered by the broker itself
+    unsigned long allocations;       // Contexts handed out
+    unsigned long poolHits;          // ... of which were ready when asked for
+    unsigned long long hitLatencyUs; // Request to response, summed over hits
+    unsigned long long missLatencyUs;
+    unsigned long tabAllocations;    // Tabs handed out
+    unsigned long tabHits;           // ... of which were loaded when asked for
+    unsigned long long tabHitLatencyUs;
+    unsigned long long tabMissLatencyUs;
+    unsigned long tabLoads;          // Tabs created and loaded
+    unsigned long long tabLoadUs;    // Creation to load event, summed: first interaction without the pool
+
+    // Internal
+    char* volatile tabUrlUpdate;  // Handed over by CdpBrokerSetTabUrls, taken every loop pass
+    char tabUrlList[CDP_BROKER_TAB_URL_LIST_MAX];  // As last taken
+    char tabUrls[CDP_BROKER_TAB_URLS][CDP_BROKER_URL_MAX];  // Parsed from tabUrlList
+    int tabUrlCount;
+    CdpSocket listener;
+    unsigned long nextSerial;
+    CdpBrokerAgent agents[CDP_BROKER_MAX_AGENTS];
+} CdpBroker;
+
+void CdpBrokerInit(CdpBroker* broker, const char* listenHost, int listenPort);
+
+// Points upstream index at host:port, from any thread: the broker takes the
+// endpoint on its next loop pass, and drops a connection to another endpoint
+// together with its agents. Returns 0 if out of memory.
+int CdpBrokerSetUpstream(CdpBroker* broker, int index, const char* host, int port);
+
+// Start URLs of the tab pool, separated by whitespace, from any thread. Tabs
+// already loaded with a URL no longer listed are closed and replaced. Returns
+// 0 if out of memory.
+int CdpBrokerSetTabUrls(CdpBroker* broker, const char* urls);
+
+// Listens and serves agents until broker->stop is set. Returns CDP_ERR_CONNECT
+// right away if the listening socket can't be set up.
+int CdpBrokerRun(CdpBroker* broker);
+
+#endif // CDP_H
@@ -0,0 +1,442 @@
+/**
+ * Mock Chrome DevTools endpoint - see mock_cdp.h
+ */
+
+#define _GNU_SOURCE  // strcasestr
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cdp.h"
+#include "mock_cdp.h"
+
+void MockCdpSleep(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static int MockCdpSendAll(int sock, const void* data, size_t len) {
+    const char* p = (const char*)data;
+    while (len > 0) {
+        ssize_t n = send(sock, p, len, MSG_NOSIGNAL);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return 0;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static int MockCdpRecvAll(int sock, void* data, size_t len) {
+    char* p = (char*)data;
+    while (len > 0) {
+        ssize_t n = recv(sock, p, len, 0);
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            return 0;
+        }
+        p += n;
+        len -= (size_t)n;
+    }
+    return 1;
+}
+
+static int MockCdpFrame(MockCdpConnection* c, int fin, int opcode, const void* payload, size_t len) {
+    unsigned char header[10];
+    size_t headerLen = 0;
+    header[headerLen++] = (unsigned char)((fin ? 0x80 : 0) | opcode);
+    if (len < 126) {
+        header[headerLen++] = (unsigned char)len;
+    } else if (len <= 0xFFFF) {
+        header[headerLen++] = 126;
+        header[headerLen++] = (unsigned char)(len >> 8);
+        header[headerLen++] = (unsigned char)len;
+    } else {
+        header[headerLen++] = 127;
+        for (int i = 7; i >= 0; i--) header[headerLen++] = (unsigned char)((unsigned long long)len >> (i * 8));
+    }
+    pthread_mutex_lock(&c->sendLock);
+    int ok = !c->done && MockCdpSendAll(c->sock, header, headerLen) && MockCdpSendAll(c->sock, payload, len);
+    pthread_mutex_unlock(&c->sendLock);
+    return ok;
+}
+
+static void MockCdpSendText(MockCdpConnection* c, const char* text) {
+    MockCdpFrame(c, 1, 0x1, text, strlen(text));
+}
+
+// ----------------------------------------------------------------------------
+// CDP
+// ----------------------------------------------------------------------------
+
+static const char* MockCdpTargetContext(MockCdp* mock, const char* targetId) {
+    for (int i = 0; i < mock->targetCount; i++) {
+        if (strcmp(mock->targets[i][0], targetId) == 0) return mock->targets[i][1];
+    }
+    return "D";
+}
+
+// Answers one command. A "sessionId" is only looked for outside the Target
+// domain, whose params carry session ids of their own.
+static void MockCdpHandle(MockCdpConnection* c, const char* message) {
+    MockCdp* mock = c->mock;
+    long id = 0;
+    char method[128] = "";
+    char sessionId[64] = "";
+    char value[256] = "";
+    CdpJsonGetInt(message, "id", &id);
+    CdpJsonGetString(message, "method", method, sizeof(method));
+    if (strncmp(method, "Target.", 7) != 0) CdpJsonGetString(message, "sessionId", sessionId, sizeof(sessionId));
+
+    pthread_mutex_lock(&mock->lock);
+    if (mock->logCount < MOCK_CDP_LOG_MAX) mock->log[mock->logCount++] = strdup(message);
+    pthread_mutex_unlock(&mock->lock);
+
+    char session[96] = "";
+    if (sessionId[0]) snprintf(session, sizeof(session), ",\"sessionId\":\"%s\"", sessionId);
+    char reply[1024];
+    char event[1024] = "";
+
+    if (strcmp(method, "Mock.hang") == 0) return;
+    if (strcmp(method, "Browser.getVersion") == 0) {
+        if (mock->muted) return;
+        snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{\"product\":\"Mock/1.0\"}}", id);
+    } else if (strcmp(method, "Target.setDiscoverTargets") == 0) {
+        snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{}}", id);
+        snprintf(event, sizeof(event),
+                 "{\"method\":\"Target.targetCreated\",\"params\":{\"targetInfo\":"
+                 "{\"targetId\":\"T0\",\"type\":\"page\",\"url\":\"about:blank\"}}}");
+    } else if (strcmp(method, "Target.createBrowserContext") == 0) {
+        pthread_mutex_lock(&mock->lock);
+        int n = ++mock->nextContext;
+        pthread_mutex_unlock(&mock->lock);
+        snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{\"browserContextId\":\"C%d\"}}", id, n);
+    } else if (strcmp(method, "Target.createTarget") == 0) {
+        char context[32] = "D";
+        CdpJsonGetString(message, "browserContextId", context, sizeof(context));
+        pthread_mutex_lock(&mock->lock);
+        int n = ++mock->nextTarget;
+        if (mock->targetCount < MOCK_CDP_TARGETS) {
+            snprintf(mock->targets[mock->targetCount][0], sizeof(mock->targets[0][0]), "T%d", n);
+            snprintf(mock->targets[mock->targetCount][1], sizeof(mock->targets[0][1]), "%s", context);
+            mock->targetCount++;
+        }
+        pthread_mutex_unlock(&mock->lock);
+        snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{\"targetId\":\"T%d\"}}", id, n);
+    } else if (strcmp(method, "Target.attachToTarget") == 0) {
+        CdpJsonGetString(message, "targetId", value, sizeof(value));
+        pthread_mutex_lock(&mock->lock);
+        int n = ++mock->nextSession;
+        const char* context = MockCdpTargetContext(mock, value);
+        snprintf(event, sizeof(event),
+                 "{\"method\":\"Target.attachedToTarget\",\"params\":{\"sessionId\":\"S%d\",\"targetInfo\":"
+                 "{\"targetId\":\"%s\",\"type\":\"page\",\"url\":\"about:blank\",\"browserContextId\":\"%s\"},"
+                 "\"waitingForDebugger\":false}}",
+                 n, value, context);
+        pthread_mutex_unlock(&mock->lock);
+        // Chrome reports the attachment before it answers the call
+        MockCdpSendText(c, event);
+        event[0] = '\0';
+        snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{\"sessionId\":\"S%d\"}}", id, n);
+    } else if (strcmp(method, "Target.detachFromTarget") == 0) {
+        CdpJsonGetString(message, "sessionId", value, sizeof(value));
+        snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{}}", id);
+        snprintf(event, sizeof(event),
+                 "{\"method\":\"Target.detachedFromTarget\",\"params\":{\"sessionId\":\"%s\"}}", value);
+    } else if (strcmp(method, "Target.closeTarget") == 0) {
+        CdpJsonGetString(message, "targetId", value, sizeof(value));
+        if (strcmp(value, "missing") == 0) {
+            snprintf(reply, sizeof(reply),
+                     "{\"id\":%ld,\"error\":{\"code\":-32602,\"message\":\"No target with given id found\"}}", id);
+        } else {
+            snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{\"success\":true}}", id);
+        }
+    } else if (strcmp(method, "Tracing.end") == 0) {
+        // T0 in process 100 with an out-of-process subframe in 101, and T7
+        // in 102; the data comes before the answer, completion after it
+        MockCdpSendText(c, "{\"method\":\"Tracing.dataCollected\",\"params\":{\"value\":["
+                           "{\"args\":{\"data\":{\"frameTreeNodeId\":1,\"frames\":["
+                           "{\"frame\":\"T0\",\"name\":\"\",\"processId\":100,\"url\":\"about:blank\"},"
+                           "{\"frame\":\"F9\",\"name\":\"\",\"parent\":\"T0\",\"processId\":101,"
+                           "\"url\":\"https://ads.example/\"},"
+                           "{\"frame\":\"T7\",\"name\":\"\",\"processId\":102,\"url\":\"https://example.com/\"}"
+                           "],\"persistentIds\":true}},\"cat\":\"disabled-by-default-devtools.timeline\","
+                           "\"name\":\"TracingStartedInBrowser\",\"ph\":\"I\",\"pid\":1,\"tid\":1,\"ts\":1}]}}");
+        snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{}}", id);
+        snprintf(event, sizeof(event), "{\"method\":\"Tracing.tracingComplete\",\"params\":{\"dataLossOccurred\":false}}");
+    } else if (strcmp(method, "Page.navigate") == 0) {
+        snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{\"frameId\":\"F1\",\"loaderId\":\"L1\"}%s}", id, session);
+        snprintf(event, sizeof(event), "{\"method\":\"Page.loadEventFired\",\"params\":{\"timestamp\":1}%s}", session);
+    } else {
+        snprintf(reply, sizeof(reply), "{\"id\":%ld,\"result\":{}%s}", id, session);
+    }
+
+    MockCdpSendText(c, reply);
+    if (event[0]) MockCdpSendText(c, event);
+}
+
+// ----------------------------------------------------------------------------
+// Connections
+// ----------------------------------------------------------------------------
+
+// Reads client frames (masked) until the connection ends
+static void MockCdpServeWebSocket(MockCdpConnection* c) {
+    char* message = NULL;
+    size_t messageLen = 0;
+
+    for (;;) {
+        unsigned char head[2];
+        if (!MockCdpRecvAll(c->sock, head, 2)) break;
+        int fin = (head[0] & 0x80) != 0;
+        int opcode = head[0] & 0x0F;
+        unsigned long long len = head[1] & 0x7F;
+        if (len == 126) {
+            unsigned char ext[2];
+            if (!MockCdpRecvAll(c->sock, ext, 2)) break;
+            len = ((unsigned long long)ext[0] << 8) | ext[1];
+        } else if (len == 127) {
+            unsigned char ext[8];
+            if (!MockCdpRecvAll(c->sock, ext, 8)) break;
+            len = 0;
+            for (int i = 0; i < 8; i++) len = (len << 8) | ext[i];
+        }
+        unsigned char key[4] = {0};
+        if ((head[1] & 0x80) && !MockCdpRecvAll(c->sock, key, 4)) break;
+        if (len > CDP_WS_MESSAGE_MAX) break;
+
+        char* payload = (char*)malloc((size_t)len + 1);
+        if (!payload || !MockCdpRecvAll(c->sock, payload, (size_t)len)) {
+            free(payload);
+            break;
+        }
+        for (unsigned long long i = 0; i < len; i++) payload[i] ^= (char)key[i & 3];
+        payload[len] = '\0';
+
+        if (opcode == 0x1 || opcode == 0x0) {
+            if (opcode == 0x1) messageLen = 0;
+            char* grown = (char*)realloc(message, messageLen + (size_t)len + 1);
+            if (!grown) {
+                free(payload);
+                break;
+            }
+            message = grown;
+            memcpy(message + messageLen, payload, (size_t)len + 1);
+            messageLen += (size_t)len;
+            if (fin) MockCdpHandle(c, message);
+        } else if (opcode == 0x9) {
+            MockCdpFrame(c, 1, 0xA, payload, (size_t)len);
+        } else if (opcode == 0xA) {
+            pthread_mutex_lock(&c->mock->lock);
+            snprintf(c->mock->lastPong, sizeof(c->mock->lastPong), "%s", payload);
+            c->mock->pongs++;
+            pthread_mutex_unlock(&c->mock->lock);
+        } else if (opcode == 0x8) {
+            MockCdpFrame(c, 1, 0x8, payload, len >= 2 ? 2 : 0);
+            free(payload);
+            break;
+        }
+        free(payload);
+    }
+    free(message);
+}
+
+static void* MockCdpServe(void* arg) {
+    MockCdpConnection* c = (MockCdpConnection*)arg;
+    MockCdp* mock = c->mock;
+
+    char request[4096];
+    size_t len = 0;
+    request[0] = '\0';
+    while (!strstr(request, "\r\n\r\n") && len < sizeof(request) - 1) {
+        ssize_t n = recv(c->sock, request + len, sizeof(request) - 1 - len, 0);
+        if (n <= 0) break;
+        len += (size_t)n;
+        request[len] = '\0';
+    }
+
+    char path[256] = "";
+    sscanf(request, "GET %255s", path);
+    int upgrade = strcasestr(request, "upgrade: websocket") != NULL;
+
+    if (!strstr(request, "\r\n\r\n")) {
+        // Closed before a full request
+    } else if (upgrade && (strncmp(path, "/devtools/browser/", 18) == 0 || strncmp(path, "/devtools/page/", 15) == 0)) {
+        if (mock->handshakeDelayMs > 0) MockCdpSleep(mock->handshakeDelayMs);
+        // cdp.c's client doesn't check Sec-WebSocket-Accept
+        static const char accept[] =
+            "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+            "Sec-WebSocket-Accept: mock\r\n\r\n";
+        // Counted before the client can see the answer
+        pthread_mutex_lock(&mock->lock);
+        c->upgraded = 1;
+        c->browser = strncmp(path, "/devtools/browser/", 18) == 0;
+        if (c->browser) mock->latest = (int)(c - mock->connections);
+        mock->upgrades++;
+        pthread_mutex_unlock(&mock->lock);
+        if (MockCdpSendAll(c->sock, accept, sizeof(accept) - 1)) MockCdpServeWebSocket(c);
+    } else if (strcmp(path, "/json/version") == 0) {
+        if (mock->httpDelayMs > 0) MockCdpSleep(mock->httpDelayMs);
+        char body[256];
+        char response[512];
+        int bodyLen = snprintf(body, sizeof(body),
+                               "{\"Browser\":\"Mock/1.0\",\"Protocol-Version\":\"1.3\","
+                               "\"webSocketDebuggerUrl\":\"ws://127.0.0.1:%d/devtools/browser/mock\"}",
+                               mock->port);
+        int responseLen = snprintf(response, sizeof(response),
+                                   "HTTP/1.1 200 OK\r\nContent-Type: application/json\r\n"
+                                   "Content-Length: %d\r\n\r\n%s",
+                                   bodyLen, body);
+        MockCdpSendAll(c->sock, response, (size_t)responseLen);
+    } else {
+        static const char notFound[] = "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\n\r\n";
+        MockCdpSendAll(c->sock, notFound, sizeof(notFound) - 1);
+    }
+
+    pthread_mutex_lock(&c->sendLock);
+    close(c->sock);
+    c->done = 1;
+    pthread_mutex_unlock(&c->sendLock);
+    return NULL;
+}
+
+static void* MockCdpAcceptLoop(void* arg) {
+    MockCdp* mock = (MockCdp*)arg;
+    while (!mock->stop) {
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(mock->listener, &fds);
+        struct timeval tv = { 0, 50000 };
+        if (select(mock->listener + 1, &fds, NULL, NULL, &tv) <= 0) continue;
+
+        int s = accept(mock->listener, NULL, NULL);
+        if (s < 0) continue;
+        int noDelay = 1;
+        setsockopt(s, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+
+        MockCdpConnection* c = NULL;
+        pthread_mutex_lock(&mock->lock);
+        for (int i = 0; i < MOCK_CDP_CONNECTIONS && !c; i++) {
+            MockCdpConnection* slot = &mock->connections[i];
+            if (slot->running && slot->done) {
+                pthread_join(slot->thread, NULL);
+                slot->running = 0;
+                if (mock->latest == i) mock->latest = -1;
+            }
+            if (!slot->running) c = slot;
+        }
+        if (c) {
+            c->sock = s;
+            c->upgraded = c->browser = 0;
+            c->done = 0;
+            c->running = pthread_create(&c->thread, NULL, MockCdpServe, c) == 0;
+        }
+        pthread_mutex_unlock(&mock->lock);
+        if (!c || !c->running) close(s);
+    }
+    return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Public
+// ----------------------------------------------------------------------------
+
+int MockCdpStart(MockCdp* mock) {
+    memset(mock, 0, sizeof(*mock));
+    mock->latest = -1;
+    pthread_mutex_init(&mock->lock, NULL);
+    for (int i = 0; i < MOCK_CDP_CONNECTIONS; i++) {
+        mock->connections[i].mock = mock;
+        pthread_mutex_init(&mock->connections[i].sendLock, NULL);
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    mock->listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (mock->listener < 0 || bind(mock->listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(mock->listener, 64) != 0 || getsockname(mock->listener, (struct sockaddr*)&addr, &addrLen) != 0) {
+        if (mock->listener >= 0) close(mock->listener);
+        return 0;
+    }
+    mock->port = ntohs(addr.sin_port);
+    return pthread_create(&mock->acceptThread, NULL, MockCdpAcceptLoop, mock) == 0;
+}
+
+void MockCdpDropConnections(MockCdp* mock) {
+    pthread_mutex_lock(&mock->lock);
+    for (int i = 0; i < MOCK_CDP_CONNECTIONS; i++) {
+        MockCdpConnection* c = &mock->connections[i];
+        pthread_mutex_lock(&c->sendLock);
+        if (c->running && !c->done && c->upgraded) shutdown(c->sock, SHUT_RDWR);
+        pthread_mutex_unlock(&c->sendLock);
+    }
+    pthread_mutex_unlock(&mock->lock);
+}
+
+void MockCdpStop(MockCdp* mock) {
+    mock->stop = 1;
+    pthread_join(mock->acceptThread, NULL);
+    close(mock->listener);
+    for (int i = 0; i < MOCK_CDP_CONNECTIONS; i++) {
+        MockCdpConnection* c = &mock->connections[i];
+        pthread_mutex_lock(&c->sendLock);
+        if (c->running && !c->done) shutdown(c->sock, SHUT_RDWR);
+        pthread_mutex_unlock(&c->sendLock);
+        if (c->running) pthread_join(c->thread, NULL);
+        c->running = 0;
+        pthread_mutex_destroy(&c->sendLock);
+    }
+    for (int i = 0; i < mock->logCount; i++) free(mock->log[i]);
+    mock->logCount = 0;
+    pthread_mutex_destroy(&mock->lock);
+}
+
+int MockCdpSendFrame(MockCdp* mock, int fin, int opcode, const void* payload, size_t len) {
+    pthread_mutex_lock(&mock->lock);
+    MockCdpConnection* c = mock->latest >= 0 ? &mock->connections[mock->latest] : NULL;
+    pthread_mutex_unlock(&mock->lock);
+    return c && MockCdpFrame(c, fin, opcode, payload, len);
+}
+
+void MockCdpBroadcast(MockCdp* mock, const char* text) {
+    for (int i = 0; i < MOCK_CDP_CONNECTIONS; i++) {
+        MockCdpConnection* c = &mock->connections[i];
+        pthread_mutex_lock(&mock->lock);
+        int browser = c->running && !c->done && c->upgraded && c->browser;
+        pthread_mutex_unlock(&mock->lock);
+        if (browser) MockCdpSendText(c, text);
+    }
+}
+
+int MockCdpCount(MockCdp* mock, const char* method, const char* needle) {
+    char pattern[160];
+    snprintf(pattern, sizeof(pattern), "\"method\":\"%s\"", method);
+    int count = 0;
+    pthread_mutex_lock(&mock->lock);
+    for (int i = 0; i < mock->logCount; i++) {
+        if (strstr(mock->log[i], pattern) && (!needle || strstr(mock->log[i], needle))) count++;
+    }
+    pthread_mutex_unlock(&mock->lock);
+    return count;
+}
+
+int MockCdpWaitCount(MockCdp* mock, const char* method, const char* needle, int count, int timeoutMs) {
+    for (int waited = 0; MockCdpCount(mock, method, needle) < count; waited += 10) {
+        if (waited >= timeoutMs) return 0;
+        MockCdpSleep(10);
+    }
+    return 1;
+}
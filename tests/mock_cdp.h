@@ -0,0 +1,85 @@
+/**
+ * Mock Chrome DevTools endpoint for the cdp.c tests
+ *
+ * Listens on an ephemeral port of 127.0.0.1, answers GET /json/version and
+ * WebSocket upgrades to /devtools/browser/<id> and /devtools/page/<id>, and
+ * answers the CDP methods the liveness monitor, the broker and the renderer
+ * lookup use - one thread per connection. Tests steer it through the settings
+ * below, push raw frames at it, and check what it received. POSIX only.
+ */
+
+#ifndef MOCK_CDP_H
+#define MOCK_CDP_H
+
+#include <pthread.h>
+#include <stddef.h>
+
+#define MOCK_CDP_CONNECTIONS 64
+#define MOCK_CDP_LOG_MAX 16384
+#define MOCK_CDP_TARGETS 256
+
+typedef struct MockCdp MockCdp;
+
+typedef struct {
+    MockCdp* mock;
+    int sock;
+    int upgraded;              // WebSocket established
+    int browser;               // ... on the browser endpoint
+    pthread_t thread;
+    int running;               // Thread started and not joined yet
+    volatile int done;         // Thread finished
+    pthread_mutex_t sendLock;  // Frames from the test thread and the connection thread
+} MockCdpConnection;
+
+struct MockCdp {
+    int port;
+
+    // Settings
+    volatile int muted;             // Leave Browser.getVersion unanswered
+    volatile int httpDelayMs;       // Wait before answering /json/version
+    volatile int handshakeDelayMs;  // Wait before answering an upgrade
+
+    // State
+    volatile int pongs;             // Pong frames received
+    volatile int upgrades;          // WebSocket connections accepted so far
+    char lastPong[128];
+
+    // Internal
+    int listener;
+    volatile int stop;
+    pthread_t acceptThread;
+    pthread_mutex_t lock;
+    MockCdpConnection connections[MOCK_CDP_CONNECTIONS];
+    int latest;                     // Newest browser connection, -1 if none
+    char* log[MOCK_CDP_LOG_MAX];    // Messages received, in order
+    int logCount;
+    int nextSession;
+    int nextContext;
+    int nextTarget;
+    char targets[MOCK_CDP_TARGETS][2][32];  // targetId, browserContextId
+    int targetCount;
+};
+
+// Returns 0 if the listening socket can't be set up
+int MockCdpStart(MockCdp* mock);
+
+void MockCdpStop(MockCdp* mock);
+
+// Sends one frame, unmasked, on the newest browser connection
+int MockCdpSendFrame(MockCdp* mock, int fin, int opcode, const void* payload, size_t len);
+
+// Sends a text message on every browser connection
+void MockCdpBroadcast(MockCdp* mock, const char* text);
+
+// Closes every WebSocket connection, as a browser that exits would
+void MockCdpDropConnections(MockCdp* mock);
+
+// Messages received with method (and containing needle, if set)
+int MockCdpCount(MockCdp* mock, const char* method, const char* needle);
+
+// Waits until MockCdpCount reaches count. Returns 0 on timeout.
+int MockCdpWaitCount(MockCdp* mock, const char* method, const char* needle, int count, int timeoutMs);
+
+void MockCdpSleep(int ms);
+
+#endif // MOCK_CDP_H
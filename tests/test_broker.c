@@ -0,0 +1,498 @@
+/**
+ * Broker tests: agents on one side, the mock endpoint as the browser
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cdp.h"
+#include "mock_cdp.h"
+
+static int g_failures;
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            g_failures++;                                                        \
+        }                                                                        \
+    } while (0)
+
+static MockCdp g_mock;
+static CdpBroker g_broker;
+static pthread_t g_brokerThread;
+
+// A port nothing listens on right now
+static int FreePort(void) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    bind(s, (struct sockaddr*)&addr, sizeof(addr));
+    getsockname(s, (struct sockaddr*)&addr, &addrLen);
+    close(s);
+    return ntohs(addr.sin_port);
+}
+
+static void* BrokerThread(void* arg) {
+    CdpBrokerRun((CdpBroker*)arg);
+    return NULL;
+}
+
+static int WaitUpstream(int u, int state, int timeoutMs) {
+    for (int waited = 0; g_broker.upstreams[u].state != state; waited += 10) {
+        if (waited >= timeoutMs) return 0;
+        MockCdpSleep(10);
+    }
+    return 1;
+}
+
+static int Connect(CdpWebSocket* ws, const char* path) {
+    CdpWsInit(ws);
+    return CdpWsConnect(ws, "127.0.0.1", g_broker.listenPort, path, 1000) == CDP_OK;
+}
+
+static int Send(CdpWebSocket* ws, const char* text) {
+    return CdpWsSendText(ws, text, strlen(text), 1000) == CDP_OK;
+}
+
+// Next message, or NULL if none arrives within timeoutMs
+static const char* Receive(CdpWebSocket* ws, int timeoutMs) {
+    const char* message = NULL;
+    return CdpWsReceive(ws, timeoutMs, &message) >= 0 ? message : NULL;
+}
+
+// Next message contains needle
+static int Expect(CdpWebSocket* ws, const char* needle) {
+    const char* message = Receive(ws, 1000);
+    if (message && strstr(message, needle)) return 1;
+    fprintf(stderr, "  expected %s, got %s\n", needle, message ? message : "nothing");
+    return 0;
+}
+
+static int Get(const char* path, char* body, size_t bodyLen) {
+    CdpHttpClient http;
+    int status = 0;
+    CdpHttpInit(&http, 1000, 2000);
+    CdpHttpSetTarget(&http, "127.0.0.1", g_broker.listenPort);
+    if (CdpHttpGet(&http, path, body, bodyLen, &status) != CDP_OK) status = 0;
+    CdpHttpClose(&http);
+    return status;
+}
+
+// ----------------------------------------------------------------------------
+// Tests
+// ----------------------------------------------------------------------------
+
+static void TestVersion(void) {
+    char body[1024];
+    CHECK(Get("/json/version", body, sizeof(body)) == 200);
+    CHECK(strstr(body, "\"Browser\":\"Mock/1.0\"") != NULL);
+    CHECK(strstr(body, "/devtools/browser/broker\"") != NULL);
+    CHECK(Get("/json/list", body, sizeof(body)) == 404);
+}
+
+// Agents pick their ids freely; each gets its own back, and the browser
+// sees distinct ones
+static void TestIdRewriting(void) {
+    CdpWebSocket a, b;
+    CHECK(Connect(&a, "/devtools/browser/broker"));
+    CHECK(Connect(&b, "/devtools/browser/broker"));
+
+    CHECK(Send(&a, "{\"id\":1000,\"method\":\"Browser.getVersion\"}"));
+    CHECK(Send(&b, "{\"id\":1000,\"method\":\"Browser.getVersion\"}"));
+    CHECK(Send(&a, "{\"method\":\"Storage.getUsage\",\"id\":1001,\"params\":{\"id\":5}}"));
+    CHECK(Expect(&a, "{\"id\":1000,\"result\":{\"product\":\"Mock/1.0\"}}"));
+    CHECK(Expect(&a, "{\"id\":1001,\"result\":{}}"));
+    CHECK(Expect(&b, "{\"id\":1000,\"result\":{\"product\":\"Mock/1.0\"}}"));
+    CHECK(MockCdpCount(&g_mock, "Browser.getVersion", "\"id\":1000") == 0);
+    CHECK(MockCdpCount(&g_mock, "Storage.getUsage", "\"params\":{\"id\":5}") == 1);
+
+    // More than the socket takes at once goes out over several passes
+    size_t dataLen = 4 * 1024 * 1024;
+    char* large = (char*)malloc(dataLen + 128);
+    int headLen = sprintf(large, "{\"id\":1003,\"method\":\"Mock.large\",\"params\":{\"data\":\"");
+    memset(large + headLen, 'x', dataLen);
+    strcpy(large + headLen + dataLen, "\"}}");
+    CHECK(Send(&a, large));
+    free(large);
+    CHECK(Expect(&a, "{\"id\":1003,\"result\":{}}"));
+    CHECK(MockCdpCount(&g_mock, "Mock.large", "xxxxxxxx\"}}") == 1);
+
+    // Messages Chrome would refuse are refused by the broker itself
+    CHECK(Send(&a, "{\"method\":\"Browser.getVersion\"}"));
+    CHECK(Expect(&a, "\"code\":-32600"));
+    CHECK(Send(&a, "{\"id\":1002,\"method\":\"Browser.close\"}"));
+    CHECK(Expect(&a, "{\"id\":1002,\"error\":{\"code\":-32000"));
+    CHECK(MockCdpCount(&g_mock, "Browser.close", NULL) == 0);
+
+    CdpWsClose(&a);
+    CdpWsClose(&b);
+}
+
+// A flat session is its attaching agent's: its events reach only it, and
+// other agents can't use it
+static void TestSessionOwnership(void) {
+    CdpWebSocket a, b;
+    CHECK(Connect(&a, "/devtools/browser/broker"));
+    CHECK(Connect(&b, "/devtools/browser/broker"));
+
+    CHECK(Send(&a, "{\"id\":1,\"method\":\"Target.attachToTarget\",\"params\":{\"targetId\":\"P1\",\"flatten\":true}}"));
+    const char* attached = Receive(&a, 1000);
+    char sessionId[64] = "";
+    CHECK(attached && strstr(attached, "Target.attachedToTarget") &&
+          CdpJsonGetString(attached, "sessionId", sessionId, sizeof(sessionId)));
+    CHECK(Expect(&a, "{\"id\":1,\"result\":{\"sessionId\":\""));
+
+    char command[256];
+    snprintf(command, sizeof(command), "{\"id\":2,\"method\":\"Runtime.evaluate\",\"sessionId\":\"%s\"}", sessionId);
+    CHECK(Send(&b, command));
+    CHECK(Expect(&b, "{\"id\":2,\"error\":{\"code\":-32001"));
+    CHECK(Send(&a, command));
+    CHECK(Expect(&a, "{\"id\":2,\"result\":{}"));
+    CHECK(MockCdpCount(&g_mock, "Runtime.evaluate", sessionId) == 1);
+
+    char event[256];
+    snprintf(event, sizeof(event), "{\"method\":\"Runtime.consoleAPICalled\",\"params\":{},\"sessionId\":\"%s\"}",
+             sessionId);
+    MockCdpBroadcast(&g_mock, event);
+    CHECK(Expect(&a, "Runtime.consoleAPICalled"));
+    CHECK(Receive(&b, 200) == NULL);
+
+    CdpWsClose(&a);
+    CdpWsClose(&b);
+}
+
+// Browser-level events go to the agents that used their domain, target
+// discovery events to the agents that enabled discovery
+static void TestEventFanOut(void) {
+    CdpWebSocket a, b, c;
+    CHECK(Connect(&a, "/devtools/browser/broker"));
+    CHECK(Connect(&b, "/devtools/browser/broker"));
+    CHECK(Connect(&c, "/devtools/browser/broker"));
+
+    CHECK(Send(&a, "{\"id\":1,\"method\":\"Browser.setDownloadBehavior\",\"params\":{\"behavior\":\"deny\"}}"));
+    CHECK(Expect(&a, "{\"id\":1,"));
+    CHECK(Send(&b, "{\"id\":1,\"method\":\"Target.setDiscoverTargets\",\"params\":{\"discover\":true}}"));
+    CHECK(Expect(&b, "{\"id\":1,"));
+    CHECK(Expect(&b, "Target.targetCreated"));
+
+    MockCdpBroadcast(&g_mock, "{\"method\":\"Browser.downloadWillBegin\",\"params\":{\"guid\":\"G\"}}");
+    MockCdpBroadcast(&g_mock, "{\"method\":\"Target.targetDestroyed\",\"params\":{\"targetId\":\"T0\"}}");
+    CHECK(Expect(&a, "Browser.downloadWillBegin"));
+    CHECK(Expect(&b, "Target.targetDestroyed"));
+    CHECK(Receive(&a, 200) == NULL);
+    CHECK(Receive(&b, 100) == NULL);
+    CHECK(Receive(&c, 100) == NULL);
+
+    // Turning discovery off is answered without bothering the browser
+    int calls = MockCdpCount(&g_mock, "Target.setDiscoverTargets", NULL);
+    CHECK(Send(&b, "{\"id\":2,\"method\":\"Target.setDiscoverTargets\",\"params\":{\"discover\":false}}"));
+    CHECK(Expect(&b, "{\"id\":2,\"result\":{}}"));
+    CHECK(MockCdpCount(&g_mock, "Target.setDiscoverTargets", NULL) == calls);
+    MockCdpBroadcast(&g_mock, "{\"method\":\"Target.targetDestroyed\",\"params\":{\"targetId\":\"T0\"}}");
+    CHECK(Receive(&b, 200) == NULL);
+
+    CdpWsClose(&a);
+    CdpWsClose(&b);
+    CdpWsClose(&c);
+}
+
+// What an agent leaves behind is released when it disconnects
+static void TestDisconnectCleanup(void) {
+    CdpWebSocket a;
+    CHECK(Connect(&a, "/devtools/browser/broker"));
+
+    CHECK(Send(&a, "{\"id\":1,\"method\":\"Target.attachToTarget\",\"params\":{\"targetId\":\"P2\",\"flatten\":true}}"));
+    const char* attached = Receive(&a, 1000);
+    char sessionId[64] = "";
+    CHECK(attached && CdpJsonGetString(attached, "sessionId", sessionId, sizeof(sessionId)));
+    CHECK(Expect(&a, "{\"id\":1,"));
+    CHECK(Send(&a, "{\"id\":2,\"method\":\"Target.createBrowserContext\"}"));
+    const char* created = Receive(&a, 1000);
+    char contextId[64] = "";
+    CHECK(created && CdpJsonGetString(created, "browserContextId", contextId, sizeof(contextId)));
+    int sessions = g_broker.upstreams[0].sessionCount;
+    CHECK(sessions >= 1);
+
+    CdpWsClose(&a);
+    char needle[96];
+    snprintf(needle, sizeof(needle), "\"sessionId\":\"%s\"", sessionId);
+    CHECK(MockCdpWaitCount(&g_mock, "Target.detachFromTarget", needle, 1, 1000));
+    snprintf(needle, sizeof(needle), "\"browserContextId\":\"%s\"", contextId);
+    CHECK(MockCdpWaitCount(&g_mock, "Target.disposeBrowserContext", needle, 1, 1000));
+    // Forgotten once Chrome reports the session detached
+    for (int i = 0; i < 100 && g_broker.upstreams[0].sessionCount == sessions; i++) MockCdpSleep(10);
+    CHECK(g_broker.upstreams[0].sessionCount == sessions - 1);
+    for (int i = 0; i < 100 && g_broker.agentCount != 0; i++) MockCdpSleep(10);
+    CHECK(g_broker.agentCount == 0);
+}
+
+// Calls the browser never answers hold up only their own slots; commands are
+// refused once every slot is waiting
+static void TestPendingTable(void) {
+    CdpWebSocket a;
+    CHECK(Connect(&a, "/devtools/browser/broker"));
+    CHECK(Send(&a, "{\"id\":1,\"method\":\"Mock.hang\"}"));
+    int refused = 0;
+    for (int i = 2; i < CDP_BROKER_MAX_PENDING + 16; i++) {
+        char command[64];
+        snprintf(command, sizeof(command), "{\"id\":%d,\"method\":\"Browser.getVersion\"}", i);
+        CHECK(Send(&a, command));
+        const char* message = Receive(&a, 1000);
+        if (!message || !strstr(message, "\"product\":\"Mock/1.0\"")) refused++;
+    }
+    CHECK(refused == 0);
+
+    for (int i = 1; i < CDP_BROKER_MAX_PENDING; i++) {
+        char command[64];
+        snprintf(command, sizeof(command), "{\"id\":%d,\"method\":\"Mock.hang\"}", 100000 + i);
+        CHECK(Send(&a, command));
+    }
+    CHECK(Send(&a, "{\"id\":7,\"method\":\"Browser.getVersion\"}"));
+    CHECK(Expect(&a, "{\"id\":7,\"error\":{\"code\":-32000,\"message\":\"Too many commands in flight\"}}"));
+    CdpWsClose(&a);
+}
+
+// Agents of a browser connection that dropped are disconnected; the broker
+// reconnects and serves new ones
+static void TestUpstreamReconnect(void) {
+    CdpWebSocket a;
+    CHECK(Connect(&a, "/devtools/browser/broker"));
+    CHECK(Send(&a, "{\"id\":1,\"method\":\"Browser.getVersion\"}"));
+    CHECK(Expect(&a, "{\"id\":1,"));
+
+    unsigned long disconnects = g_broker.upstreams[0].disconnects;
+    MockCdpDropConnections(&g_mock);
+    const char* message = NULL;
+    CHECK(CdpWsReceive(&a, 1000, &message) == CDP_ERR_IO);
+    CdpWsClose(&a);
+
+    CHECK(WaitUpstream(0, CDP_LINK_UP, 3000));
+    CHECK(g_broker.upstreams[0].disconnects == disconnects + 1);
+    CHECK(Connect(&a, "/devtools/browser/broker"));
+    CHECK(Send(&a, "{\"id\":1,\"method\":\"Browser.getVersion\"}"));
+    CHECK(Expect(&a, "{\"id\":1,\"result\":{\"product\":\"Mock/1.0\"}}"));
+    CdpWsClose(&a);
+}
+
+// Contexts are only disposed by the agent that created them or holds their
+// lease; a pooled one leaves the pool once Chrome confirms
+static void TestContextPool(void) {
+    CdpWebSocket a, b;
+    CHECK(Connect(&a, "/devtools/browser/broker"));
+    g_broker.poolSize = 1;
+    for (int i = 0; i < 100 && g_broker.upstreams[0].poolReady < 1; i++) MockCdpSleep(10);
+    CHECK(g_broker.upstreams[0].poolReady == 1);
+
+    char body[1024];
+    char contextId[64] = "";
+    char token[CDP_BROKER_TOKEN_LEN + 1] = "";
+    char path[160];
+    char needle[96];
+    char command[192];
+    CHECK(Get("/json/context/new", body, sizeof(body)) == 200);
+    CHECK(strstr(body, "\"pooled\":true") != NULL);
+    CHECK(CdpJsonGetString(body, "browserContextId", contextId, sizeof(contextId)));
+    CHECK(CdpJsonGetString(body, "token", token, sizeof(token)) && strlen(token) == CDP_BROKER_TOKEN_LEN);
+
+    // The lease takes its token to bind or release
+    snprintf(path, sizeof(path), "/devtools/browser/broker/0/%s", contextId);
+    CHECK(!Connect(&b, path));
+    CdpWsClose(&b);
+    snprintf(path, sizeof(path), "/devtools/browser/broker/0/%s?token=%032d", contextId, 0);
+    CHECK(!Connect(&b, path));
+    CdpWsClose(&b);
+    snprintf(path, sizeof(path), "/json/context/release/%s", contextId);
+    CHECK(Get(path, body, sizeof(body)) == 403);
+    snprintf(path, sizeof(path), "/devtools/browser/broker/0/%s?token=%s", contextId, token);
+    CHECK(Connect(&b, path));
+
+    snprintf(command, sizeof(command),
+             "{\"id\":30,\"method\":\"Target.disposeBrowserContext\",\"params\":{\"browserContextId\":\"%s\"}}",
+             contextId);
+    snprintf(needle, sizeof(needle), "\"browserContextId\":\"%s\"", contextId);
+    CHECK(Send(&a, command));
+    CHECK(Expect(&a, "{\"id\":30,\"error\":{\"code\":-32602,\"message\":\"Failed to find context with id"));
+    CHECK(MockCdpCount(&g_mock, "Target.disposeBrowserContext", needle) == 0);
+    CHECK(Send(&b, command));
+    CHECK(Expect(&b, "{\"id\":30,\"result\":{}"));
+    CHECK(MockCdpCount(&g_mock, "Target.disposeBrowserContext", needle) == 1);
+    snprintf(path, sizeof(path), "/json/context/release/%s?token=%s", contextId, token);
+    CHECK(Get(path, body, sizeof(body)) == 404);
+
+    // ... and the same for contexts agents create themselves
+    CHECK(Send(&a, "{\"id\":31,\"method\":\"Target.createBrowserContext\"}"));
+    const char* created = Receive(&a, 1000);
+    CHECK(created && CdpJsonGetString(created, "browserContextId", contextId, sizeof(contextId)));
+    snprintf(command, sizeof(command),
+             "{\"id\":32,\"method\":\"Target.disposeBrowserContext\",\"params\":{\"browserContextId\":\"%s\"}}",
+             contextId);
+    CHECK(Send(&b, command));
+    CHECK(Expect(&b, "{\"id\":32,\"error\":{\"code\":-32602"));
+    CHECK(Send(&a, command));
+    CHECK(Expect(&a, "{\"id\":32,\"result\":{}"));
+
+    CHECK(Get("/json/context/new", body, sizeof(body)) == 200);
+    CHECK(CdpJsonGetString(body, "browserContextId", contextId, sizeof(contextId)));
+    CHECK(CdpJsonGetString(body, "token", token, sizeof(token)));
+    snprintf(path, sizeof(path), "/devtools/browser/broker/0/%s?token=%s", contextId, token);
+    CHECK(strstr(body, path) != NULL);
+    snprintf(path, sizeof(path), "/json/context/release/%s?token=%s", contextId, token);
+    snprintf(needle, sizeof(needle), "\"browserContextId\":\"%s\"", contextId);
+    CHECK(Get(path, body, sizeof(body)) == 200);
+    CHECK(MockCdpWaitCount(&g_mock, "Target.disposeBrowserContext", needle, 1, 1000));
+
+    g_broker.poolSize = 0;
+    for (int i = 0; i < 100 && g_broker.upstreams[0].poolReady > 0; i++) MockCdpSleep(10);
+    CHECK(g_broker.upstreams[0].poolReady == 0);
+    CdpWsClose(&a);
+    CdpWsClose(&b);
+}
+
+// Background tabs are loaded over page connections that are slow to
+// answer without holding up the agents
+static void TestTabPool(void) {
+    CdpWebSocket a;
+    CHECK(Connect(&a, "/devtools/browser/broker"));
+    CdpBrokerSetTabUrls(&g_broker, "http://127.0.0.1/start");
+    g_mock.handshakeDelayMs = 300;
+    g_broker.tabPoolSize = 2;
+
+    unsigned long long slowestUs = 0;
+    for (int i = 1; i <= 10; i++) {
+        char command[64];
+        snprintf(command, sizeof(command), "{\"id\":%d,\"method\":\"Browser.getVersion\"}", i);
+        unsigned long long startUs = CdpNowUs();
+        CHECK(Send(&a, command));
+        CHECK(Expect(&a, "\"product\":\"Mock/1.0\""));
+        if (CdpNowUs() - startUs > slowestUs) slowestUs = CdpNowUs() - startUs;
+        MockCdpSleep(30);
+    }
+    CHECK(slowestUs < 100000);
+    for (int i = 0; i < 300 && g_broker.upstreams[0].tabsReady < 2; i++) MockCdpSleep(10);
+    CHECK(g_broker.upstreams[0].tabsReady == 2);
+    CHECK(MockCdpCount(&g_mock, "Page.navigate", "http://127.0.0.1/start") >= 2);
+    g_mock.handshakeDelayMs = 0;
+
+    // A leased tab is only its holder's to close
+    char body[1024];
+    char targetId[64] = "";
+    char token[CDP_BROKER_TOKEN_LEN + 1] = "";
+    char path[160];
+    char needle[96];
+    char command[192];
+    CdpWebSocket b;
+    CHECK(Get("/json/tab/new", body, sizeof(body)) == 200);
+    CHECK(strstr(body, "\"pooled\":true") != NULL);
+    CHECK(CdpJsonGetString(body, "targetId", targetId, sizeof(targetId)));
+    CHECK(CdpJsonGetString(body, "token", token, sizeof(token)) && strlen(token) == CDP_BROKER_TOKEN_LEN);
+    snprintf(path, sizeof(path), "/devtools/browser/broker/0/%s", targetId);
+    CHECK(!Connect(&b, path));
+    CdpWsClose(&b);
+    snprintf(path, sizeof(path), "/json/tab/release/%s?token=%032d", targetId, 0);
+    CHECK(Get(path, body, sizeof(body)) == 403);
+    snprintf(path, sizeof(path), "/devtools/browser/broker/0/%s?token=%s", targetId, token);
+    CHECK(Connect(&b, path));
+    snprintf(command, sizeof(command), "{\"id\":20,\"method\":\"Target.closeTarget\",\"params\":{\"targetId\":\"%s\"}}",
+             targetId);
+    snprintf(needle, sizeof(needle), "\"targetId\":\"%s\"", targetId);
+    CHECK(Send(&a, command));
+    CHECK(Expect(&a, "{\"id\":20,\"error\":{\"code\":-32602"));
+    CHECK(MockCdpCount(&g_mock, "Target.closeTarget", needle) == 0);
+    CHECK(Send(&b, command));
+    CHECK(Expect(&b, "{\"id\":20,\"result\":"));
+    snprintf(path, sizeof(path), "/json/tab/release/%s?token=%s", targetId, token);
+    CHECK(Get(path, body, sizeof(body)) == 404);
+    CdpWsClose(&b);
+
+    CHECK(Get("/json/tab/new", body, sizeof(body)) == 200);
+    CHECK(CdpJsonGetString(body, "targetId", targetId, sizeof(targetId)));
+    CHECK(CdpJsonGetString(body, "token", token, sizeof(token)));
+    snprintf(path, sizeof(path), "/json/tab/release/%s", targetId);
+    CHECK(Get(path, body, sizeof(body)) == 403);
+    snprintf(path, sizeof(path), "/json/tab/release/%s?token=%s", targetId, token);
+    snprintf(needle, sizeof(needle), "\"targetId\":\"%s\"", targetId);
+    CHECK(Get(path, body, sizeof(body)) == 200);
+    CHECK(MockCdpWaitCount(&g_mock, "Target.closeTarget", needle, 1, 1000));
+    CHECK(Get(path, body, sizeof(body)) == 404);
+
+    g_broker.tabPoolSize = 0;
+    for (int i = 0; i < 100 && g_broker.upstreams[0].tabsReady > 0; i++) MockCdpSleep(10);
+    CHECK(g_broker.upstreams[0].tabsReady == 0);
+    CdpWsClose(&a);
+}
+
+// A browser endpoint that never answers doesn't hold up the others
+static void TestHungBrowser(void) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t addrLen = sizeof(addr);
+    int hung = socket(AF_INET, SOCK_STREAM, 0);
+    CHECK(bind(hung, (struct sockaddr*)&addr, sizeof(addr)) == 0 && listen(hung, 8) == 0);
+    getsockname(hung, (struct sockaddr*)&addr, &addrLen);
+    CdpBrokerSetUpstream(&g_broker, 1, "127.0.0.1", ntohs(addr.sin_port));
+    g_broker.upstreamCount = 2;
+
+    CdpWebSocket a;
+    CHECK(Connect(&a, "/devtools/browser/broker"));
+    unsigned long long slowestUs = 0;
+    for (int i = 1; i <= 30; i++) {
+        char command[64];
+        snprintf(command, sizeof(command), "{\"id\":%d,\"method\":\"Browser.getVersion\"}", i);
+        unsigned long long startUs = CdpNowUs();
+        CHECK(Send(&a, command));
+        CHECK(Expect(&a, "\"product\":\"Mock/1.0\""));
+        if (CdpNowUs() - startUs > slowestUs) slowestUs = CdpNowUs() - startUs;
+        MockCdpSleep(50);
+    }
+    CHECK(slowestUs < 100000);
+    CHECK(g_broker.upstreams[1].state == CDP_LINK_DOWN);
+    CdpWsClose(&a);
+
+    g_broker.upstreamCount = 1;
+    close(hung);
+}
+
+int main(void) {
+    if (!MockCdpStart(&g_mock)) {
+        fprintf(stderr, "mock endpoint could not listen\n");
+        return 1;
+    }
+    CdpBrokerInit(&g_broker, "127.0.0.1", FreePort());
+    CdpBrokerSetUpstream(&g_broker, 0, "127.0.0.1", g_mock.port);
+    g_broker.upstreamCount = 1;
+    pthread_create(&g_brokerThread, NULL, BrokerThread, &g_broker);
+    if (!WaitUpstream(0, CDP_LINK_UP, 3000)) {
+        fprintf(stderr, "broker did not connect to the mock endpoint\n");
+        return 1;
+    }
+
+    TestVersion();
+    TestIdRewriting();
+    TestSessionOwnership();
+    TestEventFanOut();
+    TestDisconnectCleanup();
+    TestContextPool();
+    TestTabPool();
+    TestHungBrowser();
+    TestPendingTable();
+    TestUpstreamReconnect();
+
+    g_broker.stop = 1;
+    pthread_join(g_brokerThread, NULL);
+    MockCdpStop(&g_mock);
+    printf("test_broker: %s\n", g_failures ? "FAILED" : "ok");
+    return g_failures ? 1 : 0;
+}
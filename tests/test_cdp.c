@@ -0,0 +1,249 @@
+/**
+ * WebSocket client and liveness monitor tests, against the mock endpoint
+ */
+
+#define _POSIX_C_SOURCE 200809L
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "cdp.h"
+#include "mock_cdp.h"
+
+static int g_failures;
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #cond); \
+            g_failures++;                                                        \
+        }                                                                        \
+    } while (0)
+
+static MockCdp g_mock;
+
+static int ConnectBrowser(CdpWebSocket* ws) {
+    CdpWsInit(ws);
+    return CdpWsConnect(ws, "127.0.0.1", g_mock.port, "/devtools/browser/mock", 1000) == CDP_OK;
+}
+
+// ----------------------------------------------------------------------------
+// WebSocket client
+// ----------------------------------------------------------------------------
+
+static void TestVersion(void) {
+    CdpHttpClient http;
+    char body[1024];
+    int status = 0;
+    CdpHttpInit(&http, 1000, 1000);
+    CdpHttpSetTarget(&http, "127.0.0.1", g_mock.port);
+    CHECK(CdpHttpGet(&http, "/json/version", body, sizeof(body), &status) == CDP_OK);
+    CHECK(status == 200);
+    CHECK(strstr(body, "/devtools/browser/mock") != NULL);
+    CdpHttpClose(&http);
+}
+
+// A message split over continuation frames, with a ping between them
+static void TestFragmented(void) {
+    CdpWebSocket ws;
+    CHECK(ConnectBrowser(&ws));
+    int pongs = g_mock.pongs;
+
+    CHECK(MockCdpSendFrame(&g_mock, 0, 0x1, "{\"method\":", 10));
+    CHECK(MockCdpSendFrame(&g_mock, 0, 0x0, "\"Frag", 5));
+    CHECK(MockCdpSendFrame(&g_mock, 1, 0x9, "between", 7));
+    CHECK(MockCdpSendFrame(&g_mock, 1, 0x0, "mented\"}", 8));
+
+    const char* message = NULL;
+    int len = CdpWsReceive(&ws, 1000, &message);
+    CHECK(len == 23);
+    CHECK(message && strcmp(message, "{\"method\":\"Fragmented\"}") == 0);
+    for (int i = 0; i < 100 && g_mock.pongs == pongs; i++) MockCdpSleep(10);
+    CHECK(g_mock.pongs == pongs + 1);
+    CHECK(strcmp(g_mock.lastPong, "between") == 0);
+    CdpWsClose(&ws);
+}
+
+// Payloads past 64 KB take the 64-bit length form, both ways
+static void TestLargeFrames(void) {
+    CdpWebSocket ws;
+    CHECK(ConnectBrowser(&ws));
+
+    size_t sizes[] = { 125, 126, 0xFFFF, 0x10000, 300000 };
+    for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        char* payload = (char*)malloc(sizes[i]);
+        for (size_t k = 0; k < sizes[i]; k++) payload[k] = (char)('a' + (k % 26));
+        CHECK(MockCdpSendFrame(&g_mock, 1, 0x1, payload, sizes[i]));
+
+        const char* message = NULL;
+        int len = CdpWsReceive(&ws, 2000, &message);
+        CHECK(len == (int)sizes[i]);
+        CHECK(message && memcmp(message, payload, sizes[i]) == 0 && message[sizes[i]] == '\0');
+        free(payload);
+    }
+
+    size_t bodyLen = 200000;
+    char* request = (char*)malloc(bodyLen + 64);
+    int headLen = sprintf(request, "{\"id\":7,\"method\":\"Mock.large\",\"params\":{\"data\":\"");
+    memset(request + headLen, 'x', bodyLen);
+    strcpy(request + headLen + bodyLen, "\"}}");
+    CHECK(CdpWsSendText(&ws, request, strlen(request), 1000) == CDP_OK);
+    free(request);
+
+    const char* message = NULL;
+    CHECK(CdpWsReceive(&ws, 2000, &message) > 0);
+    CHECK(message && strstr(message, "\"id\":7") != NULL);
+    CHECK(MockCdpCount(&g_mock, "Mock.large", "xxxxxxxx\"}}") == 1);
+    CdpWsClose(&ws);
+}
+
+static void TestClose(void) {
+    CdpWebSocket ws;
+    CHECK(ConnectBrowser(&ws));
+    CHECK(MockCdpSendFrame(&g_mock, 1, 0x8, "\x03\xe8", 2));
+    const char* message = NULL;
+    CHECK(CdpWsReceive(&ws, 1000, &message) == CDP_ERR_IO);
+    CdpWsClose(&ws);
+
+    CHECK(ConnectBrowser(&ws));
+    CHECK(CdpWsReceive(&ws, 50, &message) == CDP_ERR_TIMEOUT);
+    CdpWsClose(&ws);
+}
+
+// A renderer maps to the page it hosts, or to the page above its subframes
+static void TestFindRenderer(void) {
+    CdpSession session;
+    char targetId[64];
+    CdpSessionInit(&session, 1000);
+    CHECK(CdpSessionOpen(&session, "127.0.0.1", g_mock.port) == CDP_OK);
+    CHECK(CdpSessionFindRenderer(&session, 102, targetId, sizeof(targetId)) == CDP_OK);
+    CHECK(strcmp(targetId, "T7") == 0);
+    CHECK(CdpSessionFindRenderer(&session, 101, targetId, sizeof(targetId)) == CDP_OK);
+    CHECK(strcmp(targetId, "T0") == 0);
+    CHECK(CdpSessionFindRenderer(&session, 999, targetId, sizeof(targetId)) == CDP_ERR_PROTOCOL);
+
+    // The session stays usable, the answers to Tracing.end are skipped
+    CHECK(CdpSessionCall(&session, NULL, "Browser.getVersion", NULL, NULL) == CDP_OK);
+    CHECK(MockCdpCount(&g_mock, "Tracing.start", "ReportEvents") == 3);
+    CdpSessionClose(&session);
+}
+
+// ----------------------------------------------------------------------------
+// Liveness monitor
+// ----------------------------------------------------------------------------
+
+typedef struct {
+    pthread_mutex_t lock;
+    int states[64];  // Transitions in order
+    int count;
+} StateLog;
+
+static void OnMonitorChange(CdpMonitor* monitor, void* context) {
+    StateLog* log = (StateLog*)context;
+    pthread_mutex_lock(&log->lock);
+    if ((log->count == 0 || log->states[log->count - 1] != monitor->state) && log->count < 64) {
+        log->states[log->count++] = monitor->state;
+    }
+    pthread_mutex_unlock(&log->lock);
+}
+
+// Index of the first transition to state at or after from, -1 if none
+static int FindState(StateLog* log, int state, int from, int timeoutMs) {
+    for (int waited = 0;; waited += 10) {
+        pthread_mutex_lock(&log->lock);
+        int found = -1;
+        for (int i = from; i < log->count && found < 0; i++) {
+            if (log->states[i] == state) found = i;
+        }
+        pthread_mutex_unlock(&log->lock);
+        if (found >= 0 || waited >= timeoutMs) return found;
+        MockCdpSleep(10);
+    }
+}
+
+static void* MonitorThread(void* arg) {
+    CdpMonitorRun((CdpMonitor*)arg);
+    return NULL;
+}
+
+static void TestMonitor(void) {
+    static CdpMonitor monitor;
+    StateLog log;
+    memset(&log, 0, sizeof(log));
+    pthread_mutex_init(&log.lock, NULL);
+
+    CdpMonitorInit(&monitor, "127.0.0.1", g_mock.port);
+    monitor.pingIntervalMs = 100;
+    monitor.pingDeadlineMs = 100;
+    monitor.reconnectDelayMs = 50;
+    monitor.onChange = OnMonitorChange;
+    monitor.context = &log;
+    pthread_t thread;
+    pthread_create(&thread, NULL, MonitorThread, &monitor);
+
+    // Up, with the target reported by discovery, and pings answered
+    int up = FindState(&log, CDP_LINK_UP, 0, 2000);
+    CHECK(up >= 0);
+    CHECK(MockCdpWaitCount(&g_mock, "Browser.getVersion", NULL, 2, 2000));
+    CHECK(monitor.targetCount == 1 && strcmp(monitor.targets[0].targetId, "T0") == 0);
+    CHECK(strcmp(monitor.browser, "Mock/1.0") == 0);
+
+    // A ping past its deadline stalls the link, CDP_STALL_LIMIT of them drop it
+    g_mock.muted = 1;
+    int stalled = FindState(&log, CDP_LINK_STALLED, up, 2000);
+    CHECK(stalled > up);
+    int down = FindState(&log, CDP_LINK_DOWN, stalled, 2000);
+    CHECK(down > stalled);
+    CHECK(monitor.missedPings >= 1);
+    CHECK(monitor.disconnects == 1);
+
+    // ... and it comes back once the browser answers again
+    int upgrades = g_mock.upgrades;
+    g_mock.muted = 0;
+    int again = FindState(&log, CDP_LINK_UP, down, 2000);
+    CHECK(again > down);
+    CHECK(g_mock.upgrades > upgrades);
+
+    // A connection the browser drops is reconnected
+    MockCdpDropConnections(&g_mock);
+    int lost = FindState(&log, CDP_LINK_DOWN, again, 2000);
+    CHECK(lost > again);
+    int back = FindState(&log, CDP_LINK_UP, lost, 2000);
+    CHECK(back > lost);
+    CHECK(monitor.disconnects == 2);
+    for (int i = 0; i < 100 && monitor.targetCount != 1; i++) MockCdpSleep(10);
+    CHECK(monitor.targetCount == 1);
+
+    // Retargeted from this thread, it follows to the new endpoint and back
+    CHECK(CdpMonitorRetarget(&monitor, "127.0.0.1", 1));
+    int moved = FindState(&log, CDP_LINK_DOWN, back, 2000);
+    CHECK(moved > back);
+    upgrades = g_mock.upgrades;
+    CHECK(CdpMonitorRetarget(&monitor, "127.0.0.1", g_mock.port));
+    CHECK(FindState(&log, CDP_LINK_UP, moved, 2000) > moved);
+    CHECK(g_mock.upgrades > upgrades);
+
+    monitor.stop = 1;
+    pthread_join(thread, NULL);
+    CHECK(monitor.state == CDP_LINK_DOWN);
+    pthread_mutex_destroy(&log.lock);
+}
+
+int main(void) {
+    if (!MockCdpStart(&g_mock)) {
+        fprintf(stderr, "mock endpoint could not listen\n");
+        return 1;
+    }
+
+    TestVersion();
+    TestFragmented();
+    TestLargeFrames();
+    TestClose();
+    TestFindRenderer();
+    TestMonitor();
+
+    MockCdpStop(&g_mock);
+    printf("test_cdp: %s\n", g_failures ? "FAILED" : "ok");
+    return g_failures ? 1 : 0;
+}